@@ -47,11 +47,18 @@ void update(double elapsed_frame_time);
 
 void render(GLFWwindow *window);
 
-static GLuint cube_vao = 0;
+static gla_buffer_arena *vertex_arena = NULL;
+static gla_buffer_arena *index_arena = NULL;
+static gla_vao_cache *vao_cache = NULL;
+static gla_vertex_array *cube_vertex_array = NULL;
+static GLuint cube_vertex_buffer = 0;
+static GLintptr cube_vertex_offset = 0;
+static GLuint cube_index_buffer = 0;
+static GLintptr cube_index_offset = 0;
 static GLuint cube_program = 0;
-static mat4 view;
-static mat4 proj;
+static camera cam;
 static GLint mvp_location = -1;
+static mat4 cube_dequantization;
 static float cube_y_rotation_rad = 0.0f;
 static bool do_render_wireframe = true;
 
@@ -92,7 +99,8 @@ int main(int argc, char **argv)
          0.5f,  0.5f, -0.5f, // 6
         -0.5f,  0.5f, -0.5f, // 7
     };
-    GLuint indices[] = {
+    // Eight vertices fit into 8-bit indices, see gla_choose_index_type
+    GLubyte indices[] = {
         // Face 1
         0, 1, 2,
         0, 2, 3,
@@ -113,32 +121,51 @@ int main(int argc, char **argv)
         3, 6, 7
     };
 
-    // Vertex buffer object
-    GLuint cube_vbo = 0;
-    glGenBuffers(1, &cube_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, cube_vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Element buffer object
-    GLuint cube_ebo = 0;
-    glGenBuffers(1, &cube_ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cube_ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
-                GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    // Vertex array object
-    cube_vao = 0;
-    glGenVertexArrays(1, &cube_vao);
-    glBindVertexArray(cube_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, cube_vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cube_ebo);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), NULL);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // Positions quantized to 16 bits relative to the bounds of the cube. The
+    // dequantization is folded into the model matrix.
+    GLfloat aabb_min[3] = {-0.5f, -0.5f, -0.5f};
+    GLfloat aabb_max[3] = {0.5f, 0.5f, 0.5f};
+    GLushort quantized_vertices[8 * 4];
+    gla_quantize_positions(quantized_vertices, vertices, 3 * sizeof(GLfloat),
+                        8, aabb_min, aabb_max);
+    gla_get_position_dequantization(cube_dequantization.m, aabb_min, aabb_max);
+
+    // Vertex and index ranges in buffer objects shared by all meshes
+    vertex_arena = gla_create_buffer_arena(1 << 20, 256);
+    index_arena = gla_create_buffer_arena(1 << 20, 256);
+    if (!(vertex_arena && index_arena)) {
+        clean_up_glfw(window);
+        return 1;
+    }
+    GLuint cube_vertices = gla_alloc_buffer_arena_range(
+        vertex_arena, sizeof(quantized_vertices),
+        gla_quantized_attrib_size(GLA_QUANTIZED_POSITION), quantized_vertices);
+    GLuint cube_indices = gla_alloc_buffer_arena_range(index_arena,
+                                                    sizeof(indices),
+                                                    sizeof(GLubyte), indices);
+    if (!(cube_vertices && cube_indices)) {
+        clean_up_glfw(window);
+        return 1;
+    }
+    gla_buffer_range vertex_range =
+        gla_get_buffer_arena_range(vertex_arena, cube_vertices);
+    gla_buffer_range index_range =
+        gla_get_buffer_arena_range(index_arena, cube_indices);
+    cube_vertex_buffer = vertex_range.buffer;
+    cube_vertex_offset = vertex_range.offset;
+    cube_index_buffer = index_range.buffer;
+    cube_index_offset = index_range.offset;
+
+    // Vertex array object shared by all meshes with the same vertex format
+    vao_cache = gla_create_vao_cache();
+    if (!vao_cache) {
+        clean_up_glfw(window);
+        return 1;
+    }
+    gla_vertex_format position_format = {0};
+    gla_add_quantized_vertex_attrib(&position_format, 0, 0,
+                                    GLA_QUANTIZED_POSITION);
+    cube_vertex_array = gla_get_vertex_array(vao_cache, &position_format);
 
     // Create shaders and shader programs
     GLuint vert_shader =
@@ -173,11 +200,10 @@ int main(int argc, char **argv)
     vec3 camera_eye = vec3_3f(0.0f, 2.0f, 2.0f);
     vec3 camera_center = vec3_3f(0.0f, 0.0f, 0.0f);
     vec3 camera_up = vec3_3f(0.0f, 2.0f, -2.0f);
-    mat4 model = mat4_identity();
-    view = mat4_look_at(camera_eye, camera_center, camera_up);
-    proj = mat4_perspective(65.0f, 1.25f, 0.1f, 100.0f);
-    mat4 mv = mat4_mul_mat4(view, model);
-    mat4 mvp = mat4_mul_mat4(proj, mv);
+    mat4 model = cube_dequantization;
+    cam = camera_perspective(camera_eye, camera_center, camera_up,
+                            65.0f, 1.25f, 0.1f, 100.0f);
+    mat4 mvp = camera_mvp(&cam, model);
     mvp_location = glGetUniformLocation(cube_program, "mvp");
 
     glUseProgram(cube_program);
@@ -200,6 +226,9 @@ int main(int argc, char **argv)
 
     // Clean up and terminate application
     gla_delete_program(cube_program);
+    gla_delete_vao_cache(vao_cache);
+    gla_delete_buffer_arena(index_arena);
+    gla_delete_buffer_arena(vertex_arena);
     clean_up_glfw(window);
     return 0;
 }
@@ -223,6 +252,9 @@ void error_cb(int error, const char *description)
 void framebuffer_size_cb(GLFWwindow *window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    if (height > 0) {
+        camera_set_aspect(&cam, (float) width / (float) height);
+    }
 }
 
 // -----------------------------------------------------------------------------
@@ -234,6 +266,11 @@ bool init(GLFWwindow **window, int window_width, int window_height,
         return false;
     }
 
+    // Buffer storage and direct state access require OpenGL 4.5
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
     *window =
         glfwCreateWindow(window_width, window_height, window_title, NULL, NULL);
     if (!window) {
@@ -276,9 +313,9 @@ void update(double elapsed_frame_time)
         cube_y_rotation_rad = 0.0f;
     }
 
-    mat4 model = mat4_rotate_y(cube_y_rotation_rad);
-    mat4 mv = mat4_mul_mat4(view, model);
-    mat4 mvp = mat4_mul_mat4(proj, mv);
+    mat4 model = mat4_mul_mat4(mat4_rotate_y(cube_y_rotation_rad),
+                            cube_dequantization);
+    mat4 mvp = camera_mvp(&cam, model);
 
     glUseProgram(cube_program);
     glUniformMatrix4fv(mvp_location, 1, GL_FALSE, mvp.m);
@@ -298,8 +335,9 @@ void render(GLFWwindow *window)
     }
 
     glUseProgram(cube_program);
-    glBindVertexArray(cube_vao);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, NULL);
-    glBindVertexArray(0);
+    gla_bind_vertex_array(vao_cache, cube_vertex_array, &cube_vertex_buffer,
+                        &cube_vertex_offset, cube_index_buffer);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE,
+                (const void *) cube_index_offset);
     glUseProgram(0);
 }
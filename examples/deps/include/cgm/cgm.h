@@ -73,6 +73,117 @@ typedef struct mat4 {
     float m[16];
 } mat4;
 
+// Frustum planes (a, b, c, d) with ax + by + cz + d >= 0 on the inner side,
+// ordered left, right, bottom, top, near, far
+#define CGM_FRUSTUM_LEFT 0
+#define CGM_FRUSTUM_RIGHT 1
+#define CGM_FRUSTUM_BOTTOM 2
+#define CGM_FRUSTUM_TOP 3
+#define CGM_FRUSTUM_NEAR 4
+#define CGM_FRUSTUM_FAR 5
+
+// Bounding volumes in structure-of-arrays layout. Each array holds one entry
+// per object.
+typedef struct sphere_soa {
+    const float *x;
+    const float *y;
+    const float *z;
+    const float *radius;
+} sphere_soa;
+
+typedef struct aabb_soa {
+    const float *center_x;
+    const float *center_y;
+    const float *center_z;
+    const float *extent_x;
+    const float *extent_y;
+    const float *extent_z;
+} aabb_soa;
+
+// Scheduler interface for the multi-threaded kernels. Implementations must call
+// task(arg, i) exactly once for every i in [0, count) and return only after all
+// calls have finished, e.g. gla_parallel_for from gla.h.
+typedef void (*cgm_task_fn)(void *arg, int index);
+typedef void (*cgm_parallel_for_fn)(void *scheduler, int count,
+                                    cgm_task_fn task, void *arg);
+
+// Transform hierarchy node flags
+#define CGM_TRANSFORM_DIRTY 0x1
+#define CGM_TRANSFORM_UPDATED 0x2
+
+// Transform hierarchy stored as flat arrays in topological order (parents
+// precede their children). Nodes hold local translation, rotation (unit
+// quaternion x, y, z, w) and scale components. The world matrices are valid
+// after calling one of the update functions.
+typedef struct transform_hierarchy {
+    int count;
+    int capacity;
+    int *parent; // -1 for root nodes
+    vec3 *translation;
+    vec4 *rotation;
+    vec3 *scale;
+    mat4 *world;
+    unsigned char *flags;
+    int any_dirty;
+
+    // Schedule of the parallel update, rebuilt after nodes have been added.
+    // order lists the nodes of the serial head first, followed by the nodes
+    // of each independent subtree group. Each list is in topological order.
+    int schedule_valid;
+    int *order;
+    int num_serial;
+    int *group_begin; // num_groups + 1 offsets into order
+    int num_groups;
+} transform_hierarchy;
+
+// Camera dirty flags
+#define CGM_CAMERA_VIEW_DIRTY 0x1
+#define CGM_CAMERA_PROJ_DIRTY 0x2
+
+// Perspective camera that lazily caches its derived matrices and planes. The
+// cached members are only valid after calling one of the camera_* accessors.
+typedef struct camera {
+    vec3 eye;
+    vec3 center;
+    vec3 up;
+    float fovy;
+    float aspect;
+    float near;
+    float far;
+    int dirty;
+    mat4 view;
+    mat4 proj;
+    mat4 view_proj;
+    mat4 inv_view;
+    mat4 inv_proj;
+    mat4 inv_view_proj;
+    vec4 planes[6];
+} camera;
+
+// -----------------------------------------------------------------------------
+// Scalar functions
+// -----------------------------------------------------------------------------
+// Fast approximations of libm functions. The maximum errors were measured
+// against the double precision libm results:
+//  - fast_sinf, fast_cosf, fast_sincosf: 9.3e-8 absolute for |x| <= 8192
+//  - fast_tanf: 2.5e-7 relative for |x| <= 8 where |cos(x)| > 0.01, generally
+//    about 1e-7 / |sin(x) cos(x)| since it is computed as sine over cosine
+//  - fast_rsqrtf: 2.7e-7 relative (one Newton step on the SSE estimate, two
+//    steps on a bit level estimate without SSE)
+//  - fast_sqrtf: 2.9e-7 relative, exact 0 for x <= 0
+// Defining CGM_FAST_MATH makes the vector and matrix functions use them instead
+// of libm. Call sites can also use them directly.
+CGM_LINKAGE float fast_sinf(float x);
+CGM_LINKAGE float fast_cosf(float x);
+CGM_LINKAGE void fast_sincosf(float x, float *s, float *c);
+CGM_LINKAGE float fast_tanf(float x);
+CGM_LINKAGE float fast_rsqrtf(float x);
+CGM_LINKAGE float fast_sqrtf(float x);
+
+// Batch versions with the same error bounds (in and out may alias)
+CGM_LINKAGE void fast_sincosf_n(const float *in, float *s, float *c, int n);
+CGM_LINKAGE void fast_rsqrtf_n(const float *in, float *out, int n);
+
 // -----------------------------------------------------------------------------
 // Vector functions
 // -----------------------------------------------------------------------------
@@ -176,6 +287,7 @@ CGM_LINKAGE mat4 mat4_rotate_y(float rad);
 CGM_LINKAGE mat4 mat4_rotate_z(float rad);
 CGM_LINKAGE mat4 mat4_scale(vec3 v);
 CGM_LINKAGE mat4 mat4_translate(vec3 v);
+CGM_LINKAGE mat4 mat4_trs(vec3 translation, vec4 rotation, vec3 scale);
 
 // Virtual camera functions
 CGM_LINKAGE mat4 mat4_frustum(float left, float right, float bottom, float top,
@@ -185,10 +297,94 @@ CGM_LINKAGE mat4 mat4_ortho(float left, float right, float bottom, float top,
                         float near, float far);
 CGM_LINKAGE mat4 mat4_perspective(float fovy, float aspect, float near,
                             float far);
+CGM_LINKAGE void mat4_frustum_planes(mat4 m, vec4 planes[6]);
 
 // Output
 CGM_LINKAGE void mat4_print(mat4 m);
 
+// -----------------------------------------------------------------------------
+// Quaternion functions (stored in vec4 as x, y, z, w)
+// -----------------------------------------------------------------------------
+CGM_LINKAGE vec4 quat_identity();
+CGM_LINKAGE vec4 quat_axis_angle(vec3 axis, float rad);
+CGM_LINKAGE vec4 quat_mul_quat(vec4 q1, vec4 q2);
+
+// -----------------------------------------------------------------------------
+// Camera functions
+// -----------------------------------------------------------------------------
+// Constructors
+CGM_LINKAGE camera camera_perspective(vec3 eye, vec3 center, vec3 up,
+                                    float fovy, float aspect, float near,
+                                    float far);
+
+// Modifiers (mark the affected cached values dirty)
+CGM_LINKAGE void camera_set_look_at(camera *c, vec3 eye, vec3 center, vec3 up);
+CGM_LINKAGE void camera_set_perspective(camera *c, float fovy, float aspect,
+                                    float near, float far);
+CGM_LINKAGE void camera_set_aspect(camera *c, float aspect);
+
+// Cached value access (recompute dirty values on demand)
+CGM_LINKAGE void camera_update(camera *c);
+CGM_LINKAGE mat4 camera_view(camera *c);
+CGM_LINKAGE mat4 camera_proj(camera *c);
+CGM_LINKAGE mat4 camera_view_proj(camera *c);
+CGM_LINKAGE mat4 camera_inv_view(camera *c);
+CGM_LINKAGE mat4 camera_inv_proj(camera *c);
+CGM_LINKAGE mat4 camera_inv_view_proj(camera *c);
+CGM_LINKAGE const vec4 *camera_frustum_planes(camera *c);
+CGM_LINKAGE mat4 camera_mvp(camera *c, mat4 model);
+
+// -----------------------------------------------------------------------------
+// Transform hierarchy functions
+// -----------------------------------------------------------------------------
+// Construction and destruction (init returns 0 if allocation failed)
+CGM_LINKAGE int transform_hierarchy_init(transform_hierarchy *h, int capacity);
+CGM_LINKAGE void transform_hierarchy_free(transform_hierarchy *h);
+
+// Append a node with identity components and return its index, or -1 if
+// allocation failed. The parent must be -1 or an existing node.
+CGM_LINKAGE int transform_hierarchy_add(transform_hierarchy *h, int parent);
+
+// Modifiers (mark the node dirty)
+CGM_LINKAGE void transform_hierarchy_set_translation(transform_hierarchy *h,
+                                                    int node, vec3 t);
+CGM_LINKAGE void transform_hierarchy_set_rotation(transform_hierarchy *h,
+                                                int node, vec4 q);
+CGM_LINKAGE void transform_hierarchy_set_scale(transform_hierarchy *h,
+                                            int node, vec3 s);
+
+// Recompute the world matrices of the dirty nodes and their descendants
+CGM_LINKAGE void transform_hierarchy_update(transform_hierarchy *h);
+CGM_LINKAGE void transform_hierarchy_update_mt(transform_hierarchy *h,
+                                            cgm_parallel_for_fn parallel_for,
+                                            void *scheduler);
+
+// World matrix access
+CGM_LINKAGE mat4 transform_hierarchy_world(const transform_hierarchy *h,
+                                        int node);
+
+// -----------------------------------------------------------------------------
+// Culling functions
+// -----------------------------------------------------------------------------
+// Test the bounding volumes against the frustum planes, write the indices of
+// the visible ones to visible (capacity count) and return their number. The
+// indices are written in ascending order.
+CGM_LINKAGE int frustum_cull_spheres(const vec4 planes[6], sphere_soa spheres,
+                                    int count, int *visible);
+CGM_LINKAGE int frustum_cull_aabbs(const vec4 planes[6], aabb_soa aabbs,
+                                int count, int *visible);
+
+// Same as above, split into chunks that are distributed by parallel_for
+CGM_LINKAGE int frustum_cull_spheres_mt(const vec4 planes[6],
+                                        sphere_soa spheres, int count,
+                                        int *visible,
+                                        cgm_parallel_for_fn parallel_for,
+                                        void *scheduler);
+CGM_LINKAGE int frustum_cull_aabbs_mt(const vec4 planes[6], aabb_soa aabbs,
+                                    int count, int *visible,
+                                    cgm_parallel_for_fn parallel_for,
+                                    void *scheduler);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -200,8 +396,211 @@ CGM_LINKAGE void mat4_print(mat4 m);
 
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if defined(__AVX2__) || defined(__SSE__)
+#include <immintrin.h>
+#endif // __AVX2__ || __SSE__
+
+#ifdef CGM_FAST_MATH
+#define CGM_SQRTF fast_sqrtf
+#define CGM_SINF fast_sinf
+#define CGM_COSF fast_cosf
+#define CGM_SINCOSF fast_sincosf
+#define CGM_TANF fast_tanf
+#else
+#define CGM_SQRTF sqrtf
+#define CGM_SINF sinf
+#define CGM_COSF cosf
+#define CGM_SINCOSF(x, s, c) (*(s) = sinf(x), *(c) = cosf(x))
+#define CGM_TANF tanf
+#endif // CGM_FAST_MATH
+
+// Number of bounding volumes per task of the multi-threaded culling kernels
+#define CGM_CULL_CHUNK_SIZE 16384
+
+// -----------------------------------------------------------------------------
+// Scalar functions
+// -----------------------------------------------------------------------------
+// Cody-Waite split of pi / 2 (the leading parts have trailing zero bits so that
+// k * part is exact for the supported range)
+#define CGM_PI_2_HI 1.5703125f
+#define CGM_PI_2_MID 4.837512969970703125e-4f
+#define CGM_PI_2_LO 7.54978995489188216e-8f
+#define CGM_2_OVER_PI 0.636619772367581343f
+
+// Minimax polynomials on [-pi / 4, pi / 4] (Cephes)
+#define CGM_SIN_C1 -1.6666654611e-1f
+#define CGM_SIN_C2 8.3321608736e-3f
+#define CGM_SIN_C3 -1.9515295891e-4f
+#define CGM_COS_C1 4.166664568298827e-2f
+#define CGM_COS_C2 -1.388731625493765e-3f
+#define CGM_COS_C3 2.443315711809948e-5f
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void fast_sincosf(float x, float *s, float *c)
+{
+    // Reduce to r in [-pi / 4, pi / 4] and the quadrant k
+#ifdef __SSE__
+    int quadrant = _mm_cvtss_si32(_mm_set_ss(x * CGM_2_OVER_PI));
+#else
+    int quadrant = (int) lrintf(x * CGM_2_OVER_PI);
+#endif // __SSE__
+    float k = (float) quadrant;
+    float r = x - k * CGM_PI_2_HI;
+    r -= k * CGM_PI_2_MID;
+    r -= k * CGM_PI_2_LO;
+    quadrant &= 3;
+
+    float r2 = r * r;
+    float sin_r = r + r * r2 * (CGM_SIN_C1 + r2 * (CGM_SIN_C2 +
+                                                r2 * CGM_SIN_C3));
+    float cos_r = 1.0f - 0.5f * r2 + r2 * r2 * (CGM_COS_C1 + r2 *
+                                            (CGM_COS_C2 + r2 * CGM_COS_C3));
+
+    // Odd quadrants swap sine and cosine, bit 1 of the quadrant negates the
+    // sine and bit 1 of the next quadrant negates the cosine. Selecting
+    // without branches avoids mispredictions on unordered input.
+    float sin_x = (quadrant & 1) ? cos_r : sin_r;
+    float cos_x = (quadrant & 1) ? sin_r : cos_r;
+    union { float f; unsigned int i; } us = {sin_x}, uc = {cos_x};
+    us.i ^= (unsigned int) (quadrant & 2) << 30;
+    uc.i ^= (unsigned int) ((quadrant + 1) & 2) << 30;
+    *s = us.f;
+    *c = uc.f;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE float fast_sinf(float x)
+{
+    float s, c;
+    fast_sincosf(x, &s, &c);
+    return s;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE float fast_cosf(float x)
+{
+    float s, c;
+    fast_sincosf(x, &s, &c);
+    return c;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE float fast_tanf(float x)
+{
+    float s, c;
+    fast_sincosf(x, &s, &c);
+    return s / c;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE float fast_rsqrtf(float x)
+{
+#ifdef __SSE__
+    float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return y * (1.5f - 0.5f * x * y * y);
+#else
+    // Bit level estimate refined by two Newton steps
+    union { float f; unsigned int i; } u;
+    u.f = x;
+    u.i = 0x5f375a86u - (u.i >> 1);
+    float y = u.f;
+    y = y * (1.5f - 0.5f * x * y * y);
+    return y * (1.5f - 0.5f * x * y * y);
+#endif // __SSE__
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE float fast_sqrtf(float x)
+{
+    return x > 0.0f ? x * fast_rsqrtf(x) : 0.0f;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void fast_sincosf_n(const float *in, float *s, float *c, int n)
+{
+    int i = 0;
+
+#if defined(__AVX2__) && defined(__FMA__)
+    const __m256 two_over_pi = _mm256_set1_ps(CGM_2_OVER_PI);
+    const __m256 pi_2_hi = _mm256_set1_ps(CGM_PI_2_HI);
+    const __m256 pi_2_mid = _mm256_set1_ps(CGM_PI_2_MID);
+    const __m256 pi_2_lo = _mm256_set1_ps(CGM_PI_2_LO);
+    const __m256 sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32(
+                                                (int) 0x80000000u));
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(in + i);
+        __m256 k = _mm256_round_ps(_mm256_mul_ps(x, two_over_pi),
+                                _MM_FROUND_TO_NEAREST_INT |
+                                _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(k, pi_2_hi, x);
+        r = _mm256_fnmadd_ps(k, pi_2_mid, r);
+        r = _mm256_fnmadd_ps(k, pi_2_lo, r);
+        __m256i quadrant = _mm256_cvtps_epi32(k);
+
+        __m256 r2 = _mm256_mul_ps(r, r);
+        __m256 sin_r = _mm256_fmadd_ps(r2, _mm256_set1_ps(CGM_SIN_C3),
+                                    _mm256_set1_ps(CGM_SIN_C2));
+        sin_r = _mm256_fmadd_ps(r2, sin_r, _mm256_set1_ps(CGM_SIN_C1));
+        sin_r = _mm256_fmadd_ps(_mm256_mul_ps(r, r2), sin_r, r);
+        __m256 cos_r = _mm256_fmadd_ps(r2, _mm256_set1_ps(CGM_COS_C3),
+                                    _mm256_set1_ps(CGM_COS_C2));
+        cos_r = _mm256_fmadd_ps(r2, cos_r, _mm256_set1_ps(CGM_COS_C1));
+        cos_r = _mm256_mul_ps(_mm256_mul_ps(r2, r2), cos_r);
+        cos_r = _mm256_add_ps(_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2,
+                                            _mm256_set1_ps(1.0f)), cos_r);
+
+        // Odd quadrants swap sine and cosine, the signs follow bit 1 of
+        // k for the sine and bit 1 of k + 1 for the cosine
+        __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+            _mm256_and_si256(quadrant, _mm256_set1_epi32(1)),
+            _mm256_set1_epi32(1)));
+        __m256 sin_x = _mm256_blendv_ps(sin_r, cos_r, swap);
+        __m256 cos_x = _mm256_blendv_ps(cos_r, sin_r, swap);
+        __m256 sin_sign = _mm256_castsi256_ps(_mm256_slli_epi32(
+            _mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+        __m256 cos_sign = _mm256_castsi256_ps(_mm256_slli_epi32(
+            _mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)),
+                            _mm256_set1_epi32(2)), 30));
+        _mm256_storeu_ps(s + i, _mm256_xor_ps(sin_x,
+                                            _mm256_and_ps(sin_sign,
+                                                        sign_mask)));
+        _mm256_storeu_ps(c + i, _mm256_xor_ps(cos_x,
+                                            _mm256_and_ps(cos_sign,
+                                                        sign_mask)));
+    }
+#endif // __AVX2__ && __FMA__
+
+    for (; i < n; i++) {
+        fast_sincosf(in[i], s + i, c + i);
+    }
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void fast_rsqrtf_n(const float *in, float *out, int n)
+{
+    int i = 0;
+
+#ifdef __AVX2__
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three_halves = _mm256_set1_ps(1.5f);
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(in + i);
+        __m256 y = _mm256_rsqrt_ps(x);
+        __m256 hxyy = _mm256_mul_ps(_mm256_mul_ps(half, x),
+                                    _mm256_mul_ps(y, y));
+        _mm256_storeu_ps(out + i,
+                        _mm256_mul_ps(y, _mm256_sub_ps(three_halves, hxyy)));
+    }
+#endif // __AVX2__
+
+    for (; i < n; i++) {
+        out[i] = fast_rsqrtf(in[i]);
+    }
+}
+
 // -----------------------------------------------------------------------------
 // Vector functions
 // -----------------------------------------------------------------------------
@@ -573,7 +972,7 @@ CGM_LINKAGE float vec2_dot_vec2(vec2 v1, vec2 v2)
 // -----------------------------------------------------------------------------
 CGM_LINKAGE float vec2_length(vec2 v)
 {
-    return sqrtf(v.x * v.x + v.y * v.y);
+    return CGM_SQRTF(v.x * v.x + v.y * v.y);
 }
 
 // -----------------------------------------------------------------------------
@@ -585,6 +984,13 @@ CGM_LINKAGE float vec2_sq_length(vec2 v)
 // -----------------------------------------------------------------------------
 CGM_LINKAGE vec2 vec2_normalize(vec2 v)
 {
+#ifdef CGM_FAST_MATH
+    float sq_length = vec2_sq_length(v);
+    if (sq_length < CGM_ALMOST_ZERO * CGM_ALMOST_ZERO) {
+        return vec2_2f(0.0f, 0.0f);
+    }
+    return vec2_mul_f(v, fast_rsqrtf(sq_length));
+#else
     vec2 r;
     float length = vec2_length(v);
     if (length < CGM_ALMOST_ZERO) {
@@ -593,6 +999,7 @@ CGM_LINKAGE vec2 vec2_normalize(vec2 v)
     r.x = v.x / length;
     r.y = v.y / length;
     return r;
+#endif // CGM_FAST_MATH
 }
 
 // -----------------------------------------------------------------------------
@@ -613,7 +1020,7 @@ CGM_LINKAGE float vec3_dot_vec3(vec3 v1, vec3 v2)
 // -----------------------------------------------------------------------------
 CGM_LINKAGE float vec3_length(vec3 v)
 {
-    return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+    return CGM_SQRTF(v.x * v.x + v.y * v.y + v.z * v.z);
 }
 
 // -----------------------------------------------------------------------------
@@ -625,6 +1032,13 @@ CGM_LINKAGE float vec3_sq_length(vec3 v)
 // -----------------------------------------------------------------------------
 CGM_LINKAGE vec3 vec3_normalize(vec3 v)
 {
+#ifdef CGM_FAST_MATH
+    float sq_length = vec3_sq_length(v);
+    if (sq_length < CGM_ALMOST_ZERO * CGM_ALMOST_ZERO) {
+        return vec3_3f(0.0f, 0.0f, 0.0f);
+    }
+    return vec3_mul_f(v, fast_rsqrtf(sq_length));
+#else
     vec3 r;
     float length = vec3_length(v);
     if (length < CGM_ALMOST_ZERO) {
@@ -634,6 +1048,7 @@ CGM_LINKAGE vec3 vec3_normalize(vec3 v)
     r.y = v.y / length;
     r.z = v.z / length;
     return r;
+#endif // CGM_FAST_MATH
 }
 
 // -----------------------------------------------------------------------------
@@ -654,7 +1069,7 @@ CGM_LINKAGE float vec4_dot_vec4(vec4 v1, vec4 v2)
 // -----------------------------------------------------------------------------
 CGM_LINKAGE float vec4_length(vec4 v)
 {
-    return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
+    return CGM_SQRTF(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
 }
 
 // -----------------------------------------------------------------------------
@@ -666,6 +1081,13 @@ CGM_LINKAGE float vec4_sq_length(vec4 v)
 // -----------------------------------------------------------------------------
 CGM_LINKAGE vec4 vec4_normalize(vec4 v)
 {
+#ifdef CGM_FAST_MATH
+    float sq_length = vec4_sq_length(v);
+    if (sq_length < CGM_ALMOST_ZERO * CGM_ALMOST_ZERO) {
+        return vec4_4f(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+    return vec4_mul_f(v, fast_rsqrtf(sq_length));
+#else
     vec4 r;
     float length = vec4_length(v);
     if (length < CGM_ALMOST_ZERO) {
@@ -676,6 +1098,7 @@ CGM_LINKAGE vec4 vec4_normalize(vec4 v)
     r.z = v.z / length;
     r.w = v.w / length;
     return r;
+#endif // CGM_FAST_MATH
 }
 
 // -----------------------------------------------------------------------------
@@ -1026,9 +1449,9 @@ CGM_LINKAGE mat4 mat4_rotate(vec3 axis, float rad)
     float z = axis.z;
 
     // Rodrigues rotation formula
-    float c = cosf(rad);
-    float s = sinf(rad);
-    float tmp = sinf(rad / 2.0f);
+    float c, s;
+    CGM_SINCOSF(rad, &s, &c);
+    float tmp = CGM_SINF(rad / 2.0f);
     float t = 2.0f * tmp * tmp; // 1.0f - cosf(rad);
     mat4 r;
     r.m[0] = t * x * x + c;
@@ -1053,33 +1476,39 @@ CGM_LINKAGE mat4 mat4_rotate(vec3 axis, float rad)
 // -----------------------------------------------------------------------------
 CGM_LINKAGE mat4 mat4_rotate_x(float rad)
 {
+    float c, s;
+    CGM_SINCOSF(rad, &s, &c);
     mat4 r = mat4_identity();
-    r.m[5] = cosf(rad);
-    r.m[6] = sinf(rad);
-    r.m[9] = -sinf(rad);
-    r.m[10] = cosf(rad);
+    r.m[5] = c;
+    r.m[6] = s;
+    r.m[9] = -s;
+    r.m[10] = c;
     return r;
 }
 
 // -----------------------------------------------------------------------------
 CGM_LINKAGE mat4 mat4_rotate_y(float rad)
 {
+    float c, s;
+    CGM_SINCOSF(rad, &s, &c);
     mat4 r = mat4_identity();
-    r.m[0] = cosf(rad);
-    r.m[2] = -sinf(rad);
-    r.m[8] = sinf(rad);
-    r.m[10] = cosf(rad);
+    r.m[0] = c;
+    r.m[2] = -s;
+    r.m[8] = s;
+    r.m[10] = c;
     return r;
 }
 
 // -----------------------------------------------------------------------------
 CGM_LINKAGE mat4 mat4_rotate_z(float rad)
 {
+    float c, s;
+    CGM_SINCOSF(rad, &s, &c);
     mat4 r = mat4_identity();
-    r.m[0] = cosf(rad);
-    r.m[1] = sinf(rad);
-    r.m[4] = -sinf(rad);
-    r.m[5] = cosf(rad);
+    r.m[0] = c;
+    r.m[1] = s;
+    r.m[4] = -s;
+    r.m[5] = c;
     return r;
 }
 
@@ -1103,6 +1532,34 @@ CGM_LINKAGE mat4 mat4_translate(vec3 v)
     return r;
 }
 
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 mat4_trs(vec3 translation, vec4 rotation, vec3 scale)
+{
+    float x = rotation.x;
+    float y = rotation.y;
+    float z = rotation.z;
+    float w = rotation.w;
+
+    mat4 r;
+    r.m[0] = (1.0f - 2.0f * (y * y + z * z)) * scale.x;
+    r.m[1] = 2.0f * (x * y + w * z) * scale.x;
+    r.m[2] = 2.0f * (x * z - w * y) * scale.x;
+    r.m[3] = 0.0f;
+    r.m[4] = 2.0f * (x * y - w * z) * scale.y;
+    r.m[5] = (1.0f - 2.0f * (x * x + z * z)) * scale.y;
+    r.m[6] = 2.0f * (y * z + w * x) * scale.y;
+    r.m[7] = 0.0f;
+    r.m[8] = 2.0f * (x * z + w * y) * scale.z;
+    r.m[9] = 2.0f * (y * z - w * x) * scale.z;
+    r.m[10] = (1.0f - 2.0f * (x * x + y * y)) * scale.z;
+    r.m[11] = 0.0f;
+    r.m[12] = translation.x;
+    r.m[13] = translation.y;
+    r.m[14] = translation.z;
+    r.m[15] = 1.0f;
+    return r;
+}
+
 // -----------------------------------------------------------------------------
 CGM_LINKAGE mat4 mat4_frustum(float left, float right, float bottom, float top,
                             float near, float far)
@@ -1163,7 +1620,7 @@ CGM_LINKAGE mat4 mat4_perspective(float fovy, float aspect, float near,
                                 float far)
 {
     float fovy_rad = CGM_ONE_DEG_IN_RAD * fovy;
-    float range = tanf(fovy_rad / 2.0f) * near;
+    float range = CGM_TANF(fovy_rad / 2.0f) * near;
     float s_x = (2.0f * near) / (range * aspect + range * aspect);
     float s_y = near / range;
     float s_z = -(far + near) / (far - near);
@@ -1178,6 +1635,30 @@ CGM_LINKAGE mat4 mat4_perspective(float fovy, float aspect, float near,
     return r;
 }
 
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void mat4_frustum_planes(mat4 m, vec4 planes[6])
+{
+    // Gribb/Hartmann extraction from the rows of the combined matrix
+    vec4 row0 = mat4_row(m, 0);
+    vec4 row1 = mat4_row(m, 1);
+    vec4 row2 = mat4_row(m, 2);
+    vec4 row3 = mat4_row(m, 3);
+    planes[CGM_FRUSTUM_LEFT] = vec4_add_vec4(row3, row0);
+    planes[CGM_FRUSTUM_RIGHT] = vec4_sub_vec4(row3, row0);
+    planes[CGM_FRUSTUM_BOTTOM] = vec4_add_vec4(row3, row1);
+    planes[CGM_FRUSTUM_TOP] = vec4_sub_vec4(row3, row1);
+    planes[CGM_FRUSTUM_NEAR] = vec4_add_vec4(row3, row2);
+    planes[CGM_FRUSTUM_FAR] = vec4_sub_vec4(row3, row2);
+
+    // Normalize so that plane distances are in world units
+    for (int i = 0; i < 6; i++) {
+        float length = vec3_length(vec3_vec4(planes[i]));
+        if (length >= CGM_ALMOST_ZERO) {
+            planes[i] = vec4_div_f(planes[i], length);
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 CGM_LINKAGE void mat4_print(mat4 m)
 {
@@ -1187,4 +1668,731 @@ CGM_LINKAGE void mat4_print(mat4 m)
     printf("(%.4f %.4f %.4f %.4f)", m.m[3], m.m[7], m.m[11], m.m[15]);
 }
 
+// -----------------------------------------------------------------------------
+// Quaternion functions
+// -----------------------------------------------------------------------------
+CGM_LINKAGE vec4 quat_identity()
+{
+    return vec4_4f(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE vec4 quat_axis_angle(vec3 axis, float rad)
+{
+    vec3 a = vec3_normalize(axis);
+    float s, c;
+    CGM_SINCOSF(rad / 2.0f, &s, &c);
+    return vec4_4f(a.x * s, a.y * s, a.z * s, c);
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE vec4 quat_mul_quat(vec4 q1, vec4 q2)
+{
+    vec4 r;
+    r.x = q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y;
+    r.y = q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x;
+    r.z = q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w;
+    r.w = q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z;
+    return r;
+}
+
+// -----------------------------------------------------------------------------
+// Camera functions
+// -----------------------------------------------------------------------------
+CGM_LINKAGE camera camera_perspective(vec3 eye, vec3 center, vec3 up,
+                                    float fovy, float aspect, float near,
+                                    float far)
+{
+    camera c;
+    memset(&c, 0, sizeof(camera));
+    camera_set_look_at(&c, eye, center, up);
+    camera_set_perspective(&c, fovy, aspect, near, far);
+    return c;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void camera_set_look_at(camera *c, vec3 eye, vec3 center, vec3 up)
+{
+    c->eye = eye;
+    c->center = center;
+    c->up = up;
+    c->dirty |= CGM_CAMERA_VIEW_DIRTY;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void camera_set_perspective(camera *c, float fovy, float aspect,
+                                    float near, float far)
+{
+    c->fovy = fovy;
+    c->aspect = aspect;
+    c->near = near;
+    c->far = far;
+    c->dirty |= CGM_CAMERA_PROJ_DIRTY;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void camera_set_aspect(camera *c, float aspect)
+{
+    if (c->aspect != aspect) {
+        c->aspect = aspect;
+        c->dirty |= CGM_CAMERA_PROJ_DIRTY;
+    }
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void camera_update(camera *c)
+{
+    if (!c->dirty) {
+        return;
+    }
+
+    if (c->dirty & CGM_CAMERA_VIEW_DIRTY) {
+        c->view = mat4_look_at(c->eye, c->center, c->up);
+        c->inv_view = mat4_invert(c->view);
+    }
+    if (c->dirty & CGM_CAMERA_PROJ_DIRTY) {
+        c->proj = mat4_perspective(c->fovy, c->aspect, c->near, c->far);
+        c->inv_proj = mat4_invert(c->proj);
+    }
+
+    // Either change invalidates everything that depends on both matrices
+    c->view_proj = mat4_mul_mat4(c->proj, c->view);
+    c->inv_view_proj = mat4_mul_mat4(c->inv_view, c->inv_proj);
+    mat4_frustum_planes(c->view_proj, c->planes);
+    c->dirty = 0;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 camera_view(camera *c)
+{
+    camera_update(c);
+    return c->view;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 camera_proj(camera *c)
+{
+    camera_update(c);
+    return c->proj;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 camera_view_proj(camera *c)
+{
+    camera_update(c);
+    return c->view_proj;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 camera_inv_view(camera *c)
+{
+    camera_update(c);
+    return c->inv_view;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 camera_inv_proj(camera *c)
+{
+    camera_update(c);
+    return c->inv_proj;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 camera_inv_view_proj(camera *c)
+{
+    camera_update(c);
+    return c->inv_view_proj;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE const vec4 *camera_frustum_planes(camera *c)
+{
+    camera_update(c);
+    return c->planes;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 camera_mvp(camera *c, mat4 model)
+{
+    camera_update(c);
+    return mat4_mul_mat4(c->view_proj, model);
+}
+
+// -----------------------------------------------------------------------------
+// Transform hierarchy functions
+// -----------------------------------------------------------------------------
+// Minimum number of independent subtrees the parallel update splits the
+// hierarchy into
+#define CGM_TRANSFORM_MIN_GROUPS 64
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE int transform_hierarchy_init(transform_hierarchy *h, int capacity)
+{
+    memset(h, 0, sizeof(transform_hierarchy));
+    if (capacity < 16) {
+        capacity = 16;
+    }
+    h->parent = malloc(capacity * sizeof(int));
+    h->translation = malloc(capacity * sizeof(vec3));
+    h->rotation = malloc(capacity * sizeof(vec4));
+    h->scale = malloc(capacity * sizeof(vec3));
+    h->world = malloc(capacity * sizeof(mat4));
+    h->flags = malloc(capacity * sizeof(unsigned char));
+    if (!(h->parent && h->translation && h->rotation && h->scale &&
+        h->world && h->flags)) {
+        transform_hierarchy_free(h);
+        return 0;
+    }
+    h->capacity = capacity;
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void transform_hierarchy_free(transform_hierarchy *h)
+{
+    free(h->parent);
+    free(h->translation);
+    free(h->rotation);
+    free(h->scale);
+    free(h->world);
+    free(h->flags);
+    free(h->order);
+    free(h->group_begin);
+    memset(h, 0, sizeof(transform_hierarchy));
+}
+
+// -----------------------------------------------------------------------------
+static int cgm_grow(void **array, int capacity, size_t element_size)
+{
+    void *p = realloc(*array, capacity * element_size);
+    if (!p) {
+        return 0;
+    }
+    *array = p;
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE int transform_hierarchy_add(transform_hierarchy *h, int parent)
+{
+    if (parent >= h->count) {
+        return -1;
+    }
+
+    if (h->count == h->capacity) {
+        int capacity = 2 * h->capacity;
+        if (!(cgm_grow((void **) &h->parent, capacity, sizeof(int)) &&
+            cgm_grow((void **) &h->translation, capacity, sizeof(vec3)) &&
+            cgm_grow((void **) &h->rotation, capacity, sizeof(vec4)) &&
+            cgm_grow((void **) &h->scale, capacity, sizeof(vec3)) &&
+            cgm_grow((void **) &h->world, capacity, sizeof(mat4)) &&
+            cgm_grow((void **) &h->flags, capacity, sizeof(unsigned char)))) {
+            return -1;
+        }
+        h->capacity = capacity;
+    }
+
+    int node = h->count++;
+    h->parent[node] = parent;
+    h->translation[node] = vec3_3f(0.0f, 0.0f, 0.0f);
+    h->rotation[node] = quat_identity();
+    h->scale[node] = vec3_3f(1.0f, 1.0f, 1.0f);
+    h->flags[node] = CGM_TRANSFORM_DIRTY;
+    h->any_dirty = 1;
+    h->schedule_valid = 0;
+    return node;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void transform_hierarchy_set_translation(transform_hierarchy *h,
+                                                    int node, vec3 t)
+{
+    h->translation[node] = t;
+    h->flags[node] |= CGM_TRANSFORM_DIRTY;
+    h->any_dirty = 1;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void transform_hierarchy_set_rotation(transform_hierarchy *h,
+                                                int node, vec4 q)
+{
+    h->rotation[node] = q;
+    h->flags[node] |= CGM_TRANSFORM_DIRTY;
+    h->any_dirty = 1;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void transform_hierarchy_set_scale(transform_hierarchy *h,
+                                            int node, vec3 s)
+{
+    h->scale[node] = s;
+    h->flags[node] |= CGM_TRANSFORM_DIRTY;
+    h->any_dirty = 1;
+}
+
+// -----------------------------------------------------------------------------
+static void cgm_update_node(transform_hierarchy *h, int node)
+{
+    // A node is recomputed if its own components changed or if its parent's
+    // world matrix was recomputed earlier in this pass
+    int parent = h->parent[node];
+    unsigned char flags = h->flags[node];
+    if (!(flags & CGM_TRANSFORM_DIRTY) &&
+        !(parent >= 0 && (h->flags[parent] & CGM_TRANSFORM_UPDATED))) {
+        h->flags[node] = 0;
+        return;
+    }
+
+    mat4 local = mat4_trs(h->translation[node], h->rotation[node],
+                        h->scale[node]);
+    h->world[node] = parent >= 0 ? mat4_mul_mat4(h->world[parent], local)
+                                : local;
+    h->flags[node] = CGM_TRANSFORM_UPDATED;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void transform_hierarchy_update(transform_hierarchy *h)
+{
+    if (!h->any_dirty) {
+        return;
+    }
+    for (int node = 0; node < h->count; node++) {
+        cgm_update_node(h, node);
+    }
+    h->any_dirty = 0;
+}
+
+// -----------------------------------------------------------------------------
+static int cgm_build_transform_schedule(transform_hierarchy *h)
+{
+    int n = h->count;
+    int *depth = malloc(n * sizeof(int));
+    int *group = malloc(n * sizeof(int));
+    int *order = realloc(h->order, n * sizeof(int));
+    if (order) {
+        h->order = order;
+    }
+    if (!(depth && group && order)) {
+        free(depth);
+        free(group);
+        return 0;
+    }
+
+    // Node depths and the number of nodes per depth
+    int max_depth = 0;
+    for (int node = 0; node < n; node++) {
+        int parent = h->parent[node];
+        depth[node] = parent >= 0 ? depth[parent] + 1 : 0;
+        if (depth[node] > max_depth) {
+            max_depth = depth[node];
+        }
+    }
+    int *depth_count = calloc(max_depth + 1, sizeof(int));
+    if (!depth_count) {
+        free(depth);
+        free(group);
+        return 0;
+    }
+    for (int node = 0; node < n; node++) {
+        depth_count[depth[node]]++;
+    }
+
+    // Split at the shallowest depth that provides enough independent
+    // subtrees. Everything above it forms the serial head.
+    int split = 0;
+    while (split < max_depth && depth_count[split] < CGM_TRANSFORM_MIN_GROUPS) {
+        split++;
+    }
+    int num_groups = depth_count[split];
+    free(depth_count);
+
+    int *group_begin = realloc(h->group_begin, (num_groups + 2) * sizeof(int));
+    if (!group_begin) {
+        free(depth);
+        free(group);
+        return 0;
+    }
+    h->group_begin = group_begin;
+
+    // Assign every node below the split to the group of its ancestor at the
+    // split depth and count the group sizes
+    memset(group_begin, 0, (num_groups + 2) * sizeof(int));
+    int next_group = 0;
+    int num_serial = 0;
+    for (int node = 0; node < n; node++) {
+        if (depth[node] < split) {
+            group[node] = -1;
+            num_serial++;
+            continue;
+        }
+        group[node] = depth[node] == split ? next_group++
+                                        : group[h->parent[node]];
+        group_begin[group[node] + 2]++;
+    }
+
+    // Counting sort keeps the topological order within each group
+    group_begin[1] = num_serial;
+    for (int g = 2; g < num_groups + 2; g++) {
+        group_begin[g] += group_begin[g - 1];
+    }
+    int serial_pos = 0;
+    for (int node = 0; node < n; node++) {
+        if (group[node] < 0) {
+            order[serial_pos++] = node;
+        } else {
+            order[group_begin[group[node] + 1]++] = node;
+        }
+    }
+    // group_begin[g + 1] now holds the end of group g
+    group_begin[0] = num_serial;
+
+    h->num_serial = num_serial;
+    h->num_groups = num_groups;
+    h->schedule_valid = 1;
+    free(depth);
+    free(group);
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+static void cgm_update_transform_group(void *arg, int g)
+{
+    transform_hierarchy *h = arg;
+    for (int i = h->group_begin[g]; i < h->group_begin[g + 1]; i++) {
+        cgm_update_node(h, h->order[i]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE void transform_hierarchy_update_mt(transform_hierarchy *h,
+                                            cgm_parallel_for_fn parallel_for,
+                                            void *scheduler)
+{
+    if (!h->any_dirty) {
+        return;
+    }
+    if (!parallel_for ||
+        (!h->schedule_valid && !cgm_build_transform_schedule(h))) {
+        transform_hierarchy_update(h);
+        return;
+    }
+
+    for (int i = 0; i < h->num_serial; i++) {
+        cgm_update_node(h, h->order[i]);
+    }
+    parallel_for(scheduler, h->num_groups, cgm_update_transform_group, h);
+    h->any_dirty = 0;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE mat4 transform_hierarchy_world(const transform_hierarchy *h,
+                                        int node)
+{
+    return h->world[node];
+}
+
+// -----------------------------------------------------------------------------
+// Culling functions
+// -----------------------------------------------------------------------------
+// The kernels write every candidate index unconditionally and only advance the
+// output position for visible ones, which keeps the compaction branch free.
+// This requires visible to have room for count entries.
+#if defined(__AVX2__) && defined(__FMA__)
+// For every 8-bit lane mask, the lanes of the set bits in 3 bits each from the
+// lowest, and the number of set bits in bits 24 to 27
+static const unsigned int cgm_compact_lanes[256] = {
+    0x00000000, 0x01000000, 0x01000001, 0x02000008, 0x01000002, 0x02000010,
+    0x02000011, 0x03000088, 0x01000003, 0x02000018, 0x02000019, 0x030000c8,
+    0x0200001a, 0x030000d0, 0x030000d1, 0x04000688, 0x01000004, 0x02000020,
+    0x02000021, 0x03000108, 0x02000022, 0x03000110, 0x03000111, 0x04000888,
+    0x02000023, 0x03000118, 0x03000119, 0x040008c8, 0x0300011a, 0x040008d0,
+    0x040008d1, 0x05004688, 0x01000005, 0x02000028, 0x02000029, 0x03000148,
+    0x0200002a, 0x03000150, 0x03000151, 0x04000a88, 0x0200002b, 0x03000158,
+    0x03000159, 0x04000ac8, 0x0300015a, 0x04000ad0, 0x04000ad1, 0x05005688,
+    0x0200002c, 0x03000160, 0x03000161, 0x04000b08, 0x03000162, 0x04000b10,
+    0x04000b11, 0x05005888, 0x03000163, 0x04000b18, 0x04000b19, 0x050058c8,
+    0x04000b1a, 0x050058d0, 0x050058d1, 0x0602c688, 0x01000006, 0x02000030,
+    0x02000031, 0x03000188, 0x02000032, 0x03000190, 0x03000191, 0x04000c88,
+    0x02000033, 0x03000198, 0x03000199, 0x04000cc8, 0x0300019a, 0x04000cd0,
+    0x04000cd1, 0x05006688, 0x02000034, 0x030001a0, 0x030001a1, 0x04000d08,
+    0x030001a2, 0x04000d10, 0x04000d11, 0x05006888, 0x030001a3, 0x04000d18,
+    0x04000d19, 0x050068c8, 0x04000d1a, 0x050068d0, 0x050068d1, 0x06034688,
+    0x02000035, 0x030001a8, 0x030001a9, 0x04000d48, 0x030001aa, 0x04000d50,
+    0x04000d51, 0x05006a88, 0x030001ab, 0x04000d58, 0x04000d59, 0x05006ac8,
+    0x04000d5a, 0x05006ad0, 0x05006ad1, 0x06035688, 0x030001ac, 0x04000d60,
+    0x04000d61, 0x05006b08, 0x04000d62, 0x05006b10, 0x05006b11, 0x06035888,
+    0x04000d63, 0x05006b18, 0x05006b19, 0x060358c8, 0x05006b1a, 0x060358d0,
+    0x060358d1, 0x071ac688, 0x01000007, 0x02000038, 0x02000039, 0x030001c8,
+    0x0200003a, 0x030001d0, 0x030001d1, 0x04000e88, 0x0200003b, 0x030001d8,
+    0x030001d9, 0x04000ec8, 0x030001da, 0x04000ed0, 0x04000ed1, 0x05007688,
+    0x0200003c, 0x030001e0, 0x030001e1, 0x04000f08, 0x030001e2, 0x04000f10,
+    0x04000f11, 0x05007888, 0x030001e3, 0x04000f18, 0x04000f19, 0x050078c8,
+    0x04000f1a, 0x050078d0, 0x050078d1, 0x0603c688, 0x0200003d, 0x030001e8,
+    0x030001e9, 0x04000f48, 0x030001ea, 0x04000f50, 0x04000f51, 0x05007a88,
+    0x030001eb, 0x04000f58, 0x04000f59, 0x05007ac8, 0x04000f5a, 0x05007ad0,
+    0x05007ad1, 0x0603d688, 0x030001ec, 0x04000f60, 0x04000f61, 0x05007b08,
+    0x04000f62, 0x05007b10, 0x05007b11, 0x0603d888, 0x04000f63, 0x05007b18,
+    0x05007b19, 0x0603d8c8, 0x05007b1a, 0x0603d8d0, 0x0603d8d1, 0x071ec688,
+    0x0200003e, 0x030001f0, 0x030001f1, 0x04000f88, 0x030001f2, 0x04000f90,
+    0x04000f91, 0x05007c88, 0x030001f3, 0x04000f98, 0x04000f99, 0x05007cc8,
+    0x04000f9a, 0x05007cd0, 0x05007cd1, 0x0603e688, 0x030001f4, 0x04000fa0,
+    0x04000fa1, 0x05007d08, 0x04000fa2, 0x05007d10, 0x05007d11, 0x0603e888,
+    0x04000fa3, 0x05007d18, 0x05007d19, 0x0603e8c8, 0x05007d1a, 0x0603e8d0,
+    0x0603e8d1, 0x071f4688, 0x030001f5, 0x04000fa8, 0x04000fa9, 0x05007d48,
+    0x04000faa, 0x05007d50, 0x05007d51, 0x0603ea88, 0x04000fab, 0x05007d58,
+    0x05007d59, 0x0603eac8, 0x05007d5a, 0x0603ead0, 0x0603ead1, 0x071f5688,
+    0x04000fac, 0x05007d60, 0x05007d61, 0x0603eb08, 0x05007d62, 0x0603eb10,
+    0x0603eb11, 0x071f5888, 0x05007d63, 0x0603eb18, 0x0603eb19, 0x071f58c8,
+    0x0603eb1a, 0x071f58d0, 0x071f58d1, 0x08fac688
+};
+
+// -----------------------------------------------------------------------------
+// Write the indices of the lanes in mask, first at visible, with one store of
+// 8 lanes, and return their number
+static int cgm_compact_indices(int first, int mask, int *visible)
+{
+    const __m256i lane_shifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    unsigned int lanes = cgm_compact_lanes[mask];
+    __m256i permutation = _mm256_and_si256(
+        _mm256_srlv_epi32(_mm256_set1_epi32((int) lanes), lane_shifts),
+        _mm256_set1_epi32(7));
+    __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(first),
+                                    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    _mm256_storeu_si256((__m256i *) visible,
+                        _mm256_permutevar8x32_epi32(indices, permutation));
+    return (int) (lanes >> 24);
+}
+#endif // __AVX2__ && __FMA__
+
+// -----------------------------------------------------------------------------
+static int cgm_cull_spheres_range(const vec4 planes[6], sphere_soa s,
+                                int begin, int end, int *visible)
+{
+    int num_visible = 0;
+    int i = begin;
+
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 pa[6], pb[6], pc[6], pd[6];
+    for (int p = 0; p < 6; p++) {
+        pa[p] = _mm256_set1_ps(planes[p].x);
+        pb[p] = _mm256_set1_ps(planes[p].y);
+        pc[p] = _mm256_set1_ps(planes[p].z);
+        pd[p] = _mm256_set1_ps(planes[p].w);
+    }
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_loadu_ps(s.x + i);
+        __m256 y = _mm256_loadu_ps(s.y + i);
+        __m256 z = _mm256_loadu_ps(s.z + i);
+        __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(),
+                                    _mm256_loadu_ps(s.radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 dist = _mm256_fmadd_ps(pa[p], x, pd[p]);
+            dist = _mm256_fmadd_ps(pb[p], y, dist);
+            dist = _mm256_fmadd_ps(pc[p], z, dist);
+            inside = _mm256_and_ps(inside,
+                                _mm256_cmp_ps(dist, neg_r, _CMP_GE_OQ));
+        }
+        num_visible += cgm_compact_indices(i, _mm256_movemask_ps(inside),
+                                        visible + num_visible);
+    }
+#endif // __AVX2__ && __FMA__
+
+    for (; i < end; i++) {
+        int inside = 1;
+        for (int p = 0; p < 6; p++) {
+            float dist = planes[p].x * s.x[i] + planes[p].y * s.y[i] +
+                        planes[p].z * s.z[i] + planes[p].w;
+            inside &= dist >= -s.radius[i];
+        }
+        visible[num_visible] = i;
+        num_visible += inside;
+    }
+
+    return num_visible;
+}
+
+// -----------------------------------------------------------------------------
+static int cgm_cull_aabbs_range(const vec4 planes[6], aabb_soa b, int begin,
+                                int end, int *visible)
+{
+    int num_visible = 0;
+    int i = begin;
+
+#if defined(__AVX2__) && defined(__FMA__)
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 pa[6], pb[6], pc[6], pd[6];
+    __m256 abs_pa[6], abs_pb[6], abs_pc[6];
+    for (int p = 0; p < 6; p++) {
+        pa[p] = _mm256_set1_ps(planes[p].x);
+        pb[p] = _mm256_set1_ps(planes[p].y);
+        pc[p] = _mm256_set1_ps(planes[p].z);
+        pd[p] = _mm256_set1_ps(planes[p].w);
+        abs_pa[p] = _mm256_and_ps(pa[p], abs_mask);
+        abs_pb[p] = _mm256_and_ps(pb[p], abs_mask);
+        abs_pc[p] = _mm256_and_ps(pc[p], abs_mask);
+    }
+    for (; i + 8 <= end; i += 8) {
+        __m256 cx = _mm256_loadu_ps(b.center_x + i);
+        __m256 cy = _mm256_loadu_ps(b.center_y + i);
+        __m256 cz = _mm256_loadu_ps(b.center_z + i);
+        __m256 ex = _mm256_loadu_ps(b.extent_x + i);
+        __m256 ey = _mm256_loadu_ps(b.extent_y + i);
+        __m256 ez = _mm256_loadu_ps(b.extent_z + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            // Signed distance of the center plus the projected extent
+            __m256 dist = _mm256_fmadd_ps(pa[p], cx, pd[p]);
+            dist = _mm256_fmadd_ps(pb[p], cy, dist);
+            dist = _mm256_fmadd_ps(pc[p], cz, dist);
+            dist = _mm256_fmadd_ps(abs_pa[p], ex, dist);
+            dist = _mm256_fmadd_ps(abs_pb[p], ey, dist);
+            dist = _mm256_fmadd_ps(abs_pc[p], ez, dist);
+            inside = _mm256_and_ps(inside,
+                                _mm256_cmp_ps(dist, _mm256_setzero_ps(),
+                                            _CMP_GE_OQ));
+        }
+        num_visible += cgm_compact_indices(i, _mm256_movemask_ps(inside),
+                                        visible + num_visible);
+    }
+#endif // __AVX2__ && __FMA__
+
+    for (; i < end; i++) {
+        int inside = 1;
+        for (int p = 0; p < 6; p++) {
+            float dist =
+                planes[p].x * b.center_x[i] + planes[p].y * b.center_y[i] +
+                planes[p].z * b.center_z[i] + planes[p].w +
+                fabsf(planes[p].x) * b.extent_x[i] +
+                fabsf(planes[p].y) * b.extent_y[i] +
+                fabsf(planes[p].z) * b.extent_z[i];
+            inside &= dist >= 0.0f;
+        }
+        visible[num_visible] = i;
+        num_visible += inside;
+    }
+
+    return num_visible;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE int frustum_cull_spheres(const vec4 planes[6], sphere_soa spheres,
+                                    int count, int *visible)
+{
+    return cgm_cull_spheres_range(planes, spheres, 0, count, visible);
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE int frustum_cull_aabbs(const vec4 planes[6], aabb_soa aabbs,
+                                int count, int *visible)
+{
+    return cgm_cull_aabbs_range(planes, aabbs, 0, count, visible);
+}
+
+// -----------------------------------------------------------------------------
+typedef struct cgm_cull_job {
+    const vec4 *planes;
+    sphere_soa spheres;
+    aabb_soa aabbs;
+    int use_aabbs;
+    int count;
+    int *visible;
+    int *chunk_counts;
+} cgm_cull_job;
+
+// -----------------------------------------------------------------------------
+static void cgm_cull_chunk(void *arg, int chunk)
+{
+    cgm_cull_job *job = arg;
+    int begin = chunk * CGM_CULL_CHUNK_SIZE;
+    int end = begin + CGM_CULL_CHUNK_SIZE;
+    if (end > job->count) {
+        end = job->count;
+    }
+
+    // Every chunk compacts into its own slice of the output
+    if (job->use_aabbs) {
+        job->chunk_counts[chunk] = cgm_cull_aabbs_range(job->planes, job->aabbs,
+                                                    begin, end,
+                                                    job->visible + begin);
+    } else {
+        job->chunk_counts[chunk] =
+            cgm_cull_spheres_range(job->planes, job->spheres, begin, end,
+                                job->visible + begin);
+    }
+}
+
+// -----------------------------------------------------------------------------
+static int cgm_cull_mt(cgm_cull_job *job, cgm_parallel_for_fn parallel_for,
+                    void *scheduler)
+{
+    int num_chunks = (job->count + CGM_CULL_CHUNK_SIZE - 1) /
+                    CGM_CULL_CHUNK_SIZE;
+    job->chunk_counts = malloc(num_chunks * sizeof(int));
+    if (!job->chunk_counts) {
+        return -1;
+    }
+    parallel_for(scheduler, num_chunks, cgm_cull_chunk, job);
+
+    // Close the gaps between the chunk slices
+    int num_visible = job->chunk_counts[0];
+    for (int chunk = 1; chunk < num_chunks; chunk++) {
+        memmove(job->visible + num_visible,
+                job->visible + chunk * CGM_CULL_CHUNK_SIZE,
+                job->chunk_counts[chunk] * sizeof(int));
+        num_visible += job->chunk_counts[chunk];
+    }
+    free(job->chunk_counts);
+    job->chunk_counts = NULL;
+    return num_visible;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE int frustum_cull_spheres_mt(const vec4 planes[6],
+                                        sphere_soa spheres, int count,
+                                        int *visible,
+                                        cgm_parallel_for_fn parallel_for,
+                                        void *scheduler)
+{
+    if (count <= CGM_CULL_CHUNK_SIZE || !parallel_for) {
+        return frustum_cull_spheres(planes, spheres, count, visible);
+    }
+
+    cgm_cull_job job;
+    memset(&job, 0, sizeof(cgm_cull_job));
+    job.planes = planes;
+    job.spheres = spheres;
+    job.count = count;
+    job.visible = visible;
+    int num_visible = cgm_cull_mt(&job, parallel_for, scheduler);
+    if (num_visible < 0) {
+        return frustum_cull_spheres(planes, spheres, count, visible);
+    }
+    return num_visible;
+}
+
+// -----------------------------------------------------------------------------
+CGM_LINKAGE int frustum_cull_aabbs_mt(const vec4 planes[6], aabb_soa aabbs,
+                                    int count, int *visible,
+                                    cgm_parallel_for_fn parallel_for,
+                                    void *scheduler)
+{
+    if (count <= CGM_CULL_CHUNK_SIZE || !parallel_for) {
+        return frustum_cull_aabbs(planes, aabbs, count, visible);
+    }
+
+    cgm_cull_job job;
+    memset(&job, 0, sizeof(cgm_cull_job));
+    job.planes = planes;
+    job.aabbs = aabbs;
+    job.use_aabbs = 1;
+    job.count = count;
+    job.visible = visible;
+    int num_visible = cgm_cull_mt(&job, parallel_for, scheduler);
+    if (num_visible < 0) {
+        return frustum_cull_aabbs(planes, aabbs, count, visible);
+    }
+    return num_visible;
+}
+
 #endif // CGM_IMPLEMENTATION
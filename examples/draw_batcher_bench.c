@@ -0,0 +1,359 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-present Lars Schütz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ******************************************************************************/
+/*
+ * Compare the draw batcher against issuing the same draws one at a time.
+ *
+ * Usage: draw_batcher_bench [-n draws] [-k keys] [-f frames]
+ *
+ * Every frame records draws of a cube with a per-draw offset and scale. The
+ * state key of a draw selects one of the keys tints, and the keys are
+ * interleaved in recording order as in an unsorted scene. The naive path
+ * walks the draws in recording order, sets the tint when the key changes,
+ * uploads the offset and scale as a uniform and calls
+ * glDrawElementsInstancedBaseVertexBaseInstance per draw. The batched path
+ * records the draws with gla_add_draw and issues them with
+ * gla_flush_draw_batcher.
+ *
+ * For each path the number of draw calls per frame, the CPU time to submit a
+ * frame and the frame time including glFinish are reported, averaged over
+ * the frames after a warm-up.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#define GLA_IMPLEMENTATION
+#include "../gla/gla.h"
+
+#define WARM_UP_FRAMES 10
+
+typedef struct bench_result {
+    GLuint draw_calls; // Per frame
+    double submit_ms; // Per frame
+    double frame_ms; // Per frame
+} bench_result;
+
+void clean_up_glfw(GLFWwindow *window);
+
+void error_cb(int error, const char *description);
+
+bool init(GLFWwindow **window, int window_width, int window_height,
+        const char *window_title);
+
+void set_tint(GLuint64 key);
+
+void bind_state(void *user, GLuint64 key, GLenum index_type);
+
+bench_result run_naive(GLuint num_draws, GLuint num_keys, int num_frames);
+
+bench_result run_batched(gla_draw_batcher *batcher, GLuint num_draws,
+                        GLuint num_keys, int num_frames);
+
+void print_result(const char *name, const bench_result *result,
+                const bench_result *naive);
+
+static GLuint program = 0;
+static GLint use_draw_data_location = -1;
+static GLint draw_offset_scale_location = -1;
+static GLint tint_location = -1;
+static GLfloat (*offset_scales)[4] = NULL;
+
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    GLuint num_draws = 10000;
+    GLuint num_keys = 8;
+    int num_frames = 100;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            num_draws = (GLuint) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-k") && i + 1 < argc) {
+            num_keys = (GLuint) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            num_frames = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [-n draws] [-k keys] [-f frames]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (num_draws < 1 || num_keys < 1 || num_frames < 1) {
+        fprintf(stderr, "Error: Draws, keys and frames must be positive\n");
+        return 1;
+    }
+
+    glfwSetErrorCallback(error_cb);
+
+    // Initialize the graphics systems
+    GLFWwindow *window = NULL;
+    if (!init(&window, 1024, 768, "GLA -- Draw batcher benchmark")) {
+        fprintf(stderr, "Error: Unable to initialize the graphics system\n");
+        clean_up_glfw(window);
+        return 1;
+    }
+
+    // One cube shared by all draws
+    GLfloat vertices[] = {
+        -0.5f, -0.5f,  0.5f,
+         0.5f, -0.5f,  0.5f,
+         0.5f,  0.5f,  0.5f,
+        -0.5f,  0.5f,  0.5f,
+        -0.5f, -0.5f, -0.5f,
+         0.5f, -0.5f, -0.5f,
+         0.5f,  0.5f, -0.5f,
+        -0.5f,  0.5f, -0.5f,
+    };
+    GLushort indices[] = {
+        0, 1, 2, 0, 2, 3,
+        1, 5, 6, 1, 6, 2,
+        5, 4, 7, 5, 7, 6,
+        4, 0, 3, 4, 3, 7,
+        1, 0, 4, 1, 4, 5,
+        3, 2, 6, 3, 6, 7
+    };
+    GLuint buffers[3];
+    glCreateBuffers(3, buffers);
+    glNamedBufferStorage(buffers[0], sizeof(vertices), vertices, 0);
+    glNamedBufferStorage(buffers[1], sizeof(indices), indices, 0);
+
+    GLuint vertex_array = 0;
+    glCreateVertexArrays(1, &vertex_array);
+    glVertexArrayVertexBuffer(vertex_array, 0, buffers[0], 0,
+                            3 * sizeof(GLfloat));
+    glVertexArrayElementBuffer(vertex_array, buffers[1]);
+    glEnableVertexArrayAttrib(vertex_array, 0);
+    glVertexArrayAttribFormat(vertex_array, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vertex_array, 0, 0);
+
+    // Offsets and scales of the draws on a grid that covers the viewport
+    offset_scales = malloc(num_draws * sizeof(*offset_scales));
+    if (!offset_scales) {
+        fprintf(stderr, "Error: Unable to allocate memory for the draws\n");
+        clean_up_glfw(window);
+        return 1;
+    }
+    GLuint columns = 1;
+    while (columns * columns < num_draws) {
+        columns++;
+    }
+    GLfloat cell = 2.0f / columns;
+    for (GLuint i = 0; i < num_draws; i++) {
+        offset_scales[i][0] = -1.0f + cell * (i % columns + 0.5f);
+        offset_scales[i][1] = -1.0f + cell * (i / columns + 0.5f);
+        offset_scales[i][2] = 0.0f;
+        offset_scales[i][3] = 0.5f * cell;
+    }
+
+    // Create shaders and shader programs
+    GLuint vert_shader = gla_build_shader_from_file(
+        "draw_batcher_bench_vs.glsl", GL_VERTEX_SHADER);
+    GLuint frag_shader = gla_build_shader_from_file(
+        "draw_batcher_bench_fs.glsl", GL_FRAGMENT_SHADER);
+    if (!(gla_check_shader_build(vert_shader) &&
+        gla_check_shader_build(frag_shader))) {
+        gla_delete_shader(vert_shader);
+        gla_delete_shader(frag_shader);
+        free(offset_scales);
+        clean_up_glfw(window);
+        return 1;
+    }
+    program = gla_build_program(vert_shader, 0, 0, 0, frag_shader);
+    gla_delete_shader(vert_shader);
+    gla_delete_shader(frag_shader);
+    if (!gla_check_program_build(program, GL_LINK_STATUS)) {
+        gla_delete_program(program);
+        free(offset_scales);
+        clean_up_glfw(window);
+        return 1;
+    }
+    use_draw_data_location = glGetUniformLocation(program, "use_draw_data");
+    draw_offset_scale_location =
+        glGetUniformLocation(program, "draw_offset_scale");
+    tint_location = glGetUniformLocation(program, "tint");
+
+    gla_draw_batcher *batcher =
+        gla_create_draw_batcher(num_draws, sizeof(offset_scales[0]), 0);
+    if (!batcher) {
+        gla_delete_program(program);
+        free(offset_scales);
+        clean_up_glfw(window);
+        return 1;
+    }
+
+    // Measure both paths with the same state
+    glUseProgram(program);
+    glBindVertexArray(vertex_array);
+    bench_result naive = run_naive(num_draws, num_keys, num_frames);
+    bench_result batched =
+        run_batched(batcher, num_draws, num_keys, num_frames);
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    printf("%u draws, %u keys, %d frames:\n", num_draws, num_keys,
+        num_frames);
+    print_result("naive", &naive, &naive);
+    print_result("batched", &batched, &naive);
+
+    // Clean up and terminate application
+    gla_delete_draw_batcher(batcher);
+    glDeleteVertexArrays(1, &vertex_array);
+    glDeleteBuffers(3, buffers);
+    gla_delete_program(program);
+    free(offset_scales);
+    clean_up_glfw(window);
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+void clean_up_glfw(GLFWwindow *window)
+{
+    if (window) {
+        glfwDestroyWindow(window);
+    }
+    glfwTerminate();
+}
+
+// -----------------------------------------------------------------------------
+void error_cb(int error, const char *description)
+{
+    fprintf(stderr, "Error: %s (error code %d)\n", description, error);
+}
+
+// -----------------------------------------------------------------------------
+bool init(GLFWwindow **window, int window_width, int window_height,
+        const char *window_title)
+{
+    if (!glfwInit()) {
+        fprintf(stderr, "Error: Unable to initialize GLFW\n");
+        return false;
+    }
+
+    // Buffer storage and direct state access require OpenGL 4.5
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    *window =
+        glfwCreateWindow(window_width, window_height, window_title, NULL, NULL);
+    if (!*window) {
+        fprintf(stderr, "Error: Unable to create window\n");
+        return false;
+    }
+
+    glfwMakeContextCurrent(*window);
+
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        fprintf(stderr, "Error: Unable to initialize OpenGL context\n");
+        return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+void set_tint(GLuint64 key)
+{
+    glUniform4f(tint_location, (key & 1) ? 1.0f : 0.25f,
+                (key & 2) ? 1.0f : 0.25f, (key & 4) ? 1.0f : 0.25f, 1.0f);
+}
+
+// -----------------------------------------------------------------------------
+void bind_state(void *user, GLuint64 key, GLenum index_type)
+{
+    set_tint(key);
+}
+
+// -----------------------------------------------------------------------------
+bench_result run_naive(GLuint num_draws, GLuint num_keys, int num_frames)
+{
+    bench_result result = {0};
+    glUniform1i(use_draw_data_location, GL_FALSE);
+    for (int f = -WARM_UP_FRAMES; f < num_frames; f++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        double start = glfwGetTime();
+        GLuint64 bound_key = ~(GLuint64) 0;
+        for (GLuint i = 0; i < num_draws; i++) {
+            GLuint64 key = i % num_keys;
+            if (key != bound_key) {
+                set_tint(key);
+                bound_key = key;
+            }
+            glUniform4fv(draw_offset_scale_location, 1, offset_scales[i]);
+            glDrawElementsInstancedBaseVertexBaseInstance(
+                GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, NULL, 1, 0, 0);
+        }
+        double submitted = glfwGetTime();
+        glFinish();
+        double finished = glfwGetTime();
+        if (f >= 0) {
+            result.draw_calls = num_draws;
+            result.submit_ms += (submitted - start) * 1e3 / num_frames;
+            result.frame_ms += (finished - start) * 1e3 / num_frames;
+        }
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+bench_result run_batched(gla_draw_batcher *batcher, GLuint num_draws,
+                        GLuint num_keys, int num_frames)
+{
+    bench_result result = {0};
+    glUniform1i(use_draw_data_location, GL_TRUE);
+    for (int f = -WARM_UP_FRAMES; f < num_frames; f++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        double start = glfwGetTime();
+        for (GLuint i = 0; i < num_draws; i++) {
+            gla_draw draw = {i % num_keys, GL_UNSIGNED_SHORT, 36, 0, 0, 1, 0};
+            gla_add_draw(batcher, &draw, offset_scales[i]);
+        }
+        GLuint draw_calls =
+            gla_flush_draw_batcher(batcher, GL_TRIANGLES, bind_state, NULL);
+        double submitted = glfwGetTime();
+        glFinish();
+        double finished = glfwGetTime();
+        if (f >= 0) {
+            result.draw_calls = draw_calls;
+            result.submit_ms += (submitted - start) * 1e3 / num_frames;
+            result.frame_ms += (finished - start) * 1e3 / num_frames;
+        }
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+void print_result(const char *name, const bench_result *result,
+                const bench_result *naive)
+{
+    printf("  %-8s %6u draw calls  %8.3f ms submit (%5.2fx)  "
+        "%8.3f ms frame (%5.2fx)\n",
+        name, result->draw_calls, result->submit_ms,
+        naive->submit_ms / result->submit_ms, result->frame_ms,
+        naive->frame_ms / result->frame_ms);
+}
@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-present Lars Schütz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ******************************************************************************/
+#version 450 core
+#extension GL_ARB_shader_draw_parameters : require
+
+layout (location = 0) in vec3 position;
+
+// Batched draws read their offset and scale from the per-draw data, indexed
+// with the draw ID of the multi-draw call. Naive draws set it as a uniform.
+layout (std430, binding = 0) readonly buffer draw_data_block {
+    vec4 draw_data[];
+};
+
+uniform bool use_draw_data;
+uniform vec4 draw_offset_scale;
+
+void main()
+{
+    vec4 offset_scale =
+        use_draw_data ? draw_data[gl_DrawIDARB] : draw_offset_scale;
+    gl_Position = vec4(position * offset_scale.w + offset_scale.xyz, 1.0);
+}
@@ -24,6 +24,8 @@
 #ifndef GLA_H_INCLUDE
 #define GLA_H_INCLUDE
 
+#include <stdio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -34,6 +36,585 @@ extern "C" {
 #define GLA_LINKAGE
 #endif // GLA_STATIC
 
+/**
+ * \brief Pool of worker threads that execute data parallel loops.
+ */
+typedef struct gla_job_pool gla_job_pool;
+
+/**
+ * \brief Suballocator that carves ranges out of a few large buffer objects.
+ */
+typedef struct gla_buffer_arena gla_buffer_arena;
+
+/**
+ * \brief Range of a buffer object handed out by a buffer arena.
+ */
+typedef struct gla_buffer_range {
+    GLuint buffer; ///< The buffer object that holds the range.
+    GLintptr offset; ///< The offset of the range in bytes.
+    GLsizeiptr size; ///< The size of the range in bytes.
+} gla_buffer_range;
+
+/**
+ * \brief Statistics of a buffer arena.
+ */
+typedef struct gla_buffer_arena_stats {
+    GLuint num_pages; ///< Number of backing buffer objects.
+    GLuint num_ranges; ///< Number of live ranges.
+    GLsizeiptr page_bytes; ///< Bytes of buffer storage.
+    GLsizeiptr block_bytes; ///< Bytes of allocated buddy blocks.
+    GLsizeiptr range_bytes; ///< Bytes requested by the live ranges.
+    GLuint generation; ///< Incremented whenever ranges are moved.
+} gla_buffer_arena_stats;
+
+/**
+ * \brief Maximum number of attributes of a vertex format.
+ */
+#define GLA_MAX_VERTEX_ATTRIBS 16
+
+/**
+ * \brief Maximum number of buffer binding points of a vertex format.
+ */
+#define GLA_MAX_VERTEX_BINDINGS 8
+
+/**
+ * \brief Vertex attribute of a vertex format.
+ */
+typedef struct gla_vertex_attrib {
+    GLuint location; ///< The attribute index in the vertex shader.
+    GLuint binding; ///< The buffer binding point the attribute is read from.
+    GLint count; ///< The number of components (1 to 4, or \c GL_BGRA).
+    GLenum type; ///< The component type, e.g. \c GL_FLOAT.
+    GLboolean normalized; ///< Whether fixed-point values are normalized.
+    GLboolean integer; ///< Whether the shader input is an integer type.
+                    ///< Set for unnormalized integer types by default.
+    GLuint relative_offset; ///< The offset inside a vertex in bytes.
+} gla_vertex_attrib;
+
+/**
+ * \brief Buffer binding point of a vertex format.
+ */
+typedef struct gla_vertex_binding {
+    GLsizei stride; ///< The distance between elements in bytes.
+    GLuint divisor; ///< 0 for per-vertex data, n to advance every n instances.
+} gla_vertex_binding;
+
+/**
+ * \brief Declarative description of a vertex layout. Zero-initialize it
+ *      and add attributes with gla_add_vertex_attrib.
+ */
+typedef struct gla_vertex_format {
+    GLuint num_attribs;
+    gla_vertex_attrib attribs[GLA_MAX_VERTEX_ATTRIBS];
+    GLuint num_bindings; ///< One more than the highest used binding point.
+    gla_vertex_binding bindings[GLA_MAX_VERTEX_BINDINGS];
+} gla_vertex_format;
+
+/**
+ * \brief Vertex array object of a vertex format together with its current
+ *      buffer bindings.
+ */
+typedef struct gla_vertex_array {
+    GLuint vao;
+    GLuint hash;
+    gla_vertex_format format;
+    GLuint buffers[GLA_MAX_VERTEX_BINDINGS];
+    GLintptr offsets[GLA_MAX_VERTEX_BINDINGS];
+    GLuint element_buffer;
+} gla_vertex_array;
+
+/**
+ * \brief Cache of one vertex array object per distinct vertex format.
+ */
+typedef struct gla_vao_cache gla_vao_cache;
+
+/**
+ * \brief Indirect draw command as read by glMultiDrawElementsIndirect.
+ */
+typedef struct gla_draw_elements_indirect_command {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+} gla_draw_elements_indirect_command;
+
+/**
+ * \brief Indexed draw of a mesh suballocation.
+ */
+typedef struct gla_draw {
+    GLuint64 key; ///< The state key. Draws with equal keys share one bucket.
+    GLenum index_type; ///< \c GL_UNSIGNED_BYTE, \c _SHORT or \c _INT.
+    GLuint index_count;
+    GLuint first_index; ///< The index offset in units of the index type.
+    GLint base_vertex; ///< The vertex offset added to every index.
+    GLuint instance_count;
+    GLuint base_instance;
+} gla_draw;
+
+/**
+ * \brief Batcher that turns draws into one multi-draw-indirect call per
+ *      state bucket.
+ */
+typedef struct gla_draw_batcher gla_draw_batcher;
+
+/**
+ * \brief Indexed mesh whose per-instance streams are the bindings of its
+ *      vertex format with a non-zero divisor.
+ */
+typedef struct gla_instanced_mesh {
+    gla_vertex_array *vertex_array;
+    /// Buffers and offsets of all bindings. The per-vertex ones are set by
+    /// the user, the per-instance ones by gla_alloc_instance_streams.
+    GLuint buffers[GLA_MAX_VERTEX_BINDINGS];
+    GLintptr offsets[GLA_MAX_VERTEX_BINDINGS];
+    GLuint element_buffer;
+    GLenum index_type;
+    GLsizei index_count;
+    GLuint first_index; ///< The index offset in units of the index type.
+    GLint base_vertex;
+} gla_instanced_mesh;
+
+/**
+ * \brief Bit layout of render queue sort keys. From most to least significant:
+ *      8 bits layer, 16 bits program, 16 bits material, 24 bits depth bucket.
+ */
+#define GLA_RENDER_KEY_LAYER_SHIFT 56
+#define GLA_RENDER_KEY_PROGRAM_SHIFT 40
+#define GLA_RENDER_KEY_MATERIAL_SHIFT 24
+#define GLA_RENDER_KEY_DEPTH_SHIFT 0
+#define GLA_RENDER_KEY_LAYER_MASK 0xff00000000000000ull
+#define GLA_RENDER_KEY_PROGRAM_MASK 0x00ffff0000000000ull
+#define GLA_RENDER_KEY_MATERIAL_MASK 0x000000ffff000000ull
+#define GLA_RENDER_KEY_DEPTH_MASK 0x0000000000ffffffull
+
+/**
+ * \brief Build a render queue sort key. Larger depth buckets sort later, so
+ *      translucent packets should pass an inverted depth for back to front
+ *      order.
+ */
+#define GLA_RENDER_KEY(layer, program, material, depth)                       \
+    ((((GLuint64) (layer) & 0xff) << GLA_RENDER_KEY_LAYER_SHIFT) |          \
+    (((GLuint64) (program) & 0xffff) << GLA_RENDER_KEY_PROGRAM_SHIFT) |     \
+    (((GLuint64) (material) & 0xffff) << GLA_RENDER_KEY_MATERIAL_SHIFT) |   \
+    (((GLuint64) (depth) & 0xffffff) << GLA_RENDER_KEY_DEPTH_SHIFT))
+
+/**
+ * \brief Queue of fixed-size render packets that are sorted by 64-bit keys.
+ */
+typedef struct gla_render_queue gla_render_queue;
+
+/**
+ * \brief Linear arena of plain old data commands that is recorded on any
+ *      thread and replayed on the thread that owns the OpenGL context.
+ */
+typedef struct gla_command_buffer gla_command_buffer;
+
+/**
+ * \brief Maximum number of texture units tracked by a state tracker.
+ */
+#define GLA_MAX_TRACKED_TEXTURE_UNITS 32
+
+/**
+ * \brief Maximum number of indexed uniform and shader storage buffer bindings
+ *      tracked by a state tracker.
+ */
+#define GLA_MAX_TRACKED_BUFFER_BINDINGS 16
+
+/**
+ * \brief Indexed buffer binding as tracked by a state tracker.
+ */
+typedef struct gla_tracked_buffer_binding {
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size; ///< 0 for a binding of the whole buffer.
+} gla_tracked_buffer_binding;
+
+/**
+ * \brief Bindings last set by command buffer replay, used to skip redundant
+ *      state changes.
+ */
+typedef struct gla_state_tracker {
+    GLuint program;
+    GLuint vertex_array;
+    GLuint draw_indirect_buffer;
+    GLuint texture_units[GLA_MAX_TRACKED_TEXTURE_UNITS];
+    gla_tracked_buffer_binding
+        uniform_buffers[GLA_MAX_TRACKED_BUFFER_BINDINGS];
+    gla_tracked_buffer_binding
+        storage_buffers[GLA_MAX_TRACKED_BUFFER_BINDINGS];
+    GLuint num_commands; ///< Number of replayed commands.
+    GLuint num_elided; ///< Number of skipped redundant state changes.
+} gla_state_tracker;
+
+/**
+ * \brief Thread that owns the OpenGL context and renders frame packets
+ *      handed over through a single producer single consumer ring.
+ */
+typedef struct gla_render_thread gla_render_thread;
+
+/**
+ * \brief Maximum number of frame packets in flight on a render thread.
+ */
+#define GLA_RENDER_THREAD_MAX_FRAMES 4
+
+/**
+ * \brief Statistics of a render thread.
+ */
+typedef struct gla_render_thread_stats {
+    GLuint64 num_frames; ///< Number of rendered frames.
+    GLuint64 num_producer_stalls; ///< Frames begun while all were in flight.
+    GLuint64 producer_stall_ns; ///< Total time the producer was blocked.
+    GLuint64 num_render_idles; ///< Times the render thread ran out of frames.
+} gla_render_thread_stats;
+
+/**
+ * \brief Queue that deletes OpenGL objects once the GPU has finished the
+ *      frames that may still use them.
+ */
+typedef struct gla_deletion_queue gla_deletion_queue;
+
+/**
+ * \brief Generational handle of an object in an object registry. The 32 bits
+ *      hold the object type (3 bits), a generation (11 bits) and a slot
+ *      index (18 bits). The value 0 is never a valid handle.
+ */
+typedef struct gla_handle {
+    GLuint value;
+} gla_handle;
+
+/**
+ * \brief Maximum length of an object label, including the terminator.
+ */
+#define GLA_MAX_OBJECT_LABEL_LENGTH 48
+
+/**
+ * \brief Metadata of an object in an object registry.
+ */
+typedef struct gla_object_info {
+    GLenum identifier; ///< The object type, e.g. \c GL_BUFFER.
+    GLuint name; ///< The OpenGL object name.
+    GLsizeiptr size; ///< The size in bytes as registered, 0 if unknown.
+    GLchar label[GLA_MAX_OBJECT_LABEL_LENGTH];
+    const char *file; ///< The source file of the registration.
+    int line; ///< The source line of the registration.
+} gla_object_info;
+
+/**
+ * \brief Registry that hands out generational handles for OpenGL objects and
+ *      keeps their metadata in dense per-type arrays.
+ */
+typedef struct gla_object_registry gla_object_registry;
+
+/**
+ * \brief Categories of tracked GPU memory.
+ */
+#define GLA_MEMORY_VERTEX_BUFFER 0
+#define GLA_MEMORY_INDEX_BUFFER 1
+#define GLA_MEMORY_UNIFORM_BUFFER 2
+#define GLA_MEMORY_STORAGE_BUFFER 3
+#define GLA_MEMORY_STREAM_BUFFER 4
+#define GLA_MEMORY_OTHER_BUFFER 5
+#define GLA_MEMORY_TEXTURE 6
+#define GLA_MEMORY_RENDER_TARGET 7
+#define GLA_MEMORY_NUM_CATEGORIES 8
+
+/**
+ * \brief Pseudo category that sums up all categories.
+ */
+#define GLA_MEMORY_TOTAL GLA_MEMORY_NUM_CATEGORIES
+
+/**
+ * \brief Statistics of one category of tracked GPU memory.
+ */
+typedef struct gla_memory_stats {
+    GLsizeiptr bytes; ///< Currently tracked bytes.
+    GLsizeiptr peak_bytes; ///< High-water mark of \c bytes.
+    GLuint num_objects; ///< Currently tracked objects.
+    GLsizeiptr budget; ///< The budget in bytes, 0 for none.
+    GLboolean refuse; ///< Whether allocations over budget are refused.
+} gla_memory_stats;
+
+/**
+ * \brief Magic number ("GLAM") and version of the binary mesh format.
+ */
+#define GLA_MESH_MAGIC 0x4d414c47u
+#define GLA_MESH_VERSION 2
+
+/**
+ * \brief Header of a binary mesh file. It is followed by the attribute, stream
+ *      and submesh tables. The index data and every vertex stream start at
+ *      16-byte aligned file offsets. All values are in the byte order of
+ *      the writing machine. On a machine of the other byte order the magic
+ *      number does not match and the file is rejected.
+ */
+typedef struct gla_mesh_header {
+    GLuint magic;
+    GLuint version;
+    GLuint num_vertices;
+    GLuint num_indices;
+    GLenum index_type; ///< \c GL_UNSIGNED_BYTE, \c _SHORT or \c _INT.
+    GLuint num_attribs;
+    GLuint num_streams;
+    GLuint num_submeshes;
+    GLfloat aabb_min[3]; ///< The bounds of all submeshes.
+    GLfloat aabb_max[3];
+    GLuint64 index_offset; ///< The file offset of the index data.
+} gla_mesh_header;
+
+/**
+ * \brief Vertex attribute descriptor of a binary mesh file.
+ */
+typedef struct gla_mesh_attrib {
+    GLubyte location;
+    GLubyte binding; ///< The stream the attribute is read from.
+    GLushort count;
+    GLenum type;
+    GLuint relative_offset;
+    GLubyte normalized;
+    GLubyte integer;
+    GLubyte reserved[2];
+} gla_mesh_attrib;
+
+/**
+ * \brief Vertex stream descriptor of a binary mesh file.
+ */
+typedef struct gla_mesh_stream {
+    GLuint binding;
+    GLuint stride;
+    GLuint reserved[2];
+    GLuint64 offset; ///< The file offset of the stream data.
+    GLuint64 size; ///< The size of the stream data in bytes.
+} gla_mesh_stream;
+
+/**
+ * \brief Submesh, i.e. an index range drawn with one material.
+ */
+typedef struct gla_mesh_submesh {
+    GLuint first_index;
+    GLuint index_count;
+    GLint base_vertex;
+    GLuint material;
+    GLfloat aabb_min[3];
+    GLfloat aabb_max[3];
+    GLenum mode; ///< \c GL_TRIANGLES, or \c GL_TRIANGLE_STRIP with restarts.
+    GLfloat lod_error; ///< The simplification error in model units. A
+                       ///< submesh with an error greater than 0 is a coarser
+                       ///< level of the closest preceding submesh with
+                       ///< error 0.
+} gla_mesh_submesh;
+
+/**
+ * \brief Mesh loaded from a binary mesh file, with one immutable buffer
+ *      object per vertex stream.
+ */
+typedef struct gla_mesh {
+    gla_vertex_format format;
+    GLuint buffers[GLA_MAX_VERTEX_BINDINGS]; ///< 0 for unused bindings
+    GLuint element_buffer;
+    GLenum index_type;
+    GLuint num_vertices;
+    GLuint num_indices;
+    GLuint num_submeshes;
+    gla_mesh_submesh *submeshes;
+    GLfloat aabb_min[3];
+    GLfloat aabb_max[3];
+} gla_mesh;
+
+/**
+ * \brief Post-transform vertex cache statistics of an index buffer, simulated
+ *      with a FIFO cache.
+ */
+typedef struct gla_vertex_cache_stats {
+    GLuint vertices_transformed; ///< Number of cache misses.
+    GLfloat acmr; ///< Average cache miss ratio, i.e. misses per triangle.
+    GLfloat atvr; ///< Average transform to vertex ratio, i.e. misses per
+                  ///< referenced vertex.
+} gla_vertex_cache_stats;
+
+/**
+ * \brief Maximum number of vertices of a meshlet.
+ */
+#define GLA_MESHLET_MAX_VERTICES 64
+
+/**
+ * \brief Maximum number of triangles of a meshlet.
+ */
+#define GLA_MESHLET_MAX_TRIANGLES 124
+
+/**
+ * \brief Cluster of triangles with bounds for culling. The layout matches the
+ *      std430 layout of the meshlet array read by the meshlet cull program.
+ */
+typedef struct gla_meshlet {
+    GLfloat center[3]; ///< The bounding sphere center.
+    GLfloat radius; ///< The bounding sphere radius.
+    GLfloat cone_axis[3]; ///< The mean direction of the triangle normals.
+    GLfloat cone_cutoff; ///< The cosine of the largest angle between the axis
+                         ///< and a triangle normal, or -1 if the triangles
+                         ///< face too many directions to ever be backfacing.
+    GLuint first_index;
+    GLuint index_count;
+    GLuint vertex_count;
+    GLuint reserved;
+} gla_meshlet;
+
+/**
+ * \brief Outputs of the meshlet cull program.
+ *
+ * - \c GLA_MESHLET_CULL_COMMANDS: One indirect command per visible meshlet,
+ *   whose base instance is the meshlet index, and their number.
+ * - \c GLA_MESHLET_CULL_INDICES: The indices of the visible meshlets, and one
+ *   indirect command that draws them.
+ */
+#define GLA_MESHLET_CULL_COMMANDS 0
+#define GLA_MESHLET_CULL_INDICES 1
+
+/**
+ * \brief Object as read by the object cull program. The layout matches the
+ *      std430 layout of the object array.
+ */
+typedef struct gla_cull_object {
+    GLfloat aabb_min[3]; ///< The bounds in model space.
+    GLuint index_count;
+    GLfloat aabb_max[3];
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint transform; ///< The index of the model matrix in the transforms.
+    GLuint reserved[2];
+} gla_cull_object;
+
+/**
+ * \brief Outputs of the object cull program.
+ *
+ * - \c GLA_OBJECT_CULL_COMPACT: The indirect commands of the visible objects
+ *   in arbitrary order and their number, for
+ *   glMultiDrawElementsIndirectCount.
+ * - \c GLA_OBJECT_CULL_FIXED: One indirect command per object, whose instance
+ *   count is 0 if the object is culled, for glMultiDrawElementsIndirect with
+ *   a fixed draw count. The number of visible objects is written, too.
+ *
+ * In both cases the base instance of a command is the object index.
+ */
+#define GLA_OBJECT_CULL_COMPACT 0
+#define GLA_OBJECT_CULL_FIXED 1
+
+/**
+ * \brief Tests of the object cull program.
+ *
+ * - \c GLA_CULL_PHASE_FRUSTUM: Objects in the frustum are visible.
+ * - \c GLA_CULL_PHASE_OCCLUSION: Objects in the frustum that are not hidden
+ *   behind the Hi-Z pyramid, e.g. of a depth pre-pass of occluders, are
+ *   visible.
+ * - \c GLA_CULL_PHASE_EARLY: Objects in the frustum that were visible in the
+ *   last frame are visible. Draw them and build the Hi-Z pyramid of their
+ *   depth.
+ * - \c GLA_CULL_PHASE_LATE: Objects in the frustum that are not hidden
+ *   behind the Hi-Z pyramid are recorded as visible for the next frame, and
+ *   those that were not visible in the last frame, i.e. not drawn in the
+ *   early phase, are drawn now.
+ */
+#define GLA_CULL_PHASE_FRUSTUM 0
+#define GLA_CULL_PHASE_OCCLUSION 1
+#define GLA_CULL_PHASE_EARLY 2
+#define GLA_CULL_PHASE_LATE 3
+
+/**
+ * \brief Hierarchical depth pyramid, whose texels hold the farthest depth of
+ *      the depth buffer pixels they cover.
+ */
+typedef struct gla_hiz_pyramid {
+    GLuint texture; ///< \c GL_R32F texture, level 0 of half the depth size.
+    GLuint sampler; ///< Nearest filtering sampler.
+    GLuint program; ///< The reduction program.
+    GLsizei width; ///< The width of the depth buffer.
+    GLsizei height; ///< The height of the depth buffer.
+    GLsizei num_levels;
+} gla_hiz_pyramid;
+
+/**
+ * \brief Size of the tiles of an occlusion buffer in pixels. Every tile keeps
+ *      one coverage bit per pixel and two depths.
+ */
+#define GLA_OCCLUSION_TILE_WIDTH 32
+#define GLA_OCCLUSION_TILE_HEIGHT 8
+
+/**
+ * \brief Low resolution depth buffer of occluders for culling on the CPU.
+ */
+typedef struct gla_occlusion_buffer gla_occlusion_buffer;
+
+/**
+ * \brief Quantized vertex attribute encodings.
+ *
+ * - \c GLA_QUANTIZED_POSITION: 4 normalized \c GL_UNSIGNED_SHORT relative to
+ *   an AABB, w = 1.
+ * - \c GLA_QUANTIZED_OCTAHEDRAL_10: \c GL_INT_2_10_10_10_REV, normalized,
+ *   with octahedral x and y, z = 0, and w = sign.
+ * - \c GLA_QUANTIZED_OCTAHEDRAL_16: 2 normalized \c GL_SHORT with octahedral
+ *   x and y.
+ * - \c GLA_QUANTIZED_OCTAHEDRAL_16_SIGN: 4 normalized \c GL_SHORT with
+ *   octahedral x and y, z = 0, and w = sign.
+ * - \c GLA_QUANTIZED_HALF_FLOAT_2: 2 \c GL_HALF_FLOAT.
+ */
+#define GLA_QUANTIZED_POSITION 0
+#define GLA_QUANTIZED_OCTAHEDRAL_10 1
+#define GLA_QUANTIZED_OCTAHEDRAL_16 2
+#define GLA_QUANTIZED_OCTAHEDRAL_16_SIGN 3
+#define GLA_QUANTIZED_HALF_FLOAT_2 4
+
+/**
+ * \brief GLSL functions that decode quantized attributes. Insert them after
+ *      the version directive of a vertex shader.
+ *
+ * Quantized positions are dequantized by the matrix of
+ * gla_get_position_dequantization, e.g. folded into the model matrix.
+ */
+#define GLA_DEQUANTIZATION_GLSL \
+    "vec3 gla_dequantize_position(vec3 p, vec3 aabb_min, vec3 aabb_max)\n" \
+    "{\n" \
+    "    return mix(aabb_min, aabb_max, p);\n" \
+    "}\n" \
+    "vec3 gla_decode_octahedral(vec2 e)\n" \
+    "{\n" \
+    "    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n" \
+    "    float t = max(-v.z, 0.0);\n" \
+    "    v.xy += mix(vec2(t), vec2(-t), greaterThanEqual(v.xy, vec2(0.0)));\n" \
+    "    return normalize(v);\n" \
+    "}\n"
+
+/**
+ * \brief Maximum number of frame regions of a stream buffer.
+ */
+#define GLA_STREAM_BUFFER_MAX_REGIONS 4
+
+/**
+ * \brief Statistics of a stream buffer.
+ */
+typedef struct gla_stream_buffer_stats {
+    GLuint64 num_frames; ///< Number of begun frames.
+    GLuint64 num_fence_waits; ///< Frames whose region was still in use.
+    GLuint64 fence_wait_ns; ///< Total time spent waiting on fences.
+    GLuint64 num_failed_allocs; ///< Allocations that did not fit.
+    GLsizeiptr peak_region_usage; ///< Most bytes allocated in one frame.
+} gla_stream_buffer_stats;
+
+/**
+ * \brief Persistently and coherently mapped buffer object that is split into
+ *      frame regions. Each frame bump-allocates from its own region, and a
+ *      region is reused only after the fence of its last frame has signaled.
+ */
+typedef struct gla_stream_buffer {
+    GLuint buffer; ///< The buffer object.
+    GLubyte *data; ///< The mapped storage of the whole buffer.
+    GLsizeiptr region_size;
+    GLuint num_regions;
+    GLuint region; ///< The region of the current frame.
+    GLsizeiptr offset; ///< The bump offset inside the current region.
+    GLsync fences[GLA_STREAM_BUFFER_MAX_REGIONS];
+    gla_stream_buffer_stats stats;
+} gla_stream_buffer;
+
 /**
  * \brief Create and link a program object given a compute shader object.
  * \param compute_shader Specifies the compute shader object that gets attached
@@ -138,6 +719,25 @@ GLA_LINKAGE GLint gla_check_program_build(GLuint program, GLenum pname);
  */
 GLA_LINKAGE GLint gla_check_shader_build(GLuint shader);
 
+/**
+ * \brief Create a pool of worker threads.
+ * \param num_threads Specifies the number of worker threads. If it is less than
+ *                  one, one thread less than the number of online processors
+ *                  is used since the calling thread takes part in the work.
+ * \return The job pool, or \c NULL if an error occurred.
+ * \note Without POSIX threads, or if \c GLA_NO_THREADS is defined before the
+ *      implementation, the pool has no worker threads and loops run on the
+ *      calling thread.
+ */
+GLA_LINKAGE gla_job_pool *gla_create_job_pool(int num_threads);
+
+/**
+ * \brief Stop the worker threads and delete a job pool.
+ * \param pool Specifies the job pool to be deleted.
+ * \note This function is the counterpart to gla_create_job_pool(int).
+ */
+GLA_LINKAGE void gla_delete_job_pool(gla_job_pool *pool);
+
 /**
  * \brief Delete a program object.
  * \param program Specifies the program object to be deleted.
@@ -158,6 +758,22 @@ GLA_LINKAGE void gla_delete_program(GLuint program);
  */
 GLA_LINKAGE void gla_delete_shader(GLuint shader);
 
+/**
+ * \brief Call a task for every index of a range using the threads of a job
+ *      pool, and wait until all calls have finished.
+ * \param pool Specifies the job pool (a gla_job_pool pointer). It is passed
+ *              as untyped pointer so that the function can be handed to
+ *              cgm's multi-threaded kernels as cgm_parallel_for_fn.
+ * \param count Specifies the number of indices [0, count).
+ * \param task Specifies the function that gets called once per index.
+ * \param arg Specifies the user data passed to \p task.
+ * \note The calling thread works on the range, too. Calls from several
+ *      threads at the same time are serialized. Calls from within a task,
+ *      i.e. nested loops, run on the calling thread.
+ */
+GLA_LINKAGE void gla_parallel_for(void *pool, int count,
+                                void (*task)(void *arg, int index), void *arg);
+
 /**
  * \brief Print the program object's information log to the standard output.
  * \param program Specifies the program object whose information log is to be
@@ -180,347 +796,8524 @@ GLA_LINKAGE void gla_print_shader_info_log(GLuint shader);
  */
 GLA_LINKAGE GLchar *gla_read_text_file(const GLchar *filename);
 
-#ifdef __cplusplus
-}
-#endif // __cplusplus
+// -----------------------------------------------------------------------------
+// Buffer arenas
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create a buffer arena. Ranges are allocated with a buddy allocator
+ *      from immutable pages that are created on demand.
+ * \param page_size Specifies the size of each backing buffer object. It is
+ *                  rounded up to the next power of two. Use one arena per
+ *                  usage class (e.g. vertices and indices) with a page size
+ *                  large enough that most scenes fit into a single page.
+ * \param min_block_size Specifies the smallest block size. It is rounded up
+ *                      to the next power of two and at least 16 bytes.
+ * \return The buffer arena, or \c NULL if an error occurred.
+ * \note Requires OpenGL 4.4 or \c ARB_buffer_storage.
+ */
+GLA_LINKAGE gla_buffer_arena *gla_create_buffer_arena(GLsizeiptr page_size,
+                                                    GLsizeiptr min_block_size);
 
-#endif // GLA_H_INCLUDE
+/**
+ * \brief Delete a buffer arena and all of its pages.
+ * \param arena Specifies the buffer arena to be deleted.
+ * \note This function is the counterpart to
+ *      gla_create_buffer_arena(GLsizeiptr, GLsizeiptr).
+ */
+GLA_LINKAGE void gla_delete_buffer_arena(gla_buffer_arena *arena);
 
-#ifdef GLA_IMPLEMENTATION
-#undef GLA_IMPLEMENTATION
+/**
+ * \brief Allocate a range from a buffer arena and optionally fill it.
+ * \param arena Specifies the buffer arena.
+ * \param size Specifies the size of the range in bytes.
+ * \param alignment Specifies the alignment of the range's offset, e.g. the
+ *                  vertex stride so that the range can be drawn with a base
+ *                  vertex. It need not be a power of two. 0 means no
+ *                  alignment.
+ * \param data Specifies the data copied into the range, or \c NULL.
+ * \return The handle of the range, or 0 if an error occurred.
+ */
+GLA_LINKAGE GLuint gla_alloc_buffer_arena_range(gla_buffer_arena *arena,
+                                                GLsizeiptr size,
+                                                GLsizeiptr alignment,
+                                                const void *data);
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
+/**
+ * \brief Free a range of a buffer arena.
+ * \param arena Specifies the buffer arena.
+ * \param handle Specifies the handle of the range to be freed.
+ * \note This function is the counterpart to
+ *      gla_alloc_buffer_arena_range(gla_buffer_arena *, GLsizeiptr,
+ *                                  GLsizeiptr, const void *).
+ */
+GLA_LINKAGE void gla_free_buffer_arena_range(gla_buffer_arena *arena,
+                                            GLuint handle);
 
-// -----------------------------------------------------------------------------
-GLA_LINKAGE GLuint gla_build_compute_program(GLuint compute_shader)
-{
-    if (!compute_shader) {
-        fprintf(stderr, "Error: Compute program building: "
-                        "Program must contain a compute shader\n");
-        return 0;
-    }
+/**
+ * \brief Return the buffer object, offset and size of a range.
+ * \param arena Specifies the buffer arena.
+ * \param handle Specifies the handle of the range.
+ * \return The range, or a zero range if \p handle is invalid.
+ * \note The result changes when the arena is defragmented.
+ */
+GLA_LINKAGE gla_buffer_range gla_get_buffer_arena_range(
+    const gla_buffer_arena *arena, GLuint handle);
 
-    GLuint program = glCreateProgram();
-    glAttachShader(program, compute_shader);
-    glLinkProgram(program);
-    glDetachShader(program, compute_shader);
-    return program;
-}
+/**
+ * \brief Compact the live ranges of a buffer arena into as few pages as
+ *      possible on the GPU and release the emptied pages.
+ * \param arena Specifies the buffer arena.
+ * \return Returns \c GL_TRUE if ranges were moved. In this case the
+ *      generation of the arena has been incremented and all ranges must be
+ *      queried again.
+ * \note The new pages are filled with glCopyBufferSubData before the old ones
+ *      are deleted, so the peak storage is briefly twice the used pages.
+ */
+GLA_LINKAGE GLboolean gla_defragment_buffer_arena(gla_buffer_arena *arena);
+
+/**
+ * \brief Return the statistics of a buffer arena.
+ * \param arena Specifies the buffer arena.
+ * \return The statistics.
+ */
+GLA_LINKAGE gla_buffer_arena_stats gla_get_buffer_arena_stats(
+    const gla_buffer_arena *arena);
+
+/**
+ * \brief Set the memory category and label under which the pages of a buffer
+ *      arena are tracked.
+ * \param arena Specifies the buffer arena.
+ * \param category Specifies the category, e.g. \c GLA_MEMORY_VERTEX_BUFFER.
+ *                The default is \c GLA_MEMORY_OTHER_BUFFER.
+ * \param label Specifies the label, which must outlive the arena.
+ * \note Applies to pages created afterwards, so call it right after
+ *      gla_create_buffer_arena(GLsizeiptr, GLsizeiptr).
+ */
+GLA_LINKAGE void gla_set_buffer_arena_memory_category(gla_buffer_arena *arena,
+                                                    int category,
+                                                    const GLchar *label);
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE GLuint gla_build_compute_program_from_file(const GLchar *filename)
-{
-    GLuint comp = 0;
-    if (filename) {
-        comp = gla_build_shader_from_file(filename, GL_COMPUTE_SHADER);
-    }
+// Vertex formats
+// -----------------------------------------------------------------------------
+/**
+ * \brief Append an attribute to a vertex format. The attribute is placed
+ *      directly after the previous attributes of the same binding point, whose
+ *      stride grows accordingly.
+ * \param format Specifies the vertex format.
+ * \param location Specifies the attribute index in the vertex shader.
+ * \param binding Specifies the buffer binding point.
+ * \param count Specifies the number of components.
+ * \param type Specifies the component type.
+ * \param normalized Specifies whether fixed-point values are normalized.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE if the format is
+ *      full or an argument is out of range.
+ * \note Set the binding's stride and divisor afterwards to add padding or to
+ *      read the binding per instance.
+ */
+GLA_LINKAGE GLboolean gla_add_vertex_attrib(gla_vertex_format *format,
+                                            GLuint location, GLuint binding,
+                                            GLint count, GLenum type,
+                                            GLboolean normalized);
 
-    if (filename && !gla_check_shader_build(comp)) {
-        fprintf(stderr, "Error: Program building: "
-                        "Shader (\"%s\") build error. "
-                        "See shader info log\n", filename);
-        gla_delete_shader(comp);
-        return 0;
-    }
+/**
+ * \brief Return the size of one vertex attribute in bytes.
+ * \param count Specifies the number of components.
+ * \param type Specifies the component type.
+ * \return The size in bytes, or 0 for an unknown type.
+ */
+GLA_LINKAGE GLsizei gla_vertex_attrib_size(GLint count, GLenum type);
 
-    return gla_build_compute_program(comp);
-}
+/**
+ * \brief Create an empty vertex array object cache.
+ * \return The cache, or \c NULL if an error occurred.
+ */
+GLA_LINKAGE gla_vao_cache *gla_create_vao_cache(void);
 
-// -----------------------------------------------------------------------------
-GLA_LINKAGE GLuint gla_build_program(GLuint vertex_shader,
-                                    GLuint tessellation_control_shader,
-                                    GLuint tessellation_evaluation_shader,
+/**
+ * \brief Delete a vertex array object cache and its vertex array objects.
+ * \param cache Specifies the cache to be deleted.
+ * \note This function is the counterpart to gla_create_vao_cache().
+ */
+GLA_LINKAGE void gla_delete_vao_cache(gla_vao_cache *cache);
+
+/**
+ * \brief Return the vertex array of a vertex format, creating its vertex
+ *      array object with glVertexArrayAttribFormat on first use.
+ * \param cache Specifies the cache.
+ * \param format Specifies the vertex format.
+ * \return The vertex array, or \c NULL if an error occurred. The pointer
+ *      stays valid until the cache is deleted.
+ * \note Requires OpenGL 4.5 or \c ARB_direct_state_access.
+ */
+GLA_LINKAGE gla_vertex_array *gla_get_vertex_array(gla_vao_cache *cache,
+                                                const gla_vertex_format *format);
+
+/**
+ * \brief Bind a vertex array and attach buffers to its binding points. Only
+ *      the binding points and the vertex array object that differ from the
+ *      current state are touched.
+ * \param cache Specifies the cache that owns \p vertex_array.
+ * \param vertex_array Specifies the vertex array.
+ * \param buffers Specifies one buffer object per binding point of the format.
+ * \param offsets Specifies the offsets of the first elements in the buffers,
+ *              or \c NULL for zero offsets.
+ * \param element_buffer Specifies the index buffer object, or 0.
+ */
+GLA_LINKAGE void gla_bind_vertex_array(gla_vao_cache *cache,
+                                    gla_vertex_array *vertex_array,
+                                    const GLuint *buffers,
+                                    const GLintptr *offsets,
+                                    GLuint element_buffer);
+
+/**
+ * \brief Forget the vertex array object the cache assumes to be bound, e.g.
+ *      after code outside the cache has called glBindVertexArray.
+ * \param cache Specifies the cache.
+ */
+GLA_LINKAGE void gla_reset_vao_cache_binding(gla_vao_cache *cache);
+
+// -----------------------------------------------------------------------------
+// Stream buffers
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create a stream buffer backed by immutable, persistently mapped
+ *      storage.
+ * \param stream_buffer Specifies the stream buffer to be initialized.
+ * \param region_size Specifies the number of bytes available per frame. It is
+ *                  rounded up to a multiple of 256 bytes.
+ * \param num_regions Specifies the number of frames in flight, at most
+ *                  \c GLA_STREAM_BUFFER_MAX_REGIONS.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE otherwise.
+ * \note Requires OpenGL 4.4 or \c ARB_buffer_storage.
+ */
+GLA_LINKAGE GLboolean gla_create_stream_buffer(gla_stream_buffer *stream_buffer,
+                                            GLsizeiptr region_size,
+                                            GLuint num_regions);
+
+/**
+ * \brief Delete a stream buffer.
+ * \param stream_buffer Specifies the stream buffer to be deleted.
+ * \note This function is the counterpart to
+ *      gla_create_stream_buffer(gla_stream_buffer *, GLsizeiptr, GLuint).
+ */
+GLA_LINKAGE void gla_delete_stream_buffer(gla_stream_buffer *stream_buffer);
+
+/**
+ * \brief Advance a stream buffer to the next frame region, waiting until the
+ *      GPU has finished reading it.
+ * \param stream_buffer Specifies the stream buffer.
+ */
+GLA_LINKAGE void gla_begin_stream_buffer_frame(gla_stream_buffer *stream_buffer);
+
+/**
+ * \brief Guard the current frame region of a stream buffer with a fence.
+ * \param stream_buffer Specifies the stream buffer.
+ * \note Call this after the last command that reads the frame's data has
+ *      been issued.
+ */
+GLA_LINKAGE void gla_end_stream_buffer_frame(gla_stream_buffer *stream_buffer);
+
+/**
+ * \brief Allocate a range from the current frame region of a stream buffer.
+ * \param stream_buffer Specifies the stream buffer.
+ * \param size Specifies the number of bytes to be allocated.
+ * \param alignment Specifies the alignment of the range's buffer offset. It
+ *                  must be a power of two, or 0 for no alignment.
+ * \param offset Returns the offset of the range in the buffer object.
+ * \return The mapped pointer to the range, or \c NULL if it does not fit into
+ *      the region.
+ * \note The range stays valid until the end of the frame.
+ */
+GLA_LINKAGE void *gla_alloc_stream_buffer_range(gla_stream_buffer *stream_buffer,
+                                                GLsizeiptr size,
+                                                GLsizeiptr alignment,
+                                                GLintptr *offset);
+
+/**
+ * \brief Print the statistics of a stream buffer to the standard output.
+ * \param stream_buffer Specifies the stream buffer.
+ */
+GLA_LINKAGE void gla_print_stream_buffer_stats(
+    const gla_stream_buffer *stream_buffer);
+
+// -----------------------------------------------------------------------------
+// Draw batchers
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create a draw batcher whose commands and per-draw data are streamed
+ *      through a persistently mapped stream buffer.
+ * \param max_draws Specifies the maximum number of draws per flush.
+ * \param draw_data_size Specifies the size of the per-draw data in bytes, or 0
+ *                      for none. It should match the std430 array stride of
+ *                      the shader storage block that reads it.
+ * \param draw_data_binding Specifies the shader storage buffer binding point
+ *                          of the per-draw data. The shader indexes the data
+ *                          with gl_DrawID.
+ * \return The draw batcher, or \c NULL if an error occurred.
+ * \note Requires OpenGL 4.4 and GLSL 4.60 or \c ARB_shader_draw_parameters
+ *      for gl_DrawID.
+ */
+GLA_LINKAGE gla_draw_batcher *gla_create_draw_batcher(GLuint max_draws,
+                                                    GLsizei draw_data_size,
+                                                    GLuint draw_data_binding);
+
+/**
+ * \brief Delete a draw batcher.
+ * \param batcher Specifies the draw batcher to be deleted.
+ * \note This function is the counterpart to
+ *      gla_create_draw_batcher(GLuint, GLsizei, GLuint).
+ */
+GLA_LINKAGE void gla_delete_draw_batcher(gla_draw_batcher *batcher);
+
+/**
+ * \brief Record a draw.
+ * \param batcher Specifies the draw batcher.
+ * \param draw Specifies the draw.
+ * \param draw_data Specifies the per-draw data, or \c NULL.
+ * \return Returns \c GL_FALSE if the batcher is full, and \c GL_TRUE
+ *      otherwise.
+ */
+GLA_LINKAGE GLboolean gla_add_draw(gla_draw_batcher *batcher,
+                                const gla_draw *draw, const void *draw_data);
+
+/**
+ * \brief Sort the recorded draws into buckets of equal state key and index
+ *      type, and issue one glMultiDrawElementsIndirect call per bucket.
+ * \param batcher Specifies the draw batcher.
+ * \param mode Specifies the primitive mode, e.g. \c GL_TRIANGLES.
+ * \param bind_state Specifies the function that is called before each bucket
+ *                  to bind the state (program, vertex array, textures) that
+ *                  belongs to \p key, or \c NULL.
+ * \param user Specifies the user data passed to \p bind_state.
+ * \return The number of multi-draw calls.
+ * \note Draws with equal keys keep their recording order. The batcher is
+ *      empty afterwards.
+ */
+GLA_LINKAGE GLuint gla_flush_draw_batcher(gla_draw_batcher *batcher,
+                                        GLenum mode,
+                                        void (*bind_state)(void *user,
+                                                        GLuint64 key,
+                                                        GLenum index_type),
+                                        void *user);
+
+// -----------------------------------------------------------------------------
+// Instanced meshes
+// -----------------------------------------------------------------------------
+/**
+ * \brief Allocate the per-instance streams of an instanced mesh for the
+ *      current frame of a stream buffer.
+ * \param mesh Specifies the instanced mesh. Its instance bindings are pointed
+ *            at the allocated ranges.
+ * \param stream_buffer Specifies the stream buffer.
+ * \param instance_count Specifies the number of instances.
+ * \param streams Returns the mapped pointer of every per-instance binding, to
+ *               be filled with tightly packed elements of the binding
+ *               stride, and \c NULL for the per-vertex bindings.
+ * \return Returns \c GL_FALSE if the stream buffer frame is full, and
+ *      \c GL_TRUE otherwise.
+ */
+GLA_LINKAGE GLboolean gla_alloc_instance_streams(
+    gla_instanced_mesh *mesh, gla_stream_buffer *stream_buffer,
+    GLsizei instance_count, void *streams[GLA_MAX_VERTEX_BINDINGS]);
+
+/**
+ * \brief Draw all instances of an instanced mesh with one call.
+ * \param cache Specifies the vertex array object cache the vertex array of the
+ *             mesh belongs to.
+ * \param mesh Specifies the instanced mesh.
+ * \param mode Specifies the primitive mode, e.g. \c GL_TRIANGLES.
+ * \param instance_count Specifies the number of instances.
+ * \note The per-instance streams are read from the ranges of the last
+ *      gla_alloc_instance_streams(gla_instanced_mesh *, gla_stream_buffer *,
+ *      GLsizei, void **) call.
+ */
+GLA_LINKAGE void gla_draw_instanced_mesh(gla_vao_cache *cache,
+                                        const gla_instanced_mesh *mesh,
+                                        GLenum mode, GLsizei instance_count);
+
+// -----------------------------------------------------------------------------
+// Render queues
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create a render queue.
+ * \param max_packets Specifies the maximum number of packets per frame.
+ * \param packet_size Specifies the size of a packet in bytes.
+ * \return The render queue, or \c NULL if an error occurred.
+ */
+GLA_LINKAGE gla_render_queue *gla_create_render_queue(GLuint max_packets,
+                                                    GLsizei packet_size);
+
+/**
+ * \brief Delete a render queue.
+ * \param queue Specifies the render queue to be deleted.
+ * \note This function is the counterpart to
+ *      gla_create_render_queue(GLuint, GLsizei).
+ */
+GLA_LINKAGE void gla_delete_render_queue(gla_render_queue *queue);
+
+/**
+ * \brief Push a render packet.
+ * \param queue Specifies the render queue.
+ * \param key Specifies the sort key, see GLA_RENDER_KEY.
+ * \return The packet to be filled in, or \c NULL if the queue is full.
+ */
+GLA_LINKAGE void *gla_push_render_packet(gla_render_queue *queue,
+                                        GLuint64 key);
+
+/**
+ * \brief Sort the packets of a render queue by key with an LSD radix sort.
+ * \param queue Specifies the render queue.
+ * \note Packets with equal keys keep their push order. Key bits that are
+ *      equal across all packets are skipped, and the remaining bits are
+ *      sorted in digits of up to 11 bits. If the varying bits and the packet
+ *      index fit into 64 bits, they are sorted as one word.
+ */
+GLA_LINKAGE void gla_sort_render_queue(gla_render_queue *queue);
+
+/**
+ * \brief Submit the packets of a render queue in their current order, and
+ *      clear the queue.
+ * \param queue Specifies the render queue.
+ * \param state_mask Specifies the key bits that select state, e.g.
+ *                  \c GLA_RENDER_KEY_PROGRAM_MASK |
+ *                  \c GLA_RENDER_KEY_MATERIAL_MASK.
+ * \param bind_state Specifies the function that is called before a packet
+ *                  whose key differs from its predecessor's in
+ *                  \p state_mask. \p changed holds the differing bits, all
+ *                  of \p state_mask for the first packet.
+ * \param draw Specifies the function that is called for every packet.
+ * \param user Specifies the user data passed to the functions.
+ */
+GLA_LINKAGE void gla_submit_render_queue(
+    gla_render_queue *queue, GLuint64 state_mask,
+    void (*bind_state)(void *user, GLuint64 key, GLuint64 changed),
+    void (*draw)(void *user, GLuint64 key, const void *packet), void *user);
+
+// -----------------------------------------------------------------------------
+// Command buffers
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create a command buffer.
+ * \param initial_size Specifies the initial size of the arena in bytes. The
+ *                    arena grows when it is full.
+ * \return The command buffer, or \c NULL if an error occurred.
+ * \note A command buffer must only be recorded by one thread at a time.
+ *      Recording does not call OpenGL.
+ */
+GLA_LINKAGE gla_command_buffer *gla_create_command_buffer(
+    GLsizeiptr initial_size);
+
+/**
+ * \brief Delete a command buffer.
+ * \param buffer Specifies the command buffer to be deleted.
+ * \note This function is the counterpart to
+ *      gla_create_command_buffer(GLsizeiptr).
+ */
+GLA_LINKAGE void gla_delete_command_buffer(gla_command_buffer *buffer);
+
+/**
+ * \brief Remove all commands of a command buffer and keep its memory.
+ * \param buffer Specifies the command buffer.
+ */
+GLA_LINKAGE void gla_reset_command_buffer(gla_command_buffer *buffer);
+
+/**
+ * \brief Record glUseProgram.
+ */
+GLA_LINKAGE void gla_cmd_use_program(gla_command_buffer *buffer,
+                                    GLuint program);
+
+/**
+ * \brief Record glBindVertexArray.
+ */
+GLA_LINKAGE void gla_cmd_bind_vertex_array(gla_command_buffer *buffer,
+                                        GLuint vertex_array);
+
+/**
+ * \brief Record glBindBufferRange, or glBindBufferBase if \p size is 0.
+ * \param target Specifies \c GL_UNIFORM_BUFFER or
+ *              \c GL_SHADER_STORAGE_BUFFER.
+ */
+GLA_LINKAGE void gla_cmd_bind_buffer_range(gla_command_buffer *buffer,
+                                        GLenum target, GLuint index,
+                                        GLuint buffer_object, GLintptr offset,
+                                        GLsizeiptr size);
+
+/**
+ * \brief Record glBindTextureUnit.
+ */
+GLA_LINKAGE void gla_cmd_bind_texture_unit(gla_command_buffer *buffer,
+                                        GLuint unit, GLuint texture);
+
+/**
+ * \brief Record a uniform upload to the program in use at replay time.
+ * \param type Specifies \c GL_FLOAT, \c GL_FLOAT_VEC2, \c GL_FLOAT_VEC3,
+ *            \c GL_FLOAT_VEC4, \c GL_FLOAT_MAT4, \c GL_INT or
+ *            \c GL_UNSIGNED_INT. Other types are not recorded.
+ * \param data Specifies \p count values of \p type, which are copied.
+ */
+GLA_LINKAGE void gla_cmd_uniform(gla_command_buffer *buffer, GLint location,
+                                GLenum type, GLsizei count, const void *data);
+
+/**
+ * \brief Record glDrawElementsInstancedBaseVertexBaseInstance. The key of
+ *      \p draw is ignored.
+ */
+GLA_LINKAGE void gla_cmd_draw_elements(gla_command_buffer *buffer,
+                                    GLenum mode, const gla_draw *draw);
+
+/**
+ * \brief Record glMultiDrawElementsIndirect with tightly packed commands.
+ */
+GLA_LINKAGE void gla_cmd_multi_draw_elements_indirect(
+    gla_command_buffer *buffer, GLenum mode, GLenum index_type,
+    GLuint indirect_buffer, GLintptr offset, GLsizei draw_count);
+
+/**
+ * \brief Record glDispatchCompute.
+ */
+GLA_LINKAGE void gla_cmd_dispatch_compute(gla_command_buffer *buffer,
+                                        GLuint num_groups_x,
+                                        GLuint num_groups_y,
+                                        GLuint num_groups_z);
+
+/**
+ * \brief Record glMemoryBarrier.
+ */
+GLA_LINKAGE void gla_cmd_memory_barrier(gla_command_buffer *buffer,
+                                        GLbitfield barriers);
+
+/**
+ * \brief Record a function call, for everything that has no command.
+ */
+GLA_LINKAGE void gla_cmd_callback(gla_command_buffer *buffer,
+                                void (*callback)(void *arg), void *arg);
+
+/**
+ * \brief Set a state tracker to unknown state so that the next replay binds
+ *      everything.
+ * \param tracker Specifies the state tracker.
+ * \note Must be called whenever the bindings were changed outside of command
+ *      buffer replay.
+ */
+GLA_LINKAGE void gla_reset_state_tracker(gla_state_tracker *tracker);
+
+/**
+ * \brief Replay command buffers in array order.
+ * \param buffers Specifies the command buffers.
+ * \param count Specifies the number of command buffers.
+ * \param tracker Specifies the state tracker used to skip redundant state
+ *               changes. It must have been initialized with
+ *               gla_reset_state_tracker(gla_state_tracker *).
+ * \note Must be called on the thread that owns the OpenGL context, after
+ *      all recording threads are done. The command buffers are left
+ *      unchanged. Vertex array binds bypass any gla_vao_cache, so reset its
+ *      binding afterwards with gla_reset_vao_cache_binding(gla_vao_cache *).
+ */
+GLA_LINKAGE void gla_submit_command_buffers(gla_command_buffer *const *buffers,
+                                            GLuint count,
+                                            gla_state_tracker *tracker);
+
+// -----------------------------------------------------------------------------
+// Render threads
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create a render thread.
+ * \param num_frames Specifies the number of frame packets, 2 for double and 3
+ *                  for triple buffering. The producer blocks in
+ *                  gla_begin_render_frame(gla_render_thread *) while all of
+ *                  them are queued or being rendered.
+ * \param frame_size Specifies the size of a frame packet in bytes.
+ * \param init Specifies the function that is called on the render thread
+ *            before the first frame, e.g. to make the context current. The
+ *            thread is not created if it returns \c GL_FALSE.
+ * \param render Specifies the function that renders a frame packet.
+ * \param shutdown Specifies the function that is called on the render thread
+ *                after the last frame, or \c NULL.
+ * \param user Specifies the user data passed to the functions.
+ * \return The render thread, or \c NULL if an error occurred.
+ * \note The context must not be current on any other thread while the render
+ *      thread exists. Without POSIX threads, or if \c GLA_NO_THREADS is
+ *      defined before the implementation, no thread is created and every
+ *      frame is rendered on the calling thread in
+ *      gla_end_render_frame(gla_render_thread *).
+ */
+GLA_LINKAGE gla_render_thread *gla_create_render_thread(
+    GLuint num_frames, GLsizeiptr frame_size, GLboolean (*init)(void *user),
+    void (*render)(void *user, void *frame), void (*shutdown)(void *user),
+    void *user);
+
+/**
+ * \brief Render all queued frames, call the shutdown function and join a
+ *      render thread.
+ * \param thread Specifies the render thread to be deleted.
+ * \note This function is the counterpart to
+ *      gla_create_render_thread(GLuint, GLsizeiptr, GLboolean (*)(void *),
+ *      void (*)(void *, void *), void (*)(void *), void *).
+ */
+GLA_LINKAGE void gla_delete_render_thread(gla_render_thread *thread);
+
+/**
+ * \brief Begin the next frame packet on the producer thread.
+ * \param thread Specifies the render thread.
+ * \return The frame packet to be filled in. Blocks until one is free.
+ */
+GLA_LINKAGE void *gla_begin_render_frame(gla_render_thread *thread);
+
+/**
+ * \brief Hand the frame packet begun last over to the render thread.
+ * \param thread Specifies the render thread.
+ */
+GLA_LINKAGE void gla_end_render_frame(gla_render_thread *thread);
+
+/**
+ * \brief Block until the render thread has rendered all handed over frames.
+ * \param thread Specifies the render thread.
+ */
+GLA_LINKAGE void gla_wait_render_thread_idle(gla_render_thread *thread);
+
+/**
+ * \brief Get the statistics of a render thread.
+ * \param thread Specifies the render thread.
+ * \return The statistics. Every counter is read atomically, but while the
+ *      render thread runs the counters may be from slightly different
+ *      moments.
+ */
+GLA_LINKAGE gla_render_thread_stats gla_get_render_thread_stats(
+    const gla_render_thread *thread);
+
+// -----------------------------------------------------------------------------
+// Deletion queues
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create a deletion queue.
+ * \return The deletion queue, or \c NULL if an error occurred.
+ */
+GLA_LINKAGE gla_deletion_queue *gla_create_deletion_queue(void);
+
+/**
+ * \brief Wait for the GPU, delete all queued objects and the deletion queue.
+ * \param queue Specifies the deletion queue to be deleted.
+ * \note This function is the counterpart to gla_create_deletion_queue().
+ */
+GLA_LINKAGE void gla_delete_deletion_queue(gla_deletion_queue *queue);
+
+/**
+ * \brief Queue an object for deletion after the current frame has finished on
+ *      the GPU.
+ * \param queue Specifies the deletion queue.
+ * \param identifier Specifies the object type: \c GL_BUFFER, \c GL_SHADER,
+ *                  \c GL_PROGRAM, \c GL_VERTEX_ARRAY, \c GL_QUERY,
+ *                  \c GL_TEXTURE, \c GL_FRAMEBUFFER, \c GL_RENDERBUFFER or
+ *                  \c GL_SAMPLER, as for glObjectLabel.
+ * \param name Specifies the object name. 0 is ignored.
+ * \note This is the deferred counterpart to gla_delete_program(GLuint),
+ *      gla_delete_shader(GLuint), glDeleteBuffers and glDeleteTextures.
+ */
+GLA_LINKAGE void gla_defer_delete(gla_deletion_queue *queue, GLenum identifier,
+                                GLuint name);
+
+/**
+ * \brief Close the current frame of a deletion queue with a fence, and delete
+ *      the objects of all frames whose fences have signaled.
+ * \param queue Specifies the deletion queue.
+ * \return The number of deleted objects.
+ * \note Objects of one type are deleted with one call where OpenGL allows it.
+ */
+GLA_LINKAGE GLuint gla_end_deletion_queue_frame(gla_deletion_queue *queue);
+
+// -----------------------------------------------------------------------------
+// Object registries
+// -----------------------------------------------------------------------------
+/**
+ * \brief Register an object and record the calling source location.
+ */
+#define GLA_REGISTER_OBJECT(registry, identifier, name, size, label)           \
+    gla_register_object(registry, identifier, name, size, label, __FILE__,    \
+                        __LINE__)
+
+/**
+ * \brief Create an empty object registry.
+ * \return The object registry, or \c NULL if an error occurred.
+ */
+GLA_LINKAGE gla_object_registry *gla_create_object_registry(void);
+
+/**
+ * \brief Print the objects that are still registered to the standard error
+ *      and delete an object registry.
+ * \param registry Specifies the object registry to be deleted.
+ * \note The objects themselves are not deleted, since the context may be
+ *      gone at shutdown. This function is the counterpart to
+ *      gla_create_object_registry().
+ */
+GLA_LINKAGE void gla_delete_object_registry(gla_object_registry *registry);
+
+/**
+ * \brief Register an object and label it with glObjectLabel.
+ * \param registry Specifies the object registry.
+ * \param identifier Specifies the object type: \c GL_PROGRAM, \c GL_SHADER,
+ *                  \c GL_BUFFER, \c GL_VERTEX_ARRAY, \c GL_TEXTURE or
+ *                  \c GL_QUERY.
+ * \param name Specifies the object name.
+ * \param size Specifies the size of the object in bytes, or 0.
+ * \param label Specifies the label, or \c NULL. Longer labels are truncated.
+ * \param file Specifies the source file of the registration, or \c NULL.
+ * \param line Specifies the source line of the registration.
+ * \return The handle, or a zero handle if an error occurred.
+ * \note Use GLA_REGISTER_OBJECT to record the calling source location.
+ */
+GLA_LINKAGE gla_handle gla_register_object(gla_object_registry *registry,
+                                        GLenum identifier, GLuint name,
+                                        GLsizeiptr size, const GLchar *label,
+                                        const char *file, int line);
+
+/**
+ * \brief Release the slot of an object and delete the object.
+ * \param registry Specifies the object registry.
+ * \param handle Specifies the handle. Stale handles are ignored.
+ * \param queue Specifies the deletion queue the object is handed to, or
+ *             \c NULL to delete it right away.
+ */
+GLA_LINKAGE void gla_release_object(gla_object_registry *registry,
+                                    gla_handle handle,
+                                    gla_deletion_queue *queue);
+
+/**
+ * \brief Return the object name of a handle.
+ * \param registry Specifies the object registry.
+ * \param handle Specifies the handle.
+ * \param identifier Specifies the expected object type.
+ * \return The object name, or 0 if the handle is stale or of another type.
+ */
+GLA_LINKAGE GLuint gla_get_object(const gla_object_registry *registry,
+                                gla_handle handle, GLenum identifier);
+
+/**
+ * \brief Return the metadata of a handle.
+ * \param registry Specifies the object registry.
+ * \param handle Specifies the handle.
+ * \return The metadata, or \c NULL if the handle is stale. The pointer is
+ *      valid until the next registration.
+ */
+GLA_LINKAGE const gla_object_info *gla_get_object_info(
+    const gla_object_registry *registry, gla_handle handle);
+
+/**
+ * \brief Print all registered objects.
+ * \param registry Specifies the object registry.
+ * \param stream Specifies the output stream, e.g. \c stdout.
+ * \return The number of registered objects.
+ */
+GLA_LINKAGE GLuint gla_print_live_objects(const gla_object_registry *registry,
+                                        FILE *stream);
+
+// -----------------------------------------------------------------------------
+// Memory accounting
+// -----------------------------------------------------------------------------
+/**
+ * \brief Track the storage of a buffer or texture object.
+ * \param category Specifies the category, e.g. \c GLA_MEMORY_TEXTURE.
+ * \param identifier Specifies \c GL_BUFFER, \c GL_TEXTURE or
+ *                  \c GL_RENDERBUFFER.
+ * \param name Specifies the object name.
+ * \param size Specifies the size of the storage in bytes.
+ * \param label Specifies the label, or \c NULL. Longer labels are truncated.
+ * \return Returns \c GL_FALSE if the allocation exceeds a refusing budget, in
+ *      which case it is not tracked and the storage should not be created,
+ *      and \c GL_TRUE otherwise. Exceeding a warning budget prints a warning.
+ * \note Call it before the storage is created. Buffer arena pages and stream
+ *      buffers are tracked automatically. Thread-safe.
+ */
+GLA_LINKAGE GLboolean gla_track_memory(int category, GLenum identifier,
+                                    GLuint name, GLsizeiptr size,
+                                    const GLchar *label);
+
+/**
+ * \brief Stop tracking the storage of an object.
+ * \param identifier Specifies the object type.
+ * \param name Specifies the object name. Untracked objects are ignored.
+ * \note This function is the counterpart to
+ *      gla_track_memory(int, GLenum, GLuint, GLsizeiptr, const GLchar *).
+ */
+GLA_LINKAGE void gla_untrack_memory(GLenum identifier, GLuint name);
+
+/**
+ * \brief Set the budget of a memory category.
+ * \param category Specifies the category, or \c GLA_MEMORY_TOTAL.
+ * \param budget Specifies the budget in bytes, or 0 for none.
+ * \param refuse Specifies whether allocations over budget are refused
+ *              rather than only warned about.
+ */
+GLA_LINKAGE void gla_set_memory_budget(int category, GLsizeiptr budget,
+                                    GLboolean refuse);
+
+/**
+ * \brief Return the statistics of a memory category.
+ * \param category Specifies the category, or \c GLA_MEMORY_TOTAL.
+ * \return The statistics.
+ */
+GLA_LINKAGE gla_memory_stats gla_get_memory_stats(int category);
+
+/**
+ * \brief Print the statistics of all memory categories and every tracked
+ *      object.
+ * \param stream Specifies the output stream, e.g. \c stdout.
+ */
+GLA_LINKAGE void gla_print_memory_report(FILE *stream);
+
+/**
+ * \brief Write the statistics of all memory categories and every tracked
+ *      object to a JSON file.
+ * \param filename Specifies the name of the file to be written.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE otherwise.
+ */
+GLA_LINKAGE GLboolean gla_write_memory_report(const GLchar *filename);
+
+/**
+ * \brief Write the memory report when the program exits.
+ * \param filename Specifies the name of the JSON file, or \c NULL to print
+ *                the report to the standard output.
+ */
+GLA_LINKAGE void gla_write_memory_report_at_exit(const GLchar *filename);
+
+/**
+ * \brief Return the storage size of a texture.
+ * \param target Specifies the texture target. The depth is halved per mipmap
+ *              level for \c GL_TEXTURE_3D only.
+ * \param levels Specifies the number of mipmap levels.
+ * \param internal_format Specifies the sized internal format.
+ * \param width Specifies the width of the base level.
+ * \param height Specifies the height of the base level.
+ * \param depth Specifies the depth, or the number of layers (6 per cube map).
+ * \return The size in bytes, or 0 for an unknown format.
+ */
+GLA_LINKAGE GLsizeiptr gla_texture_storage_size(GLenum target, GLsizei levels,
+                                                GLenum internal_format,
+                                                GLsizei width, GLsizei height,
+                                                GLsizei depth);
+
+// -----------------------------------------------------------------------------
+// Meshes
+// -----------------------------------------------------------------------------
+/**
+ * \brief Write a mesh in the binary mesh format.
+ * \param filename Specifies the name of the file to be written.
+ * \param format Specifies the vertex format. Every binding with attributes
+ *              becomes one stream, which must be per-vertex.
+ * \param streams Specifies the vertex data of every binding, tightly packed
+ *               with the binding stride.
+ * \param num_vertices Specifies the number of vertices.
+ * \param indices Specifies the index data.
+ * \param index_type Specifies \c GL_UNSIGNED_BYTE, \c GL_UNSIGNED_SHORT or
+ *                   \c GL_UNSIGNED_INT, e.g. from gla_choose_index_type.
+ * \param num_indices Specifies the number of indices.
+ * \param submeshes Specifies the submeshes including their bounds and
+ *                  primitive modes.
+ * \param num_submeshes Specifies the number of submeshes.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE otherwise.
+ */
+GLA_LINKAGE GLboolean gla_write_mesh(const GLchar *filename,
+                                    const gla_vertex_format *format,
+                                    const void *const *streams,
+                                    GLuint num_vertices, const void *indices,
+                                    GLenum index_type, GLuint num_indices,
+                                    const gla_mesh_submesh *submeshes,
+                                    GLuint num_submeshes);
+
+/**
+ * \brief Load a binary mesh file. The file is memory mapped and every stream
+ *      is uploaded straight from the mapping with one glNamedBufferStorage.
+ * \param mesh Specifies the mesh to be initialized.
+ * \param filename Specifies the name of the file to be read.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE otherwise.
+ * \note Requires OpenGL 4.5 or \c ARB_direct_state_access.
+ */
+GLA_LINKAGE GLboolean gla_load_mesh(gla_mesh *mesh, const GLchar *filename);
+
+/**
+ * \brief Delete the buffer objects and submeshes of a mesh.
+ * \param mesh Specifies the mesh to be deleted.
+ * \note This function is the counterpart to
+ *      gla_load_mesh(gla_mesh *, const GLchar *).
+ */
+GLA_LINKAGE void gla_delete_mesh(gla_mesh *mesh);
+
+/**
+ * \brief Return the draw of a submesh, e.g. for gla_add_draw.
+ * \param mesh Specifies the mesh.
+ * \param submesh Specifies the submesh index.
+ * \return The draw of one instance with key 0.
+ * \note Draw the submesh with its mode. Strips need
+ *      \c GL_PRIMITIVE_RESTART_FIXED_INDEX to be enabled.
+ */
+GLA_LINKAGE gla_draw gla_get_mesh_draw(const gla_mesh *mesh, GLuint submesh);
+
+// -----------------------------------------------------------------------------
+// Mesh optimization
+// -----------------------------------------------------------------------------
+/**
+ * \brief Simulate the post-transform vertex cache for a triangle list.
+ * \param indices Specifies the triangle list.
+ * \param num_indices Specifies the number of indices.
+ * \param num_vertices Specifies the number of vertices.
+ * \param cache_size Specifies the number of FIFO cache entries, e.g. 16.
+ * \return The statistics, which are all 0 on failure.
+ */
+GLA_LINKAGE gla_vertex_cache_stats
+gla_analyze_vertex_cache(const GLuint *indices, GLuint num_indices,
+                        GLuint num_vertices, GLuint cache_size);
+
+/**
+ * \brief Reorder the triangles of a triangle list for post-transform vertex
+ *      cache hits with Forsyth's linear-speed algorithm.
+ * \param dst Specifies the reordered triangle list, which may be \p indices.
+ * \param indices Specifies the triangle list.
+ * \param num_indices Specifies the number of indices.
+ * \param num_vertices Specifies the number of vertices.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE otherwise.
+ */
+GLA_LINKAGE GLboolean gla_optimize_vertex_cache(GLuint *dst,
+                                                const GLuint *indices,
+                                                GLuint num_indices,
+                                                GLuint num_vertices);
+
+/**
+ * \brief Reorder clusters of a cache optimized triangle list so that outer,
+ *      outward facing clusters are drawn first, which reduces overdraw.
+ * \param dst Specifies the reordered triangle list, which may be \p indices.
+ * \param indices Specifies the triangle list, ordered by
+ *               gla_optimize_vertex_cache.
+ * \param num_indices Specifies the number of indices.
+ * \param positions Specifies the first vertex position (3 floats).
+ * \param position_stride Specifies the byte offset between positions.
+ * \param num_vertices Specifies the number of vertices.
+ * \param threshold Specifies the allowed vertex cache degradation, e.g. 1.05
+ *                  to accept a 5% higher ACMR for smaller clusters.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE otherwise.
+ */
+GLA_LINKAGE GLboolean gla_optimize_overdraw(GLuint *dst, const GLuint *indices,
+                                            GLuint num_indices,
+                                            const GLfloat *positions,
+                                            GLsizei position_stride,
+                                            GLuint num_vertices,
+                                            GLfloat threshold);
+
+/**
+ * \brief Compute a vertex order in which the triangle list fetches vertices
+ *      sequentially.
+ * \param remap Specifies the new index of every vertex. Vertices that are not
+ *              referenced get \c 0xffffffff.
+ * \param indices Specifies the triangle list.
+ * \param num_indices Specifies the number of indices.
+ * \param num_vertices Specifies the number of vertices.
+ * \return The number of referenced vertices.
+ * \note Apply the remap to every vertex stream with gla_remap_vertices and to
+ *      the triangle list with gla_remap_indices.
+ */
+GLA_LINKAGE GLuint gla_optimize_vertex_fetch_remap(GLuint *remap,
+                                                    const GLuint *indices,
+                                                    GLuint num_indices,
+                                                    GLuint num_vertices);
+
+/**
+ * \brief Reorder vertex data by a remap.
+ * \param dst Specifies the reordered vertex data, which must not be \p src.
+ * \param src Specifies the vertex data.
+ * \param num_vertices Specifies the number of source vertices.
+ * \param vertex_size Specifies the size of one vertex in bytes.
+ * \param remap Specifies the new index of every vertex.
+ */
+GLA_LINKAGE void gla_remap_vertices(void *dst, const void *src,
+                                    GLuint num_vertices, GLsizei vertex_size,
+                                    const GLuint *remap);
+
+/**
+ * \brief Replace every index by its new index.
+ * \param dst Specifies the remapped indices, which may be \p indices.
+ * \param indices Specifies the indices.
+ * \param num_indices Specifies the number of indices.
+ * \param remap Specifies the new index of every vertex.
+ */
+GLA_LINKAGE void gla_remap_indices(GLuint *dst, const GLuint *indices,
+                                    GLuint num_indices, const GLuint *remap);
+
+// -----------------------------------------------------------------------------
+// Index buffers
+// -----------------------------------------------------------------------------
+/**
+ * \brief Return the smallest index type that can address a number of
+ *      vertices.
+ * \param num_vertices Specifies the number of vertices.
+ * \param primitive_restart Specifies whether the largest value of the type is
+ *                          reserved as primitive restart index.
+ * \return \c GL_UNSIGNED_BYTE, \c GL_UNSIGNED_SHORT or \c GL_UNSIGNED_INT.
+ * \note Some hardware converts 8-bit indices on the fly. Use at least
+ *      \c GL_UNSIGNED_SHORT where that matters more than the memory.
+ */
+GLA_LINKAGE GLenum gla_choose_index_type(GLuint num_vertices,
+                                        GLboolean primitive_restart);
+
+/**
+ * \brief Return the fixed primitive restart index of an index type, i.e. its
+ *      largest value.
+ * \param index_type Specifies the index type.
+ * \return The primitive restart index.
+ */
+GLA_LINKAGE GLuint gla_get_primitive_restart_index(GLenum index_type);
+
+/**
+ * \brief Convert 32-bit indices to an index type. The restart index
+ *      \c 0xffffffff becomes the restart index of the type.
+ * \param dst Specifies the converted indices, which may be \p indices.
+ * \param index_type Specifies the index type of \p dst.
+ * \param indices Specifies the indices, which must fit the type.
+ * \param num_indices Specifies the number of indices.
+ */
+GLA_LINKAGE void gla_convert_indices(void *dst, GLenum index_type,
+                                    const GLuint *indices,
+                                    GLuint num_indices);
+
+/**
+ * \brief Turn a triangle list into triangle strips separated by the restart
+ *      index \c 0xffffffff. Triangles are taken in list order, so that a cache
+ *      optimized order is mostly kept.
+ * \param dst Specifies the strips, with room for 4 / 3 * \p num_indices
+ *            indices. It must not be \p indices.
+ * \param indices Specifies the triangle list with consistent winding.
+ * \param num_indices Specifies the number of indices.
+ * \param num_vertices Specifies the number of vertices.
+ * \return The number of strip indices, or 0 on failure.
+ * \note Draw the strips with \c GL_TRIANGLE_STRIP and
+ *      \c GL_PRIMITIVE_RESTART_FIXED_INDEX enabled.
+ */
+GLA_LINKAGE GLuint gla_generate_triangle_strips(GLuint *dst,
+                                                const GLuint *indices,
+                                                GLuint num_indices,
+                                                GLuint num_vertices);
+
+// -----------------------------------------------------------------------------
+// Vertex quantization
+// -----------------------------------------------------------------------------
+/**
+ * \brief Append a quantized attribute to a vertex format.
+ * \param format Specifies the vertex format.
+ * \param location Specifies the attribute index in the vertex shader.
+ * \param binding Specifies the buffer binding point.
+ * \param encoding Specifies the encoding, e.g. \c GLA_QUANTIZED_POSITION.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE otherwise.
+ */
+GLA_LINKAGE GLboolean gla_add_quantized_vertex_attrib(gla_vertex_format *format,
+                                                    GLuint location,
+                                                    GLuint binding,
+                                                    GLenum encoding);
+
+/**
+ * \brief Return the size of a quantized attribute in bytes.
+ * \param encoding Specifies the encoding.
+ * \return The size in bytes, or 0 for an unknown encoding.
+ */
+GLA_LINKAGE GLsizei gla_quantized_attrib_size(GLenum encoding);
+
+/**
+ * \brief Quantize positions to 16-bit values relative to an AABB, which
+ *      halves their size. The result has the encoding
+ *      \c GLA_QUANTIZED_POSITION.
+ * \param dst Specifies the quantized positions, 4 values each.
+ * \param positions Specifies the first position (3 floats).
+ * \param stride Specifies the byte offset between positions.
+ * \param num_vertices Specifies the number of positions.
+ * \param aabb_min Specifies the minimum corner of the AABB, e.g. of the mesh.
+ * \param aabb_max Specifies the maximum corner of the AABB.
+ */
+GLA_LINKAGE void gla_quantize_positions(GLushort *dst,
+                                        const GLfloat *positions,
+                                        GLsizei stride, GLuint num_vertices,
+                                        const GLfloat aabb_min[3],
+                                        const GLfloat aabb_max[3]);
+
+/**
+ * \brief Return the column-major matrix that maps quantized positions back
+ *      into the AABB.
+ * \param matrix Specifies the matrix to be written.
+ * \param aabb_min Specifies the minimum corner of the quantization AABB.
+ * \param aabb_max Specifies the maximum corner of the quantization AABB.
+ */
+GLA_LINKAGE void gla_get_position_dequantization(GLfloat matrix[16],
+                                                const GLfloat aabb_min[3],
+                                                const GLfloat aabb_max[3]);
+
+/**
+ * \brief Quantize unit vectors such as normals and tangents with the
+ *      octahedral mapping.
+ * \param dst Specifies the quantized vectors.
+ * \param encoding Specifies \c GLA_QUANTIZED_OCTAHEDRAL_10, \c _16 or
+ *                 \c _16_SIGN.
+ * \param vectors Specifies the first vector (3 floats, or 4 floats with the
+ *                sign in w).
+ * \param stride Specifies the byte offset between vectors.
+ * \param num_vertices Specifies the number of vectors.
+ * \param has_signs Specifies whether every vector is followed by a sign,
+ *                  e.g. the handedness of a tangent frame. Otherwise the sign
+ *                  is +1.
+ * \return Returns \c GL_TRUE on success, and \c GL_FALSE for an unknown
+ *      encoding.
+ * \note Decode the vectors with gla_decode_octahedral of
+ *      \c GLA_DEQUANTIZATION_GLSL.
+ */
+GLA_LINKAGE GLboolean gla_quantize_unit_vectors(void *dst, GLenum encoding,
+                                                const GLfloat *vectors,
+                                                GLsizei stride,
+                                                GLuint num_vertices,
+                                                GLboolean has_signs);
+
+/**
+ * \brief Convert floats to half floats, rounding to nearest even. F16C
+ *      instructions are used if the processor has them.
+ * \param dst Specifies the half floats.
+ * \param src Specifies the floats.
+ * \param count Specifies the number of values.
+ */
+GLA_LINKAGE void gla_convert_to_half_floats(GLushort *dst, const GLfloat *src,
+                                            size_t count);
+
+// -----------------------------------------------------------------------------
+// Mesh simplification
+// -----------------------------------------------------------------------------
+/**
+ * \brief Simplify a triangle list with quadric error edge collapses. Vertices
+ *      are collapsed onto neighboring vertices, so the vertex data stays valid.
+ *      Vertices on attribute seams, i.e. with several vertices at their
+ *      position, and on non-manifold edges are kept, and border vertices only
+ *      move along the border.
+ * \param dst Specifies the simplified triangle list with room for
+ *            \p num_indices indices, which may be \p indices.
+ * \param indices Specifies the triangle list.
+ * \param num_indices Specifies the number of indices.
+ * \param positions Specifies the first vertex position (3 floats).
+ * \param position_stride Specifies the byte offset between positions.
+ * \param num_vertices Specifies the number of vertices.
+ * \param target_index_count Specifies the number of indices to stop at.
+ * \param target_error Specifies the largest error to accept in model units.
+ * \param result_error Specifies where to store the error of the result, or
+ *                     \c NULL. The error is estimated as the root mean
+ *                     square distance to the planes of the original
+ *                     triangles around the collapsed vertices.
+ * \return The number of indices of the simplified triangle list, or 0 on
+ *      failure.
+ */
+GLA_LINKAGE GLuint gla_simplify_mesh(GLuint *dst, const GLuint *indices,
+                                    GLuint num_indices,
+                                    const GLfloat *positions,
+                                    GLsizei position_stride,
+                                    GLuint num_vertices,
+                                    GLuint target_index_count,
+                                    GLfloat target_error,
+                                    GLfloat *result_error);
+
+/**
+ * \brief Select the level of detail of a submesh whose simplification error
+ *      projects to at most a number of pixels.
+ * \param mesh Specifies the mesh.
+ * \param submesh Specifies a full detail submesh, i.e. with error 0.
+ * \param model_view Specifies the column-major model-view matrix, e.g. the
+ *                   product of a cgm camera's view and the model matrix.
+ * \param projection Specifies the column-major projection matrix.
+ * \param viewport_height Specifies the viewport height in pixels.
+ * \param max_pixel_error Specifies the largest acceptable error in pixels.
+ * \return The index of the coarsest acceptable submesh of the chain.
+ */
+GLA_LINKAGE GLuint gla_select_mesh_lod(const gla_mesh *mesh, GLuint submesh,
+                                        const GLfloat model_view[16],
+                                        const GLfloat projection[16],
+                                        GLfloat viewport_height,
+                                        GLfloat max_pixel_error);
+
+// -----------------------------------------------------------------------------
+// Meshlets
+// -----------------------------------------------------------------------------
+/**
+ * \brief Return the maximum number of meshlets that a triangle list is split
+ *      into.
+ * \param num_indices Specifies the number of indices.
+ * \return The maximum number of meshlets.
+ */
+GLA_LINKAGE GLuint gla_get_max_meshlets(GLuint num_indices);
+
+/**
+ * \brief Split a triangle list into meshlets of at most
+ *      \c GLA_MESHLET_MAX_VERTICES vertices and \c GLA_MESHLET_MAX_TRIANGLES
+ *      triangles. Meshlets grow by the adjacent triangle that adds the fewest
+ *      vertices, so that they are compact and cull well.
+ * \param meshlets Specifies the meshlets with room for
+ *                 gla_get_max_meshlets(GLuint) meshlets.
+ * \param dst Specifies the triangle list reordered into meshlets, which may be
+ *            \p indices.
+ * \param indices Specifies the triangle list.
+ * \param num_indices Specifies the number of indices.
+ * \param positions Specifies the first vertex position (3 floats).
+ * \param position_stride Specifies the byte offset between positions.
+ * \param num_vertices Specifies the number of vertices.
+ * \return The number of meshlets, or 0 on failure.
+ */
+GLA_LINKAGE GLuint gla_build_meshlets(gla_meshlet *meshlets, GLuint *dst,
+                                    const GLuint *indices, GLuint num_indices,
+                                    const GLfloat *positions,
+                                    GLsizei position_stride,
+                                    GLuint num_vertices);
+
+/**
+ * \brief Build the compute program that culls meshlets against the view
+ *      frustum and by their normal cones.
+ * \param output Specifies the output, \c GLA_MESHLET_CULL_COMMANDS or
+ *               \c GLA_MESHLET_CULL_INDICES.
+ * \return The program object, or 0 if an error occurred.
+ * \note Requires OpenGL 4.3.
+ */
+GLA_LINKAGE GLuint gla_build_meshlet_cull_program(GLuint output);
+
+/**
+ * \brief Cull meshlets on the GPU and wait until the output may be drawn.
+ * \param program Specifies the program of
+ *                gla_build_meshlet_cull_program(GLuint).
+ * \param output Specifies the output the program was built for.
+ * \param meshlet_buffer Specifies the buffer of the meshlets.
+ * \param num_meshlets Specifies the number of meshlets.
+ * \param index_buffer Specifies the buffer of the 32-bit triangle list of
+ *                     the meshlets. Only read for
+ *                     \c GLA_MESHLET_CULL_INDICES.
+ * \param model_view_projection Specifies the column-major model-view-
+ *                              projection matrix.
+ * \param camera_position Specifies the camera position in model space.
+ * \param output_buffer Specifies the buffer of the indirect commands with
+ *                      room for \p num_meshlets commands, or of the indices
+ *                      with room for all indices of the meshlets.
+ * \param count_buffer Specifies the buffer of the number of commands, i.e.
+ *                     the parameter buffer of
+ *                     glMultiDrawElementsIndirectCount, or of the one
+ *                     command that draws the indices.
+ * \note Meshlets are tested as given, so the model-view-projection matrix and
+ *      camera position must be those of the model space of the meshlets. The
+ *      output order is arbitrary. The program and shader storage buffer
+ *      bindings 0 to 3 are changed.
+ */
+GLA_LINKAGE void gla_cull_meshlets(GLuint program, GLuint output,
+                                    GLuint meshlet_buffer,
+                                    GLuint num_meshlets, GLuint index_buffer,
+                                    const GLfloat model_view_projection[16],
+                                    const GLfloat camera_position[3],
+                                    GLuint output_buffer, GLuint count_buffer);
+
+// -----------------------------------------------------------------------------
+// Object culling
+// -----------------------------------------------------------------------------
+/**
+ * \brief Build the compute program that culls objects against the view
+ *      frustum and writes indirect commands for the visible ones.
+ * \param output Specifies the output, \c GLA_OBJECT_CULL_COMPACT or
+ *               \c GLA_OBJECT_CULL_FIXED.
+ * \return The program object, or 0 if an error occurred.
+ * \note Requires OpenGL 4.3. Custom cull programs, e.g. built with
+ *      gla_build_compute_program_from_file(const GLchar *), work with
+ *      gla_cull_objects if they keep the interface: a local size of 64,
+ *      shader storage bindings 0 to 3 for the objects, the transforms
+ *      (\c mat4), the commands and the count, and the uniforms
+ *      \c vec4 \c planes[6] at location 0, \c uint \c num_objects at
+ *      location 6 and \c uint \c phase at location 7. Occlusion culling adds
+ *      binding 4 for the visibility, the Hi-Z pyramid at texture unit 0, and
+ *      \c mat4 \c view_projection at location 8 and \c ivec2
+ *      \c depth_size at location 12.
+ */
+GLA_LINKAGE GLuint gla_build_object_cull_program(GLuint output);
+
+/**
+ * \brief Cull objects on the GPU and wait until the commands may be drawn.
+ * \param program Specifies the program of
+ *                gla_build_object_cull_program(GLuint).
+ * \param object_buffer Specifies the buffer of the objects.
+ * \param transform_buffer Specifies the buffer of the column-major model
+ *                         matrices.
+ * \param num_objects Specifies the number of objects.
+ * \param view_projection Specifies the column-major view-projection matrix.
+ * \param command_buffer Specifies the buffer of the indirect commands with
+ *                       room for \p num_objects commands.
+ * \param count_buffer Specifies the buffer of the number of visible objects.
+ * \note The program and shader storage buffer bindings 0 to 3 are changed.
+ */
+GLA_LINKAGE void gla_cull_objects(GLuint program, GLuint object_buffer,
+                                GLuint transform_buffer, GLuint num_objects,
+                                const GLfloat view_projection[16],
+                                GLuint command_buffer, GLuint count_buffer);
+
+/**
+ * \brief Draw the commands written by gla_cull_objects with one multi-draw.
+ * \param output Specifies the output the cull program was built for.
+ * \param mode Specifies the primitive mode, e.g. \c GL_TRIANGLES.
+ * \param index_type Specifies the index type of the bound element buffer.
+ * \param command_buffer Specifies the buffer of the indirect commands.
+ * \param count_buffer Specifies the buffer of the number of visible objects.
+ * \param num_objects Specifies the number of culled objects.
+ * \note Compact commands need OpenGL 4.6 for
+ *      glMultiDrawElementsIndirectCount. Without it, the count is read back,
+ *      which waits for the GPU. The draw indirect and parameter buffer
+ *      bindings are changed.
+ */
+GLA_LINKAGE void gla_draw_culled_objects(GLuint output, GLenum mode,
+                                        GLenum index_type,
+                                        GLuint command_buffer,
+                                        GLuint count_buffer,
+                                        GLsizei num_objects);
+
+/**
+ * \brief Cull objects on the GPU against the view frustum and a Hi-Z pyramid,
+ *      and wait until the commands may be drawn.
+ * \param program Specifies the program of
+ *                gla_build_object_cull_program(GLuint).
+ * \param phase Specifies the test, e.g. \c GLA_CULL_PHASE_LATE.
+ * \param object_buffer Specifies the buffer of the objects.
+ * \param transform_buffer Specifies the buffer of the column-major model
+ *                         matrices.
+ * \param num_objects Specifies the number of objects.
+ * \param view_projection Specifies the column-major view-projection matrix.
+ * \param pyramid Specifies the Hi-Z pyramid of the depth buffer rendered with
+ *                \p view_projection, or \c NULL for the frustum and early
+ *                phases.
+ * \param visibility_buffer Specifies the buffer of one \c GLuint per object
+ *                          that is nonzero if the object was visible in the
+ *                          last frame, or 0 for the frustum and occlusion
+ *                          phases. It should start out zeroed.
+ * \param command_buffer Specifies the buffer of the indirect commands with
+ *                       room for \p num_objects commands.
+ * \param count_buffer Specifies the buffer of the number of drawn objects.
+ * \note The depth is expected in [0, 1] with smaller values closer. Texture
+ *      unit 0 and shader storage buffer binding 4 are changed in addition to
+ *      the state gla_cull_objects changes.
+ */
+GLA_LINKAGE void gla_cull_objects_occlusion(GLuint program, GLuint phase,
+                                            GLuint object_buffer,
+                                            GLuint transform_buffer,
+                                            GLuint num_objects,
+                                            const GLfloat view_projection[16],
+                                            const gla_hiz_pyramid *pyramid,
+                                            GLuint visibility_buffer,
+                                            GLuint command_buffer,
+                                            GLuint count_buffer);
+
+// -----------------------------------------------------------------------------
+// Hi-Z pyramids
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create a Hi-Z pyramid for a depth buffer.
+ * \param pyramid Specifies the Hi-Z pyramid.
+ * \param width Specifies the width of the depth buffer, at least 2.
+ * \param height Specifies the height of the depth buffer, at least 2.
+ * \return Returns \c GL_TRUE if the pyramid was created, and \c GL_FALSE
+ *      otherwise.
+ * \note Requires OpenGL 4.5 or \c ARB_direct_state_access. Create the
+ *      pyramid anew when the depth buffer is resized.
+ */
+GLA_LINKAGE GLboolean gla_create_hiz_pyramid(gla_hiz_pyramid *pyramid,
+                                            GLsizei width, GLsizei height);
+
+/**
+ * \brief Delete a Hi-Z pyramid.
+ * \param pyramid Specifies the Hi-Z pyramid to be deleted.
+ * \note This function is the counterpart to
+ *      gla_create_hiz_pyramid(gla_hiz_pyramid *, GLsizei, GLsizei).
+ */
+GLA_LINKAGE void gla_delete_hiz_pyramid(gla_hiz_pyramid *pyramid);
+
+/**
+ * \brief Build the levels of a Hi-Z pyramid from a depth texture with one
+ *      compute dispatch per level.
+ * \param pyramid Specifies the Hi-Z pyramid.
+ * \param depth_texture Specifies the depth texture, e.g. of a depth pre-pass
+ *                      of the occluders.
+ * \note The program, texture unit 0 and image unit 0 are changed.
+ */
+GLA_LINKAGE void gla_build_hiz_pyramid(const gla_hiz_pyramid *pyramid,
+                                        GLuint depth_texture);
+
+// -----------------------------------------------------------------------------
+// Occlusion buffers
+// -----------------------------------------------------------------------------
+/**
+ * \brief Create an occlusion buffer.
+ * \param width Specifies the width in pixels, a multiple of
+ *              \c GLA_OCCLUSION_TILE_WIDTH.
+ * \param height Specifies the height in pixels, a multiple of
+ *               \c GLA_OCCLUSION_TILE_HEIGHT.
+ * \return The occlusion buffer, or \c NULL if an error occurred.
+ * \note The buffer is cleared.
+ */
+GLA_LINKAGE gla_occlusion_buffer *gla_create_occlusion_buffer(GLsizei width,
+                                                            GLsizei height);
+
+/**
+ * \brief Delete an occlusion buffer.
+ * \param buffer Specifies the occlusion buffer to be deleted.
+ * \note This function is the counterpart to
+ *      gla_create_occlusion_buffer(GLsizei, GLsizei).
+ */
+GLA_LINKAGE void gla_delete_occlusion_buffer(gla_occlusion_buffer *buffer);
+
+/**
+ * \brief Clear an occlusion buffer to the far plane.
+ * \param buffer Specifies the occlusion buffer.
+ */
+GLA_LINKAGE void gla_clear_occlusion_buffer(gla_occlusion_buffer *buffer);
+
+/**
+ * \brief Rasterize the triangles of an occluder into an occlusion buffer,
+ *      in parallel over rows of tiles.
+ * \param buffer Specifies the occlusion buffer.
+ * \param pool Specifies the job pool, or \c NULL to rasterize on the calling
+ *             thread.
+ * \param indices Specifies the triangle list.
+ * \param num_indices Specifies the number of indices.
+ * \param positions Specifies the first vertex position (3 floats).
+ * \param position_stride Specifies the byte offset between positions.
+ * \param num_vertices Specifies the number of vertices.
+ * \param model_view_projection Specifies the column-major
+ *                              model-view-projection matrix.
+ * \return Returns \c GL_TRUE if the occluder was rasterized, and \c GL_FALSE
+ *      otherwise.
+ * \note Both faces of the triangles are rasterized and clipped against the
+ *      near plane. A pixel is covered if its center is. Every tile merges
+ *      the triangles into a layer of coverage and farthest depth, which
+ *      becomes the depth of the whole tile once it is fully covered. The
+ *      rasterization uses AVX2 if the CPU supports it.
+ */
+GLA_LINKAGE GLboolean gla_rasterize_occluder(gla_occlusion_buffer *buffer,
+                                            gla_job_pool *pool,
+                                            const GLuint *indices,
+                                            GLuint num_indices,
+                                            const GLfloat *positions,
+                                            GLsizei position_stride,
+                                            GLuint num_vertices,
+                                            const GLfloat
+                                                model_view_projection[16]);
+
+/**
+ * \brief Test objects against the occluders of an occlusion buffer.
+ * \param buffer Specifies the occlusion buffer.
+ * \param pool Specifies the job pool, or \c NULL to test on the calling
+ *             thread.
+ * \param objects Specifies the objects, whose draw fields are ignored.
+ * \param transforms Specifies the column-major model matrices (16 floats
+ *                   each).
+ * \param num_objects Specifies the number of objects.
+ * \param view_projection Specifies the column-major view-projection matrix
+ *                        the occluders were rasterized with.
+ * \param visibility Specifies the bitset with room for
+ *                   (\p num_objects + 31) / 32 words, in which bit i % 32 of
+ *                   word i / 32 is set if object i may be visible, e.g. to
+ *                   skip pushing its render packet.
+ * \note Objects outside the view frustum are hidden, and objects that cross
+ *      the near plane are visible.
+ */
+GLA_LINKAGE void gla_test_occlusion(const gla_occlusion_buffer *buffer,
+                                    gla_job_pool *pool,
+                                    const gla_cull_object *objects,
+                                    const GLfloat *transforms,
+                                    GLuint num_objects,
+                                    const GLfloat view_projection[16],
+                                    GLuint *visibility);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // GLA_H_INCLUDE
+
+#ifdef GLA_IMPLEMENTATION
+#undef GLA_IMPLEMENTATION
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Without POSIX, mesh files are read into memory instead of being mapped
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GLA_HAS_POSIX
+#endif
+
+// Without POSIX threads, or with GLA_NO_THREADS defined, job pools have no
+// workers and run their loops on the calling thread
+#if defined(GLA_HAS_POSIX) && !defined(GLA_NO_THREADS)
+#include <pthread.h>
+#include <stdatomic.h>
+#define GLA_HAS_THREADS
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GLA_HAS_X86_INTRINSICS
+#endif
+
+#ifdef GLA_HAS_THREADS
+struct gla_job_pool {
+    pthread_t *threads;
+    int num_threads;
+    pthread_mutex_t submit_mutex; // Serializes gla_parallel_for callers
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    unsigned int generation; // Incremented for every submitted loop
+    int num_busy; // Workers that have not finished the current loop
+    int quit;
+    void (*task)(void *arg, int index);
+    void *arg;
+    int count;
+    atomic_int next;
+};
+
+// -----------------------------------------------------------------------------
+// Nonzero while the thread runs tasks of a loop
+static _Thread_local int gla_job_pool_nesting;
+
+// -----------------------------------------------------------------------------
+static void gla_job_pool_work(gla_job_pool *pool)
+{
+    int index;
+    gla_job_pool_nesting++;
+    while ((index = atomic_fetch_add(&pool->next, 1)) < pool->count) {
+        pool->task(pool->arg, index);
+    }
+    gla_job_pool_nesting--;
+}
+
+// -----------------------------------------------------------------------------
+static void *gla_job_pool_worker(void *data)
+{
+    gla_job_pool *pool = data;
+    unsigned int seen_generation = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (!pool->quit && pool->generation == seen_generation) {
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen_generation = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        gla_job_pool_work(pool);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->num_busy--;
+        if (pool->num_busy == 0) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+#else
+struct gla_job_pool {
+    int num_threads;
+};
+#endif // GLA_HAS_THREADS
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_compute_program(GLuint compute_shader)
+{
+    if (!compute_shader) {
+        fprintf(stderr, "Error: Compute program building: "
+                        "Program must contain a compute shader\n");
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, compute_shader);
+    glLinkProgram(program);
+    glDetachShader(program, compute_shader);
+    return program;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_compute_program_from_file(const GLchar *filename)
+{
+    GLuint comp = 0;
+    if (filename) {
+        comp = gla_build_shader_from_file(filename, GL_COMPUTE_SHADER);
+    }
+
+    if (filename && !gla_check_shader_build(comp)) {
+        fprintf(stderr, "Error: Program building: "
+                        "Shader (\"%s\") build error. "
+                        "See shader info log\n", filename);
+        gla_delete_shader(comp);
+        return 0;
+    }
+
+    return gla_build_compute_program(comp);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_program(GLuint vertex_shader,
+                                    GLuint tessellation_control_shader,
+                                    GLuint tessellation_evaluation_shader,
                                     GLuint geometry_shader,
                                     GLuint fragment_shader)
 {
-    if (!(vertex_shader && fragment_shader)) {
-        fprintf(stderr, "Error: Program building: "
-                        "Program must contain at least a vertex shader and a "
-                        "fragment shader\n");
+    if (!(vertex_shader && fragment_shader)) {
+        fprintf(stderr, "Error: Program building: "
+                        "Program must contain at least a vertex shader and a "
+                        "fragment shader\n");
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    if (tessellation_control_shader) {
+        glAttachShader(program, tessellation_control_shader);
+    }
+    if (tessellation_evaluation_shader) {
+        glAttachShader(program, tessellation_evaluation_shader);
+    }
+    if (geometry_shader) {
+        glAttachShader(program, geometry_shader);
+    }
+    glAttachShader(program, fragment_shader);
+
+    glLinkProgram(program);
+
+    glDetachShader(program, vertex_shader);
+    if (tessellation_control_shader) {
+        glDetachShader(program, tessellation_control_shader);
+    }
+    if (tessellation_evaluation_shader) {
+        glDetachShader(program, tessellation_evaluation_shader);
+    }
+    if (geometry_shader) {
+        glDetachShader(program, geometry_shader);
+    }
+    glDetachShader(program, fragment_shader);
+
+    return program;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_program_from_file(const GLchar *vert_filename,
+                                            const GLchar *tess_ctrl_filename,
+                                            const GLchar *tess_eval_filename,
+                                            const GLchar *geom_filename,
+                                            const GLchar *frag_filename)
+{
+    GLuint vert = 0;
+    GLuint tess_ctrl = 0;
+    GLuint tess_eval = 0;
+    GLuint geom = 0;
+    GLuint frag = 0;
+
+    if (vert_filename) {
+        vert = gla_build_shader_from_file(vert_filename, GL_VERTEX_SHADER);
+    }
+    if (tess_ctrl_filename) {
+        tess_ctrl = gla_build_shader_from_file(tess_ctrl_filename,
+                                            GL_TESS_CONTROL_SHADER);
+    }
+    if (tess_eval_filename) {
+        tess_eval = gla_build_shader_from_file(tess_eval_filename,
+                                            GL_TESS_EVALUATION_SHADER);
+    }
+    if (geom_filename) {
+        geom = gla_build_shader_from_file(geom_filename, GL_GEOMETRY_SHADER);
+    }
+    if (frag_filename) {
+        frag = gla_build_shader_from_file(frag_filename, GL_FRAGMENT_SHADER);
+    }
+
+    GLboolean success = GL_TRUE;
+
+    if (vert_filename && !gla_check_shader_build(vert)) {
+        fprintf(stderr, "Error: Program building: "
+                        "Shader (\"%s\") build error. "
+                        "See shader info log\n", vert_filename);
+        gla_delete_shader(vert);
+        success = GL_FALSE;
+    }
+    if (tess_ctrl_filename && !gla_check_shader_build(tess_ctrl)) {
+        fprintf(stderr, "Error: Program building: "
+                        "Shader (\"%s\") build error. "
+                        "See shader info log\n", tess_ctrl_filename);
+        gla_delete_shader(tess_ctrl);
+        success = GL_FALSE;
+    }
+    if (tess_eval_filename && !gla_check_shader_build(tess_eval)) {
+        fprintf(stderr, "Error: Program building: "
+                        "Shader (\"%s\") build error. "
+                        "See shader info log\n", tess_eval_filename);
+        gla_delete_shader(tess_eval);
+        success = GL_FALSE;
+    }
+    if (geom_filename && !gla_check_shader_build(geom)) {
+        fprintf(stderr, "Error: Program building: "
+                        "Shader (\"%s\") build error. "
+                        "See shader info log\n", geom_filename);
+        gla_delete_shader(geom);
+        success = GL_FALSE;
+    }
+    if (frag_filename && !gla_check_shader_build(frag)) {
+        fprintf(stderr, "Error: Shader building: "
+                        "Shader (\"%s\") build error. "
+                        "See shader info log\n", frag_filename);
+        gla_delete_shader(frag);
+        success = GL_FALSE;
+    }
+
+    if (!success) {
+        return 0;
+    }
+
+    return gla_build_program(vert, tess_ctrl, tess_eval, geom, frag);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_shader(const GLchar *source, GLenum shader_type)
+{
+    GLuint shader = glCreateShader(shader_type);
+    glShaderSource(shader, 1, (const GLchar**) &source, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_shader_from_file(const GLchar *filename,
+                                            GLenum shader_type)
+{
+    GLchar *shader_source = gla_read_text_file(filename);
+    if (!shader_source) {
+        fprintf(stderr, "Error: Shader (\"%s\") building: "
+                        "Unable to load source\n", filename);
+        return 0;
+    }
+    GLuint shader = gla_build_shader(shader_source, shader_type);
+    free(shader_source);
+    shader_source = NULL;
+    return shader;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLint gla_check_program_build(GLuint program, GLenum pname)
+{
+    if (pname != GL_LINK_STATUS || pname != GL_VALIDATE_STATUS) {
+        return GL_INVALID_ENUM;
+    }
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, pname, &success);
+    if (!success) {
+        gla_print_program_info_log(program);
+    }
+    return success;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLint gla_check_shader_build(GLuint shader)
+{
+    GLint success = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        gla_print_shader_info_log(shader);
+    }
+    return success;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_job_pool *gla_create_job_pool(int num_threads)
+{
+#ifndef GLA_HAS_THREADS
+    (void) num_threads;
+    gla_job_pool *pool = calloc(1, sizeof(gla_job_pool));
+    if (!pool) {
+        fprintf(stderr, "Error: Job pool creation: "
+                        "Unable to allocate memory for the job pool\n");
+    }
+    return pool;
+#else
+    if (num_threads < 1) {
+        num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    }
+    if (num_threads < 0) {
+        num_threads = 0;
+    }
+
+    gla_job_pool *pool = calloc(1, sizeof(gla_job_pool));
+    if (!pool) {
+        fprintf(stderr, "Error: Job pool creation: "
+                        "Unable to allocate memory for the job pool\n");
+        return NULL;
+    }
+    pool->threads = calloc(num_threads > 0 ? num_threads : 1,
+                        sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        fprintf(stderr, "Error: Job pool creation: "
+                        "Unable to allocate memory for the threads\n");
+        return NULL;
+    }
+    pthread_mutex_init(&pool->submit_mutex, NULL);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    atomic_init(&pool->next, 0);
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, gla_job_pool_worker,
+                        pool) != 0) {
+            fprintf(stderr, "Error: Job pool creation: "
+                            "Unable to create worker thread %d\n", i);
+            break;
+        }
+        pool->num_threads++;
+    }
+
+    return pool;
+#endif // GLA_HAS_THREADS
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_job_pool(gla_job_pool *pool)
+{
+    if (!pool) {
+        return;
+    }
+
+#ifdef GLA_HAS_THREADS
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_mutex_destroy(&pool->submit_mutex);
+    free(pool->threads);
+#endif // GLA_HAS_THREADS
+    free(pool);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_program(GLuint program)
+{
+    glDeleteProgram(program);
+    program = 0;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_shader(GLuint shader)
+{
+    glDeleteShader(shader);
+    shader = 0;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_parallel_for(void *pool, int count,
+                                void (*task)(void *arg, int index), void *arg)
+{
+    gla_job_pool *p = pool;
+    if (count <= 0) {
+        return;
+    }
+    if (!p || p->num_threads == 0 || count == 1) {
+        for (int i = 0; i < count; i++) {
+            task(arg, i);
+        }
+        return;
+    }
+#ifdef GLA_HAS_THREADS
+    // A loop started by a task would wait for the loop it is part of
+    if (gla_job_pool_nesting) {
+        for (int i = 0; i < count; i++) {
+            task(arg, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&p->submit_mutex);
+
+    pthread_mutex_lock(&p->mutex);
+    p->task = task;
+    p->arg = arg;
+    p->count = count;
+    atomic_store(&p->next, 0);
+    p->num_busy = p->num_threads;
+    p->generation++;
+    pthread_cond_broadcast(&p->work_cond);
+    pthread_mutex_unlock(&p->mutex);
+
+    gla_job_pool_work(p);
+
+    pthread_mutex_lock(&p->mutex);
+    while (p->num_busy > 0) {
+        pthread_cond_wait(&p->done_cond, &p->mutex);
+    }
+    pthread_mutex_unlock(&p->mutex);
+
+    pthread_mutex_unlock(&p->submit_mutex);
+#endif // GLA_HAS_THREADS
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_print_program_info_log(GLuint program)
+{
+    GLint info_log_length = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
+
+    GLchar *info_log = malloc(info_log_length);
+    if (!info_log) {
+        fprintf(stderr, "Error: Program (id = %d) info log printing: "
+                        "Unable to allocate memory for the info log\n",
+                        program);
+        return;
+    }
+    glGetProgramInfoLog(program, info_log_length, NULL, info_log);
+    fprintf(stdout, "Program (id = %d) info log: %s\n", program, info_log);
+    free(info_log);
+    info_log = NULL;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_print_shader_info_log(GLuint shader)
+{
+    GLint info_log_length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &info_log_length);
+    if (info_log_length <= 0) {
+        fprintf(stdout, "Shader (id = %d) info log: <empty>\n", shader);
+        return;
+    }
+
+    GLchar *info_log = malloc(info_log_length);
+    if (!info_log) {
+        fprintf(stderr, "Error: Shader (id = %d) info log printing: "
+                        "Unable to allocate memory for the info log\n", shader);
+        return;
+    }
+    glGetShaderInfoLog(shader, info_log_length, NULL, info_log);
+    fprintf(stdout, "Shader (id = %d) info log: %s\n", shader, info_log);
+    free(info_log);
+    info_log = NULL;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLchar *gla_read_text_file(const GLchar *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "Error: File (\"%s\") handling: "
+                        "Unable to open file\n", filename);
+        return NULL;
+    }
+
+    const size_t buffer_size = 4096;
+    char *buffer = malloc(buffer_size);
+    if (!buffer) {
+        fprintf(stderr, "Error: File (\"%s\") handling: "
+                        "Unable to allocate memory for the reading buffer\n",
+                        filename);
+        return NULL;
+    }
+
+    size_t out_size = 2 * buffer_size;
+    char *out = malloc(out_size + 1); // + '\0'
+    if (!out) {
+        free(buffer);
+        buffer = NULL;
+        fprintf(stderr, "Error: File (\"%s\") handling: "
+                        "Unable to allocate memory for the source buffer\n",
+                        filename);
+        return NULL;
+    }
+
+    size_t num_read_total = 0;
+    size_t num_read_step = 0;
+    while ((num_read_step = fread(buffer, 1, buffer_size, file)) > 0) {
+        // Make sure that there is enough space for storing the read data
+        if (num_read_total >= out_size) {
+            out_size *= 2;
+            out = realloc(out, out_size + 1); // + '\0'
+            if (!out) {
+                free(buffer);
+                buffer = NULL;
+                fprintf(stderr, "Error: File (\"%s\") handling: "
+                                "Unable to re-allocate memory for the source "
+                                "buffer\n", filename);
+                return NULL;
+            }
+        }
+
+        out += num_read_total;
+        memcpy(out, buffer, num_read_step);
+        out -= num_read_total;
+
+        num_read_total += num_read_step;
+    }
+
+    out[num_read_total] = '\0';
+    free(buffer);
+    buffer = NULL;
+
+    if (fclose(file) == EOF) {
+        free(out);
+        out = NULL;
+        fprintf(stderr, "Error: File (\"%s\") handling: "
+                        "Unable to close file\n", filename);
+        return NULL;
+    }
+
+    return out;
+}
+
+// -----------------------------------------------------------------------------
+// Buffer arenas
+// -----------------------------------------------------------------------------
+#define GLA_BUDDY_FREE 0x80
+#define GLA_BUDDY_NONE 0xff
+
+typedef struct gla_buffer_arena_page {
+    GLuint buffer;
+    GLint free_heads[32]; // Free block lists per order
+    GLint *next; // Free list links, indexed by min block
+    GLint *prev;
+    GLubyte *order; // Order and free bit of the block starting at a min block
+} gla_buffer_arena_page;
+
+typedef struct gla_buffer_arena_entry {
+    GLuint page;
+    GLint block; // First min block, or -1 for an unused handle
+    GLubyte order;
+    GLintptr offset;
+    GLsizeiptr size;
+    GLsizeiptr alignment;
+    GLuint next_unused; // Free list of unused handles
+} gla_buffer_arena_entry;
+
+struct gla_buffer_arena {
+    GLsizeiptr page_size;
+    GLsizeiptr min_block_size;
+    GLuint min_block_shift;
+    GLuint page_order; // log2(page_size / min_block_size)
+    gla_buffer_arena_page *pages;
+    GLuint num_pages;
+    gla_buffer_arena_entry *entries;
+    GLuint num_entries;
+    GLuint capacity;
+    GLuint first_unused; // Handle of the first unused entry, or 0
+    gla_buffer_arena_stats stats;
+    int memory_category;
+    const GLchar *memory_label;
+};
+
+// -----------------------------------------------------------------------------
+static void gla_buddy_push(gla_buffer_arena_page *page, GLint block,
+                        GLuint order)
+{
+    page->order[block] = (GLubyte) (order | GLA_BUDDY_FREE);
+    page->prev[block] = -1;
+    page->next[block] = page->free_heads[order];
+    if (page->free_heads[order] >= 0) {
+        page->prev[page->free_heads[order]] = block;
+    }
+    page->free_heads[order] = block;
+}
+
+// -----------------------------------------------------------------------------
+static void gla_buddy_remove(gla_buffer_arena_page *page, GLint block,
+                            GLuint order)
+{
+    if (page->prev[block] >= 0) {
+        page->next[page->prev[block]] = page->next[block];
+    } else {
+        page->free_heads[order] = page->next[block];
+    }
+    if (page->next[block] >= 0) {
+        page->prev[page->next[block]] = page->prev[block];
+    }
+    page->order[block] = GLA_BUDDY_NONE;
+}
+
+// -----------------------------------------------------------------------------
+static GLint gla_buddy_alloc(gla_buffer_arena_page *page, GLuint order,
+                            GLuint page_order)
+{
+    GLuint j = order;
+    while (j <= page_order && page->free_heads[j] < 0) {
+        j++;
+    }
+    if (j > page_order) {
+        return -1;
+    }
+
+    // Split the block until it has the requested order
+    GLint block = page->free_heads[j];
+    gla_buddy_remove(page, block, j);
+    while (j > order) {
+        j--;
+        gla_buddy_push(page, block + (1 << j), j);
+    }
+    page->order[block] = (GLubyte) order;
+    return block;
+}
+
+// -----------------------------------------------------------------------------
+static void gla_buddy_free(gla_buffer_arena_page *page, GLint block,
+                        GLuint order, GLuint page_order)
+{
+    // Merge with the buddy as long as it is free and has the same order
+    page->order[block] = GLA_BUDDY_NONE;
+    while (order < page_order) {
+        GLint buddy = block ^ (1 << order);
+        if (page->order[buddy] != (order | GLA_BUDDY_FREE)) {
+            break;
+        }
+        gla_buddy_remove(page, buddy, order);
+        if (buddy < block) {
+            block = buddy;
+        }
+        order++;
+    }
+    gla_buddy_push(page, block, order);
+}
+
+// -----------------------------------------------------------------------------
+static GLboolean gla_add_buffer_arena_page(gla_buffer_arena *arena)
+{
+    GLint num_blocks = 1 << arena->page_order;
+    gla_buffer_arena_page *pages = realloc(arena->pages,
+        (arena->num_pages + 1) * sizeof(gla_buffer_arena_page));
+    if (!pages) {
+        return GL_FALSE;
+    }
+    arena->pages = pages;
+
+    gla_buffer_arena_page *page = &pages[arena->num_pages];
+    memset(page, 0, sizeof(gla_buffer_arena_page));
+    page->next = malloc(num_blocks * sizeof(GLint));
+    page->prev = malloc(num_blocks * sizeof(GLint));
+    page->order = malloc(num_blocks);
+    if (!(page->next && page->prev && page->order)) {
+        free(page->next);
+        free(page->prev);
+        free(page->order);
+        return GL_FALSE;
+    }
+
+    glGenBuffers(1, &page->buffer);
+    if (!gla_track_memory(arena->memory_category, GL_BUFFER, page->buffer,
+                        arena->page_size, arena->memory_label)) {
+        glDeleteBuffers(1, &page->buffer);
+        free(page->next);
+        free(page->prev);
+        free(page->order);
+        return GL_FALSE;
+    }
+
+    memset(page->order, GLA_BUDDY_NONE, num_blocks);
+    for (GLuint i = 0; i < 32; i++) {
+        page->free_heads[i] = -1;
+    }
+    gla_buddy_push(page, 0, arena->page_order);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, arena->page_size, NULL,
+                    GL_DYNAMIC_STORAGE_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    arena->num_pages++;
+    arena->stats.num_pages = arena->num_pages;
+    arena->stats.page_bytes += arena->page_size;
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+static void gla_delete_buffer_arena_page(gla_buffer_arena_page *page)
+{
+    gla_untrack_memory(GL_BUFFER, page->buffer);
+    glDeleteBuffers(1, &page->buffer);
+    free(page->next);
+    free(page->prev);
+    free(page->order);
+}
+
+// -----------------------------------------------------------------------------
+static GLuint gla_buffer_arena_order(const gla_buffer_arena *arena,
+                                    GLsizeiptr size)
+{
+    GLuint order = 0;
+    while (((GLsizeiptr) 1 << (order + arena->min_block_shift)) < size) {
+        order++;
+    }
+    return order;
+}
+
+// -----------------------------------------------------------------------------
+// Place an entry's block and return the page index, or -1 if allocation failed
+static GLint gla_place_buffer_arena_entry(gla_buffer_arena *arena,
+                                        gla_buffer_arena_entry *entry)
+{
+    for (GLuint i = 0;; i++) {
+        if (i == arena->num_pages && !gla_add_buffer_arena_page(arena)) {
+            return -1;
+        }
+        GLint block = gla_buddy_alloc(&arena->pages[i], entry->order,
+                                    arena->page_order);
+        if (block >= 0) {
+            GLintptr block_offset = (GLintptr) block << arena->min_block_shift;
+            GLintptr offset = block_offset;
+            if (entry->alignment > 1) {
+                offset = (offset + entry->alignment - 1) / entry->alignment *
+                        entry->alignment;
+            }
+            entry->page = i;
+            entry->block = block;
+            entry->offset = offset;
+            return (GLint) i;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_buffer_arena *gla_create_buffer_arena(GLsizeiptr page_size,
+                                                    GLsizeiptr min_block_size)
+{
+    GLuint min_block_shift = 4;
+    while (((GLsizeiptr) 1 << min_block_shift) < min_block_size) {
+        min_block_shift++;
+    }
+    GLuint page_shift = min_block_shift;
+    while (((GLsizeiptr) 1 << page_shift) < page_size) {
+        page_shift++;
+    }
+    if (page_shift - min_block_shift > 24) {
+        fprintf(stderr, "Error: Buffer arena creation: "
+                        "Page size exceeds 2^24 minimum blocks\n");
+        return NULL;
+    }
+
+    gla_buffer_arena *arena = calloc(1, sizeof(gla_buffer_arena));
+    if (!arena) {
+        fprintf(stderr, "Error: Buffer arena creation: "
+                        "Unable to allocate memory for the arena\n");
+        return NULL;
+    }
+    arena->min_block_shift = min_block_shift;
+    arena->min_block_size = (GLsizeiptr) 1 << min_block_shift;
+    arena->page_size = (GLsizeiptr) 1 << page_shift;
+    arena->page_order = page_shift - min_block_shift;
+    arena->memory_category = GLA_MEMORY_OTHER_BUFFER;
+    arena->memory_label = "buffer arena";
+    return arena;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_buffer_arena(gla_buffer_arena *arena)
+{
+    if (!arena) {
+        return;
+    }
+    for (GLuint i = 0; i < arena->num_pages; i++) {
+        gla_delete_buffer_arena_page(&arena->pages[i]);
+    }
+    free(arena->pages);
+    free(arena->entries);
+    free(arena);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_alloc_buffer_arena_range(gla_buffer_arena *arena,
+                                                GLsizeiptr size,
+                                                GLsizeiptr alignment,
+                                                const void *data)
+{
+    // Reserve room to move the offset to the next multiple of the alignment
+    // unless the block alignment already guarantees it
+    GLsizeiptr block_size = size;
+    if (alignment > 1 && arena->min_block_size % alignment != 0) {
+        block_size += alignment - 1;
+    }
+    if (size <= 0 || block_size > arena->page_size) {
+        fprintf(stderr, "Error: Buffer arena allocation: "
+                        "Invalid size %lld (page size %lld)\n",
+                        (long long) size, (long long) arena->page_size);
+        return 0;
+    }
+
+    GLuint handle = arena->first_unused;
+    if (!handle) {
+        if (arena->num_entries == arena->capacity) {
+            GLuint capacity = arena->capacity ? 2 * arena->capacity : 64;
+            gla_buffer_arena_entry *entries = realloc(arena->entries,
+                capacity * sizeof(gla_buffer_arena_entry));
+            if (!entries) {
+                fprintf(stderr, "Error: Buffer arena allocation: "
+                                "Unable to allocate memory for the handle\n");
+                return 0;
+            }
+            arena->entries = entries;
+            arena->capacity = capacity;
+        }
+        handle = ++arena->num_entries;
+        arena->entries[handle - 1].block = -1;
+        arena->entries[handle - 1].next_unused = 0;
+    }
+
+    gla_buffer_arena_entry *entry = &arena->entries[handle - 1];
+    entry->order = (GLubyte) gla_buffer_arena_order(arena, block_size);
+    entry->size = size;
+    entry->alignment = alignment;
+    if (gla_place_buffer_arena_entry(arena, entry) < 0) {
+        // Return the handle to the unused list. A reused handle is still its
+        // head, and a new one is appended while the list is empty.
+        entry->block = -1;
+        arena->first_unused = handle;
+        fprintf(stderr, "Error: Buffer arena allocation: "
+                        "Unable to create a page\n");
+        return 0;
+    }
+    arena->first_unused = entry->next_unused;
+    entry->next_unused = 0;
+
+    arena->stats.num_ranges++;
+    arena->stats.block_bytes += arena->min_block_size << entry->order;
+    arena->stats.range_bytes += size;
+
+    if (data) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, arena->pages[entry->page].buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, entry->offset, size, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    return handle;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_free_buffer_arena_range(gla_buffer_arena *arena,
+                                            GLuint handle)
+{
+    if (!handle || handle > arena->num_entries ||
+        arena->entries[handle - 1].block < 0) {
+        return;
+    }
+
+    gla_buffer_arena_entry *entry = &arena->entries[handle - 1];
+    gla_buddy_free(&arena->pages[entry->page], entry->block, entry->order,
+                arena->page_order);
+    arena->stats.num_ranges--;
+    arena->stats.block_bytes -= arena->min_block_size << entry->order;
+    arena->stats.range_bytes -= entry->size;
+
+    entry->block = -1;
+    entry->next_unused = arena->first_unused;
+    arena->first_unused = handle;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_buffer_range gla_get_buffer_arena_range(
+    const gla_buffer_arena *arena, GLuint handle)
+{
+    gla_buffer_range range;
+    memset(&range, 0, sizeof(gla_buffer_range));
+    if (!handle || handle > arena->num_entries ||
+        arena->entries[handle - 1].block < 0) {
+        return range;
+    }
+
+    const gla_buffer_arena_entry *entry = &arena->entries[handle - 1];
+    range.buffer = arena->pages[entry->page].buffer;
+    range.offset = entry->offset;
+    range.size = entry->size;
+    return range;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_defragment_buffer_arena(gla_buffer_arena *arena)
+{
+    if (arena->stats.num_ranges == 0) {
+        for (GLuint i = 0; i < arena->num_pages; i++) {
+            gla_delete_buffer_arena_page(&arena->pages[i]);
+        }
+        arena->num_pages = 0;
+        arena->stats.num_pages = 0;
+        arena->stats.page_bytes = 0;
+        return GL_FALSE;
+    }
+
+    // Nothing to gain if the live blocks already need all pages
+    GLsizeiptr needed_pages = (arena->stats.block_bytes + arena->page_size - 1) /
+                            arena->page_size;
+    if ((GLuint) needed_pages >= arena->num_pages) {
+        return GL_FALSE;
+    }
+
+    GLuint num_live = arena->stats.num_ranges;
+    GLuint *live = malloc(num_live * sizeof(GLuint));
+    gla_buffer_arena_entry *old_entries =
+        malloc(arena->num_entries * sizeof(gla_buffer_arena_entry));
+    if (!(live && old_entries)) {
+        free(live);
+        free(old_entries);
+        fprintf(stderr, "Error: Buffer arena defragmentation: "
+                        "Unable to allocate memory\n");
+        return GL_FALSE;
+    }
+    memcpy(old_entries, arena->entries,
+        arena->num_entries * sizeof(gla_buffer_arena_entry));
+
+    // Placing blocks from largest to smallest into fresh buddy pages packs
+    // them without holes. Counting sort by descending order.
+    GLuint order_begin[33] = {0};
+    for (GLuint i = 0; i < arena->num_entries; i++) {
+        if (arena->entries[i].block >= 0) {
+            order_begin[arena->page_order - arena->entries[i].order + 1]++;
+        }
+    }
+    for (GLuint k = 1; k < 33; k++) {
+        order_begin[k] += order_begin[k - 1];
+    }
+    for (GLuint i = 0; i < arena->num_entries; i++) {
+        if (arena->entries[i].block >= 0) {
+            live[order_begin[arena->page_order - arena->entries[i].order]++] =
+                i;
+        }
+    }
+    gla_buffer_arena_page *old_pages = arena->pages;
+    GLuint num_old_pages = arena->num_pages;
+    arena->pages = NULL;
+    arena->num_pages = 0;
+    arena->stats.page_bytes = 0;
+
+    GLboolean success = GL_TRUE;
+    for (GLuint i = 0; i < num_live && success; i++) {
+        success = gla_place_buffer_arena_entry(arena,
+                                            &arena->entries[live[i]]) >= 0;
+    }
+    if (!success) {
+        // Roll back to the old pages
+        for (GLuint i = 0; i < arena->num_pages; i++) {
+            gla_delete_buffer_arena_page(&arena->pages[i]);
+        }
+        free(arena->pages);
+        arena->pages = old_pages;
+        arena->num_pages = num_old_pages;
+        arena->stats.num_pages = num_old_pages;
+        arena->stats.page_bytes = num_old_pages * arena->page_size;
+        memcpy(arena->entries, old_entries,
+            arena->num_entries * sizeof(gla_buffer_arena_entry));
+        free(live);
+        free(old_entries);
+        fprintf(stderr, "Error: Buffer arena defragmentation: "
+                        "Unable to create pages\n");
+        return GL_FALSE;
+    }
+
+    for (GLuint i = 0; i < num_live; i++) {
+        const gla_buffer_arena_entry *from = &old_entries[live[i]];
+        const gla_buffer_arena_entry *to = &arena->entries[live[i]];
+        glBindBuffer(GL_COPY_READ_BUFFER, old_pages[from->page].buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, arena->pages[to->page].buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            from->offset, to->offset, from->size);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    for (GLuint i = 0; i < num_old_pages; i++) {
+        gla_delete_buffer_arena_page(&old_pages[i]);
+    }
+    free(old_pages);
+    free(live);
+    free(old_entries);
+    arena->stats.generation++;
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_buffer_arena_stats gla_get_buffer_arena_stats(
+    const gla_buffer_arena *arena)
+{
+    return arena->stats;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_set_buffer_arena_memory_category(gla_buffer_arena *arena,
+                                                    int category,
+                                                    const GLchar *label)
+{
+    arena->memory_category = category;
+    arena->memory_label = label;
+}
+
+// -----------------------------------------------------------------------------
+// Vertex formats
+// -----------------------------------------------------------------------------
+struct gla_vao_cache {
+    gla_vertex_array **slots; // Open addressing table, capacity is a power of 2
+    GLuint capacity;
+    GLuint count;
+    GLuint bound_vao;
+};
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLsizei gla_vertex_attrib_size(GLint count, GLenum type)
+{
+    switch (type) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return count == GL_BGRA ? 4 : count;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+        return 2 * count;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+    case GL_FIXED:
+        return 4 * count;
+    case GL_DOUBLE:
+        return 8 * count;
+    case GL_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_add_vertex_attrib(gla_vertex_format *format,
+                                            GLuint location, GLuint binding,
+                                            GLint count, GLenum type,
+                                            GLboolean normalized)
+{
+    GLsizei size = gla_vertex_attrib_size(count, type);
+    if (format->num_attribs >= GLA_MAX_VERTEX_ATTRIBS ||
+        binding >= GLA_MAX_VERTEX_BINDINGS || size == 0 ||
+        !((count >= 1 && count <= 4) || count == GL_BGRA)) {
+        fprintf(stderr, "Error: Vertex format building: "
+                        "Invalid attribute (location = %d)\n", location);
+        return GL_FALSE;
+    }
+
+    gla_vertex_attrib *attrib = &format->attribs[format->num_attribs++];
+    attrib->location = location;
+    attrib->binding = binding;
+    attrib->count = count;
+    attrib->type = type;
+    attrib->normalized = normalized;
+    // Unnormalized integer data feeds integer inputs by default. Clear the
+    // flag to have it converted to floating-point instead.
+    attrib->integer = !normalized && (type == GL_BYTE ||
+                                    type == GL_UNSIGNED_BYTE ||
+                                    type == GL_SHORT ||
+                                    type == GL_UNSIGNED_SHORT ||
+                                    type == GL_INT || type == GL_UNSIGNED_INT);
+    attrib->relative_offset = format->bindings[binding].stride;
+    format->bindings[binding].stride += size;
+    if (binding >= format->num_bindings) {
+        format->num_bindings = binding + 1;
+    }
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+static GLuint gla_hash_bytes(GLuint hash, const void *data, size_t size)
+{
+    // FNV-1a
+    const GLubyte *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// -----------------------------------------------------------------------------
+// Hash the fields one by one so that padding bytes do not matter
+static GLuint gla_hash_vertex_format(const gla_vertex_format *format)
+{
+    GLuint hash = 2166136261u;
+    hash = gla_hash_bytes(hash, &format->num_attribs, sizeof(GLuint));
+    for (GLuint i = 0; i < format->num_attribs; i++) {
+        const gla_vertex_attrib *a = &format->attribs[i];
+        hash = gla_hash_bytes(hash, &a->location, sizeof(GLuint));
+        hash = gla_hash_bytes(hash, &a->binding, sizeof(GLuint));
+        hash = gla_hash_bytes(hash, &a->count, sizeof(GLint));
+        hash = gla_hash_bytes(hash, &a->type, sizeof(GLenum));
+        hash = gla_hash_bytes(hash, &a->normalized, sizeof(GLboolean));
+        hash = gla_hash_bytes(hash, &a->integer, sizeof(GLboolean));
+        hash = gla_hash_bytes(hash, &a->relative_offset, sizeof(GLuint));
+    }
+    hash = gla_hash_bytes(hash, &format->num_bindings, sizeof(GLuint));
+    for (GLuint i = 0; i < format->num_bindings; i++) {
+        hash = gla_hash_bytes(hash, &format->bindings[i].stride,
+                            sizeof(GLsizei));
+        hash = gla_hash_bytes(hash, &format->bindings[i].divisor,
+                            sizeof(GLuint));
+    }
+    return hash;
+}
+
+// -----------------------------------------------------------------------------
+static GLboolean gla_vertex_formats_equal(const gla_vertex_format *f1,
+                                        const gla_vertex_format *f2)
+{
+    if (f1->num_attribs != f2->num_attribs ||
+        f1->num_bindings != f2->num_bindings) {
+        return GL_FALSE;
+    }
+    for (GLuint i = 0; i < f1->num_attribs; i++) {
+        const gla_vertex_attrib *a1 = &f1->attribs[i];
+        const gla_vertex_attrib *a2 = &f2->attribs[i];
+        if (a1->location != a2->location || a1->binding != a2->binding ||
+            a1->count != a2->count || a1->type != a2->type ||
+            a1->normalized != a2->normalized ||
+            a1->integer != a2->integer ||
+            a1->relative_offset != a2->relative_offset) {
+            return GL_FALSE;
+        }
+    }
+    for (GLuint i = 0; i < f1->num_bindings; i++) {
+        if (f1->bindings[i].stride != f2->bindings[i].stride ||
+            f1->bindings[i].divisor != f2->bindings[i].divisor) {
+            return GL_FALSE;
+        }
+    }
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_vao_cache *gla_create_vao_cache(void)
+{
+    gla_vao_cache *cache = calloc(1, sizeof(gla_vao_cache));
+    if (cache) {
+        cache->capacity = 16;
+        cache->slots = calloc(cache->capacity, sizeof(gla_vertex_array *));
+    }
+    if (!cache || !cache->slots) {
+        free(cache);
+        fprintf(stderr, "Error: VAO cache creation: "
+                        "Unable to allocate memory for the cache\n");
+        return NULL;
+    }
+    return cache;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_vao_cache(gla_vao_cache *cache)
+{
+    if (!cache) {
+        return;
+    }
+    for (GLuint i = 0; i < cache->capacity; i++) {
+        if (cache->slots[i]) {
+            glDeleteVertexArrays(1, &cache->slots[i]->vao);
+            free(cache->slots[i]);
+        }
+    }
+    free(cache->slots);
+    free(cache);
+}
+
+// -----------------------------------------------------------------------------
+static GLboolean gla_grow_vao_cache(gla_vao_cache *cache)
+{
+    GLuint capacity = 2 * cache->capacity;
+    gla_vertex_array **slots = calloc(capacity, sizeof(gla_vertex_array *));
+    if (!slots) {
+        return GL_FALSE;
+    }
+    for (GLuint i = 0; i < cache->capacity; i++) {
+        gla_vertex_array *va = cache->slots[i];
+        if (va) {
+            GLuint slot = va->hash & (capacity - 1);
+            while (slots[slot]) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            slots[slot] = va;
+        }
+    }
+    free(cache->slots);
+    cache->slots = slots;
+    cache->capacity = capacity;
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_vertex_array *gla_get_vertex_array(gla_vao_cache *cache,
+                                                const gla_vertex_format *format)
+{
+    GLuint hash = gla_hash_vertex_format(format);
+    GLuint slot = hash & (cache->capacity - 1);
+    while (cache->slots[slot]) {
+        gla_vertex_array *va = cache->slots[slot];
+        if (va->hash == hash && gla_vertex_formats_equal(&va->format, format)) {
+            return va;
+        }
+        slot = (slot + 1) & (cache->capacity - 1);
+    }
+
+    // Keep the load factor at or below one half
+    if (2 * (cache->count + 1) > cache->capacity) {
+        if (!gla_grow_vao_cache(cache)) {
+            fprintf(stderr, "Error: VAO cache lookup: "
+                            "Unable to grow the cache\n");
+            return NULL;
+        }
+        slot = hash & (cache->capacity - 1);
+        while (cache->slots[slot]) {
+            slot = (slot + 1) & (cache->capacity - 1);
+        }
+    }
+
+    gla_vertex_array *va = calloc(1, sizeof(gla_vertex_array));
+    if (!va) {
+        fprintf(stderr, "Error: VAO cache lookup: "
+                        "Unable to allocate memory for the vertex array\n");
+        return NULL;
+    }
+    va->hash = hash;
+    va->format = *format;
+
+    glCreateVertexArrays(1, &va->vao);
+    for (GLuint i = 0; i < format->num_attribs; i++) {
+        const gla_vertex_attrib *a = &format->attribs[i];
+        glEnableVertexArrayAttrib(va->vao, a->location);
+        if (a->type == GL_DOUBLE) {
+            glVertexArrayAttribLFormat(va->vao, a->location, a->count, a->type,
+                                    a->relative_offset);
+        } else if (a->integer) {
+            glVertexArrayAttribIFormat(va->vao, a->location, a->count, a->type,
+                                    a->relative_offset);
+        } else {
+            glVertexArrayAttribFormat(va->vao, a->location, a->count, a->type,
+                                    a->normalized, a->relative_offset);
+        }
+        glVertexArrayAttribBinding(va->vao, a->location, a->binding);
+    }
+    for (GLuint i = 0; i < format->num_bindings; i++) {
+        if (format->bindings[i].divisor) {
+            glVertexArrayBindingDivisor(va->vao, i,
+                                        format->bindings[i].divisor);
+        }
+    }
+
+    cache->slots[slot] = va;
+    cache->count++;
+    return va;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_bind_vertex_array(gla_vao_cache *cache,
+                                    gla_vertex_array *vertex_array,
+                                    const GLuint *buffers,
+                                    const GLintptr *offsets,
+                                    GLuint element_buffer)
+{
+    const gla_vertex_format *format = &vertex_array->format;
+    for (GLuint i = 0; i < format->num_bindings; i++) {
+        GLintptr offset = offsets ? offsets[i] : 0;
+        if (vertex_array->buffers[i] != buffers[i] ||
+            vertex_array->offsets[i] != offset) {
+            glVertexArrayVertexBuffer(vertex_array->vao, i, buffers[i], offset,
+                                    format->bindings[i].stride);
+            vertex_array->buffers[i] = buffers[i];
+            vertex_array->offsets[i] = offset;
+        }
+    }
+    if (vertex_array->element_buffer != element_buffer) {
+        glVertexArrayElementBuffer(vertex_array->vao, element_buffer);
+        vertex_array->element_buffer = element_buffer;
+    }
+
+    if (cache->bound_vao != vertex_array->vao) {
+        glBindVertexArray(vertex_array->vao);
+        cache->bound_vao = vertex_array->vao;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_reset_vao_cache_binding(gla_vao_cache *cache)
+{
+    cache->bound_vao = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Stream buffers
+// -----------------------------------------------------------------------------
+// C11 clock, clock_gettime would need _POSIX_C_SOURCE under -std=c11
+static GLuint64 gla_now_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (GLuint64) ts.tv_sec * 1000000000u + (GLuint64) ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_create_stream_buffer(gla_stream_buffer *stream_buffer,
+                                            GLsizeiptr region_size,
+                                            GLuint num_regions)
+{
+    memset(stream_buffer, 0, sizeof(gla_stream_buffer));
+    if (region_size <= 0 || num_regions < 1 ||
+        num_regions > GLA_STREAM_BUFFER_MAX_REGIONS) {
+        fprintf(stderr, "Error: Stream buffer creation: "
+                        "Invalid region size or number of regions\n");
+        return GL_FALSE;
+    }
+
+    region_size = (region_size + 255) & ~(GLsizeiptr) 255;
+    GLsizeiptr size = region_size * num_regions;
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                            GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &stream_buffer->buffer);
+    if (!gla_track_memory(GLA_MEMORY_STREAM_BUFFER, GL_BUFFER,
+                        stream_buffer->buffer, size, "stream buffer")) {
+        glDeleteBuffers(1, &stream_buffer->buffer);
+        stream_buffer->buffer = 0;
+        return GL_FALSE;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, stream_buffer->buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+    stream_buffer->data = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size,
+                                        flags);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (!stream_buffer->data) {
+        fprintf(stderr, "Error: Stream buffer creation: "
+                        "Unable to map the buffer storage\n");
+        gla_untrack_memory(GL_BUFFER, stream_buffer->buffer);
+        glDeleteBuffers(1, &stream_buffer->buffer);
+        stream_buffer->buffer = 0;
+        return GL_FALSE;
+    }
+
+    stream_buffer->region_size = region_size;
+    stream_buffer->num_regions = num_regions;
+    // The first gla_begin_stream_buffer_frame call advances to region 0
+    stream_buffer->region = num_regions - 1;
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_stream_buffer(gla_stream_buffer *stream_buffer)
+{
+    for (GLuint i = 0; i < stream_buffer->num_regions; i++) {
+        if (stream_buffer->fences[i]) {
+            glDeleteSync(stream_buffer->fences[i]);
+        }
+    }
+    if (stream_buffer->buffer) {
+        // Deleting the buffer object implicitly unmaps it
+        gla_untrack_memory(GL_BUFFER, stream_buffer->buffer);
+        glDeleteBuffers(1, &stream_buffer->buffer);
+    }
+    memset(stream_buffer, 0, sizeof(gla_stream_buffer));
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_begin_stream_buffer_frame(gla_stream_buffer *stream_buffer)
+{
+    stream_buffer->region = (stream_buffer->region + 1) %
+                            stream_buffer->num_regions;
+    stream_buffer->offset = 0;
+    stream_buffer->stats.num_frames++;
+
+    GLsync fence = stream_buffer->fences[stream_buffer->region];
+    if (!fence) {
+        return;
+    }
+
+    // Poll first so that only frames that really block are counted
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        stream_buffer->stats.num_fence_waits++;
+        GLuint64 start = gla_now_ns();
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                    1000000000u);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        stream_buffer->stats.fence_wait_ns += gla_now_ns() - start;
+    }
+    if (status == GL_WAIT_FAILED) {
+        fprintf(stderr, "Error: Stream buffer (id = %d) frame beginning: "
+                        "Waiting on the region fence failed\n",
+                        stream_buffer->buffer);
+    }
+    glDeleteSync(fence);
+    stream_buffer->fences[stream_buffer->region] = 0;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_end_stream_buffer_frame(gla_stream_buffer *stream_buffer)
+{
+    if (stream_buffer->offset > stream_buffer->stats.peak_region_usage) {
+        stream_buffer->stats.peak_region_usage = stream_buffer->offset;
+    }
+    stream_buffer->fences[stream_buffer->region] =
+        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void *gla_alloc_stream_buffer_range(gla_stream_buffer *stream_buffer,
+                                                GLsizeiptr size,
+                                                GLsizeiptr alignment,
+                                                GLintptr *offset)
+{
+    GLintptr region_begin = stream_buffer->region * stream_buffer->region_size;
+    GLintptr begin = region_begin + stream_buffer->offset;
+    if (alignment > 1) {
+        begin = (begin + alignment - 1) & ~(GLintptr) (alignment - 1);
+    }
+    if (begin + size > region_begin + stream_buffer->region_size) {
+        stream_buffer->stats.num_failed_allocs++;
+        return NULL;
+    }
+
+    stream_buffer->offset = begin + size - region_begin;
+    *offset = begin;
+    return stream_buffer->data + begin;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_print_stream_buffer_stats(
+    const gla_stream_buffer *stream_buffer)
+{
+    const gla_stream_buffer_stats *stats = &stream_buffer->stats;
+    fprintf(stdout, "Stream buffer (id = %d) stats: "
+                    "%llu frames, %llu fence waits (%.3f ms total), "
+                    "%llu failed allocations, peak usage %lld of %lld bytes\n",
+                    stream_buffer->buffer,
+                    (unsigned long long) stats->num_frames,
+                    (unsigned long long) stats->num_fence_waits,
+                    stats->fence_wait_ns / 1.0e6,
+                    (unsigned long long) stats->num_failed_allocs,
+                    (long long) stats->peak_region_usage,
+                    (long long) stream_buffer->region_size);
+}
+
+// -----------------------------------------------------------------------------
+// Draw batchers
+// -----------------------------------------------------------------------------
+typedef struct gla_batched_draw {
+    gla_draw draw;
+    GLuint sequence; // Recording order, also the index of the draw data
+} gla_batched_draw;
+
+struct gla_draw_batcher {
+    gla_stream_buffer stream_buffer;
+    gla_batched_draw *draws;
+    GLuint num_draws;
+    GLuint max_draws;
+    GLubyte *draw_data; // CPU staging in recording order
+    GLsizei draw_data_size;
+    GLuint draw_data_binding;
+    GLint draw_data_alignment;
+};
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_draw_batcher *gla_create_draw_batcher(GLuint max_draws,
+                                                    GLsizei draw_data_size,
+                                                    GLuint draw_data_binding)
+{
+    gla_draw_batcher *batcher = calloc(1, sizeof(gla_draw_batcher));
+    if (!batcher) {
+        fprintf(stderr, "Error: Draw batcher creation: "
+                        "Unable to allocate memory for the batcher\n");
+        return NULL;
+    }
+    batcher->draws = malloc(max_draws * sizeof(gla_batched_draw));
+    batcher->draw_data = malloc(max_draws * (size_t) draw_data_size + 1);
+    if (!(batcher->draws && batcher->draw_data)) {
+        free(batcher->draws);
+        free(batcher->draw_data);
+        free(batcher);
+        fprintf(stderr, "Error: Draw batcher creation: "
+                        "Unable to allocate memory for the draws\n");
+        return NULL;
+    }
+    batcher->max_draws = max_draws;
+    batcher->draw_data_size = draw_data_size;
+    batcher->draw_data_binding = draw_data_binding;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT,
+                &batcher->draw_data_alignment);
+
+    // Every bucket may need padding to align its commands and draw data
+    GLsizeiptr region_size =
+        (GLsizeiptr) max_draws *
+        (sizeof(gla_draw_elements_indirect_command) + draw_data_size +
+        sizeof(GLuint) + batcher->draw_data_alignment);
+    if (!gla_create_stream_buffer(&batcher->stream_buffer, region_size, 3)) {
+        free(batcher->draws);
+        free(batcher->draw_data);
+        free(batcher);
+        return NULL;
+    }
+    return batcher;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_draw_batcher(gla_draw_batcher *batcher)
+{
+    if (!batcher) {
+        return;
+    }
+    gla_delete_stream_buffer(&batcher->stream_buffer);
+    free(batcher->draws);
+    free(batcher->draw_data);
+    free(batcher);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_add_draw(gla_draw_batcher *batcher,
+                                const gla_draw *draw, const void *draw_data)
+{
+    if (batcher->num_draws == batcher->max_draws) {
+        return GL_FALSE;
+    }
+
+    gla_batched_draw *d = &batcher->draws[batcher->num_draws];
+    d->draw = *draw;
+    d->sequence = batcher->num_draws;
+    if (batcher->draw_data_size > 0) {
+        GLubyte *dst = batcher->draw_data +
+                    (size_t) d->sequence * batcher->draw_data_size;
+        if (draw_data) {
+            memcpy(dst, draw_data, batcher->draw_data_size);
+        } else {
+            memset(dst, 0, batcher->draw_data_size);
+        }
+    }
+    batcher->num_draws++;
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+static int gla_compare_batched_draws(const void *a, const void *b)
+{
+    const gla_batched_draw *d1 = a;
+    const gla_batched_draw *d2 = b;
+    if (d1->draw.key != d2->draw.key) {
+        return d1->draw.key < d2->draw.key ? -1 : 1;
+    }
+    if (d1->draw.index_type != d2->draw.index_type) {
+        return d1->draw.index_type < d2->draw.index_type ? -1 : 1;
+    }
+    return d1->sequence < d2->sequence ? -1 : d1->sequence > d2->sequence;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_flush_draw_batcher(gla_draw_batcher *batcher,
+                                        GLenum mode,
+                                        void (*bind_state)(void *user,
+                                                        GLuint64 key,
+                                                        GLenum index_type),
+                                        void *user)
+{
+    if (batcher->num_draws == 0) {
+        return 0;
+    }
+
+    qsort(batcher->draws, batcher->num_draws, sizeof(gla_batched_draw),
+        gla_compare_batched_draws);
+
+    gla_stream_buffer *sb = &batcher->stream_buffer;
+    gla_begin_stream_buffer_frame(sb);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sb->buffer);
+
+    GLuint num_calls = 0;
+    GLuint begin = 0;
+    while (begin < batcher->num_draws) {
+        const gla_draw *first = &batcher->draws[begin].draw;
+        GLuint end = begin + 1;
+        while (end < batcher->num_draws &&
+            batcher->draws[end].draw.key == first->key &&
+            batcher->draws[end].draw.index_type == first->index_type) {
+            end++;
+        }
+        GLsizei count = end - begin;
+
+        GLintptr command_offset = 0;
+        gla_draw_elements_indirect_command *commands =
+            gla_alloc_stream_buffer_range(
+                sb, count * sizeof(gla_draw_elements_indirect_command),
+                sizeof(GLuint), &command_offset);
+        for (GLuint i = begin; i < end; i++) {
+            const gla_draw *draw = &batcher->draws[i].draw;
+            gla_draw_elements_indirect_command *command = &commands[i - begin];
+            command->count = draw->index_count;
+            command->instance_count = draw->instance_count;
+            command->first_index = draw->first_index;
+            command->base_vertex = draw->base_vertex;
+            command->base_instance = draw->base_instance;
+        }
+
+        // gl_DrawID restarts at zero for every call, so each bucket gets its
+        // own draw data range
+        if (batcher->draw_data_size > 0) {
+            GLsizeiptr size = (GLsizeiptr) count * batcher->draw_data_size;
+            GLintptr data_offset = 0;
+            GLubyte *data = gla_alloc_stream_buffer_range(
+                sb, size, batcher->draw_data_alignment, &data_offset);
+            for (GLuint i = begin; i < end; i++) {
+                memcpy(data + (size_t) (i - begin) * batcher->draw_data_size,
+                    batcher->draw_data + (size_t) batcher->draws[i].sequence *
+                                        batcher->draw_data_size,
+                    batcher->draw_data_size);
+            }
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER,
+                            batcher->draw_data_binding, sb->buffer,
+                            data_offset, size);
+        }
+
+        if (bind_state) {
+            bind_state(user, first->key, first->index_type);
+        }
+        glMultiDrawElementsIndirect(mode, first->index_type,
+                                    (const void *) command_offset, count, 0);
+        num_calls++;
+        begin = end;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    gla_end_stream_buffer_frame(sb);
+    batcher->num_draws = 0;
+    return num_calls;
+}
+
+// -----------------------------------------------------------------------------
+// Instanced meshes
+// -----------------------------------------------------------------------------
+static GLsizei gla_index_size(GLenum index_type)
+{
+    switch (index_type) {
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Largest component size of the attributes read from a binding, which the
+// elements of the binding have to be aligned to
+static GLsizei gla_vertex_binding_alignment(const gla_vertex_format *format,
+                                            GLuint binding)
+{
+    GLsizei alignment = 1;
+    for (GLuint i = 0; i < format->num_attribs; i++) {
+        const gla_vertex_attrib *attrib = &format->attribs[i];
+        GLsizei size = gla_vertex_attrib_size(1, attrib->type);
+        if (attrib->binding == binding && size > alignment) {
+            alignment = size;
+        }
+    }
+    return alignment;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_alloc_instance_streams(
+    gla_instanced_mesh *mesh, gla_stream_buffer *stream_buffer,
+    GLsizei instance_count, void *streams[GLA_MAX_VERTEX_BINDINGS])
+{
+    const gla_vertex_format *format = &mesh->vertex_array->format;
+    for (GLuint i = 0; i < GLA_MAX_VERTEX_BINDINGS; i++) {
+        streams[i] = NULL;
+    }
+    for (GLuint i = 0; i < format->num_bindings; i++) {
+        const gla_vertex_binding *binding = &format->bindings[i];
+        if (binding->divisor == 0) {
+            continue;
+        }
+        GLsizei num_elements =
+            (instance_count + binding->divisor - 1) / binding->divisor;
+        streams[i] = gla_alloc_stream_buffer_range(
+            stream_buffer, (GLsizeiptr) num_elements * binding->stride,
+            gla_vertex_binding_alignment(format, i), &mesh->offsets[i]);
+        if (!streams[i]) {
+            return GL_FALSE;
+        }
+        mesh->buffers[i] = stream_buffer->buffer;
+    }
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_draw_instanced_mesh(gla_vao_cache *cache,
+                                        const gla_instanced_mesh *mesh,
+                                        GLenum mode, GLsizei instance_count)
+{
+    gla_bind_vertex_array(cache, mesh->vertex_array, mesh->buffers,
+                        mesh->offsets, mesh->element_buffer);
+    GLintptr index_offset =
+        (GLintptr) mesh->first_index * gla_index_size(mesh->index_type);
+    glDrawElementsInstancedBaseVertexBaseInstance(
+        mode, mesh->index_count, mesh->index_type,
+        (const void *) index_offset, instance_count, mesh->base_vertex, 0);
+}
+
+// -----------------------------------------------------------------------------
+// Render queues
+// -----------------------------------------------------------------------------
+#define GLA_RENDER_QUEUE_DIGIT_BITS 11
+#define GLA_RENDER_QUEUE_MAX_PASSES 6 // 64 key bits in 11-bit digits
+#define GLA_RENDER_QUEUE_MAX_RUNS 8
+
+struct gla_render_queue {
+    GLuint64 *keys;
+    GLuint *indices; // Packet index of every key
+    GLuint64 *tmp_keys;
+    GLuint *tmp_indices;
+    GLuint histograms[GLA_RENDER_QUEUE_MAX_PASSES]
+                    [1 << GLA_RENDER_QUEUE_DIGIT_BITS];
+    GLubyte *packets;
+    GLsizei packet_size;
+    GLuint num_packets;
+    GLuint max_packets;
+};
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_render_queue *gla_create_render_queue(GLuint max_packets,
+                                                    GLsizei packet_size)
+{
+    gla_render_queue *queue = calloc(1, sizeof(gla_render_queue));
+    if (!queue) {
+        fprintf(stderr, "Error: Render queue creation: "
+                        "Unable to allocate memory for the queue\n");
+        return NULL;
+    }
+    queue->keys = malloc(max_packets * sizeof(GLuint64));
+    queue->indices = malloc(max_packets * sizeof(GLuint));
+    queue->tmp_keys = malloc(max_packets * sizeof(GLuint64));
+    queue->tmp_indices = malloc(max_packets * sizeof(GLuint));
+    queue->packets = malloc(max_packets * (size_t) packet_size + 1);
+    if (!(queue->keys && queue->indices && queue->tmp_keys &&
+        queue->tmp_indices && queue->packets)) {
+        fprintf(stderr, "Error: Render queue creation: "
+                        "Unable to allocate memory for the packets\n");
+        gla_delete_render_queue(queue);
+        return NULL;
+    }
+    queue->packet_size = packet_size;
+    queue->max_packets = max_packets;
+    return queue;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_render_queue(gla_render_queue *queue)
+{
+    if (!queue) {
+        return;
+    }
+    free(queue->keys);
+    free(queue->indices);
+    free(queue->tmp_keys);
+    free(queue->tmp_indices);
+    free(queue->packets);
+    free(queue);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void *gla_push_render_packet(gla_render_queue *queue,
+                                        GLuint64 key)
+{
+    if (queue->num_packets == queue->max_packets) {
+        return NULL;
+    }
+    GLuint i = queue->num_packets++;
+    queue->keys[i] = key;
+    queue->indices[i] = i;
+    return queue->packets + (size_t) i * queue->packet_size;
+}
+
+// -----------------------------------------------------------------------------
+// Plans the digits of an LSD radix sort that cover the set bits of mask
+static int gla_plan_radix_passes(GLuint64 mask,
+                                int shifts[GLA_RENDER_QUEUE_MAX_PASSES])
+{
+    int num_passes = 0;
+    for (int shift = 0; mask; shift++) {
+        if ((mask >> shift) & 1) {
+            shifts[num_passes++] = shift;
+            shift += GLA_RENDER_QUEUE_DIGIT_BITS - 1;
+            mask &= shift < 63 ? ~0ull << (shift + 1) : 0;
+        }
+    }
+    return num_passes;
+}
+
+// -----------------------------------------------------------------------------
+// Sorts the keys by the bits of mask, moving the indices along if they are
+// given. Returns through the pointers which buffers hold the result.
+static void gla_radix_sort_keys(gla_render_queue *queue, GLuint64 mask,
+                                GLuint64 **keys, GLuint64 **tmp_keys,
+                                GLuint **indices, GLuint **tmp_indices)
+{
+    GLuint n = queue->num_packets;
+    int shifts[GLA_RENDER_QUEUE_MAX_PASSES];
+    int num_passes = gla_plan_radix_passes(mask, shifts);
+
+    // One read builds the histograms of all digits
+    const GLuint digit_mask = (1 << GLA_RENDER_QUEUE_DIGIT_BITS) - 1;
+    GLuint (*histograms)[1 << GLA_RENDER_QUEUE_DIGIT_BITS] = queue->histograms;
+    memset(histograms, 0, num_passes * sizeof(queue->histograms[0]));
+    for (GLuint i = 0; i < n; i++) {
+        GLuint64 key = (*keys)[i];
+        for (int p = 0; p < num_passes; p++) {
+            histograms[p][(key >> shifts[p]) & digit_mask]++;
+        }
+    }
+
+    for (int p = 0; p < num_passes; p++) {
+        GLuint *histogram = histograms[p];
+        int shift = shifts[p];
+
+        GLuint sum = 0;
+        for (GLuint i = 0; i <= digit_mask; i++) {
+            GLuint count = histogram[i];
+            histogram[i] = sum;
+            sum += count;
+        }
+        GLuint64 *src = *keys;
+        GLuint64 *dst = *tmp_keys;
+        if (indices) {
+            for (GLuint i = 0; i < n; i++) {
+                GLuint j = histogram[(src[i] >> shift) & digit_mask]++;
+                dst[j] = src[i];
+                (*tmp_indices)[j] = (*indices)[i];
+            }
+            GLuint *swap_indices = *indices;
+            *indices = *tmp_indices;
+            *tmp_indices = swap_indices;
+        } else {
+            for (GLuint i = 0; i < n; i++) {
+                dst[histogram[(src[i] >> shift) & digit_mask]++] = src[i];
+            }
+        }
+        *keys = dst;
+        *tmp_keys = src;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_sort_render_queue(gla_render_queue *queue)
+{
+    GLuint n = queue->num_packets;
+    if (n < 2) {
+        return;
+    }
+
+    // Bits that are equal in all keys do not affect the order, so only the
+    // bits that vary are sorted
+    GLuint64 first_key = queue->keys[0];
+    GLuint64 varying = 0;
+    for (GLuint i = 1; i < n; i++) {
+        varying |= queue->keys[i] ^ first_key;
+    }
+    if (!varying) {
+        return;
+    }
+
+    // Find the runs of varying bits
+    int run_shifts[GLA_RENDER_QUEUE_MAX_RUNS];
+    int run_lengths[GLA_RENDER_QUEUE_MAX_RUNS];
+    GLuint64 run_masks[GLA_RENDER_QUEUE_MAX_RUNS];
+    GLuint64 run_bits = 0;
+    int num_runs = 0;
+    int num_varying = 0;
+    for (int shift = 0; shift < 64 && num_runs < GLA_RENDER_QUEUE_MAX_RUNS;) {
+        if (!((varying >> shift) & 1)) {
+            shift++;
+            continue;
+        }
+        int length = 0;
+        while (shift + length < 64 && ((varying >> (shift + length)) & 1)) {
+            length++;
+        }
+        run_shifts[num_runs] = shift;
+        run_lengths[num_runs] = length;
+        run_masks[num_runs] = length < 64 ? (1ull << length) - 1 : ~0ull;
+        run_bits |= run_masks[num_runs++] << shift;
+        num_varying += length;
+        shift += length;
+    }
+    int index_bits = 0;
+    while ((GLuint64) (n - 1) >> index_bits) {
+        index_bits++;
+    }
+
+    if (run_bits != varying || num_varying + index_bits > 64) {
+        // The keys are sorted with their packet indices alongside
+        GLuint64 *keys = queue->keys;
+        GLuint64 *tmp_keys = queue->tmp_keys;
+        GLuint *indices = queue->indices;
+        GLuint *tmp_indices = queue->tmp_indices;
+        gla_radix_sort_keys(queue, varying, &keys, &tmp_keys, &indices,
+                            &tmp_indices);
+        queue->keys = keys;
+        queue->tmp_keys = tmp_keys;
+        queue->indices = indices;
+        queue->tmp_indices = tmp_indices;
+        return;
+    }
+
+    // The varying bits are packed above the packet index into one word, so
+    // each pass moves 8 instead of 12 bytes per packet. The index was pushed
+    // in ascending order, so equal keys keep their push order.
+    GLuint64 *words = queue->tmp_keys;
+    for (GLuint i = 0; i < n; i++) {
+        GLuint64 key = queue->keys[i];
+        GLuint64 word = i;
+        int offset = index_bits;
+        for (int r = 0; r < num_runs; r++) {
+            word |= ((key >> run_shifts[r]) & run_masks[r]) << offset;
+            offset += run_lengths[r];
+        }
+        words[i] = word;
+    }
+    GLuint64 *tmp_words = queue->keys;
+    GLuint64 index_mask = (1ull << index_bits) - 1;
+    GLuint64 word_mask = num_varying + index_bits < 64 ?
+                        (1ull << (num_varying + index_bits)) - 1 : ~0ull;
+    gla_radix_sort_keys(queue, word_mask & ~index_mask, &words, &tmp_words,
+                        NULL, NULL);
+
+    // Unpack the sorted words into keys and packet indices
+    for (GLuint i = 0; i < n; i++) {
+        GLuint64 word = words[i];
+        GLuint64 key = first_key & ~varying;
+        int offset = index_bits;
+        for (int r = 0; r < num_runs; r++) {
+            key |= ((word >> offset) & run_masks[r]) << run_shifts[r];
+            offset += run_lengths[r];
+        }
+        tmp_words[i] = key;
+        queue->indices[i] = (GLuint) (word & index_mask);
+    }
+    queue->keys = tmp_words;
+    queue->tmp_keys = words;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_submit_render_queue(
+    gla_render_queue *queue, GLuint64 state_mask,
+    void (*bind_state)(void *user, GLuint64 key, GLuint64 changed),
+    void (*draw)(void *user, GLuint64 key, const void *packet), void *user)
+{
+    GLuint64 previous_key = 0;
+    for (GLuint i = 0; i < queue->num_packets; i++) {
+        GLuint64 key = queue->keys[i];
+        GLuint64 changed =
+            i == 0 ? state_mask : (key ^ previous_key) & state_mask;
+        if (changed && bind_state) {
+            bind_state(user, key, changed);
+        }
+        draw(user, key,
+            queue->packets + (size_t) queue->indices[i] * queue->packet_size);
+        previous_key = key;
+    }
+    queue->num_packets = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Command buffers
+// -----------------------------------------------------------------------------
+enum {
+    GLA_CMD_USE_PROGRAM,
+    GLA_CMD_BIND_VERTEX_ARRAY,
+    GLA_CMD_BIND_BUFFER_RANGE,
+    GLA_CMD_BIND_TEXTURE_UNIT,
+    GLA_CMD_UNIFORM,
+    GLA_CMD_DRAW_ELEMENTS,
+    GLA_CMD_MULTI_DRAW_ELEMENTS_INDIRECT,
+    GLA_CMD_DISPATCH_COMPUTE,
+    GLA_CMD_MEMORY_BARRIER,
+    GLA_CMD_CALLBACK
+};
+
+// Every command starts with this header and is padded to 8 bytes
+typedef struct gla_cmd_header {
+    GLuint type;
+    GLuint size; // Including the header
+} gla_cmd_header;
+
+typedef struct gla_cmd_name {
+    gla_cmd_header header;
+    GLuint name;
+} gla_cmd_name;
+
+typedef struct gla_cmd_bind_buffer {
+    gla_cmd_header header;
+    GLenum target;
+    GLuint index;
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size;
+} gla_cmd_bind_buffer;
+
+typedef struct gla_cmd_texture_unit {
+    gla_cmd_header header;
+    GLuint unit;
+    GLuint texture;
+} gla_cmd_texture_unit;
+
+typedef struct gla_cmd_uniform_data {
+    gla_cmd_header header;
+    GLint location;
+    GLenum type;
+    GLsizei count;
+    // Followed by the values
+} gla_cmd_uniform_data;
+
+typedef struct gla_cmd_draw {
+    gla_cmd_header header;
+    GLenum mode;
+    gla_draw draw;
+} gla_cmd_draw;
+
+typedef struct gla_cmd_multi_draw {
+    gla_cmd_header header;
+    GLenum mode;
+    GLenum index_type;
+    GLuint indirect_buffer;
+    GLsizei draw_count;
+    GLintptr offset;
+} gla_cmd_multi_draw;
+
+typedef struct gla_cmd_dispatch {
+    gla_cmd_header header;
+    GLuint num_groups[3];
+} gla_cmd_dispatch;
+
+typedef struct gla_cmd_call {
+    gla_cmd_header header;
+    void (*callback)(void *arg);
+    void *arg;
+} gla_cmd_call;
+
+struct gla_command_buffer {
+    GLubyte *data;
+    size_t size;
+    size_t capacity;
+    GLboolean failed; // An allocation failed and commands were dropped
+};
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_command_buffer *gla_create_command_buffer(
+    GLsizeiptr initial_size)
+{
+    gla_command_buffer *buffer = calloc(1, sizeof(gla_command_buffer));
+    if (!buffer) {
+        fprintf(stderr, "Error: Command buffer creation: "
+                        "Unable to allocate memory for the buffer\n");
+        return NULL;
+    }
+    buffer->capacity = initial_size > 64 ? (size_t) initial_size : 64;
+    buffer->data = malloc(buffer->capacity);
+    if (!buffer->data) {
+        fprintf(stderr, "Error: Command buffer creation: "
+                        "Unable to allocate memory for the commands\n");
+        free(buffer);
+        return NULL;
+    }
+    return buffer;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_command_buffer(gla_command_buffer *buffer)
+{
+    if (!buffer) {
+        return;
+    }
+    free(buffer->data);
+    free(buffer);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_reset_command_buffer(gla_command_buffer *buffer)
+{
+    buffer->size = 0;
+    buffer->failed = GL_FALSE;
+}
+
+// -----------------------------------------------------------------------------
+// Reserve an 8-byte aligned command and fill in its header
+static void *gla_alloc_command(gla_command_buffer *buffer, GLuint type,
+                            size_t size)
+{
+    size = (size + 7) & ~(size_t) 7;
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = buffer->capacity * 2;
+        while (buffer->size + size > capacity) {
+            capacity *= 2;
+        }
+        GLubyte *data = realloc(buffer->data, capacity);
+        if (!data) {
+            if (!buffer->failed) {
+                fprintf(stderr, "Error: Command recording: "
+                                "Unable to allocate memory for the command\n");
+            }
+            buffer->failed = GL_TRUE;
+            return NULL;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+
+    gla_cmd_header *header = (gla_cmd_header *) (buffer->data + buffer->size);
+    header->type = type;
+    header->size = (GLuint) size;
+    buffer->size += size;
+    return header;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_use_program(gla_command_buffer *buffer,
+                                    GLuint program)
+{
+    gla_cmd_name *cmd = gla_alloc_command(buffer, GLA_CMD_USE_PROGRAM,
+                                        sizeof(gla_cmd_name));
+    if (cmd) {
+        cmd->name = program;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_bind_vertex_array(gla_command_buffer *buffer,
+                                        GLuint vertex_array)
+{
+    gla_cmd_name *cmd = gla_alloc_command(buffer, GLA_CMD_BIND_VERTEX_ARRAY,
+                                        sizeof(gla_cmd_name));
+    if (cmd) {
+        cmd->name = vertex_array;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_bind_buffer_range(gla_command_buffer *buffer,
+                                        GLenum target, GLuint index,
+                                        GLuint buffer_object, GLintptr offset,
+                                        GLsizeiptr size)
+{
+    gla_cmd_bind_buffer *cmd = gla_alloc_command(
+        buffer, GLA_CMD_BIND_BUFFER_RANGE, sizeof(gla_cmd_bind_buffer));
+    if (cmd) {
+        cmd->target = target;
+        cmd->index = index;
+        cmd->buffer = buffer_object;
+        cmd->offset = offset;
+        cmd->size = size;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_bind_texture_unit(gla_command_buffer *buffer,
+                                        GLuint unit, GLuint texture)
+{
+    gla_cmd_texture_unit *cmd = gla_alloc_command(
+        buffer, GLA_CMD_BIND_TEXTURE_UNIT, sizeof(gla_cmd_texture_unit));
+    if (cmd) {
+        cmd->unit = unit;
+        cmd->texture = texture;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Return the size of one uniform value, or 0 for unsupported types
+static size_t gla_uniform_size(GLenum type)
+{
+    switch (type) {
+    case GL_FLOAT:
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+        return 4;
+    case GL_FLOAT_VEC2:
+        return 2 * sizeof(GLfloat);
+    case GL_FLOAT_VEC3:
+        return 3 * sizeof(GLfloat);
+    case GL_FLOAT_VEC4:
+        return 4 * sizeof(GLfloat);
+    case GL_FLOAT_MAT4:
+        return 16 * sizeof(GLfloat);
+    default:
+        return 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_uniform(gla_command_buffer *buffer, GLint location,
+                                GLenum type, GLsizei count, const void *data)
+{
+    size_t value_size = gla_uniform_size(type);
+    if (value_size == 0) {
+        fprintf(stderr, "Error: Command recording: "
+                        "Unsupported uniform type 0x%x\n", type);
+        return;
+    }
+    size_t data_size = count * value_size;
+    gla_cmd_uniform_data *cmd =
+        gla_alloc_command(buffer, GLA_CMD_UNIFORM,
+                        sizeof(gla_cmd_uniform_data) + data_size);
+    if (cmd) {
+        cmd->location = location;
+        cmd->type = type;
+        cmd->count = count;
+        memcpy(cmd + 1, data, data_size);
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_draw_elements(gla_command_buffer *buffer,
+                                    GLenum mode, const gla_draw *draw)
+{
+    gla_cmd_draw *cmd = gla_alloc_command(buffer, GLA_CMD_DRAW_ELEMENTS,
+                                        sizeof(gla_cmd_draw));
+    if (cmd) {
+        cmd->mode = mode;
+        cmd->draw = *draw;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_multi_draw_elements_indirect(
+    gla_command_buffer *buffer, GLenum mode, GLenum index_type,
+    GLuint indirect_buffer, GLintptr offset, GLsizei draw_count)
+{
+    gla_cmd_multi_draw *cmd = gla_alloc_command(
+        buffer, GLA_CMD_MULTI_DRAW_ELEMENTS_INDIRECT,
+        sizeof(gla_cmd_multi_draw));
+    if (cmd) {
+        cmd->mode = mode;
+        cmd->index_type = index_type;
+        cmd->indirect_buffer = indirect_buffer;
+        cmd->offset = offset;
+        cmd->draw_count = draw_count;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_dispatch_compute(gla_command_buffer *buffer,
+                                        GLuint num_groups_x,
+                                        GLuint num_groups_y,
+                                        GLuint num_groups_z)
+{
+    gla_cmd_dispatch *cmd = gla_alloc_command(
+        buffer, GLA_CMD_DISPATCH_COMPUTE, sizeof(gla_cmd_dispatch));
+    if (cmd) {
+        cmd->num_groups[0] = num_groups_x;
+        cmd->num_groups[1] = num_groups_y;
+        cmd->num_groups[2] = num_groups_z;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_memory_barrier(gla_command_buffer *buffer,
+                                        GLbitfield barriers)
+{
+    gla_cmd_name *cmd = gla_alloc_command(buffer, GLA_CMD_MEMORY_BARRIER,
+                                        sizeof(gla_cmd_name));
+    if (cmd) {
+        cmd->name = barriers;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cmd_callback(gla_command_buffer *buffer,
+                                void (*callback)(void *arg), void *arg)
+{
+    gla_cmd_call *cmd =
+        gla_alloc_command(buffer, GLA_CMD_CALLBACK, sizeof(gla_cmd_call));
+    if (cmd) {
+        cmd->callback = callback;
+        cmd->arg = arg;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_reset_state_tracker(gla_state_tracker *tracker)
+{
+    // No object has this name, so every first bind is issued
+    memset(tracker, 0xff, sizeof(gla_state_tracker));
+    tracker->num_commands = 0;
+    tracker->num_elided = 0;
+}
+
+// -----------------------------------------------------------------------------
+static void gla_replay_bind_buffer(const gla_cmd_bind_buffer *cmd,
+                                gla_state_tracker *tracker)
+{
+    gla_tracked_buffer_binding *binding = NULL;
+    if (cmd->index < GLA_MAX_TRACKED_BUFFER_BINDINGS) {
+        if (cmd->target == GL_UNIFORM_BUFFER) {
+            binding = &tracker->uniform_buffers[cmd->index];
+        } else if (cmd->target == GL_SHADER_STORAGE_BUFFER) {
+            binding = &tracker->storage_buffers[cmd->index];
+        }
+    }
+    if (binding) {
+        if (binding->buffer == cmd->buffer &&
+            binding->offset == cmd->offset && binding->size == cmd->size) {
+            tracker->num_elided++;
+            return;
+        }
+        binding->buffer = cmd->buffer;
+        binding->offset = cmd->offset;
+        binding->size = cmd->size;
+    }
+
+    if (cmd->size == 0) {
+        glBindBufferBase(cmd->target, cmd->index, cmd->buffer);
+    } else {
+        glBindBufferRange(cmd->target, cmd->index, cmd->buffer, cmd->offset,
+                        cmd->size);
+    }
+}
+
+// -----------------------------------------------------------------------------
+static void gla_replay_uniform(const gla_cmd_uniform_data *cmd)
+{
+    const void *data = cmd + 1;
+    switch (cmd->type) {
+    case GL_FLOAT:
+        glUniform1fv(cmd->location, cmd->count, data);
+        break;
+    case GL_FLOAT_VEC2:
+        glUniform2fv(cmd->location, cmd->count, data);
+        break;
+    case GL_FLOAT_VEC3:
+        glUniform3fv(cmd->location, cmd->count, data);
+        break;
+    case GL_FLOAT_VEC4:
+        glUniform4fv(cmd->location, cmd->count, data);
+        break;
+    case GL_FLOAT_MAT4:
+        glUniformMatrix4fv(cmd->location, cmd->count, GL_FALSE, data);
+        break;
+    case GL_INT:
+        glUniform1iv(cmd->location, cmd->count, data);
+        break;
+    case GL_UNSIGNED_INT:
+        glUniform1uiv(cmd->location, cmd->count, data);
+        break;
+    default:
+        break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+static void gla_replay_command(const gla_cmd_header *header,
+                            gla_state_tracker *tracker)
+{
+    switch (header->type) {
+    case GLA_CMD_USE_PROGRAM: {
+        const gla_cmd_name *cmd = (const gla_cmd_name *) header;
+        if (tracker->program == cmd->name) {
+            tracker->num_elided++;
+            break;
+        }
+        tracker->program = cmd->name;
+        glUseProgram(cmd->name);
+        break;
+    }
+    case GLA_CMD_BIND_VERTEX_ARRAY: {
+        const gla_cmd_name *cmd = (const gla_cmd_name *) header;
+        if (tracker->vertex_array == cmd->name) {
+            tracker->num_elided++;
+            break;
+        }
+        tracker->vertex_array = cmd->name;
+        glBindVertexArray(cmd->name);
+        break;
+    }
+    case GLA_CMD_BIND_BUFFER_RANGE:
+        gla_replay_bind_buffer((const gla_cmd_bind_buffer *) header, tracker);
+        break;
+    case GLA_CMD_BIND_TEXTURE_UNIT: {
+        const gla_cmd_texture_unit *cmd =
+            (const gla_cmd_texture_unit *) header;
+        if (cmd->unit < GLA_MAX_TRACKED_TEXTURE_UNITS) {
+            if (tracker->texture_units[cmd->unit] == cmd->texture) {
+                tracker->num_elided++;
+                break;
+            }
+            tracker->texture_units[cmd->unit] = cmd->texture;
+        }
+        glBindTextureUnit(cmd->unit, cmd->texture);
+        break;
+    }
+    case GLA_CMD_UNIFORM:
+        gla_replay_uniform((const gla_cmd_uniform_data *) header);
+        break;
+    case GLA_CMD_DRAW_ELEMENTS: {
+        const gla_cmd_draw *cmd = (const gla_cmd_draw *) header;
+        const gla_draw *draw = &cmd->draw;
+        GLintptr offset =
+            (GLintptr) draw->first_index * gla_index_size(draw->index_type);
+        glDrawElementsInstancedBaseVertexBaseInstance(
+            cmd->mode, draw->index_count, draw->index_type,
+            (const void *) offset, draw->instance_count, draw->base_vertex,
+            draw->base_instance);
+        break;
+    }
+    case GLA_CMD_MULTI_DRAW_ELEMENTS_INDIRECT: {
+        const gla_cmd_multi_draw *cmd = (const gla_cmd_multi_draw *) header;
+        if (tracker->draw_indirect_buffer == cmd->indirect_buffer) {
+            tracker->num_elided++;
+        } else {
+            tracker->draw_indirect_buffer = cmd->indirect_buffer;
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cmd->indirect_buffer);
+        }
+        glMultiDrawElementsIndirect(cmd->mode, cmd->index_type,
+                                    (const void *) cmd->offset,
+                                    cmd->draw_count, 0);
+        break;
+    }
+    case GLA_CMD_DISPATCH_COMPUTE: {
+        const gla_cmd_dispatch *cmd = (const gla_cmd_dispatch *) header;
+        glDispatchCompute(cmd->num_groups[0], cmd->num_groups[1],
+                        cmd->num_groups[2]);
+        break;
+    }
+    case GLA_CMD_MEMORY_BARRIER:
+        glMemoryBarrier(((const gla_cmd_name *) header)->name);
+        break;
+    case GLA_CMD_CALLBACK: {
+        const gla_cmd_call *cmd = (const gla_cmd_call *) header;
+        cmd->callback(cmd->arg);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_submit_command_buffers(gla_command_buffer *const *buffers,
+                                            GLuint count,
+                                            gla_state_tracker *tracker)
+{
+    for (GLuint i = 0; i < count; i++) {
+        const GLubyte *data = buffers[i]->data;
+        size_t offset = 0;
+        while (offset < buffers[i]->size) {
+            const gla_cmd_header *header =
+                (const gla_cmd_header *) (data + offset);
+            gla_replay_command(header, tracker);
+            tracker->num_commands++;
+            offset += header->size;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Render threads
+// -----------------------------------------------------------------------------
+#ifdef GLA_HAS_THREADS
+#define GLA_RENDER_THREAD_SPIN_COUNT 4096
+
+struct gla_render_thread {
+    pthread_t thread;
+    GLubyte *frames;
+    GLsizeiptr frame_size;
+    GLuint num_frames;
+    // Frames handed over and frames rendered. Each is written by one side
+    // only, so the ring itself needs no lock.
+    _Atomic GLuint64 num_written;
+    _Atomic GLuint64 num_read;
+    // The mutex and condition variables are only used to sleep after
+    // spinning, announced through the waiting flags.
+    pthread_mutex_t mutex;
+    pthread_cond_t written_cond;
+    pthread_cond_t read_cond;
+    atomic_int producer_waiting;
+    atomic_int render_waiting;
+    atomic_int quit;
+    int init_status; // 0 while pending, 1 on success and -1 on failure
+    GLboolean (*init)(void *user);
+    void (*render)(void *user, void *frame);
+    void (*shutdown)(void *user);
+    void *user;
+    // Statistics, counted by both sides and read from any thread
+    _Atomic GLuint64 num_rendered_frames;
+    _Atomic GLuint64 num_producer_stalls;
+    _Atomic GLuint64 producer_stall_ns;
+    _Atomic GLuint64 num_render_idles;
+};
+
+// -----------------------------------------------------------------------------
+static void gla_wake_render_waiter(gla_render_thread *thread,
+                                atomic_int *waiting, pthread_cond_t *cond)
+{
+    if (atomic_load(waiting)) {
+        pthread_mutex_lock(&thread->mutex);
+        pthread_cond_signal(cond);
+        pthread_mutex_unlock(&thread->mutex);
+    }
+}
+
+// -----------------------------------------------------------------------------
+static void *gla_render_thread_main(void *arg)
+{
+    gla_render_thread *thread = arg;
+
+    GLboolean ok = thread->init(thread->user);
+    pthread_mutex_lock(&thread->mutex);
+    thread->init_status = ok ? 1 : -1;
+    pthread_cond_signal(&thread->read_cond);
+    pthread_mutex_unlock(&thread->mutex);
+    if (!ok) {
+        return NULL;
+    }
+
+    for (;;) {
+        GLuint64 read = atomic_load_explicit(&thread->num_read,
+                                            memory_order_relaxed);
+        int spins = 0;
+        while (atomic_load_explicit(&thread->num_written,
+                                    memory_order_acquire) == read) {
+            if (++spins < GLA_RENDER_THREAD_SPIN_COUNT) {
+                continue;
+            }
+            if (spins == GLA_RENDER_THREAD_SPIN_COUNT) {
+                atomic_fetch_add_explicit(&thread->num_render_idles, 1,
+                                        memory_order_relaxed);
+            }
+            pthread_mutex_lock(&thread->mutex);
+            atomic_store(&thread->render_waiting, 1);
+            if (atomic_load(&thread->num_written) == read &&
+                !atomic_load(&thread->quit)) {
+                pthread_cond_wait(&thread->written_cond, &thread->mutex);
+            }
+            atomic_store(&thread->render_waiting, 0);
+            pthread_mutex_unlock(&thread->mutex);
+            if (atomic_load(&thread->quit) &&
+                atomic_load(&thread->num_written) == read) {
+                if (thread->shutdown) {
+                    thread->shutdown(thread->user);
+                }
+                return NULL;
+            }
+        }
+
+        GLubyte *frame = thread->frames + (size_t) (read % thread->num_frames) *
+                                        thread->frame_size;
+        thread->render(thread->user, frame);
+        atomic_fetch_add_explicit(&thread->num_rendered_frames, 1,
+                                memory_order_relaxed);
+        // Sequentially consistent so that the waiting flag load below can not
+        // move before it, which could lose a wakeup
+        atomic_store(&thread->num_read, read + 1);
+        gla_wake_render_waiter(thread, &thread->producer_waiting,
+                            &thread->read_cond);
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_render_thread *gla_create_render_thread(
+    GLuint num_frames, GLsizeiptr frame_size, GLboolean (*init)(void *user),
+    void (*render)(void *user, void *frame), void (*shutdown)(void *user),
+    void *user)
+{
+    if (num_frames < 1 || num_frames > GLA_RENDER_THREAD_MAX_FRAMES) {
+        fprintf(stderr, "Error: Render thread creation: "
+                        "Invalid number of frames %u\n", num_frames);
+        return NULL;
+    }
+
+    gla_render_thread *thread = calloc(1, sizeof(gla_render_thread));
+    if (!thread) {
+        fprintf(stderr, "Error: Render thread creation: "
+                        "Unable to allocate memory for the thread\n");
+        return NULL;
+    }
+    thread->frames = calloc(num_frames, frame_size > 0 ? frame_size : 1);
+    if (!thread->frames) {
+        free(thread);
+        fprintf(stderr, "Error: Render thread creation: "
+                        "Unable to allocate memory for the frames\n");
+        return NULL;
+    }
+    thread->frame_size = frame_size;
+    thread->num_frames = num_frames;
+    atomic_init(&thread->num_written, 0);
+    atomic_init(&thread->num_read, 0);
+    atomic_init(&thread->producer_waiting, 0);
+    atomic_init(&thread->render_waiting, 0);
+    atomic_init(&thread->quit, 0);
+    thread->init = init;
+    thread->render = render;
+    thread->shutdown = shutdown;
+    thread->user = user;
+    pthread_mutex_init(&thread->mutex, NULL);
+    pthread_cond_init(&thread->written_cond, NULL);
+    pthread_cond_init(&thread->read_cond, NULL);
+
+    if (pthread_create(&thread->thread, NULL, gla_render_thread_main,
+                    thread) != 0) {
+        fprintf(stderr, "Error: Render thread creation: "
+                        "Unable to create the thread\n");
+        thread->init_status = -1;
+    } else {
+        pthread_mutex_lock(&thread->mutex);
+        while (thread->init_status == 0) {
+            pthread_cond_wait(&thread->read_cond, &thread->mutex);
+        }
+        pthread_mutex_unlock(&thread->mutex);
+        if (thread->init_status < 0) {
+            pthread_join(thread->thread, NULL);
+            fprintf(stderr, "Error: Render thread creation: "
+                            "Initialization failed\n");
+        }
+    }
+
+    if (thread->init_status < 0) {
+        pthread_cond_destroy(&thread->read_cond);
+        pthread_cond_destroy(&thread->written_cond);
+        pthread_mutex_destroy(&thread->mutex);
+        free(thread->frames);
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_render_thread(gla_render_thread *thread)
+{
+    if (!thread) {
+        return;
+    }
+
+    pthread_mutex_lock(&thread->mutex);
+    atomic_store(&thread->quit, 1);
+    pthread_cond_signal(&thread->written_cond);
+    pthread_mutex_unlock(&thread->mutex);
+    pthread_join(thread->thread, NULL);
+
+    pthread_cond_destroy(&thread->read_cond);
+    pthread_cond_destroy(&thread->written_cond);
+    pthread_mutex_destroy(&thread->mutex);
+    free(thread->frames);
+    free(thread);
+}
+
+// -----------------------------------------------------------------------------
+// Block the producer until at most max_in_flight frames are not yet rendered,
+// and return the time blocked
+static GLuint64 gla_wait_render_frames(gla_render_thread *thread,
+                                GLuint max_in_flight)
+{
+    GLuint64 written = atomic_load_explicit(&thread->num_written,
+                                            memory_order_relaxed);
+    if (written - atomic_load_explicit(&thread->num_read,
+                                    memory_order_acquire) <= max_in_flight) {
+        return 0;
+    }
+
+    GLuint64 start = gla_now_ns();
+    int spins = 0;
+    while (written - atomic_load_explicit(&thread->num_read,
+                                        memory_order_acquire) >
+        max_in_flight) {
+        if (++spins < GLA_RENDER_THREAD_SPIN_COUNT) {
+            continue;
+        }
+        pthread_mutex_lock(&thread->mutex);
+        atomic_store(&thread->producer_waiting, 1);
+        if (written - atomic_load(&thread->num_read) > max_in_flight) {
+            pthread_cond_wait(&thread->read_cond, &thread->mutex);
+        }
+        atomic_store(&thread->producer_waiting, 0);
+        pthread_mutex_unlock(&thread->mutex);
+    }
+    return gla_now_ns() - start;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void *gla_begin_render_frame(gla_render_thread *thread)
+{
+    GLuint64 stall_ns = gla_wait_render_frames(thread, thread->num_frames - 1);
+    if (stall_ns > 0) {
+        atomic_fetch_add_explicit(&thread->num_producer_stalls, 1,
+                                memory_order_relaxed);
+        atomic_fetch_add_explicit(&thread->producer_stall_ns, stall_ns,
+                                memory_order_relaxed);
+    }
+    GLuint64 written = atomic_load_explicit(&thread->num_written,
+                                            memory_order_relaxed);
+    return thread->frames +
+        (size_t) (written % thread->num_frames) * thread->frame_size;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_end_render_frame(gla_render_thread *thread)
+{
+    GLuint64 written = atomic_load_explicit(&thread->num_written,
+                                            memory_order_relaxed);
+    atomic_store(&thread->num_written, written + 1);
+    gla_wake_render_waiter(thread, &thread->render_waiting,
+                        &thread->written_cond);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_wait_render_thread_idle(gla_render_thread *thread)
+{
+    gla_wait_render_frames(thread, 0);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_render_thread_stats gla_get_render_thread_stats(
+    const gla_render_thread *thread)
+{
+    gla_render_thread_stats stats;
+    stats.num_frames = atomic_load_explicit(&thread->num_rendered_frames,
+                                            memory_order_relaxed);
+    stats.num_producer_stalls =
+        atomic_load_explicit(&thread->num_producer_stalls,
+                            memory_order_relaxed);
+    stats.producer_stall_ns = atomic_load_explicit(&thread->producer_stall_ns,
+                                                memory_order_relaxed);
+    stats.num_render_idles = atomic_load_explicit(&thread->num_render_idles,
+                                                memory_order_relaxed);
+    return stats;
+}
+#else
+// Without threads every frame is rendered on the calling thread when it is
+// handed over, so one frame packet suffices
+struct gla_render_thread {
+    GLubyte *frame;
+    void (*render)(void *user, void *frame);
+    void (*shutdown)(void *user);
+    void *user;
+    gla_render_thread_stats stats;
+};
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_render_thread *gla_create_render_thread(
+    GLuint num_frames, GLsizeiptr frame_size, GLboolean (*init)(void *user),
+    void (*render)(void *user, void *frame), void (*shutdown)(void *user),
+    void *user)
+{
+    if (num_frames < 1 || num_frames > GLA_RENDER_THREAD_MAX_FRAMES) {
+        fprintf(stderr, "Error: Render thread creation: "
+                        "Invalid number of frames %u\n", num_frames);
+        return NULL;
+    }
+
+    gla_render_thread *thread = calloc(1, sizeof(gla_render_thread));
+    if (!thread) {
+        fprintf(stderr, "Error: Render thread creation: "
+                        "Unable to allocate memory for the thread\n");
+        return NULL;
+    }
+    thread->frame = calloc(1, frame_size > 0 ? frame_size : 1);
+    if (!thread->frame) {
+        free(thread);
+        fprintf(stderr, "Error: Render thread creation: "
+                        "Unable to allocate memory for the frames\n");
+        return NULL;
+    }
+    thread->render = render;
+    thread->shutdown = shutdown;
+    thread->user = user;
+    if (!init(user)) {
+        free(thread->frame);
+        free(thread);
+        fprintf(stderr, "Error: Render thread creation: "
+                        "Initialization failed\n");
+        return NULL;
+    }
+    return thread;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_render_thread(gla_render_thread *thread)
+{
+    if (!thread) {
+        return;
+    }
+
+    if (thread->shutdown) {
+        thread->shutdown(thread->user);
+    }
+    free(thread->frame);
+    free(thread);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void *gla_begin_render_frame(gla_render_thread *thread)
+{
+    return thread->frame;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_end_render_frame(gla_render_thread *thread)
+{
+    thread->render(thread->user, thread->frame);
+    thread->stats.num_frames++;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_wait_render_thread_idle(gla_render_thread *thread)
+{
+    (void) thread;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_render_thread_stats gla_get_render_thread_stats(
+    const gla_render_thread *thread)
+{
+    return thread->stats;
+}
+#endif // GLA_HAS_THREADS
+
+// -----------------------------------------------------------------------------
+// Deletion queues
+// -----------------------------------------------------------------------------
+#define GLA_DELETION_QUEUE_NUM_TYPES 9
+
+static const GLenum gla_deletion_queue_types[GLA_DELETION_QUEUE_NUM_TYPES] = {
+    GL_BUFFER, GL_SHADER, GL_PROGRAM, GL_VERTEX_ARRAY, GL_QUERY, GL_TEXTURE,
+    GL_FRAMEBUFFER, GL_RENDERBUFFER, GL_SAMPLER
+};
+
+// Names of one object type in queue order, tagged with their frame
+typedef struct gla_deletion_list {
+    GLuint *names;
+    GLuint64 *frames;
+    GLuint count;
+    GLuint capacity;
+} gla_deletion_list;
+
+typedef struct gla_deletion_fence {
+    GLsync fence;
+    GLuint64 frame;
+} gla_deletion_fence;
+
+struct gla_deletion_queue {
+    gla_deletion_list lists[GLA_DELETION_QUEUE_NUM_TYPES];
+    gla_deletion_fence *fences; // Oldest first
+    GLuint num_fences;
+    GLuint fence_capacity;
+    GLuint64 frame; // The open frame
+    GLuint num_open; // Objects queued in the open frame
+};
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_deletion_queue *gla_create_deletion_queue(void)
+{
+    gla_deletion_queue *queue = calloc(1, sizeof(gla_deletion_queue));
+    if (!queue) {
+        fprintf(stderr, "Error: Deletion queue creation: "
+                        "Unable to allocate memory for the queue\n");
+    }
+    return queue;
+}
+
+// -----------------------------------------------------------------------------
+// Delete the first count names of a list with as few calls as possible
+static void gla_delete_objects(GLenum identifier, GLsizei count,
+                            const GLuint *names)
+{
+    switch (identifier) {
+    case GL_BUFFER:
+        glDeleteBuffers(count, names);
+        break;
+    case GL_SHADER:
+        for (GLsizei i = 0; i < count; i++) {
+            gla_delete_shader(names[i]);
+        }
+        break;
+    case GL_PROGRAM:
+        for (GLsizei i = 0; i < count; i++) {
+            gla_delete_program(names[i]);
+        }
+        break;
+    case GL_VERTEX_ARRAY:
+        glDeleteVertexArrays(count, names);
+        break;
+    case GL_QUERY:
+        glDeleteQueries(count, names);
+        break;
+    case GL_TEXTURE:
+        glDeleteTextures(count, names);
+        break;
+    case GL_FRAMEBUFFER:
+        glDeleteFramebuffers(count, names);
+        break;
+    case GL_RENDERBUFFER:
+        glDeleteRenderbuffers(count, names);
+        break;
+    case GL_SAMPLER:
+        glDeleteSamplers(count, names);
+        break;
+    default:
+        break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Delete all objects of the frames before the given frame
+static GLuint gla_collect_deletion_queue(gla_deletion_queue *queue,
+                                        GLuint64 frame)
+{
+    GLuint num_deleted = 0;
+    for (int i = 0; i < GLA_DELETION_QUEUE_NUM_TYPES; i++) {
+        gla_deletion_list *list = &queue->lists[i];
+        GLuint n = 0;
+        while (n < list->count && list->frames[n] < frame) {
+            n++;
+        }
+        if (n == 0) {
+            continue;
+        }
+        gla_delete_objects(gla_deletion_queue_types[i], n, list->names);
+        list->count -= n;
+        memmove(list->names, list->names + n, list->count * sizeof(GLuint));
+        memmove(list->frames, list->frames + n,
+                list->count * sizeof(GLuint64));
+        num_deleted += n;
+    }
+    return num_deleted;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_deletion_queue(gla_deletion_queue *queue)
+{
+    if (!queue) {
+        return;
+    }
+
+    glFinish();
+    gla_collect_deletion_queue(queue, queue->frame + 1);
+    for (GLuint i = 0; i < queue->num_fences; i++) {
+        glDeleteSync(queue->fences[i].fence);
+    }
+    for (int i = 0; i < GLA_DELETION_QUEUE_NUM_TYPES; i++) {
+        free(queue->lists[i].names);
+        free(queue->lists[i].frames);
+    }
+    free(queue->fences);
+    free(queue);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_defer_delete(gla_deletion_queue *queue, GLenum identifier,
+                                GLuint name)
+{
+    if (name == 0) {
+        return;
+    }
+
+    int type = 0;
+    while (type < GLA_DELETION_QUEUE_NUM_TYPES &&
+        gla_deletion_queue_types[type] != identifier) {
+        type++;
+    }
+    if (type == GLA_DELETION_QUEUE_NUM_TYPES) {
+        fprintf(stderr, "Error: Deferred deletion: "
+                        "Unknown object identifier 0x%x\n", identifier);
+        return;
+    }
+
+    gla_deletion_list *list = &queue->lists[type];
+    if (list->count == list->capacity) {
+        GLuint capacity = list->capacity ? list->capacity * 2 : 64;
+        GLuint *names = realloc(list->names, capacity * sizeof(GLuint));
+        if (names) {
+            list->names = names;
+        }
+        GLuint64 *frames = realloc(list->frames, capacity * sizeof(GLuint64));
+        if (frames) {
+            list->frames = frames;
+        }
+        if (!(names && frames)) {
+            // Better to delete too early than to leak
+            fprintf(stderr, "Error: Deferred deletion: "
+                            "Unable to allocate memory, deleting now\n");
+            glFinish();
+            gla_delete_objects(identifier, 1, &name);
+            return;
+        }
+        list->capacity = capacity;
+    }
+    list->names[list->count] = name;
+    list->frames[list->count] = queue->frame;
+    list->count++;
+    queue->num_open++;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_end_deletion_queue_frame(gla_deletion_queue *queue)
+{
+    if (queue->num_open > 0) {
+        if (queue->num_fences == queue->fence_capacity) {
+            GLuint capacity =
+                queue->fence_capacity ? queue->fence_capacity * 2 : 8;
+            gla_deletion_fence *fences =
+                realloc(queue->fences, capacity * sizeof(gla_deletion_fence));
+            if (!fences) {
+                // Keep the frame open, its objects join the next fence
+                fprintf(stderr, "Error: Deferred deletion: "
+                                "Unable to allocate memory for the fence\n");
+                return 0;
+            }
+            queue->fences = fences;
+            queue->fence_capacity = capacity;
+        }
+        gla_deletion_fence *fence = &queue->fences[queue->num_fences++];
+        fence->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        fence->frame = queue->frame;
+        queue->frame++;
+        queue->num_open = 0;
+    }
+
+    // Fences signal in submission order, so stop at the first unsignaled one.
+    // The first poll flushes, otherwise an unflushed fence might never
+    // signal.
+    GLuint num_signaled = 0;
+    while (num_signaled < queue->num_fences) {
+        GLbitfield flags = num_signaled == 0 ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+        GLenum status = glClientWaitSync(
+            queue->fences[num_signaled].fence, flags, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        glDeleteSync(queue->fences[num_signaled].fence);
+        num_signaled++;
+    }
+    if (num_signaled == 0) {
+        return 0;
+    }
+
+    GLuint64 frame = queue->fences[num_signaled - 1].frame + 1;
+    queue->num_fences -= num_signaled;
+    memmove(queue->fences, queue->fences + num_signaled,
+            queue->num_fences * sizeof(gla_deletion_fence));
+    return gla_collect_deletion_queue(queue, frame);
+}
+
+// -----------------------------------------------------------------------------
+// Object registries
+// -----------------------------------------------------------------------------
+#define GLA_HANDLE_INDEX_BITS 18
+#define GLA_HANDLE_GENERATION_BITS 11
+#define GLA_HANDLE_INDEX_MASK ((1u << GLA_HANDLE_INDEX_BITS) - 1)
+#define GLA_HANDLE_GENERATION_MASK ((1u << GLA_HANDLE_GENERATION_BITS) - 1)
+#define GLA_OBJECT_REGISTRY_NUM_TYPES 6
+
+static const GLenum gla_object_registry_types[GLA_OBJECT_REGISTRY_NUM_TYPES] = {
+    GL_PROGRAM, GL_SHADER, GL_BUFFER, GL_VERTEX_ARRAY, GL_TEXTURE, GL_QUERY
+};
+
+static const char *gla_object_registry_type_names[
+    GLA_OBJECT_REGISTRY_NUM_TYPES] = {
+    "program", "shader", "buffer", "vertex array", "texture", "query"
+};
+
+// Slots of one object type. Released slots form a free list through
+// next_free and keep their generation, which is bumped on release.
+typedef struct gla_object_slots {
+    gla_object_info *infos;
+    GLuint *generations;
+    GLuint *next_free;
+    GLuint count;
+    GLuint capacity;
+    GLuint free_head; // One past the slot index, 0 for an empty list
+    GLuint num_live;
+} gla_object_slots;
+
+struct gla_object_registry {
+    gla_object_slots slots[GLA_OBJECT_REGISTRY_NUM_TYPES];
+};
+
+// -----------------------------------------------------------------------------
+static int gla_object_type_index(GLenum identifier)
+{
+    for (int i = 0; i < GLA_OBJECT_REGISTRY_NUM_TYPES; i++) {
+        if (gla_object_registry_types[i] == identifier) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+// Return the slot of a live handle, or NULL
+static gla_object_info *gla_find_object(const gla_object_registry *registry,
+                                        gla_handle handle)
+{
+    GLuint type = handle.value >>
+                (GLA_HANDLE_INDEX_BITS + GLA_HANDLE_GENERATION_BITS);
+    GLuint generation =
+        (handle.value >> GLA_HANDLE_INDEX_BITS) & GLA_HANDLE_GENERATION_MASK;
+    GLuint index = handle.value & GLA_HANDLE_INDEX_MASK;
+    if (handle.value == 0 || type >= GLA_OBJECT_REGISTRY_NUM_TYPES) {
+        return NULL;
+    }
+    const gla_object_slots *slots = &registry->slots[type];
+    if (index >= slots->count || slots->generations[index] != generation ||
+        slots->infos[index].name == 0) {
+        return NULL;
+    }
+    return &slots->infos[index];
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_object_registry *gla_create_object_registry(void)
+{
+    gla_object_registry *registry = calloc(1, sizeof(gla_object_registry));
+    if (!registry) {
+        fprintf(stderr, "Error: Object registry creation: "
+                        "Unable to allocate memory for the registry\n");
+    }
+    return registry;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_object_registry(gla_object_registry *registry)
+{
+    if (!registry) {
+        return;
+    }
+
+    GLuint num_live = 0;
+    for (int i = 0; i < GLA_OBJECT_REGISTRY_NUM_TYPES; i++) {
+        num_live += registry->slots[i].num_live;
+    }
+    if (num_live > 0) {
+        fprintf(stderr, "Warning: Object registry deletion: "
+                        "%u objects are still registered\n", num_live);
+        gla_print_live_objects(registry, stderr);
+    }
+
+    for (int i = 0; i < GLA_OBJECT_REGISTRY_NUM_TYPES; i++) {
+        free(registry->slots[i].infos);
+        free(registry->slots[i].generations);
+        free(registry->slots[i].next_free);
+    }
+    free(registry);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_handle gla_register_object(gla_object_registry *registry,
+                                        GLenum identifier, GLuint name,
+                                        GLsizeiptr size, const GLchar *label,
+                                        const char *file, int line)
+{
+    gla_handle handle = {0};
+    int type = gla_object_type_index(identifier);
+    if (type < 0 || name == 0) {
+        fprintf(stderr, "Error: Object registration: "
+                        "Invalid object 0x%x %u\n", identifier, name);
+        return handle;
+    }
+
+    gla_object_slots *slots = &registry->slots[type];
+    GLuint index;
+    if (slots->free_head > 0) {
+        index = slots->free_head - 1;
+        slots->free_head = slots->next_free[index];
+    } else {
+        if (slots->count > GLA_HANDLE_INDEX_MASK) {
+            fprintf(stderr, "Error: Object registration: "
+                            "Too many %s objects\n",
+                    gla_object_registry_type_names[type]);
+            return handle;
+        }
+        if (slots->count == slots->capacity) {
+            GLuint capacity = slots->capacity ? slots->capacity * 2 : 64;
+            gla_object_info *infos =
+                realloc(slots->infos, capacity * sizeof(gla_object_info));
+            if (infos) {
+                slots->infos = infos;
+            }
+            GLuint *generations =
+                realloc(slots->generations, capacity * sizeof(GLuint));
+            if (generations) {
+                slots->generations = generations;
+            }
+            GLuint *next_free =
+                realloc(slots->next_free, capacity * sizeof(GLuint));
+            if (next_free) {
+                slots->next_free = next_free;
+            }
+            if (!(infos && generations && next_free)) {
+                fprintf(stderr, "Error: Object registration: "
+                                "Unable to allocate memory for the slots\n");
+                return handle;
+            }
+            slots->capacity = capacity;
+        }
+        index = slots->count++;
+        slots->generations[index] = 1;
+    }
+
+    gla_object_info *info = &slots->infos[index];
+    info->identifier = identifier;
+    info->name = name;
+    info->size = size;
+    info->label[0] = '\0';
+    if (label) {
+        strncpy(info->label, label, GLA_MAX_OBJECT_LABEL_LENGTH - 1);
+        info->label[GLA_MAX_OBJECT_LABEL_LENGTH - 1] = '\0';
+        if (glObjectLabel) {
+            glObjectLabel(identifier, name, -1, info->label);
+        }
+    }
+    info->file = file;
+    info->line = line;
+    slots->num_live++;
+
+    handle.value = ((GLuint) type << (GLA_HANDLE_INDEX_BITS +
+                                    GLA_HANDLE_GENERATION_BITS)) |
+                (slots->generations[index] << GLA_HANDLE_INDEX_BITS) | index;
+    return handle;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_release_object(gla_object_registry *registry,
+                                    gla_handle handle,
+                                    gla_deletion_queue *queue)
+{
+    gla_object_info *info = gla_find_object(registry, handle);
+    if (!info) {
+        return;
+    }
+
+    if (queue) {
+        gla_defer_delete(queue, info->identifier, info->name);
+    } else {
+        gla_delete_objects(info->identifier, 1, &info->name);
+    }
+
+    GLuint type = handle.value >>
+                (GLA_HANDLE_INDEX_BITS + GLA_HANDLE_GENERATION_BITS);
+    GLuint index = handle.value & GLA_HANDLE_INDEX_MASK;
+    gla_object_slots *slots = &registry->slots[type];
+    info->name = 0;
+    // Generation 0 is skipped so that no handle value is 0
+    GLuint generation =
+        (slots->generations[index] + 1) & GLA_HANDLE_GENERATION_MASK;
+    slots->generations[index] = generation ? generation : 1;
+    slots->next_free[index] = slots->free_head;
+    slots->free_head = index + 1;
+    slots->num_live--;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_get_object(const gla_object_registry *registry,
+                                gla_handle handle, GLenum identifier)
+{
+    const gla_object_info *info = gla_find_object(registry, handle);
+    if (!info || info->identifier != identifier) {
+        return 0;
+    }
+    return info->name;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE const gla_object_info *gla_get_object_info(
+    const gla_object_registry *registry, gla_handle handle)
+{
+    return gla_find_object(registry, handle);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_print_live_objects(const gla_object_registry *registry,
+                                        FILE *stream)
+{
+    GLuint num_live = 0;
+    for (int i = 0; i < GLA_OBJECT_REGISTRY_NUM_TYPES; i++) {
+        const gla_object_slots *slots = &registry->slots[i];
+        for (GLuint j = 0; j < slots->count; j++) {
+            const gla_object_info *info = &slots->infos[j];
+            if (info->name == 0) {
+                continue;
+            }
+            fprintf(stream,
+                    "%s %u: %lld bytes, \"%s\", registered at %s:%d\n",
+                    gla_object_registry_type_names[i], info->name,
+                    (long long) info->size, info->label,
+                    info->file ? info->file : "?", info->line);
+            num_live++;
+        }
+    }
+    return num_live;
+}
+
+// -----------------------------------------------------------------------------
+// Memory accounting
+// -----------------------------------------------------------------------------
+typedef struct gla_memory_record {
+    GLenum identifier;
+    GLuint name;
+    int category;
+    GLsizeiptr size;
+    GLchar label[GLA_MAX_OBJECT_LABEL_LENGTH];
+} gla_memory_record;
+
+static const char *gla_memory_category_names[GLA_MEMORY_NUM_CATEGORIES + 1] = {
+    "vertex buffer", "index buffer", "uniform buffer", "storage buffer",
+    "stream buffer", "other buffer", "texture", "render target", "total"
+};
+
+// The accounting is global so that every allocation site can report to it
+// without a context parameter
+#ifdef GLA_HAS_THREADS
+static pthread_mutex_t gla_memory_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif // GLA_HAS_THREADS
+static gla_memory_record *gla_memory_records = NULL;
+static GLuint gla_num_memory_records = 0;
+static GLuint gla_memory_record_capacity = 0;
+static gla_memory_stats gla_memory_stats_table[GLA_MEMORY_NUM_CATEGORIES + 1];
+static GLchar *gla_memory_report_filename = NULL;
+static GLboolean gla_memory_report_at_exit = GL_FALSE;
+
+// -----------------------------------------------------------------------------
+static void gla_lock_memory_accounting(void)
+{
+#ifdef GLA_HAS_THREADS
+    pthread_mutex_lock(&gla_memory_mutex);
+#endif // GLA_HAS_THREADS
+}
+
+// -----------------------------------------------------------------------------
+static void gla_unlock_memory_accounting(void)
+{
+#ifdef GLA_HAS_THREADS
+    pthread_mutex_unlock(&gla_memory_mutex);
+#endif // GLA_HAS_THREADS
+}
+
+// -----------------------------------------------------------------------------
+// Return whether adding size bytes to a category breaks a refusing budget,
+// and warn about warning budgets. Expects the mutex to be locked.
+static GLboolean gla_exceeds_memory_budget(int category, GLsizeiptr size,
+                                        const GLchar *label)
+{
+    GLboolean refused = GL_FALSE;
+    int categories[2] = {category, GLA_MEMORY_TOTAL};
+    for (int i = 0; i < 2; i++) {
+        const gla_memory_stats *stats = &gla_memory_stats_table[categories[i]];
+        if (stats->budget == 0 || stats->bytes + size <= stats->budget) {
+            continue;
+        }
+        fprintf(stderr, "%s: Memory budget: %lld bytes for \"%s\" exceed the "
+                        "%s budget (%lld of %lld bytes used)\n",
+                stats->refuse ? "Error" : "Warning", (long long) size,
+                label ? label : "", gla_memory_category_names[categories[i]],
+                (long long) stats->bytes, (long long) stats->budget);
+        refused |= stats->refuse;
+    }
+    return refused;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_track_memory(int category, GLenum identifier,
+                                    GLuint name, GLsizeiptr size,
+                                    const GLchar *label)
+{
+    if (category < 0 || category >= GLA_MEMORY_NUM_CATEGORIES) {
+        category = GLA_MEMORY_OTHER_BUFFER;
+    }
+
+    gla_lock_memory_accounting();
+    if (gla_exceeds_memory_budget(category, size, label)) {
+        gla_unlock_memory_accounting();
+        return GL_FALSE;
+    }
+
+    if (gla_num_memory_records == gla_memory_record_capacity) {
+        GLuint capacity =
+            gla_memory_record_capacity ? gla_memory_record_capacity * 2 : 64;
+        gla_memory_record *records = realloc(
+            gla_memory_records, capacity * sizeof(gla_memory_record));
+        if (!records) {
+            // The allocation itself is fine, it just goes unaccounted
+            gla_unlock_memory_accounting();
+            fprintf(stderr, "Error: Memory accounting: "
+                            "Unable to allocate memory for the record\n");
+            return GL_TRUE;
+        }
+        gla_memory_records = records;
+        gla_memory_record_capacity = capacity;
+    }
+
+    gla_memory_record *record = &gla_memory_records[gla_num_memory_records++];
+    record->identifier = identifier;
+    record->name = name;
+    record->category = category;
+    record->size = size;
+    record->label[0] = '\0';
+    if (label) {
+        strncpy(record->label, label, GLA_MAX_OBJECT_LABEL_LENGTH - 1);
+        record->label[GLA_MAX_OBJECT_LABEL_LENGTH - 1] = '\0';
+    }
+
+    int categories[2] = {category, GLA_MEMORY_TOTAL};
+    for (int i = 0; i < 2; i++) {
+        gla_memory_stats *stats = &gla_memory_stats_table[categories[i]];
+        stats->bytes += size;
+        stats->num_objects++;
+        if (stats->bytes > stats->peak_bytes) {
+            stats->peak_bytes = stats->bytes;
+        }
+    }
+    gla_unlock_memory_accounting();
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_untrack_memory(GLenum identifier, GLuint name)
+{
+    gla_lock_memory_accounting();
+    for (GLuint i = 0; i < gla_num_memory_records; i++) {
+        gla_memory_record *record = &gla_memory_records[i];
+        if (record->identifier != identifier || record->name != name) {
+            continue;
+        }
+        int categories[2] = {record->category, GLA_MEMORY_TOTAL};
+        for (int j = 0; j < 2; j++) {
+            gla_memory_stats *stats = &gla_memory_stats_table[categories[j]];
+            stats->bytes -= record->size;
+            stats->num_objects--;
+        }
+        *record = gla_memory_records[--gla_num_memory_records];
+        break;
+    }
+    gla_unlock_memory_accounting();
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_set_memory_budget(int category, GLsizeiptr budget,
+                                    GLboolean refuse)
+{
+    if (category < 0 || category > GLA_MEMORY_TOTAL) {
+        return;
+    }
+    gla_lock_memory_accounting();
+    gla_memory_stats_table[category].budget = budget;
+    gla_memory_stats_table[category].refuse = refuse;
+    gla_unlock_memory_accounting();
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_memory_stats gla_get_memory_stats(int category)
+{
+    gla_memory_stats stats = {0};
+    if (category < 0 || category > GLA_MEMORY_TOTAL) {
+        return stats;
+    }
+    gla_lock_memory_accounting();
+    stats = gla_memory_stats_table[category];
+    gla_unlock_memory_accounting();
+    return stats;
+}
+
+// -----------------------------------------------------------------------------
+static const char *gla_memory_identifier_name(GLenum identifier)
+{
+    switch (identifier) {
+    case GL_BUFFER:
+        return "buffer";
+    case GL_TEXTURE:
+        return "texture";
+    case GL_RENDERBUFFER:
+        return "renderbuffer";
+    default:
+        return "object";
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_print_memory_report(FILE *stream)
+{
+    gla_lock_memory_accounting();
+    fprintf(stream, "%-16s %12s %12s %8s %12s\n", "Category", "Bytes", "Peak",
+            "Objects", "Budget");
+    for (int i = 0; i <= GLA_MEMORY_TOTAL; i++) {
+        const gla_memory_stats *stats = &gla_memory_stats_table[i];
+        fprintf(stream, "%-16s %12lld %12lld %8u %12lld\n",
+                gla_memory_category_names[i], (long long) stats->bytes,
+                (long long) stats->peak_bytes, stats->num_objects,
+                (long long) stats->budget);
+    }
+    for (GLuint i = 0; i < gla_num_memory_records; i++) {
+        const gla_memory_record *record = &gla_memory_records[i];
+        fprintf(stream, "%s %u: %lld bytes, %s, \"%s\"\n",
+                gla_memory_identifier_name(record->identifier), record->name,
+                (long long) record->size,
+                gla_memory_category_names[record->category], record->label);
+    }
+    gla_unlock_memory_accounting();
+}
+
+// -----------------------------------------------------------------------------
+static void gla_write_json_string(FILE *file, const GLchar *string)
+{
+    fputc('"', file);
+    for (const GLchar *c = string; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        } else if ((unsigned char) *c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned char) *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_write_memory_report(const GLchar *filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Error: Memory report writing: "
+                        "Unable to open file %s\n", filename);
+        return GL_FALSE;
+    }
+
+    gla_lock_memory_accounting();
+    fprintf(file, "{\n  \"categories\": [\n");
+    for (int i = 0; i <= GLA_MEMORY_TOTAL; i++) {
+        const gla_memory_stats *stats = &gla_memory_stats_table[i];
+        fprintf(file, "    {\"name\": \"%s\", \"bytes\": %lld, "
+                    "\"peak_bytes\": %lld, \"objects\": %u, "
+                    "\"budget\": %lld}%s\n",
+                gla_memory_category_names[i], (long long) stats->bytes,
+                (long long) stats->peak_bytes, stats->num_objects,
+                (long long) stats->budget, i < GLA_MEMORY_TOTAL ? "," : "");
+    }
+    fprintf(file, "  ],\n  \"objects\": [\n");
+    for (GLuint i = 0; i < gla_num_memory_records; i++) {
+        const gla_memory_record *record = &gla_memory_records[i];
+        fprintf(file, "    {\"type\": \"%s\", \"name\": %u, "
+                    "\"category\": \"%s\", \"bytes\": %lld, \"label\": ",
+                gla_memory_identifier_name(record->identifier), record->name,
+                gla_memory_category_names[record->category],
+                (long long) record->size);
+        gla_write_json_string(file, record->label);
+        fprintf(file, "}%s\n", i + 1 < gla_num_memory_records ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    gla_unlock_memory_accounting();
+
+    GLboolean ok = !ferror(file);
+    ok &= fclose(file) == 0;
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+static void gla_write_memory_report_on_exit(void)
+{
+    if (gla_memory_report_filename) {
+        gla_write_memory_report(gla_memory_report_filename);
+        free(gla_memory_report_filename);
+        gla_memory_report_filename = NULL;
+    } else {
+        gla_print_memory_report(stdout);
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_write_memory_report_at_exit(const GLchar *filename)
+{
+    gla_lock_memory_accounting();
+    free(gla_memory_report_filename);
+    gla_memory_report_filename = NULL;
+    if (filename) {
+        gla_memory_report_filename = malloc(strlen(filename) + 1);
+        if (gla_memory_report_filename) {
+            strcpy(gla_memory_report_filename, filename);
+        }
+    }
+    GLboolean registered = gla_memory_report_at_exit;
+    gla_memory_report_at_exit = GL_TRUE;
+    gla_unlock_memory_accounting();
+
+    if (!registered) {
+        atexit(gla_write_memory_report_on_exit);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Return the bytes per texel, or for block compressed formats the bytes per
+// 4x4 block with *block_size set to 4
+static GLsizeiptr gla_texel_size(GLenum internal_format, GLsizei *block_size)
+{
+    *block_size = 1;
+    switch (internal_format) {
+    case GL_R8:
+    case GL_R8I:
+    case GL_R8UI:
+    case GL_R8_SNORM:
+    case GL_STENCIL_INDEX8:
+        return 1;
+    case GL_RG8:
+    case GL_RG8I:
+    case GL_RG8UI:
+    case GL_RG8_SNORM:
+    case GL_R16:
+    case GL_R16F:
+    case GL_R16I:
+    case GL_R16UI:
+    case GL_R16_SNORM:
+    case GL_DEPTH_COMPONENT16:
+        return 2;
+    case GL_RGB8:
+    case GL_SRGB8:
+        return 3;
+    case GL_RGBA8:
+    case GL_RGBA8I:
+    case GL_RGBA8UI:
+    case GL_RGBA8_SNORM:
+    case GL_SRGB8_ALPHA8:
+    case GL_RG16:
+    case GL_RG16F:
+    case GL_RG16I:
+    case GL_RG16UI:
+    case GL_R32F:
+    case GL_R32I:
+    case GL_R32UI:
+    case GL_RGB10_A2:
+    case GL_RGB10_A2UI:
+    case GL_R11F_G11F_B10F:
+    case GL_RGB9_E5:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+        return 4;
+    case GL_RGB16F:
+        return 6;
+    case GL_RGBA16:
+    case GL_RGBA16F:
+    case GL_RGBA16I:
+    case GL_RGBA16UI:
+    case GL_RG32F:
+    case GL_RG32I:
+    case GL_RG32UI:
+    case GL_DEPTH32F_STENCIL8:
+        return 8;
+    case GL_RGB32F:
+        return 12;
+    case GL_RGBA32F:
+    case GL_RGBA32I:
+    case GL_RGBA32UI:
+        return 16;
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_SRGB8_ETC2:
+        *block_size = 4;
+        return 8;
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+    case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+        *block_size = 4;
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLsizeiptr gla_texture_storage_size(GLenum target, GLsizei levels,
+                                                GLenum internal_format,
+                                                GLsizei width, GLsizei height,
+                                                GLsizei depth)
+{
+    GLsizei block_size;
+    GLsizeiptr texel_size = gla_texel_size(internal_format, &block_size);
+    GLsizeiptr size = 0;
+    for (GLsizei level = 0; level < levels; level++) {
+        GLsizei w = width >> level > 0 ? width >> level : 1;
+        GLsizei h = height >> level > 0 ? height >> level : 1;
+        GLsizei d = depth;
+        if (target == GL_TEXTURE_3D) {
+            d = depth >> level > 0 ? depth >> level : 1;
+        }
+        w = (w + block_size - 1) / block_size;
+        h = (h + block_size - 1) / block_size;
+        size += (GLsizeiptr) w * h * (d > 0 ? d : 1) * texel_size;
+    }
+    return size;
+}
+
+// -----------------------------------------------------------------------------
+// Meshes
+// -----------------------------------------------------------------------------
+#define GLA_MESH_ALIGNMENT 16
+
+// -----------------------------------------------------------------------------
+static GLboolean gla_write_mesh_block(FILE *file, const void *data,
+                                    size_t size, GLuint64 *offset)
+{
+    static const GLubyte zeros[GLA_MESH_ALIGNMENT] = {0};
+    size_t padding = (size_t) (-*offset & (GLA_MESH_ALIGNMENT - 1));
+    if (fwrite(zeros, 1, padding, file) != padding ||
+        (size > 0 && fwrite(data, 1, size, file) != size)) {
+        return GL_FALSE;
+    }
+    *offset += padding + size;
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_write_mesh(const GLchar *filename,
+                                    const gla_vertex_format *format,
+                                    const void *const *streams,
+                                    GLuint num_vertices, const void *indices,
+                                    GLenum index_type, GLuint num_indices,
+                                    const gla_mesh_submesh *submeshes,
+                                    GLuint num_submeshes)
+{
+    if (index_type != GL_UNSIGNED_BYTE && index_type != GL_UNSIGNED_SHORT &&
+        index_type != GL_UNSIGNED_INT) {
+        fprintf(stderr, "Error: Mesh writing: "
+                        "Invalid index type 0x%x\n", index_type);
+        return GL_FALSE;
+    }
+    for (GLuint i = 0; i < num_submeshes; i++) {
+        if (submeshes[i].mode != GL_TRIANGLES &&
+            submeshes[i].mode != GL_TRIANGLE_STRIP) {
+            fprintf(stderr, "Error: Mesh writing: "
+                            "Invalid submesh mode 0x%x\n", submeshes[i].mode);
+            return GL_FALSE;
+        }
+    }
+
+    gla_mesh_header header = {0};
+    header.magic = GLA_MESH_MAGIC;
+    header.version = GLA_MESH_VERSION;
+    header.num_vertices = num_vertices;
+    header.num_indices = num_indices;
+    header.index_type = index_type;
+    header.num_attribs = format->num_attribs;
+    header.num_submeshes = num_submeshes;
+    for (int i = 0; i < 3; i++) {
+        header.aabb_min[i] = num_submeshes > 0 ? submeshes[0].aabb_min[i] : 0;
+        header.aabb_max[i] = num_submeshes > 0 ? submeshes[0].aabb_max[i] : 0;
+    }
+    for (GLuint i = 1; i < num_submeshes; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (submeshes[i].aabb_min[j] < header.aabb_min[j]) {
+                header.aabb_min[j] = submeshes[i].aabb_min[j];
+            }
+            if (submeshes[i].aabb_max[j] > header.aabb_max[j]) {
+                header.aabb_max[j] = submeshes[i].aabb_max[j];
+            }
+        }
+    }
+
+    gla_mesh_attrib attribs[GLA_MAX_VERTEX_ATTRIBS];
+    memset(attribs, 0, sizeof(attribs));
+    GLboolean used[GLA_MAX_VERTEX_BINDINGS] = {0};
+    for (GLuint i = 0; i < format->num_attribs; i++) {
+        const gla_vertex_attrib *attrib = &format->attribs[i];
+        attribs[i].location = (GLubyte) attrib->location;
+        attribs[i].binding = (GLubyte) attrib->binding;
+        attribs[i].count = (GLushort) attrib->count;
+        attribs[i].type = attrib->type;
+        attribs[i].relative_offset = attrib->relative_offset;
+        attribs[i].normalized = attrib->normalized;
+        attribs[i].integer = attrib->integer;
+        used[attrib->binding] = GL_TRUE;
+    }
+
+    for (GLuint i = 0; i < format->num_bindings; i++) {
+        if (used[i]) {
+            if (format->bindings[i].divisor != 0) {
+                fprintf(stderr, "Error: Mesh writing: "
+                                "Binding %u is not per-vertex\n", i);
+                return GL_FALSE;
+            }
+            header.num_streams++;
+        }
+    }
+
+    // The index data and then the stream data follow the tables
+    const GLuint64 mask = GLA_MESH_ALIGNMENT - 1;
+    GLuint64 offset = sizeof(gla_mesh_header) +
+                    format->num_attribs * sizeof(gla_mesh_attrib) +
+                    header.num_streams * sizeof(gla_mesh_stream) +
+                    num_submeshes * sizeof(gla_mesh_submesh);
+    header.index_offset = (offset + mask) & ~mask;
+    offset = header.index_offset +
+            (GLuint64) num_indices * gla_index_size(index_type);
+    gla_mesh_stream mesh_streams[GLA_MAX_VERTEX_BINDINGS];
+    memset(mesh_streams, 0, sizeof(mesh_streams));
+    GLuint num_streams = 0;
+    for (GLuint i = 0; i < format->num_bindings; i++) {
+        if (!used[i]) {
+            continue;
+        }
+        gla_mesh_stream *stream = &mesh_streams[num_streams++];
+        offset = (offset + mask) & ~mask;
+        stream->binding = i;
+        stream->stride = format->bindings[i].stride;
+        stream->offset = offset;
+        stream->size = (GLuint64) num_vertices * stream->stride;
+        offset += stream->size;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Mesh writing: "
+                        "Unable to open file %s\n", filename);
+        return GL_FALSE;
+    }
+    GLuint64 written = 0;
+    GLboolean ok =
+        gla_write_mesh_block(file, &header, sizeof(header), &written) &&
+        gla_write_mesh_block(file, attribs,
+                            format->num_attribs * sizeof(gla_mesh_attrib),
+                            &written) &&
+        gla_write_mesh_block(file, mesh_streams,
+                            num_streams * sizeof(gla_mesh_stream),
+                            &written) &&
+        gla_write_mesh_block(file, submeshes,
+                            num_submeshes * sizeof(gla_mesh_submesh),
+                            &written) &&
+        gla_write_mesh_block(file, indices,
+                            (size_t) num_indices * gla_index_size(index_type),
+                            &written);
+    for (GLuint i = 0; ok && i < num_streams; i++) {
+        ok = gla_write_mesh_block(file, streams[mesh_streams[i].binding],
+                                mesh_streams[i].size, &written);
+    }
+    ok &= fclose(file) == 0;
+    if (!ok) {
+        fprintf(stderr, "Error: Mesh writing: "
+                        "Unable to write file %s\n", filename);
+    }
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Create an immutable buffer object from mapped file data
+static GLuint gla_upload_mesh_block(int category, const GLubyte *data,
+                                    GLuint64 size, const GLchar *label)
+{
+    GLuint buffer;
+    glCreateBuffers(1, &buffer);
+    if (!gla_track_memory(category, GL_BUFFER, buffer, (GLsizeiptr) size,
+                        label)) {
+        glDeleteBuffers(1, &buffer);
+        return 0;
+    }
+    glNamedBufferStorage(buffer, (GLsizeiptr) size, data, 0);
+    return buffer;
+}
+
+// -----------------------------------------------------------------------------
+// Check the tables and data blocks of a mapped mesh file against its size, and
+// that every attribute fits into the stride of exactly one stream
+static GLboolean gla_validate_mesh(const GLubyte *data, size_t size,
+                                const GLchar *filename)
+{
+    const gla_mesh_header *header = (const gla_mesh_header *) data;
+    if (size < sizeof(gla_mesh_header) || header->magic != GLA_MESH_MAGIC ||
+        header->version < 1 || header->version > GLA_MESH_VERSION ||
+        (header->index_type != GL_UNSIGNED_BYTE &&
+        header->index_type != GL_UNSIGNED_SHORT &&
+        header->index_type != GL_UNSIGNED_INT) ||
+        header->num_attribs > GLA_MAX_VERTEX_ATTRIBS ||
+        header->num_streams > GLA_MAX_VERTEX_BINDINGS) {
+        fprintf(stderr, "Error: Mesh loading: "
+                        "File %s has no valid mesh header\n", filename);
+        return GL_FALSE;
+    }
+
+    GLuint64 tables_size = sizeof(gla_mesh_header) +
+                        header->num_attribs * sizeof(gla_mesh_attrib) +
+                        header->num_streams * sizeof(gla_mesh_stream) +
+                        (GLuint64) header->num_submeshes *
+                        sizeof(gla_mesh_submesh);
+    GLuint64 index_size =
+        (GLuint64) header->num_indices * gla_index_size(header->index_type);
+    if (tables_size > size || header->index_offset < tables_size ||
+        header->index_offset > size ||
+        index_size > size - header->index_offset) {
+        fprintf(stderr, "Error: Mesh loading: "
+                        "File %s is truncated\n", filename);
+        return GL_FALSE;
+    }
+
+    const gla_mesh_attrib *attribs =
+        (const gla_mesh_attrib *) (data + sizeof(gla_mesh_header));
+    const gla_mesh_stream *streams =
+        (const gla_mesh_stream *) (attribs + header->num_attribs);
+    GLuint64 strides[GLA_MAX_VERTEX_BINDINGS];
+    GLboolean has_stream[GLA_MAX_VERTEX_BINDINGS] = {0};
+    for (GLuint i = 0; i < header->num_streams; i++) {
+        GLuint binding = streams[i].binding;
+        if (binding >= GLA_MAX_VERTEX_BINDINGS || has_stream[binding]) {
+            fprintf(stderr, "Error: Mesh loading: "
+                            "File %s has an invalid or duplicate binding %u "
+                            "in stream %u\n", filename, binding, i);
+            return GL_FALSE;
+        }
+        if (streams[i].offset > size ||
+            streams[i].size > size - streams[i].offset ||
+            streams[i].size < (GLuint64) header->num_vertices *
+                            streams[i].stride) {
+            fprintf(stderr, "Error: Mesh loading: "
+                            "Stream %u of file %s exceeds the file or is too "
+                            "small for the vertices\n", i, filename);
+            return GL_FALSE;
+        }
+        has_stream[binding] = GL_TRUE;
+        strides[binding] = streams[i].stride;
+    }
+    for (GLuint i = 0; i < header->num_attribs; i++) {
+        GLint count = attribs[i].count;
+        GLsizei attrib_size = (count >= 1 && count <= 4) || count == GL_BGRA ?
+                            gla_vertex_attrib_size(count, attribs[i].type) : 0;
+        if (attribs[i].location >= GLA_MAX_VERTEX_ATTRIBS ||
+            attribs[i].binding >= GLA_MAX_VERTEX_BINDINGS ||
+            !has_stream[attribs[i].binding] || attrib_size == 0 ||
+            (GLuint64) attribs[i].relative_offset + attrib_size >
+                strides[attribs[i].binding]) {
+            fprintf(stderr, "Error: Mesh loading: "
+                            "Attribute %u of file %s is invalid or exceeds "
+                            "the stride of its stream\n", i, filename);
+            return GL_FALSE;
+        }
+    }
+
+    const gla_mesh_submesh *submeshes =
+        (const gla_mesh_submesh *) (streams + header->num_streams);
+    for (GLuint i = 0; i < header->num_submeshes; i++) {
+        if (submeshes[i].first_index > header->num_indices ||
+            submeshes[i].index_count >
+                header->num_indices - submeshes[i].first_index ||
+            (header->version >= 2 && submeshes[i].mode != GL_TRIANGLES &&
+            submeshes[i].mode != GL_TRIANGLE_STRIP)) {
+            fprintf(stderr, "Error: Mesh loading: "
+                            "Submesh %u of file %s is invalid\n", i, filename);
+            return GL_FALSE;
+        }
+    }
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+// Map a mesh file read-only, or read it into memory without POSIX
+static const GLubyte *gla_map_mesh_file(const GLchar *filename, size_t *size)
+{
+#ifdef GLA_HAS_POSIX
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Mesh loading: "
+                        "Unable to open file %s\n", filename);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        fprintf(stderr, "Error: Mesh loading: "
+                        "Unable to read file %s\n", filename);
+        return NULL;
+    }
+    *size = (size_t) st.st_size;
+    const GLubyte *data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Error: Mesh loading: "
+                        "Unable to map file %s\n", filename);
+        return NULL;
+    }
+    return data;
+#else
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Error: Mesh loading: "
+                        "Unable to open file %s\n", filename);
+        return NULL;
+    }
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        length = ftell(file);
+    }
+    GLubyte *data = NULL;
+    if (length > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc((size_t) length);
+    }
+    if (!data || fread(data, 1, (size_t) length, file) != (size_t) length) {
+        free(data);
+        fclose(file);
+        fprintf(stderr, "Error: Mesh loading: "
+                        "Unable to read file %s\n", filename);
+        return NULL;
+    }
+    fclose(file);
+    *size = (size_t) length;
+    return data;
+#endif // GLA_HAS_POSIX
+}
+
+// -----------------------------------------------------------------------------
+static void gla_unmap_mesh_file(const GLubyte *data, size_t size)
+{
+#ifdef GLA_HAS_POSIX
+    munmap((void *) data, size);
+#else
+    (void) size;
+    free((void *) data);
+#endif // GLA_HAS_POSIX
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_load_mesh(gla_mesh *mesh, const GLchar *filename)
+{
+    memset(mesh, 0, sizeof(gla_mesh));
+
+    size_t size = 0;
+    const GLubyte *data = gla_map_mesh_file(filename, &size);
+    if (!data) {
+        return GL_FALSE;
+    }
+
+    if (!gla_validate_mesh(data, size, filename)) {
+        gla_unmap_mesh_file(data, size);
+        return GL_FALSE;
+    }
+
+    const gla_mesh_header *header = (const gla_mesh_header *) data;
+    const gla_mesh_attrib *attribs =
+        (const gla_mesh_attrib *) (data + sizeof(gla_mesh_header));
+    const gla_mesh_stream *streams =
+        (const gla_mesh_stream *) (attribs + header->num_attribs);
+    const gla_mesh_submesh *submeshes =
+        (const gla_mesh_submesh *) (streams + header->num_streams);
+
+    mesh->submeshes = malloc(header->num_submeshes * sizeof(gla_mesh_submesh) +
+                            1);
+    if (!mesh->submeshes) {
+        gla_unmap_mesh_file(data, size);
+        fprintf(stderr, "Error: Mesh loading: "
+                        "Unable to allocate memory for the submeshes\n");
+        return GL_FALSE;
+    }
+    memcpy(mesh->submeshes, submeshes,
+        header->num_submeshes * sizeof(gla_mesh_submesh));
+    if (header->version == 1) {
+        // Version 1 has triangle lists only
+        for (GLuint i = 0; i < header->num_submeshes; i++) {
+            mesh->submeshes[i].mode = GL_TRIANGLES;
+        }
+    }
+    mesh->num_submeshes = header->num_submeshes;
+    mesh->index_type = header->index_type;
+    mesh->num_vertices = header->num_vertices;
+    mesh->num_indices = header->num_indices;
+    memcpy(mesh->aabb_min, header->aabb_min, sizeof(mesh->aabb_min));
+    memcpy(mesh->aabb_max, header->aabb_max, sizeof(mesh->aabb_max));
+
+    for (GLuint i = 0; i < header->num_attribs; i++) {
+        gla_vertex_attrib *attrib = &mesh->format.attribs[i];
+        attrib->location = attribs[i].location;
+        attrib->binding = attribs[i].binding;
+        attrib->count = attribs[i].count;
+        attrib->type = attribs[i].type;
+        attrib->normalized = attribs[i].normalized;
+        attrib->integer = attribs[i].integer;
+        attrib->relative_offset = attribs[i].relative_offset;
+    }
+    mesh->format.num_attribs = header->num_attribs;
+
+    GLboolean ok = GL_TRUE;
+    GLuint64 index_size =
+        (GLuint64) header->num_indices * gla_index_size(header->index_type);
+    if (index_size > 0) {
+        mesh->element_buffer = gla_upload_mesh_block(
+            GLA_MEMORY_INDEX_BUFFER, data + header->index_offset, index_size,
+            filename);
+        ok = mesh->element_buffer != 0;
+    }
+    for (GLuint i = 0; ok && i < header->num_streams; i++) {
+        GLuint binding = streams[i].binding;
+        mesh->format.bindings[binding].stride = streams[i].stride;
+        if (binding >= mesh->format.num_bindings) {
+            mesh->format.num_bindings = binding + 1;
+        }
+        if (streams[i].size > 0) {
+            mesh->buffers[binding] = gla_upload_mesh_block(
+                GLA_MEMORY_VERTEX_BUFFER, data + streams[i].offset,
+                streams[i].size, filename);
+            ok = mesh->buffers[binding] != 0;
+        }
+    }
+    gla_unmap_mesh_file(data, size);
+
+    if (!ok) {
+        fprintf(stderr, "Error: Mesh loading: "
+                        "Unable to create the buffers of %s\n", filename);
+        gla_delete_mesh(mesh);
+    }
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_mesh(gla_mesh *mesh)
+{
+    for (GLuint i = 0; i < GLA_MAX_VERTEX_BINDINGS; i++) {
+        if (mesh->buffers[i]) {
+            gla_untrack_memory(GL_BUFFER, mesh->buffers[i]);
+            glDeleteBuffers(1, &mesh->buffers[i]);
+        }
+    }
+    if (mesh->element_buffer) {
+        gla_untrack_memory(GL_BUFFER, mesh->element_buffer);
+        glDeleteBuffers(1, &mesh->element_buffer);
+    }
+    free(mesh->submeshes);
+    memset(mesh, 0, sizeof(gla_mesh));
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_draw gla_get_mesh_draw(const gla_mesh *mesh, GLuint submesh)
+{
+    gla_draw draw = {0};
+    const gla_mesh_submesh *s = &mesh->submeshes[submesh];
+    draw.index_type = mesh->index_type;
+    draw.index_count = s->index_count;
+    draw.first_index = s->first_index;
+    draw.base_vertex = s->base_vertex;
+    draw.instance_count = 1;
+    return draw;
+}
+
+// -----------------------------------------------------------------------------
+// Mesh optimization
+// -----------------------------------------------------------------------------
+#define GLA_FORSYTH_CACHE_SIZE 32
+#define GLA_FORSYTH_MAX_VALENCE 32
+#define GLA_OVERDRAW_CACHE_SIZE 16
+
+// -----------------------------------------------------------------------------
+// Return a copy of the indices if dst aliases them, or the indices themselves
+static const GLuint *gla_unaliased_indices(const GLuint *dst,
+                                            const GLuint *indices,
+                                            GLuint num_indices, GLuint **copy)
+{
+    *copy = NULL;
+    if (dst != indices) {
+        return indices;
+    }
+    *copy = malloc((size_t) num_indices * sizeof(GLuint) + 1);
+    if (*copy) {
+        memcpy(*copy, indices, (size_t) num_indices * sizeof(GLuint));
+    }
+    return *copy;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_vertex_cache_stats
+gla_analyze_vertex_cache(const GLuint *indices, GLuint num_indices,
+                        GLuint num_vertices, GLuint cache_size)
+{
+    gla_vertex_cache_stats stats = {0};
+    GLuint *timestamps = calloc((size_t) num_vertices + 1, sizeof(GLuint));
+    if (!timestamps || cache_size == 0) {
+        free(timestamps);
+        return stats;
+    }
+
+    // A vertex is cached if fewer than cache_size misses happened since its
+    // own miss
+    GLuint time = cache_size + 1;
+    GLuint num_referenced = 0;
+    for (GLuint i = 0; i < num_indices; i++) {
+        GLuint v = indices[i];
+        if (v >= num_vertices) {
+            continue;
+        }
+        num_referenced += timestamps[v] == 0;
+        if (time - timestamps[v] > cache_size) {
+            timestamps[v] = time++;
+            stats.vertices_transformed++;
+        }
+    }
+    free(timestamps);
+
+    if (num_indices >= 3) {
+        stats.acmr = (GLfloat) stats.vertices_transformed / (num_indices / 3);
+    }
+    if (num_referenced > 0) {
+        stats.atvr = (GLfloat) stats.vertices_transformed / num_referenced;
+    }
+    return stats;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_optimize_vertex_cache(GLuint *dst,
+                                                const GLuint *indices,
+                                                GLuint num_indices,
+                                                GLuint num_vertices)
+{
+    GLuint num_triangles = num_indices / 3;
+    GLuint *copy;
+    const GLuint *src = gla_unaliased_indices(dst, indices, num_indices,
+                                                &copy);
+    GLuint *live = calloc((size_t) num_vertices + 1, sizeof(GLuint));
+    GLuint *offsets = malloc(((size_t) num_vertices + 1) * sizeof(GLuint));
+    GLuint *adjacency = malloc((size_t) num_triangles * 3 * sizeof(GLuint) + 1);
+    GLfloat *scores = malloc(((size_t) num_vertices + 1) * sizeof(GLfloat));
+    int *positions = malloc(((size_t) num_vertices + 1) * sizeof(int));
+    GLubyte *emitted = calloc((size_t) num_triangles + 1, 1);
+    GLboolean ok = src && live && offsets && adjacency && scores &&
+                    positions && emitted;
+    for (GLuint i = 0; ok && i < num_triangles * 3; i++) {
+        if (src[i] >= num_vertices) {
+            fprintf(stderr, "Error: Vertex cache optimization: Index %u out "
+                            "of range\n", src[i]);
+            ok = GL_FALSE;
+        }
+    }
+    if (!ok) {
+        free(copy);
+        free(live);
+        free(offsets);
+        free(adjacency);
+        free(scores);
+        free(positions);
+        free(emitted);
+        return GL_FALSE;
+    }
+
+    // Score tables after Forsyth's "Linear-Speed Vertex Cache Optimisation".
+    // The last three vertices get a fixed score so that the algorithm does not
+    // prefer the triangle it has just emitted.
+    GLfloat cache_scores[GLA_FORSYTH_CACHE_SIZE];
+    GLfloat valence_scores[GLA_FORSYTH_MAX_VALENCE];
+    for (int i = 0; i < GLA_FORSYTH_CACHE_SIZE; i++) {
+        cache_scores[i] = i < 3 ? 0.75f
+                        : powf(1.0f - (GLfloat) (i - 3) /
+                                        (GLA_FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+    valence_scores[0] = 0.0f;
+    for (int i = 1; i < GLA_FORSYTH_MAX_VALENCE; i++) {
+        valence_scores[i] = 2.0f / sqrtf((GLfloat) i);
+    }
+
+    // Triangles of every vertex. The first live[v] entries are not emitted.
+    for (GLuint i = 0; i < num_triangles * 3; i++) {
+        live[src[i]]++;
+    }
+    offsets[0] = 0;
+    for (GLuint v = 0; v < num_vertices; v++) {
+        offsets[v + 1] = offsets[v] + live[v];
+        live[v] = 0;
+    }
+    for (GLuint t = 0; t < num_triangles; t++) {
+        for (int k = 0; k < 3; k++) {
+            GLuint v = src[3 * t + k];
+            adjacency[offsets[v] + live[v]++] = t;
+        }
+    }
+    for (GLuint v = 0; v < num_vertices; v++) {
+        positions[v] = -1;
+        scores[v] = valence_scores[live[v] < GLA_FORSYTH_MAX_VALENCE
+                                    ? live[v] : GLA_FORSYTH_MAX_VALENCE - 1];
+    }
+
+    GLuint cache[GLA_FORSYTH_CACHE_SIZE + 3];
+    GLuint new_cache[GLA_FORSYTH_CACHE_SIZE + 3];
+    GLuint cache_size = 0;
+    GLuint cursor = 0;
+    GLuint best = num_triangles > 0 ? 0 : ~0u;
+    for (GLuint out = 0; out < num_triangles; out++) {
+        // At a dead end, continue with the next triangle in input order
+        if (best == ~0u) {
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+        emitted[best] = 1;
+        memcpy(&dst[3 * out], &src[3 * best], 3 * sizeof(GLuint));
+
+        // Put the triangle's vertices in front of the LRU cache
+        GLuint new_size = 0;
+        for (int k = 0; k < 3; k++) {
+            GLuint v = src[3 * best + k];
+            GLuint *triangles = &adjacency[offsets[v]];
+            for (GLuint i = 0; i < live[v]; i++) {
+                if (triangles[i] == best) {
+                    triangles[i] = triangles[--live[v]];
+                    break;
+                }
+            }
+            if (positions[v] < 0 || (GLuint) positions[v] >= new_size ||
+                new_cache[positions[v]] != v) {
+                positions[v] = (int) new_size;
+                new_cache[new_size++] = v;
+            }
+        }
+        for (GLuint i = 0; i < cache_size; i++) {
+            GLuint v = cache[i];
+            if ((GLuint) positions[v] >= new_size || new_cache[positions[v]] != v) {
+                new_cache[new_size++] = v;
+            }
+        }
+
+        // Rescore the cached and evicted vertices, then pick the best
+        // triangle among those of the cached vertices
+        for (GLuint i = 0; i < new_size; i++) {
+            GLuint v = new_cache[i];
+            positions[v] = i < GLA_FORSYTH_CACHE_SIZE ? (int) i : -1;
+            scores[v] = live[v] == 0 ? -1.0f
+                        : (positions[v] >= 0 ? cache_scores[i] : 0.0f) +
+                          valence_scores[live[v] < GLA_FORSYTH_MAX_VALENCE
+                                        ? live[v]
+                                        : GLA_FORSYTH_MAX_VALENCE - 1];
+        }
+        best = ~0u;
+        GLfloat best_score = 0.0f;
+        cache_size = new_size < GLA_FORSYTH_CACHE_SIZE
+                    ? new_size : GLA_FORSYTH_CACHE_SIZE;
+        for (GLuint i = 0; i < cache_size; i++) {
+            GLuint v = new_cache[i];
+            cache[i] = v;
+            const GLuint *triangles = &adjacency[offsets[v]];
+            for (GLuint j = 0; j < live[v]; j++) {
+                const GLuint *triangle = &src[3 * triangles[j]];
+                GLfloat score = scores[triangle[0]] + scores[triangle[1]] +
+                                scores[triangle[2]];
+                if (score > best_score) {
+                    best_score = score;
+                    best = triangles[j];
+                }
+            }
+        }
+    }
+    memcpy(&dst[3 * num_triangles], &src[3 * num_triangles],
+        (num_indices - 3 * num_triangles) * sizeof(GLuint));
+
+    free(copy);
+    free(live);
+    free(offsets);
+    free(adjacency);
+    free(scores);
+    free(positions);
+    free(emitted);
+    return GL_TRUE;
+}
+
+typedef struct gla_overdraw_cluster {
+    GLuint first_triangle;
+    GLuint num_triangles;
+    GLfloat sort_key;
+} gla_overdraw_cluster;
+
+// -----------------------------------------------------------------------------
+// Count the FIFO cache misses of one triangle
+static GLuint gla_triangle_cache_misses(const GLuint *triangle,
+                                        GLuint *timestamps, GLuint *time)
+{
+    GLuint misses = 0;
+    for (int k = 0; k < 3; k++) {
+        if (*time - timestamps[triangle[k]] > GLA_OVERDRAW_CACHE_SIZE) {
+            timestamps[triangle[k]] = (*time)++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+// -----------------------------------------------------------------------------
+static int gla_compare_overdraw_clusters(const void *a, const void *b)
+{
+    const gla_overdraw_cluster *ca = a;
+    const gla_overdraw_cluster *cb = b;
+    if (ca->sort_key != cb->sort_key) {
+        return ca->sort_key > cb->sort_key ? -1 : 1;
+    }
+    return (ca->first_triangle > cb->first_triangle) -
+            (ca->first_triangle < cb->first_triangle);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_optimize_overdraw(GLuint *dst, const GLuint *indices,
+                                            GLuint num_indices,
+                                            const GLfloat *positions,
+                                            GLsizei position_stride,
+                                            GLuint num_vertices,
+                                            GLfloat threshold)
+{
+    GLuint num_triangles = num_indices / 3;
+    GLuint *copy;
+    const GLuint *src = gla_unaliased_indices(dst, indices, num_indices,
+                                                &copy);
+    GLuint *timestamps = calloc((size_t) num_vertices + 1, sizeof(GLuint));
+    gla_overdraw_cluster *clusters =
+        malloc(((size_t) num_triangles + 1) * sizeof(gla_overdraw_cluster));
+    if (!(src && timestamps && clusters)) {
+        free(copy);
+        free(timestamps);
+        free(clusters);
+        return GL_FALSE;
+    }
+    for (GLuint i = 0; i < num_triangles * 3; i++) {
+        if (src[i] >= num_vertices) {
+            fprintf(stderr, "Error: Overdraw optimization: Index %u out of "
+                            "range\n", src[i]);
+            free(copy);
+            free(timestamps);
+            free(clusters);
+            return GL_FALSE;
+        }
+    }
+
+    // Hard boundaries are where the cache optimized order restarts, i.e. at
+    // triangles that miss all three vertices. Reordering clusters there costs
+    // no vertex cache efficiency.
+    GLuint num_clusters = 0;
+    GLuint time = GLA_OVERDRAW_CACHE_SIZE + 1;
+    for (GLuint t = 0; t < num_triangles; t++) {
+        if (gla_triangle_cache_misses(&src[3 * t], timestamps, &time) == 3 ||
+            t == 0) {
+            clusters[num_clusters++].first_triangle = t;
+        }
+    }
+
+    // Soft boundaries split hard clusters further wherever the running cache
+    // miss ratio is within the threshold of the cluster's own. Every cluster
+    // starts with a cold cache, since it may be drawn after any other.
+    GLuint num_hard_clusters = num_clusters;
+    GLuint *hard_starts = malloc(((size_t) num_hard_clusters + 1) *
+                                sizeof(GLuint));
+    if (!hard_starts) {
+        free(copy);
+        free(timestamps);
+        free(clusters);
+        return GL_FALSE;
+    }
+    for (GLuint c = 0; c < num_hard_clusters; c++) {
+        hard_starts[c] = clusters[c].first_triangle;
+    }
+    hard_starts[num_hard_clusters] = num_triangles;
+    num_clusters = 0;
+    for (GLuint c = 0; c < num_hard_clusters; c++) {
+        GLuint begin = hard_starts[c];
+        GLuint end = hard_starts[c + 1];
+        GLuint misses = 0;
+        time += GLA_OVERDRAW_CACHE_SIZE + 1;
+        for (GLuint t = begin; t < end; t++) {
+            misses += gla_triangle_cache_misses(&src[3 * t], timestamps,
+                                                &time);
+        }
+        GLfloat cluster_threshold = threshold * misses / (end - begin);
+
+        GLuint start = begin;
+        misses = 0;
+        time += GLA_OVERDRAW_CACHE_SIZE + 1;
+        for (GLuint t = begin; t < end; t++) {
+            misses += gla_triangle_cache_misses(&src[3 * t], timestamps,
+                                                &time);
+            if (t + 1 == end ||
+                (GLfloat) misses / (t - start + 1) <= cluster_threshold) {
+                clusters[num_clusters].first_triangle = start;
+                clusters[num_clusters++].num_triangles = t + 1 - start;
+                start = t + 1;
+                misses = 0;
+                time += GLA_OVERDRAW_CACHE_SIZE + 1;
+            }
+        }
+    }
+    free(hard_starts);
+    free(timestamps);
+
+    // Sort clusters by how far they face outward from the mesh center, so
+    // that the occluders are drawn first
+    GLfloat center[3] = {0.0f, 0.0f, 0.0f};
+    for (GLuint v = 0; v < num_vertices; v++) {
+        const GLfloat *p = (const GLfloat *) ((const GLubyte *) positions +
+                                            (size_t) v * position_stride);
+        for (int k = 0; k < 3; k++) {
+            center[k] += p[k] / num_vertices;
+        }
+    }
+    for (GLuint c = 0; c < num_clusters; c++) {
+        GLfloat centroid[3] = {0.0f, 0.0f, 0.0f};
+        GLfloat normal[3] = {0.0f, 0.0f, 0.0f};
+        GLfloat area = 0.0f;
+        for (GLuint t = clusters[c].first_triangle;
+            t < clusters[c].first_triangle + clusters[c].num_triangles; t++) {
+            const GLfloat *p[3];
+            for (int k = 0; k < 3; k++) {
+                p[k] = (const GLfloat *) ((const GLubyte *) positions +
+                                        (size_t) src[3 * t + k] *
+                                            position_stride);
+            }
+            GLfloat e1[3], e2[3], n[3];
+            for (int k = 0; k < 3; k++) {
+                e1[k] = p[1][k] - p[0][k];
+                e2[k] = p[2][k] - p[0][k];
+            }
+            n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+            GLfloat a = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; k++) {
+                centroid[k] += a * (p[0][k] + p[1][k] + p[2][k]) / 3.0f;
+                normal[k] += n[k];
+            }
+            area += a;
+        }
+        GLfloat length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] +
+                                normal[2] * normal[2]);
+        clusters[c].sort_key = 0.0f;
+        if (area > 0.0f && length > 0.0f) {
+            for (int k = 0; k < 3; k++) {
+                clusters[c].sort_key +=
+                    (centroid[k] / area - center[k]) * normal[k] / length;
+            }
+        }
+    }
+    qsort(clusters, num_clusters, sizeof(gla_overdraw_cluster),
+        gla_compare_overdraw_clusters);
+
+    GLuint out = 0;
+    for (GLuint c = 0; c < num_clusters; c++) {
+        memcpy(&dst[3 * out], &src[3 * clusters[c].first_triangle],
+            (size_t) clusters[c].num_triangles * 3 * sizeof(GLuint));
+        out += clusters[c].num_triangles;
+    }
+    memcpy(&dst[3 * num_triangles], &src[3 * num_triangles],
+        (num_indices - 3 * num_triangles) * sizeof(GLuint));
+    free(copy);
+    free(clusters);
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_optimize_vertex_fetch_remap(GLuint *remap,
+                                                    const GLuint *indices,
+                                                    GLuint num_indices,
+                                                    GLuint num_vertices)
+{
+    memset(remap, 0xff, (size_t) num_vertices * sizeof(GLuint));
+    GLuint count = 0;
+    for (GLuint i = 0; i < num_indices; i++) {
+        GLuint v = indices[i];
+        if (v < num_vertices && remap[v] == ~0u) {
+            remap[v] = count++;
+        }
+    }
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_remap_vertices(void *dst, const void *src,
+                                    GLuint num_vertices, GLsizei vertex_size,
+                                    const GLuint *remap)
+{
+    for (GLuint v = 0; v < num_vertices; v++) {
+        if (remap[v] != ~0u) {
+            memcpy((GLubyte *) dst + (size_t) remap[v] * vertex_size,
+                (const GLubyte *) src + (size_t) v * vertex_size,
+                vertex_size);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_remap_indices(GLuint *dst, const GLuint *indices,
+                                    GLuint num_indices, const GLuint *remap)
+{
+    for (GLuint i = 0; i < num_indices; i++) {
+        dst[i] = remap[indices[i]];
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Index buffers
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLenum gla_choose_index_type(GLuint num_vertices,
+                                        GLboolean primitive_restart)
+{
+    GLuint reserved = primitive_restart ? 1 : 0;
+    if (num_vertices <= 0x100 - reserved) {
+        return GL_UNSIGNED_BYTE;
+    }
+    if (num_vertices <= 0x10000 - reserved) {
+        return GL_UNSIGNED_SHORT;
+    }
+    return GL_UNSIGNED_INT;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_get_primitive_restart_index(GLenum index_type)
+{
+    switch (index_type) {
+    case GL_UNSIGNED_BYTE:
+        return 0xffu;
+    case GL_UNSIGNED_SHORT:
+        return 0xffffu;
+    default:
+        return 0xffffffffu;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_convert_indices(void *dst, GLenum index_type,
+                                    const GLuint *indices,
+                                    GLuint num_indices)
+{
+    // Narrowing front to back never overwrites an index before it is read
+    switch (index_type) {
+    case GL_UNSIGNED_BYTE:
+        for (GLuint i = 0; i < num_indices; i++) {
+            GLubyte index = (GLubyte) indices[i];
+            memcpy((GLubyte *) dst + i, &index, sizeof(index));
+        }
+        break;
+    case GL_UNSIGNED_SHORT:
+        for (GLuint i = 0; i < num_indices; i++) {
+            GLushort index = (GLushort) indices[i];
+            memcpy((GLushort *) dst + i, &index, sizeof(index));
+        }
+        break;
+    default:
+        memmove(dst, indices, (size_t) num_indices * sizeof(GLuint));
+        break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Return the unused triangle that continues a strip ending in p, q with the
+// given parity, and its third vertex, or ~0u
+static GLuint gla_find_strip_triangle(const GLuint *indices,
+                                    const GLuint *offsets,
+                                    const GLuint *adjacency,
+                                    const GLuint *live, GLuint p, GLuint q,
+                                    GLboolean odd, GLuint *r)
+{
+    // Even triangles of a strip are wound (p, q, r), odd ones (q, p, r)
+    GLuint a = odd ? q : p;
+    GLuint b = odd ? p : q;
+    const GLuint *triangles = &adjacency[offsets[p]];
+    for (GLuint i = 0; i < live[p]; i++) {
+        const GLuint *triangle = &indices[3 * triangles[i]];
+        for (int k = 0; k < 3; k++) {
+            if (triangle[k] == a && triangle[(k + 1) % 3] == b) {
+                *r = triangle[(k + 2) % 3];
+                return triangles[i];
+            }
+        }
+    }
+    return ~0u;
+}
+
+// -----------------------------------------------------------------------------
+// Remove a triangle from the live triangles of its vertices
+static void gla_remove_strip_triangle(const GLuint *indices,
+                                    const GLuint *offsets, GLuint *adjacency,
+                                    GLuint *live, GLuint t)
+{
+    for (int k = 0; k < 3; k++) {
+        GLuint v = indices[3 * t + k];
+        GLuint *triangles = &adjacency[offsets[v]];
+        for (GLuint i = 0; i < live[v]; i++) {
+            if (triangles[i] == t) {
+                triangles[i] = triangles[--live[v]];
+                break;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_generate_triangle_strips(GLuint *dst,
+                                                const GLuint *indices,
+                                                GLuint num_indices,
+                                                GLuint num_vertices)
+{
+    GLuint num_triangles = num_indices / 3;
+    GLuint *live = calloc((size_t) num_vertices + 1, sizeof(GLuint));
+    GLuint *offsets = malloc(((size_t) num_vertices + 1) * sizeof(GLuint));
+    GLuint *adjacency = malloc((size_t) num_triangles * 3 * sizeof(GLuint) + 1);
+    GLubyte *emitted = calloc((size_t) num_triangles + 1, 1);
+    GLboolean ok = live && offsets && adjacency && emitted;
+    for (GLuint i = 0; ok && i < num_triangles * 3; i++) {
+        if (indices[i] >= num_vertices) {
+            fprintf(stderr, "Error: Strip generation: Index %u out of "
+                            "range\n", indices[i]);
+            ok = GL_FALSE;
+        }
+    }
+    if (!ok) {
+        free(live);
+        free(offsets);
+        free(adjacency);
+        free(emitted);
+        return 0;
+    }
+
+    for (GLuint i = 0; i < num_triangles * 3; i++) {
+        live[indices[i]]++;
+    }
+    offsets[0] = 0;
+    for (GLuint v = 0; v < num_vertices; v++) {
+        offsets[v + 1] = offsets[v] + live[v];
+        live[v] = 0;
+    }
+    for (GLuint t = 0; t < num_triangles; t++) {
+        for (int k = 0; k < 3; k++) {
+            GLuint v = indices[3 * t + k];
+            adjacency[offsets[v] + live[v]++] = t;
+        }
+    }
+
+    GLuint count = 0;
+    for (GLuint first = 0; first < num_triangles; first++) {
+        if (emitted[first]) {
+            continue;
+        }
+        emitted[first] = 1;
+        gla_remove_strip_triangle(indices, offsets, adjacency, live, first);
+
+        // Start with the rotation whose last edge has a neighbor
+        const GLuint *triangle = &indices[3 * first];
+        int rotation = 0;
+        for (int k = 0; k < 3; k++) {
+            GLuint r;
+            if (gla_find_strip_triangle(indices, offsets, adjacency, live,
+                                        triangle[(k + 1) % 3],
+                                        triangle[(k + 2) % 3], GL_TRUE,
+                                        &r) != ~0u) {
+                rotation = k;
+                break;
+            }
+        }
+        if (count > 0) {
+            dst[count++] = 0xffffffffu;
+        }
+        GLuint p = triangle[(rotation + 1) % 3];
+        GLuint q = triangle[(rotation + 2) % 3];
+        dst[count++] = triangle[rotation];
+        dst[count++] = p;
+        dst[count++] = q;
+
+        for (GLboolean odd = GL_TRUE;; odd = !odd) {
+            GLuint r;
+            GLuint t = gla_find_strip_triangle(indices, offsets, adjacency,
+                                                live, p, q, odd, &r);
+            if (t == ~0u) {
+                break;
+            }
+            emitted[t] = 1;
+            gla_remove_strip_triangle(indices, offsets, adjacency, live, t);
+            dst[count++] = r;
+            p = q;
+            q = r;
+        }
+    }
+
+    free(live);
+    free(offsets);
+    free(adjacency);
+    free(emitted);
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// Vertex quantization
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLsizei gla_quantized_attrib_size(GLenum encoding)
+{
+    switch (encoding) {
+    case GLA_QUANTIZED_POSITION:
+    case GLA_QUANTIZED_OCTAHEDRAL_16_SIGN:
+        return 8;
+    case GLA_QUANTIZED_OCTAHEDRAL_10:
+    case GLA_QUANTIZED_OCTAHEDRAL_16:
+    case GLA_QUANTIZED_HALF_FLOAT_2:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_add_quantized_vertex_attrib(gla_vertex_format *format,
+                                                    GLuint location,
+                                                    GLuint binding,
+                                                    GLenum encoding)
+{
+    switch (encoding) {
+    case GLA_QUANTIZED_POSITION:
+        return gla_add_vertex_attrib(format, location, binding, 4,
+                                    GL_UNSIGNED_SHORT, GL_TRUE);
+    case GLA_QUANTIZED_OCTAHEDRAL_10:
+        return gla_add_vertex_attrib(format, location, binding, 4,
+                                    GL_INT_2_10_10_10_REV, GL_TRUE);
+    case GLA_QUANTIZED_OCTAHEDRAL_16:
+        return gla_add_vertex_attrib(format, location, binding, 2, GL_SHORT,
+                                    GL_TRUE);
+    case GLA_QUANTIZED_OCTAHEDRAL_16_SIGN:
+        return gla_add_vertex_attrib(format, location, binding, 4, GL_SHORT,
+                                    GL_TRUE);
+    case GLA_QUANTIZED_HALF_FLOAT_2:
+        return gla_add_vertex_attrib(format, location, binding, 2,
+                                    GL_HALF_FLOAT, GL_FALSE);
+    default:
+        fprintf(stderr, "Error: Vertex quantization: "
+                        "Invalid encoding %u\n", encoding);
+        return GL_FALSE;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_quantize_positions(GLushort *dst,
+                                        const GLfloat *positions,
+                                        GLsizei stride, GLuint num_vertices,
+                                        const GLfloat aabb_min[3],
+                                        const GLfloat aabb_max[3])
+{
+    GLfloat scale[3];
+    for (int k = 0; k < 3; k++) {
+        GLfloat extent = aabb_max[k] - aabb_min[k];
+        scale[k] = extent > 0.0f ? 65535.0f / extent : 0.0f;
+    }
+    for (GLuint v = 0; v < num_vertices; v++) {
+        const GLfloat *p = (const GLfloat *) ((const GLubyte *) positions +
+                                            (size_t) v * stride);
+        for (int k = 0; k < 3; k++) {
+            GLfloat q = (p[k] - aabb_min[k]) * scale[k] + 0.5f;
+            q = q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q);
+            dst[4 * v + k] = (GLushort) q;
+        }
+        dst[4 * v + 3] = 65535;
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_get_position_dequantization(GLfloat matrix[16],
+                                                const GLfloat aabb_min[3],
+                                                const GLfloat aabb_max[3])
+{
+    memset(matrix, 0, 16 * sizeof(GLfloat));
+    for (int k = 0; k < 3; k++) {
+        matrix[5 * k] = aabb_max[k] - aabb_min[k];
+        matrix[12 + k] = aabb_min[k];
+    }
+    matrix[15] = 1.0f;
+}
+
+// -----------------------------------------------------------------------------
+// Map a unit vector onto the octahedron unfolded into [-1, 1]^2
+static void gla_encode_octahedral(const GLfloat *v, GLfloat e[2])
+{
+    GLfloat l1 = fabsf(v[0]) + fabsf(v[1]) + fabsf(v[2]);
+    if (l1 == 0.0f) {
+        e[0] = e[1] = 0.0f;
+        return;
+    }
+    e[0] = v[0] / l1;
+    e[1] = v[1] / l1;
+    if (v[2] < 0.0f) {
+        GLfloat x = e[0];
+        e[0] = (1.0f - fabsf(e[1])) * (x >= 0.0f ? 1.0f : -1.0f);
+        e[1] = (1.0f - fabsf(x)) * (e[1] >= 0.0f ? 1.0f : -1.0f);
+    }
+}
+
+// -----------------------------------------------------------------------------
+static void gla_decode_octahedral(const GLfloat e[2], GLfloat v[3])
+{
+    v[0] = e[0];
+    v[1] = e[1];
+    v[2] = 1.0f - fabsf(e[0]) - fabsf(e[1]);
+    if (v[2] < 0.0f) {
+        GLfloat x = v[0];
+        v[0] = (1.0f - fabsf(v[1])) * (x >= 0.0f ? 1.0f : -1.0f);
+        v[1] = (1.0f - fabsf(x)) * (v[1] >= 0.0f ? 1.0f : -1.0f);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Quantize the octahedral coordinates of a unit vector to signed normalized
+// integers with the given maximum. Of the four neighboring grid points, the
+// one that decodes closest to the vector is taken.
+static void gla_quantize_octahedral(const GLfloat *v, GLfloat max, GLint q[2])
+{
+    GLfloat e[2];
+    gla_encode_octahedral(v, e);
+    GLfloat base[2] = {floorf(e[0] * max), floorf(e[1] * max)};
+    GLfloat best = -2.0f;
+    for (int i = 0; i < 4; i++) {
+        GLfloat c[2] = {base[0] + (i & 1), base[1] + (i >> 1)};
+        c[0] = c[0] < -max ? -max : (c[0] > max ? max : c[0]);
+        c[1] = c[1] < -max ? -max : (c[1] > max ? max : c[1]);
+        GLfloat d[2] = {c[0] / max, c[1] / max};
+        GLfloat u[3];
+        gla_decode_octahedral(d, u);
+        GLfloat length = sqrtf(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+        GLfloat cosine = (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]) / length;
+        if (cosine > best) {
+            best = cosine;
+            q[0] = (GLint) c[0];
+            q[1] = (GLint) c[1];
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_quantize_unit_vectors(void *dst, GLenum encoding,
+                                                const GLfloat *vectors,
+                                                GLsizei stride,
+                                                GLuint num_vertices,
+                                                GLboolean has_signs)
+{
+    if (encoding != GLA_QUANTIZED_OCTAHEDRAL_10 &&
+        encoding != GLA_QUANTIZED_OCTAHEDRAL_16 &&
+        encoding != GLA_QUANTIZED_OCTAHEDRAL_16_SIGN) {
+        fprintf(stderr, "Error: Vertex quantization: "
+                        "Invalid unit vector encoding %u\n", encoding);
+        return GL_FALSE;
+    }
+    for (GLuint i = 0; i < num_vertices; i++) {
+        const GLfloat *v = (const GLfloat *) ((const GLubyte *) vectors +
+                                            (size_t) i * stride);
+        GLint sign = has_signs && v[3] < 0.0f ? -1 : 1;
+        GLint q[2];
+        if (encoding == GLA_QUANTIZED_OCTAHEDRAL_10) {
+            gla_quantize_octahedral(v, 511.0f, q);
+            GLuint packed = ((GLuint) q[0] & 0x3ffu) |
+                            ((GLuint) q[1] & 0x3ffu) << 10 |
+                            ((GLuint) sign & 0x3u) << 30;
+            memcpy((GLubyte *) dst + 4 * (size_t) i, &packed, sizeof(packed));
+            continue;
+        }
+        gla_quantize_octahedral(v, 32767.0f, q);
+        if (encoding == GLA_QUANTIZED_OCTAHEDRAL_16) {
+            GLshort packed[2] = {(GLshort) q[0], (GLshort) q[1]};
+            memcpy((GLubyte *) dst + 4 * (size_t) i, packed, sizeof(packed));
+        } else {
+            GLshort packed[4] = {(GLshort) q[0], (GLshort) q[1], 0,
+                                (GLshort) (sign * 32767)};
+            memcpy((GLubyte *) dst + 8 * (size_t) i, packed, sizeof(packed));
+        }
+    }
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+static GLushort gla_float_to_half(GLfloat value)
+{
+    GLuint bits;
+    memcpy(&bits, &value, sizeof(bits));
+    GLushort sign = (GLushort) ((bits >> 16) & 0x8000u);
+    GLuint magnitude = bits & 0x7fffffffu;
+    if (magnitude > 0x7f800000u) {
+        return sign | 0x7e00u; // NaN
+    }
+    if (magnitude >= 0x477ff000u) {
+        return sign | 0x7c00u; // Infinity, or rounds up to it
+    }
+    if (magnitude < 0x38800000u) {
+        // Subnormal, scaled by 2^24 exactly and rounded to nearest even
+        GLfloat scaled = fabsf(value) * 16777216.0f;
+        return sign | (GLushort) lrintf(scaled);
+    }
+    GLuint half = (magnitude - 0x38000000u) >> 13;
+    GLuint rest = magnitude & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        half++;
+    }
+    return sign | (GLushort) half;
+}
+
+#ifdef GLA_HAS_X86_INTRINSICS
+// -----------------------------------------------------------------------------
+__attribute__((target("avx,f16c")))
+static size_t gla_convert_to_half_floats_f16c(GLushort *dst,
+                                            const GLfloat *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 values = _mm256_loadu_ps(src + i);
+        __m128i halves = _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *) (dst + i), halves);
+    }
+    return i;
+}
+#endif // GLA_HAS_X86_INTRINSICS
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_convert_to_half_floats(GLushort *dst, const GLfloat *src,
+                                            size_t count)
+{
+    size_t i = 0;
+#ifdef GLA_HAS_X86_INTRINSICS
+    if (__builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx")) {
+        i = gla_convert_to_half_floats_f16c(dst, src, count);
+    }
+#endif // GLA_HAS_X86_INTRINSICS
+    for (; i < count; i++) {
+        dst[i] = gla_float_to_half(src[i]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Mesh simplification
+// -----------------------------------------------------------------------------
+#define GLA_SIMPLIFY_MANIFOLD 0
+#define GLA_SIMPLIFY_BORDER 1
+#define GLA_SIMPLIFY_LOCKED 2
+#define GLA_SIMPLIFY_BORDER_WEIGHT 10.0
+
+// Weighted sum of squared distances to a set of planes
+typedef struct gla_quadric {
+    double a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+    double weight;
+} gla_quadric;
+
+typedef struct gla_collapse {
+    GLuint vertex; // The position class that is removed
+    GLuint target; // The vertex that replaces it
+    double cost;
+} gla_collapse;
+
+// -----------------------------------------------------------------------------
+static void gla_add_plane_quadric(gla_quadric *q, double a, double b, double c,
+                                double d, double weight)
+{
+    q->a2 += weight * a * a;
+    q->b2 += weight * b * b;
+    q->c2 += weight * c * c;
+    q->d2 += weight * d * d;
+    q->ab += weight * a * b;
+    q->ac += weight * a * c;
+    q->ad += weight * a * d;
+    q->bc += weight * b * c;
+    q->bd += weight * b * d;
+    q->cd += weight * c * d;
+    q->weight += weight;
+}
+
+// -----------------------------------------------------------------------------
+static double gla_quadric_error(const gla_quadric *q, const GLfloat *p)
+{
+    double x = p[0];
+    double y = p[1];
+    double z = p[2];
+    double error = q->a2 * x * x + q->b2 * y * y + q->c2 * z * z + q->d2 +
+                2.0 * (q->ab * x * y + q->ac * x * z + q->bc * y * z +
+                        q->ad * x + q->bd * y + q->cd * z);
+    return error > 0.0 ? error : 0.0;
+}
+
+// -----------------------------------------------------------------------------
+static int gla_compare_collapses(const void *a, const void *b)
+{
+    const gla_collapse *ca = a;
+    const gla_collapse *cb = b;
+    return (ca->cost > cb->cost) - (ca->cost < cb->cost);
+}
+
+// -----------------------------------------------------------------------------
+static int gla_compare_edges(const void *a, const void *b)
+{
+    GLuint64 ea = *(const GLuint64 *) a;
+    GLuint64 eb = *(const GLuint64 *) b;
+    return (ea > eb) - (ea < eb);
+}
+
+// -----------------------------------------------------------------------------
+static const GLfloat *gla_position(const GLfloat *positions, GLsizei stride,
+                                    GLuint vertex)
+{
+    return (const GLfloat *) ((const GLubyte *) positions +
+                            (size_t) vertex * stride);
+}
+
+// -----------------------------------------------------------------------------
+static void gla_triangle_normal(const GLfloat *p0, const GLfloat *p1,
+                                const GLfloat *p2, double n[3])
+{
+    double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+// -----------------------------------------------------------------------------
+// Map every vertex to the first vertex with the same position
+static GLboolean gla_find_position_classes(const GLfloat *positions,
+                                            GLsizei stride,
+                                            GLuint num_vertices,
+                                            GLuint *classes)
+{
+    // Vertex indices stay below ~0u, so 2^32 slots always leave an empty
+    // one and the empty marker never collides with a vertex
+    size_t capacity = 16;
+    while (capacity < 2 * (GLuint64) num_vertices &&
+            (GLuint64) capacity < (GLuint64) 1 << 32) {
+        if (capacity > (size_t) -1 / (2 * sizeof(GLuint))) {
+            return GL_FALSE;
+        }
+        capacity *= 2;
+    }
+    GLuint *table = malloc(capacity * sizeof(GLuint));
+    if (!table) {
+        return GL_FALSE;
+    }
+    memset(table, 0xff, capacity * sizeof(GLuint));
+    for (GLuint v = 0; v < num_vertices; v++) {
+        const GLfloat *p = gla_position(positions, stride, v);
+        GLuint bits[3];
+        memcpy(bits, p, sizeof(bits));
+        GLuint hash = (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^
+                    (bits[2] * 83492791u);
+        // Round numbers have zero low bits, so mix the high bits down
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        size_t slot = hash & (capacity - 1);
+        for (;;) {
+            if (table[slot] == ~0u) {
+                table[slot] = v;
+                classes[v] = v;
+                break;
+            }
+            if (memcmp(gla_position(positions, stride, table[slot]), p,
+                    3 * sizeof(GLfloat)) == 0) {
+                classes[v] = table[slot];
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+    }
+    free(table);
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+// Classify the position classes and add border planes to their quadrics
+// unless quadrics is NULL. Borders are edges without an opposite edge;
+// border_next links every border class to the next class along its border.
+static GLboolean gla_classify_vertices(const GLuint *indices,
+                                        GLuint num_indices,
+                                        const GLfloat *positions,
+                                        GLsizei stride, GLuint num_vertices,
+                                        const GLuint *classes, GLubyte *kinds,
+                                        GLuint *border_next,
+                                        gla_quadric *quadrics)
+{
+    GLuint64 *edges = malloc((size_t) num_indices * sizeof(GLuint64) + 1);
+    GLubyte *num_out = calloc((size_t) num_vertices + 1, 1);
+    GLubyte *num_in = calloc((size_t) num_vertices + 1, 1);
+    GLubyte *num_wedges = calloc((size_t) num_vertices + 1, 1);
+    if (!(edges && num_out && num_in && num_wedges)) {
+        free(edges);
+        free(num_out);
+        free(num_in);
+        free(num_wedges);
+        return GL_FALSE;
+    }
+
+    for (GLuint v = 0; v < num_vertices; v++) {
+        if (num_wedges[classes[v]] < 2) {
+            num_wedges[classes[v]]++;
+        }
+    }
+    for (GLuint i = 0; i < num_indices; i++) {
+        GLuint a = classes[indices[i]];
+        GLuint b = classes[indices[i - i % 3 + (i + 1) % 3]];
+        edges[i] = (GLuint64) a << 32 | b;
+    }
+    GLuint64 *sorted = malloc((size_t) num_indices * sizeof(GLuint64) + 1);
+    if (!sorted) {
+        free(edges);
+        free(num_out);
+        free(num_in);
+        free(num_wedges);
+        return GL_FALSE;
+    }
+    memcpy(sorted, edges, (size_t) num_indices * sizeof(GLuint64));
+    qsort(sorted, num_indices, sizeof(GLuint64), gla_compare_edges);
+
+    memset(kinds, GLA_SIMPLIFY_MANIFOLD, num_vertices);
+    for (GLuint i = 0; i < num_indices; i++) {
+        GLuint a = (GLuint) (edges[i] >> 32);
+        GLuint b = (GLuint) edges[i];
+        if (a == b) {
+            continue;
+        }
+        GLuint64 reverse = (GLuint64) b << 32 | a;
+        const GLuint64 *found = bsearch(&reverse, sorted, num_indices,
+                                        sizeof(GLuint64), gla_compare_edges);
+        const GLuint64 *same = bsearch(&edges[i], sorted, num_indices,
+                                    sizeof(GLuint64), gla_compare_edges);
+        GLboolean repeated = (same > sorted && same[-1] == edges[i]) ||
+                            (same + 1 < sorted + num_indices &&
+                            same[1] == edges[i]);
+        if (repeated) {
+            // Non-manifold edge
+            kinds[a] = GLA_SIMPLIFY_LOCKED;
+            kinds[b] = GLA_SIMPLIFY_LOCKED;
+        }
+        if (found) {
+            continue;
+        }
+
+        if (num_out[a] < 2) {
+            num_out[a]++;
+        }
+        if (num_in[b] < 2) {
+            num_in[b]++;
+        }
+        border_next[a] = b;
+        if (!quadrics) {
+            continue;
+        }
+
+        // A plane through the edge, perpendicular to its triangle, keeps the
+        // border in place
+        GLuint first = i - i % 3;
+        double n[3];
+        gla_triangle_normal(gla_position(positions, stride, indices[first]),
+                            gla_position(positions, stride,
+                                        indices[first + 1]),
+                            gla_position(positions, stride,
+                                        indices[first + 2]), n);
+        const GLfloat *pa = gla_position(positions, stride, a);
+        const GLfloat *pb = gla_position(positions, stride, b);
+        double e[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+        double m[3] = {e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2],
+                    e[0] * n[1] - e[1] * n[0]};
+        double length = sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+        if (length > 0.0) {
+            for (int k = 0; k < 3; k++) {
+                m[k] /= length;
+            }
+            double d = -(m[0] * pa[0] + m[1] * pa[1] + m[2] * pa[2]);
+            gla_add_plane_quadric(&quadrics[a], m[0], m[1], m[2], d,
+                                GLA_SIMPLIFY_BORDER_WEIGHT);
+            gla_add_plane_quadric(&quadrics[b], m[0], m[1], m[2], d,
+                                GLA_SIMPLIFY_BORDER_WEIGHT);
+        }
+    }
+
+    for (GLuint v = 0; v < num_vertices; v++) {
+        if (classes[v] != v) {
+            continue;
+        }
+        if (num_wedges[v] > 1 || num_out[v] != num_in[v] || num_out[v] > 1) {
+            kinds[v] = GLA_SIMPLIFY_LOCKED;
+        } else if (num_out[v] == 1 && kinds[v] != GLA_SIMPLIFY_LOCKED) {
+            kinds[v] = GLA_SIMPLIFY_BORDER;
+        }
+    }
+    free(edges);
+    free(sorted);
+    free(num_out);
+    free(num_in);
+    free(num_wedges);
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_simplify_mesh(GLuint *dst, const GLuint *indices,
+                                    GLuint num_indices,
+                                    const GLfloat *positions,
+                                    GLsizei position_stride,
+                                    GLuint num_vertices,
+                                    GLuint target_index_count,
+                                    GLfloat target_error,
+                                    GLfloat *result_error)
+{
+    num_indices -= num_indices % 3;
+    for (GLuint i = 0; i < num_indices; i++) {
+        if (indices[i] >= num_vertices) {
+            fprintf(stderr, "Error: Mesh simplification: "
+                            "Index %u out of range\n", indices[i]);
+            return 0;
+        }
+    }
+    GLuint *classes = malloc((size_t) num_vertices * sizeof(GLuint) + 1);
+    GLubyte *kinds = malloc((size_t) num_vertices + 1);
+    GLuint *border_next = malloc((size_t) num_vertices * sizeof(GLuint) + 1);
+    gla_quadric *quadrics = calloc((size_t) num_vertices + 1,
+                                sizeof(gla_quadric));
+    GLuint *offsets = malloc(((size_t) num_vertices + 1) * sizeof(GLuint));
+    GLuint *adjacency = malloc((size_t) num_indices * sizeof(GLuint) + 1);
+    GLuint *targets = malloc((size_t) num_vertices * sizeof(GLuint) + 1);
+    GLubyte *touched = malloc((size_t) num_vertices + 1);
+    gla_collapse *collapses = malloc((size_t) num_indices * 2 *
+                                    sizeof(gla_collapse) + 1);
+    GLboolean ok = classes && kinds && border_next && quadrics && offsets &&
+                    adjacency && targets && touched && collapses &&
+                    gla_find_position_classes(positions, position_stride,
+                                            num_vertices, classes);
+    if (ok) {
+        memmove(dst, indices, (size_t) num_indices * sizeof(GLuint));
+        for (GLuint t = 0; t < num_indices / 3; t++) {
+            const GLfloat *p0 = gla_position(positions, position_stride,
+                                            dst[3 * t]);
+            double n[3];
+            gla_triangle_normal(p0,
+                                gla_position(positions, position_stride,
+                                            dst[3 * t + 1]),
+                                gla_position(positions, position_stride,
+                                            dst[3 * t + 2]), n);
+            double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length == 0.0) {
+                continue;
+            }
+            for (int k = 0; k < 3; k++) {
+                n[k] /= length;
+            }
+            double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+            for (int k = 0; k < 3; k++) {
+                gla_add_plane_quadric(&quadrics[classes[dst[3 * t + k]]],
+                                    n[0], n[1], n[2], d, 1.0);
+            }
+        }
+        ok = gla_classify_vertices(dst, num_indices, positions,
+                                    position_stride, num_vertices, classes,
+                                    kinds, border_next, quadrics);
+    }
+    if (!ok) {
+        free(classes);
+        free(kinds);
+        free(border_next);
+        free(quadrics);
+        free(offsets);
+        free(adjacency);
+        free(targets);
+        free(touched);
+        free(collapses);
+        fprintf(stderr, "Error: Mesh simplification: "
+                        "Unable to allocate memory\n");
         return 0;
     }
 
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertex_shader);
-    if (tessellation_control_shader) {
-        glAttachShader(program, tessellation_control_shader);
+    double error_limit = (double) target_error * target_error;
+    double max_error = 0.0;
+    GLuint count = num_indices;
+    while (count > target_index_count) {
+        // Collapses change the topology, so classify again
+        if (count != num_indices &&
+            !gla_classify_vertices(dst, count, positions, position_stride,
+                                    num_vertices, classes, kinds, border_next,
+                                    NULL)) {
+            break;
+        }
+
+        // Triangles of every position class
+        memset(offsets, 0, ((size_t) num_vertices + 1) * sizeof(GLuint));
+        for (GLuint i = 0; i < count; i++) {
+            offsets[classes[dst[i]] + 1]++;
+        }
+        for (GLuint v = 0; v < num_vertices; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+        for (GLuint i = 0; i < count; i++) {
+            adjacency[offsets[classes[dst[i]]]++] = i / 3;
+        }
+        for (GLuint v = num_vertices; v > 0; v--) {
+            offsets[v] = offsets[v - 1];
+        }
+        offsets[0] = 0;
+
+        // Every allowed collapse along every edge, cheapest first
+        GLuint num_collapses = 0;
+        for (GLuint i = 0; i < count; i++) {
+            GLuint from = dst[i];
+            GLuint to = dst[i - i % 3 + (i + 1) % 3];
+            for (int direction = 0; direction < 2; direction++) {
+                GLuint a = classes[from];
+                GLuint b = classes[to];
+                if (a != b && (kinds[a] == GLA_SIMPLIFY_MANIFOLD ||
+                            (kinds[a] == GLA_SIMPLIFY_BORDER &&
+                            border_next[a] == b))) {
+                    const GLfloat *p = gla_position(positions,
+                                                    position_stride, b);
+                    gla_collapse *c = &collapses[num_collapses++];
+                    c->vertex = a;
+                    c->target = to;
+                    // Mean squared distance to the planes of both vertices
+                    double weight = quadrics[a].weight + quadrics[b].weight;
+                    c->cost = weight > 0.0 ?
+                            (gla_quadric_error(&quadrics[a], p) +
+                            gla_quadric_error(&quadrics[b], p)) / weight :
+                            0.0;
+                }
+                GLuint swap = from;
+                from = to;
+                to = swap;
+            }
+        }
+        qsort(collapses, num_collapses, sizeof(gla_collapse),
+            gla_compare_collapses);
+
+        // Collapses that are blocked in this pass must not be replaced by
+        // much worse ones, so limit the cost to a bit above the cost that
+        // reaches the target if nothing was blocked. Every collapse removes
+        // about two triangles and is listed once per triangle.
+        double pass_limit = error_limit;
+        GLuint goal = (count - target_index_count) / 3;
+        if (goal < num_collapses && 1.5 * collapses[goal].cost < pass_limit) {
+            pass_limit = 1.5 * collapses[goal].cost;
+        }
+
+        // Apply independent collapses that flip no triangle
+        memset(touched, 0, num_vertices);
+        memset(targets, 0xff, (size_t) num_vertices * sizeof(GLuint));
+        GLuint removed = 0;
+        GLuint applied = 0;
+        for (GLuint c = 0; c < num_collapses; c++) {
+            const gla_collapse *collapse = &collapses[c];
+            GLuint a = collapse->vertex;
+            GLuint b = classes[collapse->target];
+            if (collapse->cost > pass_limit ||
+                count - 3 * removed <= target_index_count) {
+                break;
+            }
+            if (touched[a] || touched[b]) {
+                continue;
+            }
+            const GLfloat *pb = gla_position(positions, position_stride, b);
+            GLboolean flips = GL_FALSE;
+            GLuint num_removed = 0;
+            for (GLuint j = offsets[a]; j < offsets[a + 1] && !flips; j++) {
+                const GLuint *triangle = &dst[3 * adjacency[j]];
+                const GLfloat *p[3];
+                const GLfloat *q[3];
+                GLboolean has_b = GL_FALSE;
+                for (int k = 0; k < 3; k++) {
+                    GLuint v = classes[triangle[k]];
+                    has_b |= v == b;
+                    p[k] = gla_position(positions, position_stride, v);
+                    q[k] = v == a ? pb : p[k];
+                }
+                if (has_b) {
+                    num_removed++;
+                    continue;
+                }
+                double n0[3], n1[3];
+                gla_triangle_normal(p[0], p[1], p[2], n0);
+                gla_triangle_normal(q[0], q[1], q[2], n1);
+                double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+                double l0 = n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2];
+                double l1 = n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2];
+                flips = dot <= 0.25 * sqrt(l0 * l1);
+            }
+            if (flips) {
+                continue;
+            }
+
+            targets[a] = collapse->target;
+            for (GLuint j = offsets[a]; j < offsets[a + 1]; j++) {
+                for (int k = 0; k < 3; k++) {
+                    touched[classes[dst[3 * adjacency[j] + k]]] = 1;
+                }
+            }
+            touched[b] = 1;
+            gla_quadric *qa = &quadrics[a];
+            gla_quadric *qb = &quadrics[b];
+            qb->a2 += qa->a2;
+            qb->b2 += qa->b2;
+            qb->c2 += qa->c2;
+            qb->d2 += qa->d2;
+            qb->ab += qa->ab;
+            qb->ac += qa->ac;
+            qb->ad += qa->ad;
+            qb->bc += qa->bc;
+            qb->bd += qa->bd;
+            qb->cd += qa->cd;
+            qb->weight += qa->weight;
+            if (collapse->cost > max_error) {
+                max_error = collapse->cost;
+            }
+            removed += num_removed;
+            applied++;
+        }
+        if (applied == 0) {
+            break;
+        }
+
+        // Replace collapsed vertices and drop degenerate triangles
+        GLuint out = 0;
+        for (GLuint t = 0; t < count / 3; t++) {
+            GLuint v[3];
+            for (int k = 0; k < 3; k++) {
+                v[k] = dst[3 * t + k];
+                if (targets[classes[v[k]]] != ~0u) {
+                    v[k] = targets[classes[v[k]]];
+                }
+            }
+            if (classes[v[0]] != classes[v[1]] &&
+                classes[v[1]] != classes[v[2]] &&
+                classes[v[2]] != classes[v[0]]) {
+                memcpy(&dst[out], v, sizeof(v));
+                out += 3;
+            }
+        }
+        count = out;
     }
-    if (tessellation_evaluation_shader) {
-        glAttachShader(program, tessellation_evaluation_shader);
+
+    if (result_error) {
+        *result_error = (GLfloat) sqrt(max_error);
     }
-    if (geometry_shader) {
-        glAttachShader(program, geometry_shader);
+    free(classes);
+    free(kinds);
+    free(border_next);
+    free(quadrics);
+    free(offsets);
+    free(adjacency);
+    free(targets);
+    free(touched);
+    free(collapses);
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_select_mesh_lod(const gla_mesh *mesh, GLuint submesh,
+                                        const GLfloat model_view[16],
+                                        const GLfloat projection[16],
+                                        GLfloat viewport_height,
+                                        GLfloat max_pixel_error)
+{
+    const gla_mesh_submesh *s = &mesh->submeshes[submesh];
+
+    // Distance from the eye to the bounding sphere, in view space
+    GLfloat center[3];
+    GLfloat radius = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        center[k] = 0.5f * (s->aabb_min[k] + s->aabb_max[k]);
+        GLfloat half = 0.5f * (s->aabb_max[k] - s->aabb_min[k]);
+        radius += half * half;
     }
-    glAttachShader(program, fragment_shader);
+    GLfloat scale = 0.0f;
+    for (int c = 0; c < 3; c++) {
+        const GLfloat *column = &model_view[4 * c];
+        GLfloat length = column[0] * column[0] + column[1] * column[1] +
+                        column[2] * column[2];
+        scale = length > scale ? length : scale;
+    }
+    scale = sqrtf(scale);
+    radius = sqrtf(radius) * scale;
+    GLfloat view[3];
+    for (int r = 0; r < 3; r++) {
+        view[r] = model_view[r] * center[0] + model_view[4 + r] * center[1] +
+                model_view[8 + r] * center[2] + model_view[12 + r];
+    }
+    GLfloat distance = sqrtf(view[0] * view[0] + view[1] * view[1] +
+                            view[2] * view[2]) - radius;
 
-    glLinkProgram(program);
+    // Pixels per view space unit at that distance. An orthographic projection
+    // does not depend on the distance.
+    GLfloat pixels = 0.5f * viewport_height * projection[5] * scale;
+    if (projection[15] == 0.0f) {
+        if (distance <= 0.0f) {
+            return submesh;
+        }
+        pixels /= distance;
+    }
 
-    glDetachShader(program, vertex_shader);
-    if (tessellation_control_shader) {
-        glDetachShader(program, tessellation_control_shader);
+    GLuint selected = submesh;
+    for (GLuint i = submesh + 1; i < mesh->num_submeshes &&
+        mesh->submeshes[i].lod_error > 0.0f; i++) {
+        if (mesh->submeshes[i].lod_error * pixels <= max_pixel_error) {
+            selected = i;
+        }
+    }
+    return selected;
+}
+
+// -----------------------------------------------------------------------------
+// Meshlets
+// -----------------------------------------------------------------------------
+#define GLA_MESHLET_CULL_GROUP_SIZE 64
+
+static const GLchar *gla_meshlet_cull_source =
+    "layout(local_size_x = 64) in;\n"
+    "struct gla_meshlet {\n"
+    "    vec4 sphere;\n"
+    "    vec4 cone;\n"
+    "    uint first_index;\n"
+    "    uint index_count;\n"
+    "    uint vertex_count;\n"
+    "    uint reserved;\n"
+    "};\n"
+    "layout(std430, binding = 0) readonly buffer gla_meshlets {\n"
+    "    gla_meshlet meshlets[];\n"
+    "};\n"
+    "#ifdef GLA_CULL_INDICES\n"
+    "layout(std430, binding = 1) readonly buffer gla_indices {\n"
+    "    uint indices[];\n"
+    "};\n"
+    "layout(std430, binding = 2) writeonly buffer gla_visible_indices {\n"
+    "    uint visible_indices[];\n"
+    "};\n"
+    "layout(std430, binding = 3) buffer gla_command {\n"
+    "    uint count;\n"
+    "    uint instance_count;\n"
+    "} command;\n"
+    "#else\n"
+    "struct gla_command {\n"
+    "    uint count;\n"
+    "    uint instance_count;\n"
+    "    uint first_index;\n"
+    "    int base_vertex;\n"
+    "    uint base_instance;\n"
+    "};\n"
+    "layout(std430, binding = 2) writeonly buffer gla_commands {\n"
+    "    gla_command commands[];\n"
+    "};\n"
+    "layout(std430, binding = 3) buffer gla_draw_count {\n"
+    "    uint draw_count;\n"
+    "};\n"
+    "#endif\n"
+    "layout(location = 0) uniform vec4 planes[6];\n"
+    "layout(location = 6) uniform vec3 camera_position;\n"
+    "layout(location = 7) uniform uint num_meshlets;\n"
+    "void main()\n"
+    "{\n"
+    "    uint i = gl_GlobalInvocationID.x;\n"
+    "#ifdef GLA_CULL_INDICES\n"
+    "    if (i == 0u) {\n"
+    "        command.instance_count = 1u;\n"
+    "    }\n"
+    "#endif\n"
+    "    if (i >= num_meshlets) {\n"
+    "        return;\n"
+    "    }\n"
+    "    gla_meshlet m = meshlets[i];\n"
+    "    vec3 center = m.sphere.xyz;\n"
+    "    float radius = m.sphere.w;\n"
+    "    for (int p = 0; p < 6; p++) {\n"
+    "        if (dot(planes[p].xyz, center) + planes[p].w < -radius) {\n"
+    "            return;\n"
+    "        }\n"
+    "    }\n"
+    // Backfacing if every normal in the cone and every point in the sphere
+    // face away, i.e. the angle between the axis and the view direction plus
+    // the cone angle is small enough
+    "    if (m.cone.w > 0.0) {\n"
+    "        vec3 v = center - camera_position;\n"
+    "        float d = dot(m.cone.xyz, v);\n"
+    "        float s = sqrt(max(dot(v, v) - d * d, 0.0));\n"
+    "        float sin_cone = sqrt(max(1.0 - m.cone.w * m.cone.w, 0.0));\n"
+    "        if (d * m.cone.w - s * sin_cone >= radius) {\n"
+    "            return;\n"
+    "        }\n"
+    "    }\n"
+    "#ifdef GLA_CULL_INDICES\n"
+    "    uint offset = atomicAdd(command.count, m.index_count);\n"
+    "    for (uint k = 0u; k < m.index_count; k++) {\n"
+    "        visible_indices[offset + k] = indices[m.first_index + k];\n"
+    "    }\n"
+    "#else\n"
+    "    uint slot = atomicAdd(draw_count, 1u);\n"
+    "    commands[slot] = gla_command(m.index_count, 1u, m.first_index, 0, i);\n"
+    "#endif\n"
+    "}\n";
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_get_max_meshlets(GLuint num_indices)
+{
+    // A meshlet is only closed early when no triangle fits, i.e. when it has
+    // more than GLA_MESHLET_MAX_VERTICES - 3 vertices
+    GLuint min_triangles = (GLA_MESHLET_MAX_VERTICES - 3) / 3 + 1;
+    if (min_triangles > GLA_MESHLET_MAX_TRIANGLES) {
+        min_triangles = GLA_MESHLET_MAX_TRIANGLES;
+    }
+    return num_indices / 3 / min_triangles + 1;
+}
+
+// -----------------------------------------------------------------------------
+// Compute the bounding sphere and normal cone of a meshlet
+static void gla_compute_meshlet_bounds(gla_meshlet *meshlet,
+                                        const GLuint *indices,
+                                        const GLuint *vertices,
+                                        const GLfloat *positions,
+                                        GLsizei stride)
+{
+    // Ritter's sphere: start with the vertex farthest from the first vertex
+    // and the vertex farthest from that one, then grow it to contain every
+    // vertex
+    const GLfloat *p0 = gla_position(positions, stride, vertices[0]);
+    const GLfloat *p1 = p0;
+    const GLfloat *p2 = p0;
+    GLfloat d1 = 0.0f;
+    for (GLuint i = 0; i < meshlet->vertex_count; i++) {
+        const GLfloat *p = gla_position(positions, stride, vertices[i]);
+        GLfloat dx = p[0] - p0[0], dy = p[1] - p0[1], dz = p[2] - p0[2];
+        GLfloat d = dx * dx + dy * dy + dz * dz;
+        if (d > d1) {
+            d1 = d;
+            p1 = p;
+        }
+    }
+    GLfloat d2 = 0.0f;
+    for (GLuint i = 0; i < meshlet->vertex_count; i++) {
+        const GLfloat *p = gla_position(positions, stride, vertices[i]);
+        GLfloat dx = p[0] - p1[0], dy = p[1] - p1[1], dz = p[2] - p1[2];
+        GLfloat d = dx * dx + dy * dy + dz * dz;
+        if (d > d2) {
+            d2 = d;
+            p2 = p;
+        }
+    }
+    GLfloat center[3];
+    for (int k = 0; k < 3; k++) {
+        center[k] = 0.5f * (p1[k] + p2[k]);
+    }
+    GLfloat radius = 0.5f * sqrtf(d2);
+    for (GLuint i = 0; i < meshlet->vertex_count; i++) {
+        const GLfloat *p = gla_position(positions, stride, vertices[i]);
+        GLfloat dx = p[0] - center[0], dy = p[1] - center[1],
+                dz = p[2] - center[2];
+        GLfloat d = sqrtf(dx * dx + dy * dy + dz * dz);
+        if (d > radius) {
+            GLfloat grown = 0.5f * (radius + d);
+            GLfloat shift = (grown - radius) / d;
+            center[0] += dx * shift;
+            center[1] += dy * shift;
+            center[2] += dz * shift;
+            radius = grown;
+        }
+    }
+    memcpy(meshlet->center, center, sizeof(center));
+    meshlet->radius = radius;
+
+    // The cone axis is the mean unit normal. Degenerate triangles face
+    // nowhere and are skipped.
+    GLfloat normals[GLA_MESHLET_MAX_TRIANGLES][3];
+    GLuint num_normals = 0;
+    double axis[3] = {0.0, 0.0, 0.0};
+    for (GLuint i = 0; i < meshlet->index_count; i += 3) {
+        double n[3];
+        gla_triangle_normal(gla_position(positions, stride, indices[i]),
+                            gla_position(positions, stride, indices[i + 1]),
+                            gla_position(positions, stride, indices[i + 2]),
+                            n);
+        double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0.0) {
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            normals[num_normals][k] = (GLfloat) (n[k] / length);
+            axis[k] += n[k] / length;
+        }
+        num_normals++;
+    }
+    double length = sqrt(axis[0] * axis[0] + axis[1] * axis[1] +
+                        axis[2] * axis[2]);
+    meshlet->cone_cutoff = -1.0f;
+    for (int k = 0; k < 3; k++) {
+        meshlet->cone_axis[k] = length > 0.0 ? (GLfloat) (axis[k] / length)
+                                            : 0.0f;
+    }
+    if (length == 0.0) {
+        return;
+    }
+    GLfloat cutoff = 1.0f;
+    for (GLuint i = 0; i < num_normals; i++) {
+        GLfloat d = normals[i][0] * meshlet->cone_axis[0] +
+                    normals[i][1] * meshlet->cone_axis[1] +
+                    normals[i][2] * meshlet->cone_axis[2];
+        cutoff = d < cutoff ? d : cutoff;
+    }
+    meshlet->cone_cutoff = cutoff > 0.0f ? cutoff : -1.0f;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_meshlets(gla_meshlet *meshlets, GLuint *dst,
+                                    const GLuint *indices, GLuint num_indices,
+                                    const GLfloat *positions,
+                                    GLsizei position_stride,
+                                    GLuint num_vertices)
+{
+    GLuint num_triangles = num_indices / 3;
+    GLuint *copy;
+    const GLuint *src = gla_unaliased_indices(dst, indices, num_indices,
+                                                &copy);
+    GLuint *offsets = calloc((size_t) num_vertices + 1, sizeof(GLuint));
+    GLuint *adjacency = malloc((size_t) num_triangles * 3 * sizeof(GLuint) + 1);
+    GLuint *stamps = malloc((size_t) num_vertices * sizeof(GLuint) + 1);
+    GLubyte *emitted = calloc((size_t) num_triangles + 1, 1);
+    GLboolean ok = src && offsets && adjacency && stamps && emitted;
+    for (GLuint i = 0; ok && i < num_triangles * 3; i++) {
+        if (src[i] >= num_vertices) {
+            fprintf(stderr, "Error: Meshlet building: Index %u out of "
+                            "range\n", src[i]);
+            ok = GL_FALSE;
+        }
+    }
+    if (!ok) {
+        free(copy);
+        free(offsets);
+        free(adjacency);
+        free(stamps);
+        free(emitted);
+        return 0;
+    }
+
+    // Triangles of every vertex
+    for (GLuint i = 0; i < num_triangles * 3; i++) {
+        offsets[src[i]]++;
+    }
+    GLuint sum = 0;
+    for (GLuint v = 0; v < num_vertices; v++) {
+        GLuint count = offsets[v];
+        offsets[v] = sum;
+        sum += count;
+    }
+    offsets[num_vertices] = sum;
+    for (GLuint i = 0; i < num_triangles * 3; i++) {
+        adjacency[offsets[src[i]]++] = i / 3;
+    }
+    for (GLuint v = num_vertices; v > 0; v--) {
+        offsets[v] = offsets[v - 1];
+    }
+    offsets[0] = 0;
+
+    // Vertices stamped with the current meshlet number belong to it
+    memset(stamps, 0xff, (size_t) num_vertices * sizeof(GLuint));
+    GLuint vertices[GLA_MESHLET_MAX_VERTICES];
+    GLuint num_meshlets = 0;
+    GLuint cursor = 0;
+    GLuint count = 0;
+    gla_meshlet *meshlet = NULL;
+    for (GLuint t = 0; t < num_triangles; t++) {
+        // The adjacent triangle that adds the fewest vertices, or else the
+        // next triangle in order
+        GLuint best = ~0u;
+        GLuint best_new = 4;
+        for (GLuint i = 0; meshlet && i < meshlet->vertex_count &&
+            best_new > 0; i++) {
+            GLuint v = vertices[i];
+            for (GLuint j = offsets[v]; j < offsets[v + 1]; j++) {
+                GLuint candidate = adjacency[j];
+                if (emitted[candidate]) {
+                    continue;
+                }
+                GLuint new_vertices = 0;
+                for (int k = 0; k < 3; k++) {
+                    new_vertices += stamps[src[3 * candidate + k]] !=
+                                    num_meshlets - 1;
+                }
+                if (new_vertices < best_new ||
+                    (new_vertices == best_new && candidate < best)) {
+                    best = candidate;
+                    best_new = new_vertices;
+                }
+            }
+        }
+        if (best == ~0u) {
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+            best_new = 0;
+            for (int k = 0; meshlet && k < 3; k++) {
+                best_new += stamps[src[3 * best + k]] != num_meshlets - 1;
+            }
+        }
+
+        if (!meshlet ||
+            meshlet->vertex_count + best_new > GLA_MESHLET_MAX_VERTICES ||
+            meshlet->index_count == 3 * GLA_MESHLET_MAX_TRIANGLES) {
+            if (meshlet) {
+                gla_compute_meshlet_bounds(meshlet,
+                                        &dst[meshlet->first_index], vertices,
+                                        positions, position_stride);
+            }
+            meshlet = &meshlets[num_meshlets++];
+            memset(meshlet, 0, sizeof(gla_meshlet));
+            meshlet->first_index = count;
+        }
+
+        emitted[best] = 1;
+        for (int k = 0; k < 3; k++) {
+            GLuint v = src[3 * best + k];
+            if (stamps[v] != num_meshlets - 1) {
+                stamps[v] = num_meshlets - 1;
+                vertices[meshlet->vertex_count++] = v;
+            }
+            dst[count++] = v;
+        }
+        meshlet->index_count += 3;
+    }
+    if (meshlet) {
+        gla_compute_meshlet_bounds(meshlet, &dst[meshlet->first_index],
+                                vertices, positions, position_stride);
+    }
+
+    free(copy);
+    free(offsets);
+    free(adjacency);
+    free(stamps);
+    free(emitted);
+    return num_meshlets;
+}
+
+// -----------------------------------------------------------------------------
+// Normalized left, right, bottom, top, near and far planes of a column-major
+// matrix, in the order of cgm's mat4_frustum_planes, which applications use on
+// the CPU. gla does not depend on cgm, so the culling entry points extract the
+// planes themselves.
+static void gla_frustum_planes(GLfloat planes[24], const GLfloat matrix[16])
+{
+    // Gribb and Hartmann: the planes are the sums and differences of the
+    // fourth row and the other rows
+    for (int i = 0; i < 6; i++) {
+        GLfloat sign = i % 2 == 0 ? 1.0f : -1.0f;
+        GLfloat *plane = &planes[4 * i];
+        for (int c = 0; c < 4; c++) {
+            plane[c] = matrix[4 * c + 3] + sign * matrix[4 * c + i / 2];
+        }
+        GLfloat length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] +
+                            plane[2] * plane[2]);
+        if (length > 0.0f) {
+            for (int c = 0; c < 4; c++) {
+                plane[c] /= length;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Build a compute program from built-in source with a define
+static GLuint gla_build_builtin_compute_program(const GLchar *define,
+                                                const GLchar *source,
+                                                const char *context)
+{
+    const GLchar *sources[3] = {"#version 430\n", define, source};
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 3, sources, NULL);
+    glCompileShader(shader);
+    if (!gla_check_shader_build(shader)) {
+        fprintf(stderr, "Error: %s: Shader build error. "
+                        "See shader info log\n", context);
+        gla_delete_shader(shader);
+        return 0;
+    }
+    GLuint program = gla_build_compute_program(shader);
+    gla_delete_shader(shader);
+    if (!gla_check_program_build(program, GL_LINK_STATUS)) {
+        gla_delete_program(program);
+        return 0;
+    }
+    return program;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_meshlet_cull_program(GLuint output)
+{
+    return gla_build_builtin_compute_program(
+        output == GLA_MESHLET_CULL_INDICES ? "#define GLA_CULL_INDICES\n" : "",
+        gla_meshlet_cull_source, "Meshlet cull program building");
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cull_meshlets(GLuint program, GLuint output,
+                                    GLuint meshlet_buffer,
+                                    GLuint num_meshlets, GLuint index_buffer,
+                                    const GLfloat model_view_projection[16],
+                                    const GLfloat camera_position[3],
+                                    GLuint output_buffer, GLuint count_buffer)
+{
+    GLfloat planes[24];
+    gla_frustum_planes(planes, model_view_projection);
+    glProgramUniform4fv(program, 0, 6, planes);
+    glProgramUniform3fv(program, 6, 1, camera_position);
+    glProgramUniform1ui(program, 7, num_meshlets);
+
+    // The program sets the instance count of the one command
+    GLsizeiptr count_size = output == GLA_MESHLET_CULL_INDICES ?
+                            sizeof(gla_draw_elements_indirect_command) :
+                            sizeof(GLuint);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, count_buffer);
+    glClearBufferSubData(GL_COPY_WRITE_BUFFER, GL_R32UI, 0, count_size,
+                        GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, meshlet_buffer);
+    if (output == GLA_MESHLET_CULL_INDICES) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, index_buffer);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, output_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, count_buffer);
+    glUseProgram(program);
+    glDispatchCompute((num_meshlets + GLA_MESHLET_CULL_GROUP_SIZE - 1) /
+                    GLA_MESHLET_CULL_GROUP_SIZE + (num_meshlets == 0), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT |
+                    GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// -----------------------------------------------------------------------------
+// Object culling
+// -----------------------------------------------------------------------------
+#define GLA_OBJECT_CULL_GROUP_SIZE 64
+
+static const GLchar *gla_object_cull_source =
+    "layout(local_size_x = 64) in;\n"
+    "struct gla_cull_object {\n"
+    "    vec3 aabb_min;\n"
+    "    uint index_count;\n"
+    "    vec3 aabb_max;\n"
+    "    uint first_index;\n"
+    "    int base_vertex;\n"
+    "    uint transform;\n"
+    "    uint reserved[2];\n"
+    "};\n"
+    "struct gla_command {\n"
+    "    uint count;\n"
+    "    uint instance_count;\n"
+    "    uint first_index;\n"
+    "    int base_vertex;\n"
+    "    uint base_instance;\n"
+    "};\n"
+    "layout(std430, binding = 0) readonly buffer gla_objects {\n"
+    "    gla_cull_object objects[];\n"
+    "};\n"
+    "layout(std430, binding = 1) readonly buffer gla_transforms {\n"
+    "    mat4 transforms[];\n"
+    "};\n"
+    "layout(std430, binding = 2) writeonly buffer gla_commands {\n"
+    "    gla_command commands[];\n"
+    "};\n"
+    "layout(std430, binding = 3) buffer gla_draw_count {\n"
+    "    uint draw_count;\n"
+    "};\n"
+    "layout(std430, binding = 4) buffer gla_visibility {\n"
+    "    uint visibility[];\n"
+    "};\n"
+    "layout(binding = 0) uniform sampler2D hiz;\n"
+    "layout(location = 0) uniform vec4 planes[6];\n"
+    "layout(location = 6) uniform uint num_objects;\n"
+    "layout(location = 7) uniform uint phase;\n"
+    "layout(location = 8) uniform mat4 view_projection;\n"
+    "layout(location = 12) uniform ivec2 depth_size;\n"
+    "shared uint group_count;\n"
+    "shared uint group_offset;\n"
+    // The world space box around the transformed box is tested against the
+    // planes
+    "bool gla_is_visible(vec3 center, vec3 extent)\n"
+    "{\n"
+    "    for (int p = 0; p < 6; p++) {\n"
+    "        if (dot(planes[p].xyz, center) + planes[p].w <\n"
+    "            -dot(abs(planes[p].xyz), extent)) {\n"
+    "            return false;\n"
+    "        }\n"
+    "    }\n"
+    "    return true;\n"
+    "}\n"
+    // Hidden if the closest depth of the box is farther than the farthest
+    // depth of the at most 2 x 2 pyramid texels covering its screen rectangle.
+    // Texel t of level l covers the pixels from t * 2^(l + 1) on, and the last
+    // texels of a row or column cover the remaining pixels.
+    "bool gla_is_occluded(vec3 center, vec3 extent)\n"
+    "{\n"
+    "    vec2 uv_min = vec2(1.0);\n"
+    "    vec2 uv_max = vec2(0.0);\n"
+    "    float depth = 1.0;\n"
+    "    for (int c = 0; c < 8; c++) {\n"
+    "        vec3 corner = center + extent * vec3((c & 1) != 0 ? 1.0 : -1.0,\n"
+    "                                             (c & 2) != 0 ? 1.0 : -1.0,\n"
+    "                                             (c & 4) != 0 ? 1.0 : -1.0);\n"
+    "        vec4 clip = view_projection * vec4(corner, 1.0);\n"
+    "        if (clip.w <= 0.0) {\n"
+    "            return false;\n"
+    "        }\n"
+    "        vec3 ndc = clip.xyz / clip.w;\n"
+    "        uv_min = min(uv_min, ndc.xy * 0.5 + 0.5);\n"
+    "        uv_max = max(uv_max, ndc.xy * 0.5 + 0.5);\n"
+    "        depth = min(depth, ndc.z * 0.5 + 0.5);\n"
+    "    }\n"
+    "    ivec2 p_min = min(ivec2(clamp(uv_min, 0.0, 1.0) * vec2(depth_size)),\n"
+    "                      depth_size - 1);\n"
+    "    ivec2 p_max = min(ivec2(clamp(uv_max, 0.0, 1.0) * vec2(depth_size)),\n"
+    "                      depth_size - 1);\n"
+    // The rectangle spans at most 2 texels per axis from the level of the
+    // highest bit of its size on, and possibly from the level below
+    "    ivec2 span = p_max - p_min;\n"
+    "    int level = max(findMSB(max(span.x, span.y)), 0);\n"
+    "    if (level > 0 && all(lessThanEqual((p_max >> level) -\n"
+    "                                       (p_min >> level), ivec2(1)))) {\n"
+    "        level--;\n"
+    "    }\n"
+    "    level = min(level, textureQueryLevels(hiz) - 1);\n"
+    "    ivec2 size = max(depth_size >> (level + 1), ivec2(1));\n"
+    "    ivec2 t0 = min(p_min >> (level + 1), size - 1);\n"
+    "    ivec2 t1 = min(p_max >> (level + 1), size - 1);\n"
+    "    float occluder = max(\n"
+    "        max(texelFetch(hiz, t0, level).r,\n"
+    "            texelFetch(hiz, ivec2(t1.x, t0.y), level).r),\n"
+    "        max(texelFetch(hiz, ivec2(t0.x, t1.y), level).r,\n"
+    "            texelFetch(hiz, t1, level).r));\n"
+    "    return depth > occluder;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "    uint i = gl_GlobalInvocationID.x;\n"
+    "    gla_cull_object o;\n"
+    "    bool visible = false;\n"
+    "    if (i < num_objects) {\n"
+    "        o = objects[i];\n"
+    "        mat4 m = transforms[o.transform];\n"
+    "        vec3 center = 0.5 * (o.aabb_min + o.aabb_max);\n"
+    "        vec3 extent = 0.5 * (o.aabb_max - o.aabb_min);\n"
+    "        center = (m * vec4(center, 1.0)).xyz;\n"
+    "        extent = abs(m[0].xyz) * extent.x + abs(m[1].xyz) * extent.y +\n"
+    "                 abs(m[2].xyz) * extent.z;\n"
+    "        visible = gla_is_visible(center, extent);\n"
+    "        if (phase == 1u) {\n"
+    "            visible = visible && !gla_is_occluded(center, extent);\n"
+    "        } else if (phase == 2u) {\n"
+    "            visible = visible && visibility[i] != 0u;\n"
+    "        } else if (phase == 3u) {\n"
+    "            bool now = visible && !gla_is_occluded(center, extent);\n"
+    "            visible = now && visibility[i] == 0u;\n"
+    "            visibility[i] = now ? 1u : 0u;\n"
+    "        }\n"
+    "    }\n"
+    // One atomic operation on the count per group instead of per object
+    "    if (gl_LocalInvocationIndex == 0u) {\n"
+    "        group_count = 0u;\n"
+    "    }\n"
+    "    memoryBarrierShared();\n"
+    "    barrier();\n"
+    "    uint local_offset = 0u;\n"
+    "    if (visible) {\n"
+    "        local_offset = atomicAdd(group_count, 1u);\n"
+    "    }\n"
+    "    memoryBarrierShared();\n"
+    "    barrier();\n"
+    "    if (gl_LocalInvocationIndex == 0u && group_count > 0u) {\n"
+    "        group_offset = atomicAdd(draw_count, group_count);\n"
+    "    }\n"
+    "    memoryBarrierShared();\n"
+    "    barrier();\n"
+    "#ifdef GLA_CULL_COMPACT\n"
+    "    if (visible) {\n"
+    "        commands[group_offset + local_offset] = gla_command(\n"
+    "            o.index_count, 1u, o.first_index, o.base_vertex, i);\n"
+    "    }\n"
+    "#else\n"
+    "    if (i < num_objects) {\n"
+    "        commands[i] = gla_command(o.index_count, visible ? 1u : 0u,\n"
+    "                                  o.first_index, o.base_vertex, i);\n"
+    "    }\n"
+    "#endif\n"
+    "}\n";
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLuint gla_build_object_cull_program(GLuint output)
+{
+    return gla_build_builtin_compute_program(
+        output == GLA_OBJECT_CULL_COMPACT ? "#define GLA_CULL_COMPACT\n" : "",
+        gla_object_cull_source, "Object cull program building");
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cull_objects(GLuint program, GLuint object_buffer,
+                                GLuint transform_buffer, GLuint num_objects,
+                                const GLfloat view_projection[16],
+                                GLuint command_buffer, GLuint count_buffer)
+{
+    gla_cull_objects_occlusion(program, GLA_CULL_PHASE_FRUSTUM, object_buffer,
+                            transform_buffer, num_objects, view_projection,
+                            NULL, 0, command_buffer, count_buffer);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_cull_objects_occlusion(GLuint program, GLuint phase,
+                                            GLuint object_buffer,
+                                            GLuint transform_buffer,
+                                            GLuint num_objects,
+                                            const GLfloat view_projection[16],
+                                            const gla_hiz_pyramid *pyramid,
+                                            GLuint visibility_buffer,
+                                            GLuint command_buffer,
+                                            GLuint count_buffer)
+{
+    GLfloat planes[24];
+    gla_frustum_planes(planes, view_projection);
+    glProgramUniform4fv(program, 0, 6, planes);
+    glProgramUniform1ui(program, 6, num_objects);
+    glProgramUniform1ui(program, 7, phase);
+    if (phase != GLA_CULL_PHASE_FRUSTUM) {
+        glProgramUniformMatrix4fv(program, 8, 1, GL_FALSE, view_projection);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, visibility_buffer);
+    }
+    if (pyramid) {
+        glProgramUniform2i(program, 12, pyramid->width, pyramid->height);
+        glBindTextureUnit(0, pyramid->texture);
+        glBindSampler(0, pyramid->sampler);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, count_buffer);
+    glClearBufferSubData(GL_COPY_WRITE_BUFFER, GL_R32UI, 0, sizeof(GLuint),
+                        GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, object_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, transform_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, command_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, count_buffer);
+    glUseProgram(program);
+    glDispatchCompute((num_objects + GLA_OBJECT_CULL_GROUP_SIZE - 1) /
+                    GLA_OBJECT_CULL_GROUP_SIZE + (num_objects == 0), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_draw_culled_objects(GLuint output, GLenum mode,
+                                        GLenum index_type,
+                                        GLuint command_buffer,
+                                        GLuint count_buffer,
+                                        GLsizei num_objects)
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+    if (output == GLA_OBJECT_CULL_FIXED) {
+        glMultiDrawElementsIndirect(mode, index_type, NULL, num_objects, 0);
+    } else if (glMultiDrawElementsIndirectCount) {
+        glBindBuffer(GL_PARAMETER_BUFFER, count_buffer);
+        glMultiDrawElementsIndirectCount(mode, index_type, NULL, 0,
+                                        num_objects, 0);
+    } else {
+        // The count is written by a shader, so the read back must wait for it
+        GLuint count = 0;
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_COPY_READ_BUFFER, count_buffer);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(GLuint), &count);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glMultiDrawElementsIndirect(mode, index_type, NULL, (GLsizei) count,
+                                    0);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Hi-Z pyramids
+// -----------------------------------------------------------------------------
+#define GLA_HIZ_GROUP_SIZE 8
+
+// Every texel takes the farthest of the 2 x 2 source texels, and at odd
+// source sizes the last texels of a row or column also take the remaining
+// source texels, so that no source texel is left out
+static const GLchar *gla_hiz_source =
+    "layout(local_size_x = 8, local_size_y = 8) in;\n"
+    "layout(binding = 0) uniform sampler2D source;\n"
+    "layout(r32f, binding = 0) uniform writeonly image2D destination;\n"
+    "layout(location = 0) uniform int source_level;\n"
+    "float gla_fetch(ivec2 p, ivec2 size)\n"
+    "{\n"
+    "    return texelFetch(source, min(p, size - 1), source_level).r;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "    ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+    "    ivec2 size = imageSize(destination);\n"
+    "    if (any(greaterThanEqual(p, size))) {\n"
+    "        return;\n"
+    "    }\n"
+    "    ivec2 source_size = textureSize(source, source_level);\n"
+    "    ivec2 s = 2 * p;\n"
+    "    ivec2 last = ivec2(equal(p, size - 1)) * (source_size & 1);\n"
+    "    float depth = 0.0;\n"
+    "    for (int y = 0; y <= 1 + last.y; y++) {\n"
+    "        for (int x = 0; x <= 1 + last.x; x++) {\n"
+    "            depth = max(depth, gla_fetch(s + ivec2(x, y), source_size));\n"
+    "        }\n"
+    "    }\n"
+    "    imageStore(destination, p, vec4(depth));\n"
+    "}\n";
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE GLboolean gla_create_hiz_pyramid(gla_hiz_pyramid *pyramid,
+                                            GLsizei width, GLsizei height)
+{
+    memset(pyramid, 0, sizeof(gla_hiz_pyramid));
+    if (width < 2 || height < 2) {
+        fprintf(stderr, "Error: Hi-Z pyramid creation: "
+                        "Invalid depth buffer size\n");
+        return GL_FALSE;
+    }
+
+    GLsizei level_width = width / 2;
+    GLsizei level_height = height / 2;
+    GLsizeiptr size = 0;
+    for (GLsizei w = level_width, h = level_height;; w = w > 1 ? w / 2 : 1,
+        h = h > 1 ? h / 2 : 1) {
+        size += (GLsizeiptr) w * h * sizeof(GLfloat);
+        pyramid->num_levels++;
+        if (w == 1 && h == 1) {
+            break;
+        }
+    }
+
+    pyramid->program = gla_build_builtin_compute_program(
+        "", gla_hiz_source, "Hi-Z pyramid creation");
+    if (!pyramid->program) {
+        return GL_FALSE;
+    }
+    glCreateTextures(GL_TEXTURE_2D, 1, &pyramid->texture);
+    if (!gla_track_memory(GLA_MEMORY_TEXTURE, GL_TEXTURE, pyramid->texture,
+                        size, "Hi-Z pyramid")) {
+        glDeleteTextures(1, &pyramid->texture);
+        gla_delete_program(pyramid->program);
+        memset(pyramid, 0, sizeof(gla_hiz_pyramid));
+        return GL_FALSE;
+    }
+    glTextureStorage2D(pyramid->texture, pyramid->num_levels, GL_R32F,
+                    level_width, level_height);
+
+    // Texel fetches ignore the filters, but only a mipmapping sampler makes
+    // the levels above the base level accessible
+    glCreateSamplers(1, &pyramid->sampler);
+    glSamplerParameteri(pyramid->sampler, GL_TEXTURE_MIN_FILTER,
+                        GL_NEAREST_MIPMAP_NEAREST);
+    glSamplerParameteri(pyramid->sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glSamplerParameteri(pyramid->sampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    pyramid->width = width;
+    pyramid->height = height;
+    return GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_hiz_pyramid(gla_hiz_pyramid *pyramid)
+{
+    if (pyramid->texture) {
+        gla_untrack_memory(GL_TEXTURE, pyramid->texture);
+        glDeleteTextures(1, &pyramid->texture);
+    }
+    if (pyramid->sampler) {
+        glDeleteSamplers(1, &pyramid->sampler);
+    }
+    if (pyramid->program) {
+        gla_delete_program(pyramid->program);
+    }
+    memset(pyramid, 0, sizeof(gla_hiz_pyramid));
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_build_hiz_pyramid(const gla_hiz_pyramid *pyramid,
+                                        GLuint depth_texture)
+{
+    glUseProgram(pyramid->program);
+    glBindSampler(0, pyramid->sampler);
+    GLsizei width = pyramid->width / 2;
+    GLsizei height = pyramid->height / 2;
+    for (GLsizei level = 0; level < pyramid->num_levels; level++) {
+        // The depth texture has a single level, which the mipmapping sampler
+        // must not require
+        glSamplerParameteri(pyramid->sampler, GL_TEXTURE_MIN_FILTER,
+                            level == 0 ? GL_NEAREST
+                                    : GL_NEAREST_MIPMAP_NEAREST);
+        glBindTextureUnit(0, level == 0 ? depth_texture : pyramid->texture);
+        glProgramUniform1i(pyramid->program, 0, level == 0 ? 0 : level - 1);
+        glBindImageTexture(0, pyramid->texture, level, GL_FALSE, 0,
+                        GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((width + GLA_HIZ_GROUP_SIZE - 1) / GLA_HIZ_GROUP_SIZE,
+                        (height + GLA_HIZ_GROUP_SIZE - 1) / GLA_HIZ_GROUP_SIZE,
+                        1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Occlusion buffers
+// -----------------------------------------------------------------------------
+#define GLA_OCCLUSION_VERTEX_CHUNK 1024
+#define GLA_OCCLUSION_TRIANGLE_CHUNK 256
+#define GLA_OCCLUSION_OBJECT_CHUNK 1024
+
+// Triangles are merged into a working layer of coverage and farthest depth,
+// whose depth replaces the tile depth once the layer covers the whole tile
+typedef struct gla_occlusion_tile {
+    GLuint mask[GLA_OCCLUSION_TILE_HEIGHT]; // Bit x of row y per pixel
+    GLfloat depth; // Farthest depth of the tile
+    GLfloat layer_depth; // Farthest depth of the working layer
+} gla_occlusion_tile;
+
+// The rows of a triangle are bounded by the lines x = x0 + slope * (y - y0)
+// of its left and right edges. Missing edges bound nothing.
+typedef struct gla_occluder_triangle {
+    GLfloat left[2][3]; // x0, y0, slope
+    GLfloat right[2][3];
+    GLfloat plane[3]; // depth = plane[0] * x + plane[1] * y + plane[2]
+    GLfloat max_depth;
+    GLint x_min; // Columns and rows whose pixel centers may be covered
+    GLint x_max;
+    GLint y_min;
+    GLint y_max;
+} gla_occluder_triangle;
+
+struct gla_occlusion_buffer {
+    gla_occlusion_tile *tiles;
+    GLsizei width;
+    GLsizei height;
+    GLsizei tiles_x;
+    GLsizei tiles_y;
+    GLfloat (*clip)[4]; // Clip space positions of the current occluder
+    GLuint clip_capacity;
+    gla_occluder_triangle *triangles; // Two per triangle for near clipping
+    GLuint triangle_capacity;
+};
+
+typedef struct gla_occluder_job {
+    gla_occlusion_buffer *buffer;
+    const GLuint *indices;
+    GLuint num_triangles;
+    const GLubyte *positions;
+    GLsizei position_stride;
+    GLuint num_vertices;
+    const GLfloat *model_view_projection;
+    int use_avx2;
+} gla_occluder_job;
+
+typedef struct gla_occlusion_test_job {
+    const gla_occlusion_buffer *buffer;
+    const gla_cull_object *objects;
+    const GLfloat *transforms;
+    GLuint num_objects;
+    const GLfloat *view_projection;
+    GLuint *visibility;
+} gla_occlusion_test_job;
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE gla_occlusion_buffer *gla_create_occlusion_buffer(GLsizei width,
+                                                            GLsizei height)
+{
+    if (width <= 0 || height <= 0 || width % GLA_OCCLUSION_TILE_WIDTH ||
+        height % GLA_OCCLUSION_TILE_HEIGHT) {
+        fprintf(stderr, "Error: Occlusion buffer creation: "
+                        "Size must be a positive multiple of the tile size\n");
+        return NULL;
+    }
+    gla_occlusion_buffer *buffer = calloc(1, sizeof(gla_occlusion_buffer));
+    if (!buffer) {
+        fprintf(stderr, "Error: Occlusion buffer creation: "
+                        "Unable to allocate memory for the buffer\n");
+        return NULL;
+    }
+    buffer->width = width;
+    buffer->height = height;
+    buffer->tiles_x = width / GLA_OCCLUSION_TILE_WIDTH;
+    buffer->tiles_y = height / GLA_OCCLUSION_TILE_HEIGHT;
+    buffer->tiles = malloc((size_t) buffer->tiles_x * buffer->tiles_y *
+                        sizeof(gla_occlusion_tile));
+    if (!buffer->tiles) {
+        fprintf(stderr, "Error: Occlusion buffer creation: "
+                        "Unable to allocate memory for the tiles\n");
+        free(buffer);
+        return NULL;
+    }
+    gla_clear_occlusion_buffer(buffer);
+    return buffer;
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_delete_occlusion_buffer(gla_occlusion_buffer *buffer)
+{
+    if (!buffer) {
+        return;
+    }
+    free(buffer->tiles);
+    free(buffer->clip);
+    free(buffer->triangles);
+    free(buffer);
+}
+
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_clear_occlusion_buffer(gla_occlusion_buffer *buffer)
+{
+    GLsizei num_tiles = buffer->tiles_x * buffer->tiles_y;
+    for (GLsizei i = 0; i < num_tiles; i++) {
+        memset(buffer->tiles[i].mask, 0, sizeof(buffer->tiles[i].mask));
+        buffer->tiles[i].depth = 1.0f;
+        buffer->tiles[i].layer_depth = 0.0f;
     }
-    if (tessellation_evaluation_shader) {
-        glDetachShader(program, tessellation_evaluation_shader);
+}
+
+// -----------------------------------------------------------------------------
+static void gla_transform_occluder_vertices(void *arg, int chunk)
+{
+    const gla_occluder_job *job = arg;
+    const GLfloat *m = job->model_view_projection;
+    GLuint first = (GLuint) chunk * GLA_OCCLUSION_VERTEX_CHUNK;
+    GLuint last = first + GLA_OCCLUSION_VERTEX_CHUNK;
+    if (last > job->num_vertices) {
+        last = job->num_vertices;
     }
-    if (geometry_shader) {
-        glDetachShader(program, geometry_shader);
+    for (GLuint v = first; v < last; v++) {
+        const GLfloat *p = (const GLfloat *) (job->positions +
+                                            (size_t) v * job->position_stride);
+        for (int i = 0; i < 4; i++) {
+            job->buffer->clip[v][i] = m[i] * p[0] + m[4 + i] * p[1] +
+                                    m[8 + i] * p[2] + m[12 + i];
+        }
     }
-    glDetachShader(program, fragment_shader);
+}
 
-    return program;
+// -----------------------------------------------------------------------------
+static GLfloat gla_clamp_occlusion_coord(GLfloat value, GLsizei size)
+{
+    return fminf(fmaxf(value, -1.0f), (GLfloat) size + 1.0f);
 }
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE GLuint gla_build_program_from_file(const GLchar *vert_filename,
-                                            const GLchar *tess_ctrl_filename,
-                                            const GLchar *tess_eval_filename,
-                                            const GLchar *geom_filename,
-                                            const GLchar *frag_filename)
+static void gla_setup_occluder_triangle(gla_occluder_triangle *tri,
+                                        const gla_occlusion_buffer *buffer,
+                                        const GLfloat *clip[3])
 {
-    GLuint vert = 0;
-    GLuint tess_ctrl = 0;
-    GLuint tess_eval = 0;
-    GLuint geom = 0;
-    GLuint frag = 0;
+    tri->y_min = buffer->height;
+    tri->y_max = -1;
 
-    if (vert_filename) {
-        vert = gla_build_shader_from_file(vert_filename, GL_VERTEX_SHADER);
-    }
-    if (tess_ctrl_filename) {
-        tess_ctrl = gla_build_shader_from_file(tess_ctrl_filename,
-                                            GL_TESS_CONTROL_SHADER);
-    }
-    if (tess_eval_filename) {
-        tess_eval = gla_build_shader_from_file(tess_eval_filename,
-                                            GL_TESS_EVALUATION_SHADER);
+    GLfloat v[3][3];
+    for (int i = 0; i < 3; i++) {
+        GLfloat inv_w = 1.0f / clip[i][3];
+        v[i][0] = (clip[i][0] * inv_w * 0.5f + 0.5f) * buffer->width;
+        v[i][1] = (clip[i][1] * inv_w * 0.5f + 0.5f) * buffer->height;
+        v[i][2] = clip[i][2] * inv_w * 0.5f + 0.5f;
     }
-    if (geom_filename) {
-        geom = gla_build_shader_from_file(geom_filename, GL_GEOMETRY_SHADER);
+    // Both faces are rasterized as counterclockwise triangles
+    GLfloat area = (v[1][0] - v[0][0]) * (v[2][1] - v[0][1]) -
+                (v[2][0] - v[0][0]) * (v[1][1] - v[0][1]);
+    if (!(fabsf(area) > 1e-12f)) {
+        return;
     }
-    if (frag_filename) {
-        frag = gla_build_shader_from_file(frag_filename, GL_FRAGMENT_SHADER);
+    if (area < 0.0f) {
+        for (int i = 0; i < 3; i++) {
+            GLfloat tmp = v[1][i];
+            v[1][i] = v[2][i];
+            v[2][i] = tmp;
+        }
+        area = -area;
     }
 
-    GLboolean success = GL_TRUE;
-
-    if (vert_filename && !gla_check_shader_build(vert)) {
-        fprintf(stderr, "Error: Program building: "
-                        "Shader (\"%s\") build error. "
-                        "See shader info log\n", vert_filename);
-        gla_delete_shader(vert);
-        success = GL_FALSE;
-    }
-    if (tess_ctrl_filename && !gla_check_shader_build(tess_ctrl)) {
-        fprintf(stderr, "Error: Program building: "
-                        "Shader (\"%s\") build error. "
-                        "See shader info log\n", tess_ctrl_filename);
-        gla_delete_shader(tess_ctrl);
-        success = GL_FALSE;
+    GLfloat x_min = fminf(fminf(v[0][0], v[1][0]), v[2][0]);
+    GLfloat x_max = fmaxf(fmaxf(v[0][0], v[1][0]), v[2][0]);
+    GLfloat y_min = fminf(fminf(v[0][1], v[1][1]), v[2][1]);
+    GLfloat y_max = fmaxf(fmaxf(v[0][1], v[1][1]), v[2][1]);
+    tri->x_min = (GLint) ceilf(
+        gla_clamp_occlusion_coord(x_min, buffer->width) - 0.5f);
+    tri->x_max = (GLint) floorf(
+        gla_clamp_occlusion_coord(x_max, buffer->width) - 0.5f);
+    tri->x_min = tri->x_min < 0 ? 0 : tri->x_min;
+    tri->x_max = tri->x_max >= buffer->width ? buffer->width - 1 : tri->x_max;
+    if (tri->x_min > tri->x_max) {
+        return;
     }
-    if (tess_eval_filename && !gla_check_shader_build(tess_eval)) {
-        fprintf(stderr, "Error: Program building: "
-                        "Shader (\"%s\") build error. "
-                        "See shader info log\n", tess_eval_filename);
-        gla_delete_shader(tess_eval);
-        success = GL_FALSE;
+
+    int num_left = 0;
+    int num_right = 0;
+    for (int i = 0; i < 3; i++) {
+        const GLfloat *p = v[i];
+        const GLfloat *q = v[(i + 1) % 3];
+        GLfloat dy = q[1] - p[1];
+        // Horizontal edges lie on the first or last row of the triangle
+        if (dy == 0.0f) {
+            continue;
+        }
+        GLfloat *edge = dy < 0.0f ? tri->left[num_left++]
+                                : tri->right[num_right++];
+        edge[0] = p[0];
+        edge[1] = p[1];
+        edge[2] = (q[0] - p[0]) / dy;
     }
-    if (geom_filename && !gla_check_shader_build(geom)) {
-        fprintf(stderr, "Error: Program building: "
-                        "Shader (\"%s\") build error. "
-                        "See shader info log\n", geom_filename);
-        gla_delete_shader(geom);
-        success = GL_FALSE;
+    for (; num_left < 2; num_left++) {
+        tri->left[num_left][0] = -1.0f;
+        tri->left[num_left][1] = 0.0f;
+        tri->left[num_left][2] = 0.0f;
     }
-    if (frag_filename && !gla_check_shader_build(frag)) {
-        fprintf(stderr, "Error: Shader building: "
-                        "Shader (\"%s\") build error. "
-                        "See shader info log\n", frag_filename);
-        gla_delete_shader(frag);
-        success = GL_FALSE;
+    for (; num_right < 2; num_right++) {
+        tri->right[num_right][0] = (GLfloat) buffer->width + 1.0f;
+        tri->right[num_right][1] = 0.0f;
+        tri->right[num_right][2] = 0.0f;
     }
 
-    if (!success) {
-        return 0;
-    }
+    GLfloat dx1 = v[1][0] - v[0][0];
+    GLfloat dy1 = v[1][1] - v[0][1];
+    GLfloat dz1 = v[1][2] - v[0][2];
+    GLfloat dx2 = v[2][0] - v[0][0];
+    GLfloat dy2 = v[2][1] - v[0][1];
+    GLfloat dz2 = v[2][2] - v[0][2];
+    tri->plane[0] = (dz1 * dy2 - dz2 * dy1) / area;
+    tri->plane[1] = (dx1 * dz2 - dx2 * dz1) / area;
+    tri->plane[2] = v[0][2] - tri->plane[0] * v[0][0] -
+                    tri->plane[1] * v[0][1];
+    tri->max_depth = fmaxf(fmaxf(v[0][2], v[1][2]), v[2][2]);
 
-    return gla_build_program(vert, tess_ctrl, tess_eval, geom, frag);
+    GLint row_min = (GLint) ceilf(
+        gla_clamp_occlusion_coord(y_min, buffer->height) - 0.5f);
+    GLint row_max = (GLint) floorf(
+        gla_clamp_occlusion_coord(y_max, buffer->height) - 0.5f);
+    tri->y_min = row_min < 0 ? 0 : row_min;
+    tri->y_max = row_max >= buffer->height ? buffer->height - 1 : row_max;
 }
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE GLuint gla_build_shader(const GLchar *source, GLenum shader_type)
+static void gla_setup_occluder_triangles(void *arg, int chunk)
 {
-    GLuint shader = glCreateShader(shader_type);
-    glShaderSource(shader, 1, (const GLchar**) &source, NULL);
-    glCompileShader(shader);
-    return shader;
+    const gla_occluder_job *job = arg;
+    const gla_occlusion_buffer *buffer = job->buffer;
+    GLuint first = (GLuint) chunk * GLA_OCCLUSION_TRIANGLE_CHUNK;
+    GLuint last = first + GLA_OCCLUSION_TRIANGLE_CHUNK;
+    if (last > job->num_triangles) {
+        last = job->num_triangles;
+    }
+    for (GLuint t = first; t < last; t++) {
+        gla_occluder_triangle *tris = &buffer->triangles[2 * t];
+        tris[0].y_min = tris[1].y_min = buffer->height;
+        tris[0].y_max = tris[1].y_max = -1;
+
+        const GLuint *index = &job->indices[3 * t];
+        if (index[0] >= job->num_vertices || index[1] >= job->num_vertices ||
+            index[2] >= job->num_vertices) {
+            continue;
+        }
+        // Clip against the near plane z = -w, which leaves a triangle or a
+        // quad
+        GLfloat polygon[4][4];
+        int n = 0;
+        for (int i = 0; i < 3; i++) {
+            const GLfloat *p = buffer->clip[index[i]];
+            const GLfloat *q = buffer->clip[index[(i + 1) % 3]];
+            GLfloat dp = p[2] + p[3];
+            GLfloat dq = q[2] + q[3];
+            if (dp >= 0.0f) {
+                memcpy(polygon[n++], p, 4 * sizeof(GLfloat));
+            }
+            if ((dp >= 0.0f) != (dq >= 0.0f)) {
+                GLfloat s = dp / (dp - dq);
+                for (int j = 0; j < 4; j++) {
+                    polygon[n][j] = p[j] + s * (q[j] - p[j]);
+                }
+                n++;
+            }
+        }
+        if (n < 3) {
+            continue;
+        }
+        GLboolean behind = GL_FALSE;
+        for (int i = 0; i < n; i++) {
+            behind = behind || !(polygon[i][3] > 1e-6f);
+        }
+        if (behind) {
+            continue;
+        }
+        for (int i = 0; i + 2 < n; i++) {
+            const GLfloat *clip[3] = {polygon[0], polygon[i + 1],
+                                    polygon[i + 2]};
+            gla_setup_occluder_triangle(&tris[i], buffer, clip);
+        }
+    }
 }
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE GLuint gla_build_shader_from_file(const GLchar *filename,
-                                            GLenum shader_type)
+static GLfloat gla_get_occluder_tile_depth(const gla_occluder_triangle *tri,
+                                            GLint x, GLint y)
 {
-    GLchar *shader_source = gla_read_text_file(filename);
-    if (!shader_source) {
-        fprintf(stderr, "Error: Shader (\"%s\") building: "
-                        "Unable to load source\n", filename);
-        return 0;
-    }
-    GLuint shader = gla_build_shader(shader_source, shader_type);
-    free(shader_source);
-    shader_source = NULL;
-    return shader;
+    // The depth plane is farthest at one of the tile corners
+    GLfloat depth = tri->plane[2] +
+        tri->plane[0] * (GLfloat) (tri->plane[0] > 0.0f ?
+                                    x + GLA_OCCLUSION_TILE_WIDTH : x) +
+        tri->plane[1] * (GLfloat) (tri->plane[1] > 0.0f ?
+                                    y + GLA_OCCLUSION_TILE_HEIGHT : y);
+    return fminf(depth, tri->max_depth);
 }
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE GLint gla_check_program_build(GLuint program, GLenum pname)
+// Merge the coverage of a triangle into a tile. The working layer is dropped
+// if the triangle is closer to the tile depth than to the layer.
+static void gla_merge_occlusion_tile(gla_occlusion_tile *tile,
+                                    const GLuint *coverage, GLfloat depth)
 {
-    if (pname != GL_LINK_STATUS || pname != GL_VALIDATE_STATUS) {
-        return GL_INVALID_ENUM;
+    if (depth >= tile->depth) {
+        return;
     }
-
-    GLint success = GL_FALSE;
-    glGetProgramiv(program, pname, &success);
-    if (!success) {
-        gla_print_program_info_log(program);
+    GLuint any = 0;
+    for (int r = 0; r < GLA_OCCLUSION_TILE_HEIGHT; r++) {
+        any |= tile->mask[r];
+    }
+    GLuint all = ~0u;
+    if (!any || depth - tile->layer_depth > tile->depth - depth) {
+        tile->layer_depth = depth;
+        for (int r = 0; r < GLA_OCCLUSION_TILE_HEIGHT; r++) {
+            tile->mask[r] = coverage[r];
+            all &= tile->mask[r];
+        }
+    } else {
+        tile->layer_depth = fmaxf(tile->layer_depth, depth);
+        for (int r = 0; r < GLA_OCCLUSION_TILE_HEIGHT; r++) {
+            tile->mask[r] |= coverage[r];
+            all &= tile->mask[r];
+        }
+    }
+    if (all == ~0u) {
+        tile->depth = tile->layer_depth;
+        memset(tile->mask, 0, sizeof(tile->mask));
     }
-    return success;
 }
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE GLint gla_check_shader_build(GLuint shader)
+static GLfloat gla_get_occluder_edge_x(const GLfloat *edge, GLfloat y)
 {
-    GLint success = GL_FALSE;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        gla_print_shader_info_log(shader);
-    }
-    return success;
+    return edge[0] + edge[2] * (y - edge[1]);
 }
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE void gla_delete_program(GLuint program)
+static void gla_rasterize_occluder_band(gla_occlusion_buffer *buffer,
+                                        const gla_occluder_triangle *tri,
+                                        GLint band)
 {
-    glDeleteProgram(program);
-    program = 0;
+    GLint y0 = band * GLA_OCCLUSION_TILE_HEIGHT;
+    GLint start[GLA_OCCLUSION_TILE_HEIGHT];
+    GLint end[GLA_OCCLUSION_TILE_HEIGHT];
+    for (int r = 0; r < GLA_OCCLUSION_TILE_HEIGHT; r++) {
+        GLint y = y0 + r;
+        if (y < tri->y_min || y > tri->y_max) {
+            start[r] = buffer->width;
+            end[r] = -1;
+            continue;
+        }
+        GLfloat center = (GLfloat) y + 0.5f;
+        GLfloat left = fmaxf(gla_get_occluder_edge_x(tri->left[0], center),
+                            gla_get_occluder_edge_x(tri->left[1], center));
+        GLfloat right = fminf(gla_get_occluder_edge_x(tri->right[0], center),
+                            gla_get_occluder_edge_x(tri->right[1], center));
+        left = gla_clamp_occlusion_coord(left, buffer->width);
+        right = gla_clamp_occlusion_coord(right, buffer->width);
+        start[r] = (GLint) ceilf(left - 0.5f);
+        end[r] = (GLint) floorf(right - 0.5f);
+    }
+
+    GLint tx_end = tri->x_max / GLA_OCCLUSION_TILE_WIDTH;
+    for (GLint tx = tri->x_min / GLA_OCCLUSION_TILE_WIDTH; tx <= tx_end;
+        tx++) {
+        GLint x0 = tx * GLA_OCCLUSION_TILE_WIDTH;
+        GLuint coverage[GLA_OCCLUSION_TILE_HEIGHT];
+        GLuint any = 0;
+        for (int r = 0; r < GLA_OCCLUSION_TILE_HEIGHT; r++) {
+            GLint s = start[r] - x0;
+            GLint e = end[r] - x0;
+            GLuint mask = s <= 0 ? ~0u : s >= 32 ? 0u : ~0u << s;
+            mask &= e >= 31 ? ~0u : e < 0 ? 0u : ~0u >> (31 - e);
+            coverage[r] = mask;
+            any |= mask;
+        }
+        if (any) {
+            gla_merge_occlusion_tile(
+                &buffer->tiles[band * buffer->tiles_x + tx], coverage,
+                gla_get_occluder_tile_depth(tri, x0, y0));
+        }
+    }
 }
 
+#ifdef GLA_HAS_X86_INTRINSICS
 // -----------------------------------------------------------------------------
-GLA_LINKAGE void gla_delete_shader(GLuint shader)
+// The 8 rows of a tile are the 8 lanes, so that the coverage of a row comes
+// from shifting its span's bounds into 32-bit masks
+__attribute__((target("avx2,fma")))
+static void gla_rasterize_occluder_band_avx2(gla_occlusion_buffer *buffer,
+                                            const gla_occluder_triangle *tri,
+                                            GLint band)
 {
-    glDeleteShader(shader);
-    shader = 0;
+    GLint y0 = band * GLA_OCCLUSION_TILE_HEIGHT;
+    __m256i rows = _mm256_add_epi32(_mm256_set1_epi32(y0),
+                                    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256 center = _mm256_add_ps(_mm256_cvtepi32_ps(rows),
+                                _mm256_set1_ps(0.5f));
+    __m256 left = _mm256_set1_ps(-1.0f);
+    __m256 right = _mm256_set1_ps((GLfloat) buffer->width + 1.0f);
+    for (int i = 0; i < 2; i++) {
+        left = _mm256_max_ps(left, _mm256_fmadd_ps(
+            _mm256_set1_ps(tri->left[i][2]),
+            _mm256_sub_ps(center, _mm256_set1_ps(tri->left[i][1])),
+            _mm256_set1_ps(tri->left[i][0])));
+        right = _mm256_min_ps(right, _mm256_fmadd_ps(
+            _mm256_set1_ps(tri->right[i][2]),
+            _mm256_sub_ps(center, _mm256_set1_ps(tri->right[i][1])),
+            _mm256_set1_ps(tri->right[i][0])));
+    }
+    left = _mm256_min_ps(left, _mm256_set1_ps((GLfloat) buffer->width + 1.0f));
+    right = _mm256_max_ps(right, _mm256_set1_ps(-1.0f));
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256i start = _mm256_cvtps_epi32(_mm256_round_ps(
+        _mm256_sub_ps(left, half), _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+    __m256i end = _mm256_cvtps_epi32(_mm256_round_ps(
+        _mm256_sub_ps(right, half), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+    __m256i outside = _mm256_or_si256(
+        _mm256_cmpgt_epi32(_mm256_set1_epi32(tri->y_min), rows),
+        _mm256_cmpgt_epi32(rows, _mm256_set1_epi32(tri->y_max)));
+    start = _mm256_blendv_epi8(start, _mm256_set1_epi32(buffer->width),
+                            outside);
+
+    __m256i zero = _mm256_setzero_si256();
+    __m256i ones = _mm256_set1_epi32(-1);
+    __m256i bits = _mm256_set1_epi32(32);
+    GLint tx_end = tri->x_max / GLA_OCCLUSION_TILE_WIDTH;
+    for (GLint tx = tri->x_min / GLA_OCCLUSION_TILE_WIDTH; tx <= tx_end;
+        tx++) {
+        GLint x0 = tx * GLA_OCCLUSION_TILE_WIDTH;
+        // Shifts by 32 or more give 0
+        __m256i s = _mm256_sub_epi32(start, _mm256_set1_epi32(x0));
+        __m256i e = _mm256_sub_epi32(_mm256_set1_epi32(x0 + 31), end);
+        s = _mm256_min_epi32(_mm256_max_epi32(s, zero), bits);
+        e = _mm256_min_epi32(_mm256_max_epi32(e, zero), bits);
+        __m256i coverage = _mm256_and_si256(_mm256_sllv_epi32(ones, s),
+                                            _mm256_srlv_epi32(ones, e));
+        if (_mm256_testz_si256(coverage, coverage)) {
+            continue;
+        }
+
+        gla_occlusion_tile *tile = &buffer->tiles[band * buffer->tiles_x + tx];
+        GLfloat depth = gla_get_occluder_tile_depth(tri, x0, y0);
+        if (depth >= tile->depth) {
+            continue;
+        }
+        __m256i mask = _mm256_loadu_si256((const __m256i *) tile->mask);
+        if (_mm256_testz_si256(mask, mask) ||
+            depth - tile->layer_depth > tile->depth - depth) {
+            tile->layer_depth = depth;
+            mask = coverage;
+        } else {
+            tile->layer_depth = fmaxf(tile->layer_depth, depth);
+            mask = _mm256_or_si256(mask, coverage);
+        }
+        if (_mm256_testc_si256(mask, ones)) {
+            tile->depth = tile->layer_depth;
+            mask = zero;
+        }
+        _mm256_storeu_si256((__m256i *) tile->mask, mask);
+    }
 }
+#endif // GLA_HAS_X86_INTRINSICS
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE void gla_print_program_info_log(GLuint program)
+// Every band of tile rows is rasterized by one job, in triangle order
+static void gla_rasterize_occluder_bands(void *arg, int band)
 {
-    GLint info_log_length = 0;
-    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
-
-    GLchar *info_log = malloc(info_log_length);
-    if (!info_log) {
-        fprintf(stderr, "Error: Program (id = %d) info log printing: "
-                        "Unable to allocate memory for the info log\n",
-                        program);
-        return;
+    const gla_occluder_job *job = arg;
+    gla_occlusion_buffer *buffer = job->buffer;
+    GLint y0 = band * GLA_OCCLUSION_TILE_HEIGHT;
+    GLint y1 = y0 + GLA_OCCLUSION_TILE_HEIGHT - 1;
+    for (GLuint t = 0; t < 2 * job->num_triangles; t++) {
+        const gla_occluder_triangle *tri = &buffer->triangles[t];
+        if (tri->y_min > y1 || tri->y_max < y0) {
+            continue;
+        }
+#ifdef GLA_HAS_X86_INTRINSICS
+        if (job->use_avx2) {
+            gla_rasterize_occluder_band_avx2(buffer, tri, band);
+            continue;
+        }
+#endif // GLA_HAS_X86_INTRINSICS
+        gla_rasterize_occluder_band(buffer, tri, band);
     }
-    glGetProgramInfoLog(program, info_log_length, NULL, info_log);
-    fprintf(stdout, "Program (id = %d) info log: %s\n", program, info_log);
-    free(info_log);
-    info_log = NULL;
 }
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE void gla_print_shader_info_log(GLuint shader)
+GLA_LINKAGE GLboolean gla_rasterize_occluder(gla_occlusion_buffer *buffer,
+                                            gla_job_pool *pool,
+                                            const GLuint *indices,
+                                            GLuint num_indices,
+                                            const GLfloat *positions,
+                                            GLsizei position_stride,
+                                            GLuint num_vertices,
+                                            const GLfloat
+                                                model_view_projection[16])
 {
-    GLint info_log_length = 0;
-    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &info_log_length);
-    if (info_log_length <= 0) {
-        fprintf(stdout, "Shader (id = %d) info log: <empty>\n", shader);
-        return;
+    GLuint num_triangles = num_indices / 3;
+    if (num_vertices > buffer->clip_capacity) {
+        void *clip = realloc(buffer->clip,
+                            num_vertices * sizeof(*buffer->clip));
+        if (!clip) {
+            fprintf(stderr, "Error: Occluder rasterization: "
+                            "Unable to allocate memory for the vertices\n");
+            return GL_FALSE;
+        }
+        buffer->clip = clip;
+        buffer->clip_capacity = num_vertices;
     }
-
-    GLchar *info_log = malloc(info_log_length);
-    if (!info_log) {
-        fprintf(stderr, "Error: Shader (id = %d) info log printing: "
-                        "Unable to allocate memory for the info log\n", shader);
-        return;
+    if (num_triangles > buffer->triangle_capacity) {
+        void *triangles = realloc(buffer->triangles,
+                                2 * (size_t) num_triangles *
+                                    sizeof(gla_occluder_triangle));
+        if (!triangles) {
+            fprintf(stderr, "Error: Occluder rasterization: "
+                            "Unable to allocate memory for the triangles\n");
+            return GL_FALSE;
+        }
+        buffer->triangles = triangles;
+        buffer->triangle_capacity = num_triangles;
     }
-    glGetShaderInfoLog(shader, info_log_length, NULL, info_log);
-    fprintf(stdout, "Shader (id = %d) info log: %s\n", shader, info_log);
-    free(info_log);
-    info_log = NULL;
+
+    gla_occluder_job job = {
+        buffer, indices, num_triangles, (const GLubyte *) positions,
+        position_stride, num_vertices, model_view_projection, 0
+    };
+#ifdef GLA_HAS_X86_INTRINSICS
+    job.use_avx2 = __builtin_cpu_supports("avx2") &&
+                __builtin_cpu_supports("fma");
+#endif // GLA_HAS_X86_INTRINSICS
+    gla_parallel_for(pool,
+                    (int) ((num_vertices + GLA_OCCLUSION_VERTEX_CHUNK - 1) /
+                            GLA_OCCLUSION_VERTEX_CHUNK),
+                    gla_transform_occluder_vertices, &job);
+    gla_parallel_for(pool,
+                    (int) ((num_triangles + GLA_OCCLUSION_TRIANGLE_CHUNK - 1) /
+                            GLA_OCCLUSION_TRIANGLE_CHUNK),
+                    gla_setup_occluder_triangles, &job);
+    gla_parallel_for(pool, buffer->tiles_y, gla_rasterize_occluder_bands, &job);
+    return GL_TRUE;
 }
 
 // -----------------------------------------------------------------------------
-GLA_LINKAGE GLchar *gla_read_text_file(const GLchar *filename)
+// Test the screen rectangle of an object's box against the tiles it overlaps
+static GLboolean gla_is_object_unoccluded(const gla_occlusion_buffer *buffer,
+                                        const gla_cull_object *object,
+                                        const GLfloat *model,
+                                        const GLfloat *view_projection)
 {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Error: File (\"%s\") handling: "
-                        "Unable to open file\n", filename);
-        return NULL;
+    GLfloat m[16];
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            m[4 * c + r] = view_projection[r] * model[4 * c] +
+                        view_projection[4 + r] * model[4 * c + 1] +
+                        view_projection[8 + r] * model[4 * c + 2] +
+                        view_projection[12 + r] * model[4 * c + 3];
+        }
     }
-
-    const size_t buffer_size = 4096;
-    char *buffer = malloc(buffer_size);
-    if (!buffer) {
-        fprintf(stderr, "Error: File (\"%s\") handling: "
-                        "Unable to allocate memory for the reading buffer\n",
-                        filename);
-        return NULL;
+    GLfloat ndc_min[3] = {0.0f, 0.0f, 0.0f};
+    GLfloat ndc_max[3] = {0.0f, 0.0f, 0.0f};
+    for (int c = 0; c < 8; c++) {
+        GLfloat corner[3] = {
+            (c & 1) ? object->aabb_max[0] : object->aabb_min[0],
+            (c & 2) ? object->aabb_max[1] : object->aabb_min[1],
+            (c & 4) ? object->aabb_max[2] : object->aabb_min[2]
+        };
+        GLfloat clip[4];
+        for (int i = 0; i < 4; i++) {
+            clip[i] = m[i] * corner[0] + m[4 + i] * corner[1] +
+                    m[8 + i] * corner[2] + m[12 + i];
+        }
+        if (!(clip[3] > 1e-6f) || clip[2] < -clip[3]) {
+            return GL_TRUE;
+        }
+        for (int i = 0; i < 3; i++) {
+            GLfloat ndc = clip[i] / clip[3];
+            ndc_min[i] = c == 0 ? ndc : fminf(ndc_min[i], ndc);
+            ndc_max[i] = c == 0 ? ndc : fmaxf(ndc_max[i], ndc);
+        }
     }
-
-    size_t out_size = 2 * buffer_size;
-    char *out = malloc(out_size + 1); // + '\0'
-    if (!out) {
-        free(buffer);
-        buffer = NULL;
-        fprintf(stderr, "Error: File (\"%s\") handling: "
-                        "Unable to allocate memory for the source buffer\n",
-                        filename);
-        return NULL;
+    if (ndc_max[0] < -1.0f || ndc_min[0] > 1.0f || ndc_max[1] < -1.0f ||
+        ndc_min[1] > 1.0f || ndc_min[2] > 1.0f) {
+        return GL_FALSE;
     }
 
-    size_t num_read_total = 0;
-    size_t num_read_step = 0;
-    while ((num_read_step = fread(buffer, 1, buffer_size, file)) > 0) {
-        // Make sure that there is enough space for storing the read data
-        if (num_read_total >= out_size) {
-            out_size *= 2;
-            out = realloc(out, out_size + 1); // + '\0'
-            if (!out) {
-                free(buffer);
-                buffer = NULL;
-                fprintf(stderr, "Error: File (\"%s\") handling: "
-                                "Unable to re-allocate memory for the source "
-                                "buffer\n", filename);
-                return NULL;
+    GLint x_min = (GLint) floorf((fmaxf(ndc_min[0], -1.0f) * 0.5f + 0.5f) *
+                                buffer->width);
+    GLint x_max = (GLint) floorf((fminf(ndc_max[0], 1.0f) * 0.5f + 0.5f) *
+                                buffer->width);
+    GLint y_min = (GLint) floorf((fmaxf(ndc_min[1], -1.0f) * 0.5f + 0.5f) *
+                                buffer->height);
+    GLint y_max = (GLint) floorf((fminf(ndc_max[1], 1.0f) * 0.5f + 0.5f) *
+                                buffer->height);
+    x_max = x_max >= buffer->width ? buffer->width - 1 : x_max;
+    y_max = y_max >= buffer->height ? buffer->height - 1 : y_max;
+    GLfloat depth = ndc_min[2] * 0.5f + 0.5f;
+
+    for (GLint ty = y_min / GLA_OCCLUSION_TILE_HEIGHT;
+        ty <= y_max / GLA_OCCLUSION_TILE_HEIGHT; ty++) {
+        for (GLint tx = x_min / GLA_OCCLUSION_TILE_WIDTH;
+            tx <= x_max / GLA_OCCLUSION_TILE_WIDTH; tx++) {
+            GLint x0 = tx * GLA_OCCLUSION_TILE_WIDTH;
+            GLint s = x_min > x0 ? x_min - x0 : 0;
+            GLint e = x_max - x0 < 31 ? x_max - x0 : 31;
+            GLuint columns = (~0u << s) & (~0u >> (31 - e));
+            const gla_occlusion_tile *tile =
+                &buffer->tiles[ty * buffer->tiles_x + tx];
+            GLuint in_layer = 0;
+            GLuint outside_layer = 0;
+            for (int r = 0; r < GLA_OCCLUSION_TILE_HEIGHT; r++) {
+                GLint y = ty * GLA_OCCLUSION_TILE_HEIGHT + r;
+                if (y >= y_min && y <= y_max) {
+                    in_layer |= columns & tile->mask[r];
+                    outside_layer |= columns & ~tile->mask[r];
+                }
+            }
+            if ((outside_layer && depth <= tile->depth) ||
+                (in_layer && depth <= tile->layer_depth)) {
+                return GL_TRUE;
             }
         }
-
-        out += num_read_total;
-        memcpy(out, buffer, num_read_step);
-        out -= num_read_total;
-
-        num_read_total += num_read_step;
     }
+    return GL_FALSE;
+}
 
-    out[num_read_total] = '\0';
-    free(buffer);
-    buffer = NULL;
-
-    if (fclose(file) == EOF) {
-        free(out);
-        out = NULL;
-        fprintf(stderr, "Error: File (\"%s\") handling: "
-                        "Unable to close file\n", filename);
-        return NULL;
+// -----------------------------------------------------------------------------
+// Every job tests whole words of the bitset
+static void gla_test_occlusion_chunk(void *arg, int chunk)
+{
+    const gla_occlusion_test_job *job = arg;
+    GLuint first = (GLuint) chunk * GLA_OCCLUSION_OBJECT_CHUNK;
+    GLuint last = first + GLA_OCCLUSION_OBJECT_CHUNK;
+    if (last > job->num_objects) {
+        last = job->num_objects;
+    }
+    memset(&job->visibility[first / 32], 0,
+        (last - first + 31) / 32 * sizeof(GLuint));
+    for (GLuint i = first; i < last; i++) {
+        const gla_cull_object *object = &job->objects[i];
+        if (gla_is_object_unoccluded(job->buffer, object,
+                                    &job->transforms[16 * object->transform],
+                                    job->view_projection)) {
+            job->visibility[i / 32] |= 1u << (i % 32);
+        }
     }
+}
 
-    return out;
+// -----------------------------------------------------------------------------
+GLA_LINKAGE void gla_test_occlusion(const gla_occlusion_buffer *buffer,
+                                    gla_job_pool *pool,
+                                    const gla_cull_object *objects,
+                                    const GLfloat *transforms,
+                                    GLuint num_objects,
+                                    const GLfloat view_projection[16],
+                                    GLuint *visibility)
+{
+    gla_occlusion_test_job job = {
+        buffer, objects, transforms, num_objects, view_projection, visibility
+    };
+    gla_parallel_for(pool,
+                    (int) ((num_objects + GLA_OCCLUSION_OBJECT_CHUNK - 1) /
+                            GLA_OCCLUSION_OBJECT_CHUNK),
+                    gla_test_occlusion_chunk, &job);
 }
 
 #endif // GLA_IMPLEMENTATION
@@ -0,0 +1,193 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-present Lars Schütz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ******************************************************************************/
+/*
+ * Measure the time of cgm's frustum culling kernels.
+ *
+ * Usage: cgm_cull [-n count] [-r repetitions] [-t threads]
+ *
+ * count random bounding spheres and AABBs are scattered in a cube around a
+ * camera whose 60 degree frustum sees a part of them. The time of
+ * frustum_cull_spheres and frustum_cull_aabbs is reported as the best of the
+ * repetitions. Build with AVX2 and FMA, as the Makefile does, to measure the
+ * vector kernels, and without them to measure the scalar loops.
+ *
+ * The _mt variants run on a gla job pool with the given number of worker
+ * threads besides the calling thread, by default one less than the number of
+ * online processors. Their results are checked against the serial kernels.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glad/glad.h>
+
+#define GLA_IMPLEMENTATION
+#include "../gla/gla.h"
+
+#define CGM_IMPLEMENTATION
+#include <cgm/cgm.h>
+
+#define SCENE_EXTENT 100.0f
+#define MAX_OBJECT_EXTENT 1.0f
+
+// -----------------------------------------------------------------------------
+static double now_ms(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+// -----------------------------------------------------------------------------
+static float random_float(float min, float max)
+{
+    return min + (max - min) * ((float) rand() / RAND_MAX);
+}
+
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int count = 1 << 20;
+    int repetitions = 20;
+    int num_threads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            repetitions = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else {
+            fprintf(stderr,
+                    "Usage: %s [-n count] [-r repetitions] [-t threads]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (count < 1 || repetitions < 1) {
+        fprintf(stderr, "Error: Count and repetitions must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    float *values = malloc(7 * (size_t) count * sizeof(float));
+    int *visible = malloc(count * sizeof(int));
+    int *visible_mt = malloc(count * sizeof(int));
+    gla_job_pool *pool = gla_create_job_pool(num_threads);
+    if (!(values && visible && visible_mt && pool)) {
+        fprintf(stderr, "Error: Unable to allocate memory for the objects\n");
+        return EXIT_FAILURE;
+    }
+    float *x = values;
+    float *y = x + count;
+    float *z = y + count;
+    float *radius = z + count;
+    float *extent_x = radius + count;
+    float *extent_y = extent_x + count;
+    float *extent_z = extent_y + count;
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        x[i] = random_float(-SCENE_EXTENT, SCENE_EXTENT);
+        y[i] = random_float(-SCENE_EXTENT, SCENE_EXTENT);
+        z[i] = random_float(-SCENE_EXTENT, SCENE_EXTENT);
+        extent_x[i] = random_float(0.0f, MAX_OBJECT_EXTENT);
+        extent_y[i] = random_float(0.0f, MAX_OBJECT_EXTENT);
+        extent_z[i] = random_float(0.0f, MAX_OBJECT_EXTENT);
+        radius[i] = sqrtf(extent_x[i] * extent_x[i] +
+                        extent_y[i] * extent_y[i] +
+                        extent_z[i] * extent_z[i]);
+    }
+    sphere_soa spheres = {x, y, z, radius};
+    aabb_soa aabbs = {x, y, z, extent_x, extent_y, extent_z};
+
+    mat4 view = mat4_look_at(vec3_3f(0.0f, 0.0f, 0.0f),
+                            vec3_3f(0.0f, 0.0f, -1.0f),
+                            vec3_3f(0.0f, 1.0f, 0.0f));
+    mat4 proj = mat4_perspective(60.0f, 16.0f / 9.0f, 0.1f, SCENE_EXTENT);
+    vec4 planes[6];
+    mat4_frustum_planes(mat4_mul_mat4(proj, view), planes);
+
+    double best_spheres = INFINITY;
+    double best_aabbs = INFINITY;
+    double best_spheres_mt = INFINITY;
+    double best_aabbs_mt = INFINITY;
+    int num_spheres = 0;
+    int num_aabbs = 0;
+    int same = 1;
+    for (int r = 0; r < repetitions; r++) {
+        double t0 = now_ms();
+        num_spheres = frustum_cull_spheres(planes, spheres, count, visible);
+        double t1 = now_ms();
+        int num_spheres_mt =
+            frustum_cull_spheres_mt(planes, spheres, count, visible_mt,
+                                    gla_parallel_for, pool);
+        double t2 = now_ms();
+        same = same && num_spheres_mt == num_spheres &&
+            !memcmp(visible, visible_mt, num_spheres * sizeof(int));
+
+        double t3 = now_ms();
+        num_aabbs = frustum_cull_aabbs(planes, aabbs, count, visible);
+        double t4 = now_ms();
+        int num_aabbs_mt = frustum_cull_aabbs_mt(planes, aabbs, count,
+                                                visible_mt, gla_parallel_for,
+                                                pool);
+        double t5 = now_ms();
+        same = same && num_aabbs_mt == num_aabbs &&
+            !memcmp(visible, visible_mt, num_aabbs * sizeof(int));
+
+        best_spheres = fmin(best_spheres, t1 - t0);
+        best_spheres_mt = fmin(best_spheres_mt, t2 - t1);
+        best_aabbs = fmin(best_aabbs, t4 - t3);
+        best_aabbs_mt = fmin(best_aabbs_mt, t5 - t4);
+    }
+
+#if defined(__AVX2__) && defined(__FMA__)
+    const char *kernel = "AVX2";
+#else
+    const char *kernel = "scalar";
+#endif // __AVX2__ && __FMA__
+    printf("%d objects, %s kernels, best of %d:\n", count, kernel,
+        repetitions);
+    printf("  frustum_cull_spheres    %8.3f ms  %6.2f ns/object  %d visible\n",
+        best_spheres, best_spheres * 1e6 / count, num_spheres);
+    printf("  frustum_cull_aabbs      %8.3f ms  %6.2f ns/object  %d visible\n",
+        best_aabbs, best_aabbs * 1e6 / count, num_aabbs);
+    if (num_threads > 0) {
+        printf("_mt variants with %d worker threads:\n", num_threads);
+    } else {
+        printf("_mt variants with the default worker threads:\n");
+    }
+    printf("  frustum_cull_spheres_mt %8.3f ms  %6.2f ns/object\n",
+        best_spheres_mt, best_spheres_mt * 1e6 / count);
+    printf("  frustum_cull_aabbs_mt   %8.3f ms  %6.2f ns/object\n",
+        best_aabbs_mt, best_aabbs_mt * 1e6 / count);
+    printf("  _mt results %s the serial results\n",
+        same ? "match" : "DIFFER FROM");
+    gla_delete_job_pool(pool);
+    free(values);
+    free(visible);
+    free(visible_mt);
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
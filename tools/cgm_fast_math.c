@@ -0,0 +1,288 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-present Lars Schütz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ******************************************************************************/
+/*
+ * Measure the accuracy and the speed of cgm's fast math functions against
+ * libm.
+ *
+ * Usage: cgm_fast_math [-n count] [-r repetitions]
+ *
+ * The accuracy is measured against the double precision libm results over
+ * the ranges documented in cgm.h, for the scalar and the batch versions. The
+ * errors are reported as absolute or relative error and in units in the last
+ * place (ulp) of the float nearest to the exact result. Close to the zeros of
+ * sine and cosine, an absolute error of one float epsilon is many ulp.
+ *
+ * The speed is measured on count random values, as the best time of the
+ * repetitions, for libm, the scalar and the batch versions. Build with AVX2
+ * and FMA, as the Makefile does, to measure the vector batch versions.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CGM_IMPLEMENTATION
+#include <cgm/cgm.h>
+
+#define ACCURACY_SAMPLES (1 << 24)
+#define TRIG_RANGE 8192.0f
+#define TAN_RANGE 8.0f
+#define TAN_MIN_COS 0.01
+
+typedef struct error_stats {
+    double max_error; // Absolute or relative
+    double max_ulp;
+    float worst_x;
+} error_stats;
+
+// Consumed results, so that the benchmark loops are not optimized away
+static volatile float sink;
+
+// -----------------------------------------------------------------------------
+static double now_ms(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+// -----------------------------------------------------------------------------
+// Error in units of the last place of the float nearest to the exact value
+static double ulp_error(float value, double exact)
+{
+    float nearest = (float) exact;
+    double ulp = (double) nextafterf(fabsf(nearest), INFINITY) -
+                fabsf(nearest);
+    return fabs((double) value - exact) / ulp;
+}
+
+// -----------------------------------------------------------------------------
+static void add_error(error_stats *stats, float x, float value, double exact,
+                    int relative)
+{
+    double error = fabs((double) value - exact);
+    if (relative) {
+        error /= fabs(exact);
+    }
+    if (error > stats->max_error) {
+        stats->max_error = error;
+        stats->worst_x = x;
+    }
+    double ulp = ulp_error(value, exact);
+    if (ulp > stats->max_ulp) {
+        stats->max_ulp = ulp;
+    }
+}
+
+// -----------------------------------------------------------------------------
+static void print_error(const char *name, const char *kind,
+                        const error_stats *stats)
+{
+    printf("  %-18s max %s error %.3g (at x = %.9g), max %.2f ulp\n", name,
+        kind, stats->max_error, stats->worst_x, stats->max_ulp);
+}
+
+// -----------------------------------------------------------------------------
+static void measure_trig_accuracy(void)
+{
+    float *in = malloc(ACCURACY_SAMPLES * sizeof(float));
+    float *s = malloc(ACCURACY_SAMPLES * sizeof(float));
+    float *c = malloc(ACCURACY_SAMPLES * sizeof(float));
+    if (!(in && s && c)) {
+        fprintf(stderr, "Error: Unable to allocate memory for the samples\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < ACCURACY_SAMPLES; i++) {
+        in[i] = -TRIG_RANGE + 2.0f * TRIG_RANGE * i / ACCURACY_SAMPLES;
+    }
+    fast_sincosf_n(in, s, c, ACCURACY_SAMPLES);
+
+    error_stats sin_stats = {0};
+    error_stats cos_stats = {0};
+    error_stats sin_n_stats = {0};
+    error_stats cos_n_stats = {0};
+    error_stats tan_stats = {0};
+    for (int i = 0; i < ACCURACY_SAMPLES; i++) {
+        float x = in[i];
+        double exact_sin = sin((double) x);
+        double exact_cos = cos((double) x);
+        add_error(&sin_stats, x, fast_sinf(x), exact_sin, 0);
+        add_error(&cos_stats, x, fast_cosf(x), exact_cos, 0);
+        add_error(&sin_n_stats, x, s[i], exact_sin, 0);
+        add_error(&cos_n_stats, x, c[i], exact_cos, 0);
+    }
+    for (int i = 0; i < ACCURACY_SAMPLES; i++) {
+        float x = -TAN_RANGE + 2.0f * TAN_RANGE * i / ACCURACY_SAMPLES;
+        if (fabs(cos((double) x)) > TAN_MIN_COS) {
+            add_error(&tan_stats, x, fast_tanf(x), tan((double) x), 1);
+        }
+    }
+
+    printf("Accuracy, |x| <= %g:\n", TRIG_RANGE);
+    print_error("fast_sinf", "absolute", &sin_stats);
+    print_error("fast_cosf", "absolute", &cos_stats);
+    print_error("fast_sincosf_n sin", "absolute", &sin_n_stats);
+    print_error("fast_sincosf_n cos", "absolute", &cos_n_stats);
+    printf("Accuracy, |x| <= %g where |cos(x)| > %g:\n", TAN_RANGE,
+        TAN_MIN_COS);
+    print_error("fast_tanf", "relative", &tan_stats);
+    free(in);
+    free(s);
+    free(c);
+}
+
+// -----------------------------------------------------------------------------
+static void measure_rsqrt_accuracy(void)
+{
+    // Every 64th float from 2^-100 to 2^100
+    int count = (int) ((0x71800000u - 0x0d800000u) / 64u);
+    float *in = malloc(count * sizeof(float));
+    float *out = malloc(count * sizeof(float));
+    if (!(in && out)) {
+        fprintf(stderr, "Error: Unable to allocate memory for the samples\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        unsigned int bits = 0x0d800000u + 64u * (unsigned int) i;
+        memcpy(&in[i], &bits, sizeof(float));
+    }
+    fast_rsqrtf_n(in, out, count);
+
+    error_stats rsqrt_stats = {0};
+    error_stats rsqrt_n_stats = {0};
+    error_stats sqrt_stats = {0};
+    for (int i = 0; i < count; i++) {
+        float x = in[i];
+        double exact = sqrt((double) x);
+        add_error(&rsqrt_stats, x, fast_rsqrtf(x), 1.0 / exact, 1);
+        add_error(&rsqrt_n_stats, x, out[i], 1.0 / exact, 1);
+        add_error(&sqrt_stats, x, fast_sqrtf(x), exact, 1);
+    }
+
+    printf("Accuracy, 2^-100 <= x <= 2^100:\n");
+    print_error("fast_rsqrtf", "relative", &rsqrt_stats);
+    print_error("fast_rsqrtf_n", "relative", &rsqrt_n_stats);
+    print_error("fast_sqrtf", "relative", &sqrt_stats);
+    free(in);
+    free(out);
+}
+
+// -----------------------------------------------------------------------------
+static void print_time(const char *name, double ms, double libm_ms, int count)
+{
+    printf("  %-22s %8.3f ms  %6.2f ns/value  %5.2fx\n", name, ms,
+        ms * 1e6 / count, libm_ms / ms);
+}
+
+// -----------------------------------------------------------------------------
+static void measure_speed(int count, int repetitions)
+{
+    float *in = malloc(count * sizeof(float));
+    float *positive = malloc(count * sizeof(float));
+    float *s = malloc(count * sizeof(float));
+    float *c = malloc(count * sizeof(float));
+    if (!(in && positive && s && c)) {
+        fprintf(stderr, "Error: Unable to allocate memory for the values\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        in[i] = (float) rand() / RAND_MAX * 200.0f - 100.0f;
+        positive[i] = fabsf(in[i]) + 1e-3f;
+    }
+
+    double best[6];
+    for (int k = 0; k < 6; k++) {
+        best[k] = INFINITY;
+    }
+    for (int r = 0; r < repetitions; r++) {
+        double t[7];
+        t[0] = now_ms();
+        for (int i = 0; i < count; i++) {
+            s[i] = sinf(in[i]);
+            c[i] = cosf(in[i]);
+        }
+        t[1] = now_ms();
+        for (int i = 0; i < count; i++) {
+            fast_sincosf(in[i], &s[i], &c[i]);
+        }
+        t[2] = now_ms();
+        fast_sincosf_n(in, s, c, count);
+        t[3] = now_ms();
+        for (int i = 0; i < count; i++) {
+            s[i] = 1.0f / sqrtf(positive[i]);
+        }
+        t[4] = now_ms();
+        for (int i = 0; i < count; i++) {
+            s[i] = fast_rsqrtf(positive[i]);
+        }
+        t[5] = now_ms();
+        fast_rsqrtf_n(positive, s, count);
+        t[6] = now_ms();
+        sink = s[count / 2] + c[count / 2];
+        for (int k = 0; k < 6; k++) {
+            best[k] = fmin(best[k], t[k + 1] - t[k]);
+        }
+    }
+
+    printf("Speed, %d values, best of %d:\n", count, repetitions);
+    print_time("sinf + cosf", best[0], best[0], count);
+    print_time("fast_sincosf", best[1], best[0], count);
+    print_time("fast_sincosf_n", best[2], best[0], count);
+    print_time("1 / sqrtf", best[3], best[3], count);
+    print_time("fast_rsqrtf", best[4], best[3], count);
+    print_time("fast_rsqrtf_n", best[5], best[3], count);
+    free(in);
+    free(positive);
+    free(s);
+    free(c);
+}
+
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int count = 1 << 20;
+    int repetitions = 10;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            repetitions = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [-n count] [-r repetitions]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (count < 1 || repetitions < 1) {
+        fprintf(stderr, "Error: Count and repetitions must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    measure_trig_accuracy();
+    measure_rsqrt_accuracy();
+    measure_speed(count, repetitions);
+    return EXIT_SUCCESS;
+}
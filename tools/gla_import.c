@@ -0,0 +1,1992 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-present Lars Schütz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ******************************************************************************/
+/*
+ * Convert Wavefront OBJ and PLY (ASCII and binary) files into the GLA binary
+ * mesh format.
+ *
+ * Usage: gla_import [-j threads] [-O] [-d threshold] [-s] [-q] [-l levels]
+ *                   input.obj|input.ply output.glam
+ *
+ * The input is memory mapped and split into chunks at line boundaries that
+ * are parsed in parallel. OBJ corners are deduplicated into unique vertices
+ * with a concurrent hash map. Vertex ids are handed out in order of first
+ * use, so the output does not depend on the number of threads. Positions,
+ * normals and texture coordinates become separate streams at attribute
+ * locations 0, 1 and 2, and one submesh is written per material.
+ *
+ * With -O, the triangles of every submesh are reordered for the vertex cache
+ * and the vertices for sequential fetching. With -d, the triangles are also
+ * clustered to reduce overdraw, accepting the given factor of vertex cache
+ * misses, e.g. 1.05. With -s, submeshes are written as triangle strips with
+ * primitive restarts. Indices are 8, 16 or 32 bits wide, whatever suffices.
+ * With -q, positions are quantized to 16 bits relative to the mesh bounds,
+ * normals to octahedral 10-bit values and texture coordinates to half floats.
+ * With -l, every submesh is followed by the given number of coarser levels of
+ * detail, each simplified to about half the triangles of the previous one.
+ */
+#include <fcntl.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <glad/glad.h>
+
+#define GLA_IMPLEMENTATION
+#include "../gla/gla.h"
+
+#define MAX_MATERIALS 4096
+#define MAX_MATERIAL_NAME_LENGTH 64
+#define CHUNKS_PER_THREAD 4
+#define MIN_CHUNK_SIZE (64 * 1024)
+#define NO_INDEX UINT32_MAX
+#define VERTEX_CACHE_SIZE 16
+#define LOD_MIN_REDUCTION 0.75f
+
+// OBJ indices are stored unresolved while chunks are parsed. Negative indices
+// refer to the vertices parsed so far, whose global count is only known after
+// all chunks are done, so they are kept relative to the chunk start.
+#define ABSENT_INDEX INT64_MIN
+#define RELATIVE_INDEX_BIAS ((int64_t) 1 << 40)
+
+typedef struct array {
+    void *data;
+    size_t count;
+    size_t capacity;
+    size_t element_size;
+} array;
+
+typedef struct raw_corner {
+    int64_t position;
+    int64_t texcoord;
+    int64_t normal;
+} raw_corner;
+
+typedef struct corner {
+    uint32_t position;
+    uint32_t texcoord;
+    uint32_t normal;
+} corner;
+
+typedef struct material_change {
+    size_t triangle; // Chunk-local index of the first triangle
+    char name[MAX_MATERIAL_NAME_LENGTH];
+} material_change;
+
+typedef struct obj_chunk {
+    const char *begin;
+    const char *end;
+    array positions; // 3 floats each
+    array texcoords; // 2 floats each
+    array normals; // 3 floats each
+    array corners; // 3 raw corners per triangle
+    array material_changes;
+    size_t error_line;
+    bool failed;
+} obj_chunk;
+
+typedef struct imported_mesh {
+    float *positions;
+    float *normals; // NULL if the input has none
+    float *texcoords; // NULL if the input has none
+    uint32_t num_vertices;
+    uint32_t *indices;
+    uint32_t *materials; // Material of every triangle
+    size_t num_triangles;
+    uint32_t num_materials;
+} imported_mesh;
+
+static gla_job_pool *pool = NULL;
+static int num_threads = 1;
+static bool optimize = false;
+static float overdraw_threshold = 0.0f;
+static bool strips = false;
+static bool quantize = false;
+static int lod_levels = 0;
+
+// -----------------------------------------------------------------------------
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// -----------------------------------------------------------------------------
+static void array_init(array *a, size_t element_size)
+{
+    a->data = NULL;
+    a->count = 0;
+    a->capacity = 0;
+    a->element_size = element_size;
+}
+
+// -----------------------------------------------------------------------------
+static void array_free(array *a)
+{
+    free(a->data);
+    a->data = NULL;
+    a->count = 0;
+    a->capacity = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Append n uninitialized elements and return the first, or NULL
+static void *array_push(array *a, size_t n)
+{
+    if (a->count + n > a->capacity) {
+        size_t capacity = a->capacity ? a->capacity * 2 : 1024;
+        while (capacity < a->count + n) {
+            capacity *= 2;
+        }
+        void *data = realloc(a->data, capacity * a->element_size);
+        if (!data) {
+            return NULL;
+        }
+        a->data = data;
+        a->capacity = capacity;
+    }
+    void *element = (char *) a->data + a->count * a->element_size;
+    a->count += n;
+    return element;
+}
+
+// -----------------------------------------------------------------------------
+static const char *skip_spaces(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+// -----------------------------------------------------------------------------
+// Parse a decimal floating-point number. Up to 19 significant digits are
+// accumulated in an integer and scaled by an exact power of ten, which is
+// exact enough for single precision. Returns the position after the number,
+// or NULL if there is none.
+static const char *parse_float(const char *p, const char *end, float *value)
+{
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    p = skip_spaces(p, end);
+    const char *start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int num_digits = 0;
+    int exponent = 0;
+    bool any_digits = false;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (num_digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+            num_digits += mantissa > 0;
+        } else {
+            exponent++;
+        }
+        any_digits = true;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (num_digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+                num_digits += mantissa > 0;
+                exponent--;
+            }
+            any_digits = true;
+            p++;
+        }
+    }
+    if (!any_digits) {
+        // Rare spellings such as "nan" and "inf"
+        char buffer[32];
+        size_t n = 0;
+        while (start + n < end && n < sizeof(buffer) - 1 && start[n] > ' ') {
+            buffer[n] = start[n];
+            n++;
+        }
+        buffer[n] = '\0';
+        char *parsed_end;
+        *value = strtof(buffer, &parsed_end);
+        return parsed_end == buffer ? NULL : start + (parsed_end - buffer);
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool negative_exponent = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            negative_exponent = *q == '-';
+            q++;
+        }
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            while (q < end && *q >= '0' && *q <= '9') {
+                if (e < 10000) {
+                    e = e * 10 + (*q - '0');
+                }
+                q++;
+            }
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+
+    double d = (double) mantissa;
+    if (exponent < 0 && exponent >= -22) {
+        d /= powers_of_ten[-exponent];
+    } else if (exponent > 0 && exponent <= 22) {
+        d *= powers_of_ten[exponent];
+    } else if (exponent != 0) {
+        d *= pow(10.0, exponent);
+    }
+    *value = (float) (negative ? -d : d);
+    return p;
+}
+
+// -----------------------------------------------------------------------------
+static const char *parse_int(const char *p, const char *end, int64_t *value)
+{
+    p = skip_spaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    int64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        p++;
+    }
+    *value = negative ? -v : v;
+    return p;
+}
+
+// -----------------------------------------------------------------------------
+static bool parse_floats(const char *p, const char *end, float *values, int n)
+{
+    for (int i = 0; i < n; i++) {
+        p = parse_float(p, end, &values[i]);
+        if (!p) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Encode an OBJ index given the number of elements parsed before it in the
+// chunk
+static int64_t encode_obj_index(int64_t index, size_t local_count)
+{
+    if (index > 0) {
+        return index - 1;
+    }
+    return RELATIVE_INDEX_BIAS + (int64_t) local_count + index;
+}
+
+// -----------------------------------------------------------------------------
+// Parse one "f" line and append its fan triangulation
+static bool parse_obj_face(obj_chunk *chunk, const char *p, const char *end)
+{
+    raw_corner polygon_corners[64];
+    int num_corners = 0;
+    for (;;) {
+        p = skip_spaces(p, end);
+        if (p == end) {
+            break;
+        }
+        raw_corner c = {ABSENT_INDEX, ABSENT_INDEX, ABSENT_INDEX};
+        int64_t index;
+        p = parse_int(p, end, &index);
+        if (!p || index == 0) {
+            return false;
+        }
+        c.position = encode_obj_index(index, chunk->positions.count);
+        if (p < end && *p == '/') {
+            p++;
+            if (p < end && *p != '/') {
+                p = parse_int(p, end, &index);
+                if (!p || index == 0) {
+                    return false;
+                }
+                c.texcoord = encode_obj_index(index, chunk->texcoords.count);
+            }
+            if (p < end && *p == '/') {
+                p = parse_int(p + 1, end, &index);
+                if (!p || index == 0) {
+                    return false;
+                }
+                c.normal = encode_obj_index(index, chunk->normals.count);
+            }
+        }
+        if (num_corners == 64) {
+            return false;
+        }
+        polygon_corners[num_corners++] = c;
+    }
+    if (num_corners < 3) {
+        return false;
+    }
+
+    raw_corner *triangles = array_push(&chunk->corners, 3 * (num_corners - 2));
+    if (!triangles) {
+        return false;
+    }
+    for (int i = 1; i + 1 < num_corners; i++) {
+        *triangles++ = polygon_corners[0];
+        *triangles++ = polygon_corners[i];
+        *triangles++ = polygon_corners[i + 1];
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool parse_obj_line(obj_chunk *chunk, const char *p, const char *end)
+{
+    p = skip_spaces(p, end);
+    if (p == end || *p == '#') {
+        return true;
+    }
+
+    if (p[0] == 'v' && end - p > 1 && (p[1] == ' ' || p[1] == '\t')) {
+        float *v = array_push(&chunk->positions, 1);
+        return v && parse_floats(p + 2, end, v, 3);
+    }
+    if (p[0] == 'v' && end - p > 2 && p[1] == 't' &&
+        (p[2] == ' ' || p[2] == '\t')) {
+        float *v = array_push(&chunk->texcoords, 1);
+        const char *q = v ? parse_float(p + 3, end, &v[0]) : NULL;
+        if (!q) {
+            return false;
+        }
+        // The second coordinate is optional for 1D textures
+        if (!parse_float(q, end, &v[1])) {
+            v[1] = 0.0f;
+        }
+        return true;
+    }
+    if (p[0] == 'v' && end - p > 2 && p[1] == 'n' &&
+        (p[2] == ' ' || p[2] == '\t')) {
+        float *v = array_push(&chunk->normals, 1);
+        return v && parse_floats(p + 3, end, v, 3);
+    }
+    if (p[0] == 'f' && end - p > 1 && (p[1] == ' ' || p[1] == '\t')) {
+        return parse_obj_face(chunk, p + 2, end);
+    }
+    if (end - p > 7 && strncmp(p, "usemtl", 6) == 0 &&
+        (p[6] == ' ' || p[6] == '\t')) {
+        material_change *change = array_push(&chunk->material_changes, 1);
+        if (!change) {
+            return false;
+        }
+        const char *name = skip_spaces(p + 7, end);
+        size_t length = (size_t) (end - name);
+        while (length > 0 && (name[length - 1] == ' ' ||
+                            name[length - 1] == '\t' ||
+                            name[length - 1] == '\r')) {
+            length--;
+        }
+        if (length >= MAX_MATERIAL_NAME_LENGTH) {
+            length = MAX_MATERIAL_NAME_LENGTH - 1;
+        }
+        memcpy(change->name, name, length);
+        change->name[length] = '\0';
+        change->triangle = chunk->corners.count / 3;
+        return true;
+    }
+    // Groups, objects, smoothing groups and material libraries are ignored
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+static void parse_obj_chunk(void *arg, int index)
+{
+    obj_chunk *chunk = &((obj_chunk *) arg)[index];
+    const char *p = chunk->begin;
+    size_t line = 0;
+    while (p < chunk->end) {
+        const char *eol = memchr(p, '\n', (size_t) (chunk->end - p));
+        if (!eol) {
+            eol = chunk->end;
+        }
+        if (!parse_obj_line(chunk, p, eol)) {
+            chunk->failed = true;
+            chunk->error_line = line;
+            return;
+        }
+        line++;
+        p = eol + 1;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Split [begin, end) into at most max_chunks ranges that end at line breaks
+static size_t split_lines(const char *begin, const char *end,
+                        size_t max_chunks, const char **bounds)
+{
+    size_t size = (size_t) (end - begin);
+    size_t num_chunks = size / MIN_CHUNK_SIZE + 1;
+    if (num_chunks > max_chunks) {
+        num_chunks = max_chunks;
+    }
+
+    bounds[0] = begin;
+    size_t n = 0;
+    for (size_t i = 1; i < num_chunks; i++) {
+        const char *p = begin + size * i / num_chunks;
+        if (p <= bounds[n]) {
+            continue;
+        }
+        const char *eol = memchr(p, '\n', (size_t) (end - p));
+        if (!eol || eol + 1 >= end) {
+            break;
+        }
+        bounds[++n] = eol + 1;
+    }
+    bounds[++n] = end;
+    return n;
+}
+
+// -----------------------------------------------------------------------------
+static uint32_t hash_corner(const corner *c)
+{
+    uint64_t h = (uint64_t) c->position * 0x9e3779b97f4a7c15ull;
+    h ^= ((uint64_t) c->texcoord + 0x632be59bd9b4e019ull) *
+        0xbf58476d1ce4e5b9ull;
+    h ^= ((uint64_t) c->normal + 0x2545f4914f6cdd1dull) * 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return (uint32_t) h;
+}
+
+typedef struct dedup_context {
+    const corner *corners;
+    size_t num_corners;
+    _Atomic uint32_t *slots; // First corner with the slot's key, or NO_INDEX
+    uint32_t mask;
+    uint32_t *corner_slots;
+    size_t num_tasks;
+} dedup_context;
+
+// -----------------------------------------------------------------------------
+// Insert a range of corners into the concurrent hash map. A slot is claimed
+// with a compare-and-swap from empty, and afterwards only ever lowered to an
+// earlier corner with the same key, so its key never changes.
+static void dedup_corners(void *arg, int index)
+{
+    dedup_context *ctx = arg;
+    size_t begin = ctx->num_corners * index / ctx->num_tasks;
+    size_t end = ctx->num_corners * (index + 1) / ctx->num_tasks;
+    for (size_t i = begin; i < end; i++) {
+        const corner *c = &ctx->corners[i];
+        uint32_t slot = hash_corner(c) & ctx->mask;
+        for (;;) {
+            uint32_t first = atomic_load_explicit(&ctx->slots[slot],
+                                                memory_order_relaxed);
+            if (first == NO_INDEX) {
+                if (atomic_compare_exchange_weak(&ctx->slots[slot], &first,
+                                                (uint32_t) i)) {
+                    break;
+                }
+                continue;
+            }
+            const corner *other = &ctx->corners[first];
+            if (other->position == c->position &&
+                other->texcoord == c->texcoord &&
+                other->normal == c->normal) {
+                while (i < first &&
+                    !atomic_compare_exchange_weak(&ctx->slots[slot], &first,
+                                                    (uint32_t) i)) {
+                }
+                break;
+            }
+            slot = (slot + 1) & ctx->mask;
+        }
+        ctx->corner_slots[i] = slot;
+    }
+}
+
+typedef struct gather_context {
+    const corner *corners;
+    const uint32_t *vertex_corners;
+    uint32_t num_vertices;
+    const float *positions;
+    const float *texcoords;
+    const float *normals;
+    imported_mesh *mesh;
+    size_t num_tasks;
+} gather_context;
+
+// -----------------------------------------------------------------------------
+static void gather_vertices(void *arg, int index)
+{
+    gather_context *ctx = arg;
+    imported_mesh *mesh = ctx->mesh;
+    uint32_t begin = (uint32_t) ((uint64_t) ctx->num_vertices * index /
+                                ctx->num_tasks);
+    uint32_t end = (uint32_t) ((uint64_t) ctx->num_vertices * (index + 1) /
+                            ctx->num_tasks);
+    for (uint32_t v = begin; v < end; v++) {
+        const corner *c = &ctx->corners[ctx->vertex_corners[v]];
+        memcpy(&mesh->positions[3 * v], &ctx->positions[3 * c->position],
+            3 * sizeof(float));
+        if (mesh->normals) {
+            if (c->normal != NO_INDEX) {
+                memcpy(&mesh->normals[3 * v], &ctx->normals[3 * c->normal],
+                    3 * sizeof(float));
+            } else {
+                memset(&mesh->normals[3 * v], 0, 3 * sizeof(float));
+            }
+        }
+        if (mesh->texcoords) {
+            if (c->texcoord != NO_INDEX) {
+                memcpy(&mesh->texcoords[2 * v],
+                    &ctx->texcoords[2 * c->texcoord], 2 * sizeof(float));
+            } else {
+                memset(&mesh->texcoords[2 * v], 0, 2 * sizeof(float));
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Turn unique (position, texcoord, normal) corners into indexed vertices
+static bool build_indexed_mesh(const corner *corners, size_t num_corners,
+                            const float *positions, const float *texcoords,
+                            const float *normals, imported_mesh *mesh)
+{
+    // Corners are stored as 32-bit indices and NO_INDEX marks empty slots.
+    // The table has at most 2^32 slots, which is more than the number of
+    // corners, so probing always finds an empty slot.
+    if (num_corners >= NO_INDEX) {
+        fprintf(stderr, "Error: The mesh has %zu corners, more than 32-bit "
+                        "indices can address\n", num_corners);
+        return false;
+    }
+    size_t capacity = 1024;
+    while (capacity < 2 * num_corners && capacity < (size_t) NO_INDEX + 1) {
+        capacity *= 2;
+    }
+    dedup_context dedup = {0};
+    dedup.corners = corners;
+    dedup.num_corners = num_corners;
+    dedup.slots = malloc(capacity * sizeof(_Atomic uint32_t));
+    dedup.mask = (uint32_t) (capacity - 1);
+    dedup.corner_slots = malloc(num_corners * sizeof(uint32_t) + 1);
+    dedup.num_tasks = (size_t) num_threads * CHUNKS_PER_THREAD;
+    uint32_t *slot_vertices = malloc(capacity * sizeof(uint32_t));
+    uint32_t *vertex_corners = malloc(num_corners * sizeof(uint32_t) + 1);
+    mesh->indices = malloc(num_corners * sizeof(uint32_t) + 1);
+    if (!(dedup.slots && dedup.corner_slots && slot_vertices &&
+        vertex_corners && mesh->indices)) {
+        free((void *) dedup.slots);
+        free(dedup.corner_slots);
+        free(slot_vertices);
+        free(vertex_corners);
+        fprintf(stderr, "Error: Unable to allocate memory for the vertices\n");
+        return false;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&dedup.slots[i], NO_INDEX);
+    }
+    gla_parallel_for(pool, (int) dedup.num_tasks, dedup_corners, &dedup);
+
+    // Number vertices by their first corner so that the result is the same
+    // for any number of threads
+    uint32_t num_vertices = 0;
+    for (size_t i = 0; i < num_corners; i++) {
+        uint32_t slot = dedup.corner_slots[i];
+        if (atomic_load_explicit(&dedup.slots[slot], memory_order_relaxed) ==
+            i) {
+            slot_vertices[slot] = num_vertices;
+            vertex_corners[num_vertices++] = (uint32_t) i;
+        }
+        mesh->indices[i] = slot_vertices[slot];
+    }
+    free((void *) dedup.slots);
+    free(dedup.corner_slots);
+    free(slot_vertices);
+
+    mesh->num_vertices = num_vertices;
+    mesh->positions = malloc(num_vertices * 3 * sizeof(float) + 1);
+    mesh->normals = normals ? malloc(num_vertices * 3 * sizeof(float) + 1)
+                            : NULL;
+    mesh->texcoords = texcoords ? malloc(num_vertices * 2 * sizeof(float) + 1)
+                                : NULL;
+    if (!mesh->positions || (normals && !mesh->normals) ||
+        (texcoords && !mesh->texcoords)) {
+        free(vertex_corners);
+        fprintf(stderr, "Error: Unable to allocate memory for the vertices\n");
+        return false;
+    }
+    gather_context gather = {
+        corners, vertex_corners, num_vertices, positions, texcoords, normals,
+        mesh, (size_t) num_threads * CHUNKS_PER_THREAD
+    };
+    gla_parallel_for(pool, (int) gather.num_tasks, gather_vertices, &gather);
+    free(vertex_corners);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Concatenate the float arrays of all chunks
+static float *concat_chunk_floats(obj_chunk *chunks, size_t num_chunks,
+                                size_t offset_of_array, size_t num_floats,
+                                size_t *count)
+{
+    *count = 0;
+    for (size_t i = 0; i < num_chunks; i++) {
+        *count += ((array *) ((char *) &chunks[i] + offset_of_array))->count;
+    }
+    float *result = malloc(*count * num_floats * sizeof(float) + 1);
+    if (!result) {
+        return NULL;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < num_chunks; i++) {
+        array *a = (array *) ((char *) &chunks[i] + offset_of_array);
+        memcpy(result + n * num_floats, a->data,
+            a->count * num_floats * sizeof(float));
+        n += a->count;
+        array_free(a);
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Resolve a raw OBJ index against the chunk base and the global count
+static bool resolve_obj_index(int64_t raw, size_t base, size_t count,
+                            uint32_t *index)
+{
+    if (raw == ABSENT_INDEX) {
+        *index = NO_INDEX;
+        return true;
+    }
+    int64_t i = raw;
+    if (raw >= RELATIVE_INDEX_BIAS / 2) {
+        i = raw - RELATIVE_INDEX_BIAS + (int64_t) base;
+    }
+    if (i < 0 || (uint64_t) i >= count || (uint64_t) i >= NO_INDEX) {
+        return false;
+    }
+    *index = (uint32_t) i;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool import_obj(const char *data, size_t size, imported_mesh *mesh)
+{
+    size_t max_chunks = (size_t) num_threads * CHUNKS_PER_THREAD;
+    const char **bounds = malloc((max_chunks + 1) * sizeof(const char *));
+    obj_chunk *chunks = calloc(max_chunks, sizeof(obj_chunk));
+    if (!(bounds && chunks)) {
+        free(bounds);
+        free(chunks);
+        fprintf(stderr, "Error: Unable to allocate memory for the chunks\n");
+        return false;
+    }
+    size_t num_chunks = split_lines(data, data + size, max_chunks, bounds);
+    for (size_t i = 0; i < num_chunks; i++) {
+        chunks[i].begin = bounds[i];
+        chunks[i].end = bounds[i + 1];
+        array_init(&chunks[i].positions, 3 * sizeof(float));
+        array_init(&chunks[i].texcoords, 2 * sizeof(float));
+        array_init(&chunks[i].normals, 3 * sizeof(float));
+        array_init(&chunks[i].corners, sizeof(raw_corner));
+        array_init(&chunks[i].material_changes, sizeof(material_change));
+    }
+    free(bounds);
+
+    double start = now_ms();
+    gla_parallel_for(pool, (int) num_chunks, parse_obj_chunk, chunks);
+    printf("Parsed %zu chunks in %.1f ms\n", num_chunks, now_ms() - start);
+    bool ok = true;
+    size_t line = 0;
+    for (size_t i = 0; i < num_chunks; i++) {
+        if (chunks[i].failed) {
+            // Count the lines of the preceding chunks only on failure
+            for (size_t j = 0; j < i; j++) {
+                for (const char *p = chunks[j].begin; p < chunks[j].end; p++) {
+                    line += *p == '\n';
+                }
+            }
+            fprintf(stderr, "Error: Invalid OBJ data in line %zu\n",
+                    line + chunks[i].error_line + 1);
+            ok = false;
+            break;
+        }
+    }
+
+    // Prefix sums give every chunk the global base of its elements
+    size_t *bases = calloc(4 * (num_chunks + 1), sizeof(size_t));
+    if (ok && !bases) {
+        fprintf(stderr, "Error: Unable to allocate memory for the chunks\n");
+        ok = false;
+    }
+    for (size_t i = 0; ok && i < num_chunks; i++) {
+        bases[4 * (i + 1) + 0] = bases[4 * i + 0] + chunks[i].positions.count;
+        bases[4 * (i + 1) + 1] = bases[4 * i + 1] + chunks[i].texcoords.count;
+        bases[4 * (i + 1) + 2] = bases[4 * i + 2] + chunks[i].normals.count;
+        bases[4 * (i + 1) + 3] = bases[4 * i + 3] + chunks[i].corners.count;
+    }
+
+    size_t num_positions = 0;
+    size_t num_texcoords = 0;
+    size_t num_normals = 0;
+    size_t num_corners = ok ? bases[4 * num_chunks + 3] : 0;
+    corner *corners = malloc(num_corners * sizeof(corner) + 1);
+    mesh->num_triangles = num_corners / 3;
+    mesh->materials = malloc(mesh->num_triangles * sizeof(uint32_t) + 1);
+    if (ok && !(corners && mesh->materials)) {
+        fprintf(stderr, "Error: Unable to allocate memory for the faces\n");
+        ok = false;
+    }
+
+    // Resolve the indices and number the materials by first appearance
+    char (*material_names)[MAX_MATERIAL_NAME_LENGTH] =
+        calloc(MAX_MATERIALS, MAX_MATERIAL_NAME_LENGTH);
+    uint32_t material = 0;
+    mesh->num_materials = 1;
+    if (ok && !material_names) {
+        ok = false;
+    }
+    for (size_t i = 0; ok && i < num_chunks; i++) {
+        const raw_corner *raw = chunks[i].corners.data;
+        size_t base = bases[4 * i + 3];
+        for (size_t j = 0; ok && j < chunks[i].corners.count; j++) {
+            corner *c = &corners[base + j];
+            ok = resolve_obj_index(raw[j].position, bases[4 * i + 0],
+                                bases[4 * num_chunks + 0], &c->position) &&
+                c->position != NO_INDEX &&
+                resolve_obj_index(raw[j].texcoord, bases[4 * i + 1],
+                                bases[4 * num_chunks + 1], &c->texcoord) &&
+                resolve_obj_index(raw[j].normal, bases[4 * i + 2],
+                                bases[4 * num_chunks + 2], &c->normal);
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: OBJ face index out of range\n");
+            break;
+        }
+
+        const material_change *changes = chunks[i].material_changes.data;
+        size_t num_changes = chunks[i].material_changes.count;
+        size_t change = 0;
+        size_t first_triangle = base / 3;
+        for (size_t t = 0; t < chunks[i].corners.count / 3; t++) {
+            while (change < num_changes && changes[change].triangle <= t) {
+                uint32_t m = 0;
+                while (m < mesh->num_materials &&
+                    strcmp(material_names[m], changes[change].name) != 0) {
+                    m++;
+                }
+                if (m == mesh->num_materials &&
+                    mesh->num_materials < MAX_MATERIALS) {
+                    strcpy(material_names[mesh->num_materials],
+                        changes[change].name);
+                    printf("Material %u: %s\n", mesh->num_materials++,
+                        changes[change].name);
+                }
+                material = m < MAX_MATERIALS ? m : 0;
+                change++;
+            }
+            mesh->materials[first_triangle + t] = material;
+        }
+        array_free(&chunks[i].corners);
+        array_free(&chunks[i].material_changes);
+    }
+    free(material_names);
+
+    float *positions = NULL;
+    float *texcoords = NULL;
+    float *normals = NULL;
+    if (ok) {
+        positions = concat_chunk_floats(chunks, num_chunks,
+                                        offsetof(obj_chunk, positions), 3,
+                                        &num_positions);
+        texcoords = concat_chunk_floats(chunks, num_chunks,
+                                        offsetof(obj_chunk, texcoords), 2,
+                                        &num_texcoords);
+        normals = concat_chunk_floats(chunks, num_chunks,
+                                    offsetof(obj_chunk, normals), 3,
+                                    &num_normals);
+        if (!(positions && texcoords && normals)) {
+            fprintf(stderr, "Error: Unable to allocate memory for the "
+                            "attributes\n");
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        start = now_ms();
+        ok = build_indexed_mesh(corners, num_corners, positions,
+                                num_texcoords > 0 ? texcoords : NULL,
+                                num_normals > 0 ? normals : NULL, mesh);
+        printf("Deduplicated %zu corners into %u vertices in %.1f ms\n",
+            num_corners, mesh->num_vertices, now_ms() - start);
+    }
+
+    for (size_t i = 0; i < num_chunks; i++) {
+        array_free(&chunks[i].positions);
+        array_free(&chunks[i].texcoords);
+        array_free(&chunks[i].normals);
+        array_free(&chunks[i].corners);
+        array_free(&chunks[i].material_changes);
+    }
+    free(chunks);
+    free(bases);
+    free(corners);
+    free(positions);
+    free(texcoords);
+    free(normals);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+// PLY
+// -----------------------------------------------------------------------------
+typedef enum ply_type {
+    PLY_NONE, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32,
+    PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+} ply_type;
+
+typedef enum ply_format {
+    PLY_ASCII, PLY_BINARY_LITTLE_ENDIAN, PLY_BINARY_BIG_ENDIAN
+} ply_format;
+
+// Vertex property roles
+enum {
+    PLY_X, PLY_Y, PLY_Z, PLY_NX, PLY_NY, PLY_NZ, PLY_U, PLY_V, PLY_OTHER
+};
+
+#define PLY_MAX_PROPERTIES 32
+#define PLY_MAX_ELEMENTS 16
+
+typedef struct ply_property {
+    ply_type type;
+    ply_type count_type; // PLY_NONE unless the property is a list
+    int role; // For vertex properties, or 0 for the face index list
+    size_t offset; // Offset in a fixed-size binary record
+} ply_property;
+
+typedef struct ply_element {
+    char name[64];
+    size_t count;
+    ply_property properties[PLY_MAX_PROPERTIES];
+    int num_properties;
+    size_t record_size; // 0 if the element has list properties
+} ply_element;
+
+typedef struct ply_file {
+    ply_format format;
+    ply_element elements[PLY_MAX_ELEMENTS];
+    int num_elements;
+} ply_file;
+
+// -----------------------------------------------------------------------------
+static ply_type parse_ply_type(const char *name)
+{
+    static const struct {
+        const char *name;
+        ply_type type;
+    } types[] = {
+        {"char", PLY_INT8}, {"int8", PLY_INT8}, {"uchar", PLY_UINT8},
+        {"uint8", PLY_UINT8}, {"short", PLY_INT16}, {"int16", PLY_INT16},
+        {"ushort", PLY_UINT16}, {"uint16", PLY_UINT16}, {"int", PLY_INT32},
+        {"int32", PLY_INT32}, {"uint", PLY_UINT32}, {"uint32", PLY_UINT32},
+        {"float", PLY_FLOAT32}, {"float32", PLY_FLOAT32},
+        {"double", PLY_FLOAT64}, {"float64", PLY_FLOAT64}
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (strcmp(name, types[i].name) == 0) {
+            return types[i].type;
+        }
+    }
+    return PLY_NONE;
+}
+
+// -----------------------------------------------------------------------------
+static size_t ply_type_size(ply_type type)
+{
+    static const size_t sizes[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+    return sizes[type];
+}
+
+// -----------------------------------------------------------------------------
+static int ply_vertex_role(const char *name)
+{
+    static const struct {
+        const char *name;
+        int role;
+    } roles[] = {
+        {"x", PLY_X}, {"y", PLY_Y}, {"z", PLY_Z}, {"nx", PLY_NX},
+        {"ny", PLY_NY}, {"nz", PLY_NZ}, {"u", PLY_U}, {"s", PLY_U},
+        {"texture_u", PLY_U}, {"texture_s", PLY_U}, {"v", PLY_V},
+        {"t", PLY_V}, {"texture_v", PLY_V}, {"texture_t", PLY_V}
+    };
+    for (size_t i = 0; i < sizeof(roles) / sizeof(roles[0]); i++) {
+        if (strcmp(name, roles[i].name) == 0) {
+            return roles[i].role;
+        }
+    }
+    return PLY_OTHER;
+}
+
+// -----------------------------------------------------------------------------
+// Parse the header and return the start of the body, or NULL
+static const char *parse_ply_header(const char *data, size_t size,
+                                    ply_file *ply)
+{
+    const char *end = data + size;
+    const char *p = data;
+    memset(ply, 0, sizeof(ply_file));
+    bool has_format = false;
+    while (p < end) {
+        const char *eol = memchr(p, '\n', (size_t) (end - p));
+        if (!eol) {
+            return NULL;
+        }
+        char line[256];
+        size_t length = (size_t) (eol - p);
+        if (length >= sizeof(line)) {
+            length = sizeof(line) - 1;
+        }
+        memcpy(line, p, length);
+        line[length] = '\0';
+        p = eol + 1;
+
+        char word[3][64];
+        int n = sscanf(line, "%63s %63s %63s", word[0], word[1], word[2]);
+        if (n <= 0 || strcmp(word[0], "comment") == 0 ||
+            strcmp(word[0], "obj_info") == 0 || strcmp(word[0], "ply") == 0) {
+            continue;
+        }
+        if (strcmp(word[0], "end_header") == 0) {
+            return has_format ? p : NULL;
+        }
+        if (strcmp(word[0], "format") == 0 && n >= 2) {
+            if (strcmp(word[1], "ascii") == 0) {
+                ply->format = PLY_ASCII;
+            } else if (strcmp(word[1], "binary_little_endian") == 0) {
+                ply->format = PLY_BINARY_LITTLE_ENDIAN;
+            } else if (strcmp(word[1], "binary_big_endian") == 0) {
+                ply->format = PLY_BINARY_BIG_ENDIAN;
+            } else {
+                return NULL;
+            }
+            has_format = true;
+        } else if (strcmp(word[0], "element") == 0 && n == 3) {
+            if (ply->num_elements == PLY_MAX_ELEMENTS) {
+                return NULL;
+            }
+            ply_element *element = &ply->elements[ply->num_elements++];
+            snprintf(element->name, sizeof(element->name), "%s", word[1]);
+            element->count = strtoull(word[2], NULL, 10);
+        } else if (strcmp(word[0], "property") == 0 && ply->num_elements > 0) {
+            ply_element *element = &ply->elements[ply->num_elements - 1];
+            if (element->num_properties == PLY_MAX_PROPERTIES) {
+                return NULL;
+            }
+            ply_property *property =
+                &element->properties[element->num_properties++];
+            char list_words[4][64];
+            if (strcmp(word[1], "list") == 0) {
+                if (sscanf(line, "%63s %63s %63s %63s %63s", list_words[0],
+                        list_words[1], list_words[2], list_words[3],
+                        word[2]) != 5) {
+                    return NULL;
+                }
+                property->count_type = parse_ply_type(list_words[2]);
+                property->type = parse_ply_type(list_words[3]);
+                property->role = strcmp(word[2], "vertex_indices") == 0 ||
+                                strcmp(word[2], "vertex_index") == 0
+                                ? 0 : PLY_OTHER;
+                if (property->count_type == PLY_NONE) {
+                    return NULL;
+                }
+            } else {
+                property->type = parse_ply_type(word[1]);
+                property->role = ply_vertex_role(word[2]);
+            }
+            if (property->type == PLY_NONE) {
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+static double read_ply_binary(const unsigned char *p, ply_type type,
+                            bool swap)
+{
+    unsigned char bytes[8];
+    size_t size = ply_type_size(type);
+    for (size_t i = 0; i < size; i++) {
+        bytes[i] = swap ? p[size - 1 - i] : p[i];
+    }
+    switch (type) {
+    case PLY_INT8: {
+        int8_t v;
+        memcpy(&v, bytes, 1);
+        return v;
+    }
+    case PLY_UINT8:
+        return bytes[0];
+    case PLY_INT16: {
+        int16_t v;
+        memcpy(&v, bytes, 2);
+        return v;
+    }
+    case PLY_UINT16: {
+        uint16_t v;
+        memcpy(&v, bytes, 2);
+        return v;
+    }
+    case PLY_INT32: {
+        int32_t v;
+        memcpy(&v, bytes, 4);
+        return v;
+    }
+    case PLY_UINT32: {
+        uint32_t v;
+        memcpy(&v, bytes, 4);
+        return v;
+    }
+    case PLY_FLOAT32: {
+        float v;
+        memcpy(&v, bytes, 4);
+        return v;
+    }
+    case PLY_FLOAT64: {
+        double v;
+        memcpy(&v, bytes, 8);
+        return v;
+    }
+    default:
+        return 0.0;
+    }
+}
+
+typedef struct ply_vertex_context {
+    const ply_element *element;
+    ply_format format;
+    const char *body; // Binary vertex records
+    const char **lines; // ASCII lines, one more than the count
+    imported_mesh *mesh;
+    size_t num_tasks;
+    atomic_bool failed;
+} ply_vertex_context;
+
+// -----------------------------------------------------------------------------
+static void store_ply_vertex(imported_mesh *mesh, size_t v, int role,
+                            double value)
+{
+    switch (role) {
+    case PLY_X:
+    case PLY_Y:
+    case PLY_Z:
+        mesh->positions[3 * v + role - PLY_X] = (float) value;
+        break;
+    case PLY_NX:
+    case PLY_NY:
+    case PLY_NZ:
+        if (mesh->normals) {
+            mesh->normals[3 * v + role - PLY_NX] = (float) value;
+        }
+        break;
+    case PLY_U:
+    case PLY_V:
+        if (mesh->texcoords) {
+            mesh->texcoords[2 * v + role - PLY_U] = (float) value;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+static void parse_ply_vertices(void *arg, int index)
+{
+    ply_vertex_context *ctx = arg;
+    const ply_element *element = ctx->element;
+    size_t begin = element->count * index / ctx->num_tasks;
+    size_t end = element->count * (index + 1) / ctx->num_tasks;
+    bool swap = ctx->format == PLY_BINARY_BIG_ENDIAN;
+    for (size_t v = begin; v < end; v++) {
+        if (ctx->format != PLY_ASCII) {
+            const unsigned char *record = (const unsigned char *) ctx->body +
+                                        v * element->record_size;
+            for (int i = 0; i < element->num_properties; i++) {
+                const ply_property *property = &element->properties[i];
+                store_ply_vertex(ctx->mesh, v, property->role,
+                                read_ply_binary(record + property->offset,
+                                                property->type, swap));
+            }
+            continue;
+        }
+        const char *p = ctx->lines[v];
+        const char *line_end = ctx->lines[v + 1];
+        for (int i = 0; i < element->num_properties; i++) {
+            float value;
+            p = parse_float(p, line_end, &value);
+            if (!p) {
+                atomic_store(&ctx->failed, true);
+                return;
+            }
+            store_ply_vertex(ctx->mesh, v, element->properties[i].role,
+                            value);
+        }
+    }
+}
+
+typedef struct ply_face_context {
+    const ply_element *element;
+    const char **lines;
+    array *chunk_indices; // Triangle corner indices of every task
+    uint32_t num_vertices;
+    size_t num_tasks;
+    atomic_bool failed;
+} ply_face_context;
+
+// -----------------------------------------------------------------------------
+// Fan triangulate a polygon into out
+static bool push_ply_polygon(array *out, const int64_t *polygon, size_t n,
+                            uint32_t num_vertices)
+{
+    if (n < 3) {
+        return n == 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (polygon[i] < 0 || polygon[i] >= num_vertices) {
+            return false;
+        }
+    }
+    uint32_t *triangles = array_push(out, 3 * (n - 2));
+    if (!triangles) {
+        return false;
+    }
+    for (size_t i = 1; i + 1 < n; i++) {
+        *triangles++ = (uint32_t) polygon[0];
+        *triangles++ = (uint32_t) polygon[i];
+        *triangles++ = (uint32_t) polygon[i + 1];
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+static void parse_ply_ascii_faces(void *arg, int index)
+{
+    ply_face_context *ctx = arg;
+    const ply_element *element = ctx->element;
+    size_t begin = element->count * index / ctx->num_tasks;
+    size_t end = element->count * (index + 1) / ctx->num_tasks;
+    array *out = &ctx->chunk_indices[index];
+    int64_t polygon[64];
+    for (size_t f = begin; f < end; f++) {
+        const char *p = ctx->lines[f];
+        const char *line_end = ctx->lines[f + 1];
+        for (int i = 0; i < element->num_properties; i++) {
+            const ply_property *property = &element->properties[i];
+            size_t count = 1;
+            if (property->count_type != PLY_NONE) {
+                int64_t c;
+                p = parse_int(p, line_end, &c);
+                if (!p || c < 0) {
+                    atomic_store(&ctx->failed, true);
+                    return;
+                }
+                count = (size_t) c;
+            }
+            size_t n = 0;
+            for (size_t j = 0; j < count; j++) {
+                float value;
+                p = parse_float(p, line_end, &value);
+                if (!p) {
+                    atomic_store(&ctx->failed, true);
+                    return;
+                }
+                if (n < 64) {
+                    polygon[n++] = (int64_t) value;
+                }
+            }
+            if (property->count_type != PLY_NONE && property->role == 0 &&
+                (count > 64 ||
+                !push_ply_polygon(out, polygon, n, ctx->num_vertices))) {
+                atomic_store(&ctx->failed, true);
+                return;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Collect the starts of count lines, plus the end of the last one
+static const char **index_lines(const char *p, const char *end, size_t count,
+                                const char **next)
+{
+    const char **lines = malloc((count + 1) * sizeof(const char *));
+    if (!lines) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        p = skip_spaces(p, end);
+        while (p < end && *p == '\n') {
+            p = skip_spaces(p + 1, end);
+        }
+        if (p == end) {
+            free(lines);
+            return NULL;
+        }
+        lines[i] = p;
+        const char *eol = memchr(p, '\n', (size_t) (end - p));
+        p = eol ? eol + 1 : end;
+    }
+    lines[count] = p;
+    *next = p;
+    return lines;
+}
+
+// -----------------------------------------------------------------------------
+// Return the size of one binary record, advancing past it
+static bool skip_ply_binary_record(const ply_element *element, bool swap,
+                                const char **p, const char *end)
+{
+    for (int i = 0; i < element->num_properties; i++) {
+        const ply_property *property = &element->properties[i];
+        size_t count = 1;
+        if (property->count_type != PLY_NONE) {
+            size_t count_size = ply_type_size(property->count_type);
+            if ((size_t) (end - *p) < count_size) {
+                return false;
+            }
+            double c = read_ply_binary((const unsigned char *) *p,
+                                    property->count_type, swap);
+            if (c < 0) {
+                return false;
+            }
+            count = (size_t) c;
+            *p += count_size;
+        }
+        size_t size = count * ply_type_size(property->type);
+        if ((size_t) (end - *p) < size) {
+            return false;
+        }
+        *p += size;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool import_ply(const char *data, size_t size, imported_mesh *mesh)
+{
+    ply_file ply;
+    const char *p = parse_ply_header(data, size, &ply);
+    const char *end = data + size;
+    if (!p) {
+        fprintf(stderr, "Error: Invalid PLY header\n");
+        return false;
+    }
+    bool swap = ply.format == PLY_BINARY_BIG_ENDIAN;
+    size_t num_tasks = (size_t) num_threads * CHUNKS_PER_THREAD;
+
+    array indices;
+    array_init(&indices, sizeof(uint32_t));
+    bool has_vertices = false;
+    for (int e = 0; e < ply.num_elements; e++) {
+        ply_element *element = &ply.elements[e];
+        bool is_vertex = strcmp(element->name, "vertex") == 0;
+        bool is_face = strcmp(element->name, "face") == 0;
+
+        element->record_size = 0;
+        bool fixed = true;
+        for (int i = 0; i < element->num_properties; i++) {
+            element->properties[i].offset = element->record_size;
+            element->record_size += ply_type_size(element->properties[i].type);
+            fixed &= element->properties[i].count_type == PLY_NONE;
+        }
+        if (!fixed) {
+            element->record_size = 0;
+        }
+
+        if (is_vertex) {
+            bool has_normals = false;
+            bool has_texcoords = false;
+            for (int i = 0; i < element->num_properties; i++) {
+                has_normals |= element->properties[i].role == PLY_NX;
+                has_texcoords |= element->properties[i].role == PLY_U;
+            }
+            if (!fixed || element->count >= NO_INDEX) {
+                fprintf(stderr, "Error: Unsupported PLY vertex element\n");
+                return false;
+            }
+            mesh->num_vertices = (uint32_t) element->count;
+            mesh->positions = calloc(element->count * 3 + 1, sizeof(float));
+            mesh->normals = has_normals
+                            ? calloc(element->count * 3 + 1, sizeof(float))
+                            : NULL;
+            mesh->texcoords = has_texcoords
+                            ? calloc(element->count * 2 + 1, sizeof(float))
+                            : NULL;
+            if (!mesh->positions || (has_normals && !mesh->normals) ||
+                (has_texcoords && !mesh->texcoords)) {
+                fprintf(stderr, "Error: Unable to allocate memory for the "
+                                "vertices\n");
+                return false;
+            }
+
+            ply_vertex_context ctx = {0};
+            ctx.element = element;
+            ctx.format = ply.format;
+            ctx.mesh = mesh;
+            ctx.num_tasks = num_tasks;
+            atomic_init(&ctx.failed, false);
+            if (ply.format == PLY_ASCII) {
+                ctx.lines = index_lines(p, end, element->count, &p);
+                if (!ctx.lines) {
+                    fprintf(stderr, "Error: Truncated PLY vertex data\n");
+                    return false;
+                }
+            } else {
+                if ((size_t) (end - p) < element->count * element->record_size) {
+                    fprintf(stderr, "Error: Truncated PLY vertex data\n");
+                    return false;
+                }
+                ctx.body = p;
+                p += element->count * element->record_size;
+            }
+            gla_parallel_for(pool, (int) num_tasks, parse_ply_vertices, &ctx);
+            free(ctx.lines);
+            if (atomic_load(&ctx.failed)) {
+                fprintf(stderr, "Error: Invalid PLY vertex data\n");
+                return false;
+            }
+            has_vertices = true;
+        } else if (is_face && ply.format == PLY_ASCII) {
+            ply_face_context ctx = {0};
+            ctx.element = element;
+            ctx.num_vertices = mesh->num_vertices;
+            ctx.num_tasks = num_tasks;
+            atomic_init(&ctx.failed, false);
+            ctx.lines = index_lines(p, end, element->count, &p);
+            ctx.chunk_indices = malloc(num_tasks * sizeof(array));
+            if (!(ctx.lines && ctx.chunk_indices)) {
+                free(ctx.lines);
+                free(ctx.chunk_indices);
+                fprintf(stderr, "Error: Truncated PLY face data\n");
+                return false;
+            }
+            for (size_t i = 0; i < num_tasks; i++) {
+                array_init(&ctx.chunk_indices[i], sizeof(uint32_t));
+            }
+            gla_parallel_for(pool, (int) num_tasks, parse_ply_ascii_faces,
+                            &ctx);
+            bool ok = !atomic_load(&ctx.failed);
+            for (size_t i = 0; i < num_tasks; i++) {
+                array *chunk = &ctx.chunk_indices[i];
+                uint32_t *dst = ok ? array_push(&indices, chunk->count) : NULL;
+                if (ok && chunk->count > 0 && !dst) {
+                    ok = false;
+                }
+                if (ok && chunk->count > 0) {
+                    memcpy(dst, chunk->data, chunk->count * sizeof(uint32_t));
+                }
+                array_free(chunk);
+            }
+            free(ctx.lines);
+            free(ctx.chunk_indices);
+            if (!ok) {
+                array_free(&indices);
+                fprintf(stderr, "Error: Invalid PLY face data\n");
+                return false;
+            }
+        } else if (is_face) {
+            // Variable-length binary records can only be found sequentially
+            int64_t polygon[64];
+            for (size_t f = 0; f < element->count; f++) {
+                bool ok = true;
+                for (int i = 0; ok && i < element->num_properties; i++) {
+                    const ply_property *property = &element->properties[i];
+                    size_t count = 1;
+                    if (property->count_type != PLY_NONE) {
+                        size_t count_size = ply_type_size(property->count_type);
+                        ok = (size_t) (end - p) >= count_size;
+                        if (!ok) {
+                            break;
+                        }
+                        count = (size_t) read_ply_binary(
+                            (const unsigned char *) p, property->count_type,
+                            swap);
+                        p += count_size;
+                    }
+                    size_t item_size = ply_type_size(property->type);
+                    ok = (size_t) (end - p) >= count * item_size &&
+                        count <= 64;
+                    for (size_t j = 0; ok && j < count; j++) {
+                        polygon[j] = (int64_t) read_ply_binary(
+                            (const unsigned char *) p + j * item_size,
+                            property->type, swap);
+                    }
+                    if (ok && property->count_type != PLY_NONE &&
+                        property->role == 0) {
+                        ok = push_ply_polygon(&indices, polygon, count,
+                                            mesh->num_vertices);
+                    }
+                    p += count * item_size;
+                }
+                if (!ok) {
+                    array_free(&indices);
+                    fprintf(stderr, "Error: Invalid PLY face data\n");
+                    return false;
+                }
+            }
+        } else if (ply.format == PLY_ASCII) {
+            const char **lines = index_lines(p, end, element->count, &p);
+            if (!lines) {
+                fprintf(stderr, "Error: Truncated PLY data\n");
+                return false;
+            }
+            free(lines);
+        } else {
+            for (size_t i = 0; i < element->count; i++) {
+                if (!skip_ply_binary_record(element, swap, &p, end)) {
+                    fprintf(stderr, "Error: Truncated PLY data\n");
+                    return false;
+                }
+            }
+        }
+    }
+
+    if (!has_vertices) {
+        array_free(&indices);
+        fprintf(stderr, "Error: PLY file has no vertices\n");
+        return false;
+    }
+    mesh->indices = indices.data;
+    mesh->num_triangles = indices.count / 3;
+    mesh->materials = calloc(mesh->num_triangles + 1, sizeof(uint32_t));
+    mesh->num_materials = 1;
+    return mesh->materials != NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Output
+// -----------------------------------------------------------------------------
+// Reorder the triangles of one submesh for the vertex cache and, optionally,
+// for less overdraw
+static bool optimize_triangles(const imported_mesh *mesh, uint32_t *indices,
+                            size_t num_indices)
+{
+    if (!gla_optimize_vertex_cache(indices, indices, (GLuint) num_indices,
+                                mesh->num_vertices) ||
+        (overdraw_threshold > 0.0f &&
+        !gla_optimize_overdraw(indices, indices, (GLuint) num_indices,
+                                mesh->positions, 3 * sizeof(float),
+                                mesh->num_vertices, overdraw_threshold))) {
+        fprintf(stderr, "Error: Unable to optimize the triangles\n");
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reorder a vertex stream of float vectors
+static bool remap_stream(float **stream, uint32_t num_vertices,
+                        uint32_t num_remapped, int count, const uint32_t *remap)
+{
+    if (!*stream) {
+        return true;
+    }
+    float *remapped = malloc(num_remapped * count * sizeof(float) + 1);
+    if (!remapped) {
+        return false;
+    }
+    gla_remap_vertices(remapped, *stream, num_vertices,
+                    (GLsizei) (count * sizeof(float)), remap);
+    free(*stream);
+    *stream = remapped;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reorder the vertices in order of first use and drop unreferenced ones
+static bool optimize_vertices(imported_mesh *mesh, uint32_t *indices,
+                            size_t num_indices)
+{
+    uint32_t *remap = malloc(mesh->num_vertices * sizeof(uint32_t) + 1);
+    if (!remap) {
+        fprintf(stderr, "Error: Unable to allocate memory for the remap\n");
+        return false;
+    }
+    uint32_t num_remapped = gla_optimize_vertex_fetch_remap(
+        remap, indices, (GLuint) num_indices, mesh->num_vertices);
+    bool ok = remap_stream(&mesh->positions, mesh->num_vertices, num_remapped,
+                        3, remap) &&
+            remap_stream(&mesh->normals, mesh->num_vertices, num_remapped, 3,
+                        remap) &&
+            remap_stream(&mesh->texcoords, mesh->num_vertices, num_remapped,
+                        2, remap);
+    if (ok) {
+        gla_remap_indices(indices, indices, (GLuint) num_indices, remap);
+        mesh->num_vertices = num_remapped;
+    } else {
+        fprintf(stderr, "Error: Unable to allocate memory for the vertices\n");
+    }
+    free(remap);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Turn the triangle list of every submesh into strips and return the new
+// index data
+static uint32_t *generate_strips(const imported_mesh *mesh,
+                                const uint32_t *indices,
+                                gla_mesh_submesh *submeshes,
+                                uint32_t num_submeshes, size_t *num_indices)
+{
+    uint32_t *strip_indices = malloc(*num_indices / 3 * 4 * sizeof(uint32_t) +
+                                    1);
+    if (!strip_indices) {
+        fprintf(stderr, "Error: Unable to allocate memory for the strips\n");
+        return NULL;
+    }
+    size_t count = 0;
+    for (uint32_t i = 0; i < num_submeshes; i++) {
+        gla_mesh_submesh *submesh = &submeshes[i];
+        GLuint n = gla_generate_triangle_strips(
+            &strip_indices[count], &indices[submesh->first_index],
+            submesh->index_count, mesh->num_vertices);
+        if (n == 0) {
+            free(strip_indices);
+            return NULL;
+        }
+        submesh->first_index = (GLuint) count;
+        submesh->index_count = n;
+        submesh->mode = GL_TRIANGLE_STRIP;
+        count += n;
+    }
+    *num_indices = count;
+    return strip_indices;
+}
+
+// -----------------------------------------------------------------------------
+// Follow every submesh with its levels of detail and return the new index
+// data. A level that removes less than a quarter of the triangles of the
+// previous one ends the chain.
+static uint32_t *generate_lods(const imported_mesh *mesh,
+                            const uint32_t *indices,
+                            gla_mesh_submesh *submeshes,
+                            uint32_t *num_submeshes, size_t *num_indices)
+{
+    // Every level is at most LOD_MIN_REDUCTION times the previous one
+    size_t capacity = (size_t) (*num_indices / (1.0f - LOD_MIN_REDUCTION)) + 3;
+    uint32_t *lod_indices = malloc(capacity * sizeof(uint32_t));
+    uint32_t *scratch = malloc(*num_indices * sizeof(uint32_t) + 1);
+    gla_mesh_submesh *lods = malloc(*num_submeshes * (lod_levels + 1) *
+                                    sizeof(gla_mesh_submesh));
+    if (!(lod_indices && scratch && lods)) {
+        free(lod_indices);
+        free(scratch);
+        free(lods);
+        fprintf(stderr, "Error: Unable to allocate memory for the levels of "
+                        "detail\n");
+        return NULL;
+    }
+
+    size_t count = 0;
+    uint32_t num_lods = 0;
+    for (uint32_t i = 0; i < *num_submeshes; i++) {
+        gla_mesh_submesh *lod = &lods[num_lods++];
+        *lod = submeshes[i];
+        lod->first_index = (GLuint) count;
+        memcpy(&lod_indices[count], &indices[submeshes[i].first_index],
+            submeshes[i].index_count * sizeof(uint32_t));
+        count += submeshes[i].index_count;
+
+        float error = 0.0f;
+        for (int level = 1; level <= lod_levels; level++) {
+            const gla_mesh_submesh *previous = &lods[num_lods - 1];
+            GLuint target = previous->index_count / 6 * 3;
+            float level_error;
+            GLuint n = gla_simplify_mesh(
+                scratch, &lod_indices[previous->first_index],
+                previous->index_count, mesh->positions, 3 * sizeof(float),
+                mesh->num_vertices, target, INFINITY, &level_error);
+            if (n == 0 || n > previous->index_count * LOD_MIN_REDUCTION) {
+                break;
+            }
+            if (optimize && !optimize_triangles(mesh, scratch, n)) {
+                free(lod_indices);
+                free(scratch);
+                free(lods);
+                return NULL;
+            }
+
+            // The errors of the levels add up, as every level is simplified
+            // from the previous one
+            error += level_error;
+            lod = &lods[num_lods++];
+            *lod = *previous;
+            lod->first_index = (GLuint) count;
+            lod->index_count = n;
+            lod->lod_error = error;
+            memcpy(&lod_indices[count], scratch, n * sizeof(uint32_t));
+            count += n;
+            printf("Material %u LOD %d: %u triangles, error %g\n",
+                lod->material, level, n / 3, error);
+        }
+    }
+    memcpy(submeshes, lods, num_lods * sizeof(gla_mesh_submesh));
+    free(scratch);
+    free(lods);
+    *num_submeshes = num_lods;
+    *num_indices = count;
+    return lod_indices;
+}
+
+// -----------------------------------------------------------------------------
+// Quantize positions relative to the mesh bounds, which the mesh file stores
+// as the union of the submesh bounds, normals to octahedral 10-bit values and
+// texture coordinates to half floats
+static bool quantize_streams(const imported_mesh *mesh,
+                            const gla_mesh_submesh *submeshes,
+                            uint32_t num_submeshes, void *quantized[3])
+{
+    float aabb_min[3] = {INFINITY, INFINITY, INFINITY};
+    float aabb_max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t i = 0; i < num_submeshes; i++) {
+        for (int j = 0; j < 3; j++) {
+            aabb_min[j] = fminf(aabb_min[j], submeshes[i].aabb_min[j]);
+            aabb_max[j] = fmaxf(aabb_max[j], submeshes[i].aabb_max[j]);
+        }
+    }
+
+    size_t n = mesh->num_vertices;
+    quantized[0] = malloc(n * gla_quantized_attrib_size(GLA_QUANTIZED_POSITION)
+                        + 1);
+    if (mesh->normals) {
+        quantized[1] = malloc(
+            n * gla_quantized_attrib_size(GLA_QUANTIZED_OCTAHEDRAL_10) + 1);
+    }
+    if (mesh->texcoords) {
+        quantized[2] = malloc(
+            n * gla_quantized_attrib_size(GLA_QUANTIZED_HALF_FLOAT_2) + 1);
+    }
+    if (!quantized[0] || (mesh->normals && !quantized[1]) ||
+        (mesh->texcoords && !quantized[2])) {
+        for (int i = 0; i < 3; i++) {
+            free(quantized[i]);
+            quantized[i] = NULL;
+        }
+        fprintf(stderr, "Error: Unable to allocate memory for the quantized "
+                        "vertices\n");
+        return false;
+    }
+
+    gla_quantize_positions(quantized[0], mesh->positions, 3 * sizeof(float),
+                        mesh->num_vertices, aabb_min, aabb_max);
+    if (mesh->normals) {
+        gla_quantize_unit_vectors(quantized[1], GLA_QUANTIZED_OCTAHEDRAL_10,
+                                mesh->normals, 3 * sizeof(float),
+                                mesh->num_vertices, GL_FALSE);
+    }
+    if (mesh->texcoords) {
+        gla_convert_to_half_floats(quantized[2], mesh->texcoords, 2 * n);
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool write_mesh(const char *filename, imported_mesh *mesh)
+{
+    // Group the triangles by material with a stable counting sort
+    uint32_t *counts = calloc(mesh->num_materials + 1, sizeof(uint32_t));
+    uint32_t *indices = malloc(mesh->num_triangles * 3 * sizeof(uint32_t) + 1);
+    gla_mesh_submesh *submeshes =
+        calloc(mesh->num_materials * (lod_levels + 1),
+            sizeof(gla_mesh_submesh));
+    if (!(counts && indices && submeshes)) {
+        free(counts);
+        free(indices);
+        free(submeshes);
+        fprintf(stderr, "Error: Unable to allocate memory for the output\n");
+        return false;
+    }
+    for (size_t t = 0; t < mesh->num_triangles; t++) {
+        counts[mesh->materials[t] + 1]++;
+    }
+    for (uint32_t m = 0; m < mesh->num_materials; m++) {
+        counts[m + 1] += counts[m];
+    }
+    for (size_t t = 0; t < mesh->num_triangles; t++) {
+        uint32_t dst = counts[mesh->materials[t]]++;
+        memcpy(&indices[3 * dst], &mesh->indices[3 * t], 3 * sizeof(uint32_t));
+    }
+    size_t num_indices = mesh->num_triangles * 3;
+    gla_vertex_cache_stats before = gla_analyze_vertex_cache(
+        indices, (GLuint) num_indices, mesh->num_vertices, VERTEX_CACHE_SIZE);
+
+    // One submesh per used material, with bounds of its vertices
+    uint32_t num_submeshes = 0;
+    uint32_t first = 0;
+    for (uint32_t m = 0; m < mesh->num_materials; m++) {
+        uint32_t last = counts[m];
+        if (last == first) {
+            continue;
+        }
+        gla_mesh_submesh *submesh = &submeshes[num_submeshes++];
+        submesh->first_index = 3 * first;
+        submesh->index_count = 3 * (last - first);
+        submesh->material = m;
+        submesh->mode = GL_TRIANGLES;
+        if (optimize && !optimize_triangles(mesh, &indices[3 * first],
+                                            3 * (last - first))) {
+            free(counts);
+            free(indices);
+            free(submeshes);
+            return false;
+        }
+        for (int j = 0; j < 3; j++) {
+            submesh->aabb_min[j] = INFINITY;
+            submesh->aabb_max[j] = -INFINITY;
+        }
+        for (uint32_t i = 3 * first; i < 3 * last; i++) {
+            const float *position = &mesh->positions[3 * indices[i]];
+            for (int j = 0; j < 3; j++) {
+                submesh->aabb_min[j] = fminf(submesh->aabb_min[j], position[j]);
+                submesh->aabb_max[j] = fmaxf(submesh->aabb_max[j], position[j]);
+            }
+        }
+        first = last;
+    }
+    free(counts);
+    gla_vertex_cache_stats after = gla_analyze_vertex_cache(
+        indices, (GLuint) num_indices, mesh->num_vertices, VERTEX_CACHE_SIZE);
+
+    if (lod_levels > 0) {
+        uint32_t *lod_indices = generate_lods(mesh, indices, submeshes,
+                                            &num_submeshes, &num_indices);
+        free(indices);
+        if (!lod_indices) {
+            free(submeshes);
+            return false;
+        }
+        indices = lod_indices;
+    }
+
+    if (optimize && !optimize_vertices(mesh, indices, num_indices)) {
+        free(indices);
+        free(submeshes);
+        return false;
+    }
+    // The vertex order does not change the misses, only their ratio
+    after.atvr = (GLfloat) after.vertices_transformed / mesh->num_vertices;
+    printf("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr, after.acmr,
+        before.atvr, after.atvr);
+
+    if (strips) {
+        uint32_t *strip_indices = generate_strips(mesh, indices, submeshes,
+                                                num_submeshes, &num_indices);
+        free(indices);
+        if (!strip_indices) {
+            free(submeshes);
+            return false;
+        }
+        indices = strip_indices;
+    }
+
+    // The smallest index type that suffices, converted in place
+    GLenum index_type = gla_choose_index_type(mesh->num_vertices, strips);
+    gla_convert_indices(indices, index_type, indices, (GLuint) num_indices);
+
+    gla_vertex_format format = {0};
+    const void *streams[3] = {mesh->positions, NULL, NULL};
+    void *quantized[3] = {NULL, NULL, NULL};
+    if (quantize && !quantize_streams(mesh, submeshes, num_submeshes,
+                                    quantized)) {
+        free(indices);
+        free(submeshes);
+        return false;
+    }
+    if (quantize) {
+        gla_add_quantized_vertex_attrib(&format, 0, 0, GLA_QUANTIZED_POSITION);
+        streams[0] = quantized[0];
+    } else {
+        gla_add_vertex_attrib(&format, 0, 0, 3, GL_FLOAT, GL_FALSE);
+    }
+    GLuint binding = 1;
+    if (mesh->normals) {
+        if (quantize) {
+            gla_add_quantized_vertex_attrib(&format, 1, binding,
+                                            GLA_QUANTIZED_OCTAHEDRAL_10);
+            streams[binding++] = quantized[1];
+        } else {
+            gla_add_vertex_attrib(&format, 1, binding, 3, GL_FLOAT, GL_FALSE);
+            streams[binding++] = mesh->normals;
+        }
+    }
+    if (mesh->texcoords) {
+        if (quantize) {
+            gla_add_quantized_vertex_attrib(&format, 2, binding,
+                                            GLA_QUANTIZED_HALF_FLOAT_2);
+            streams[binding++] = quantized[2];
+        } else {
+            gla_add_vertex_attrib(&format, 2, binding, 2, GL_FLOAT, GL_FALSE);
+            streams[binding++] = mesh->texcoords;
+        }
+    }
+
+    bool ok = gla_write_mesh(filename, &format, streams, mesh->num_vertices,
+                            indices, index_type, (GLuint) num_indices,
+                            submeshes, num_submeshes);
+    for (int i = 0; i < 3; i++) {
+        free(quantized[i]);
+    }
+    printf("Wrote %u vertices, %zu triangles, %zu indices and %u submeshes\n",
+        mesh->num_vertices, mesh->num_triangles, num_indices, num_submeshes);
+    free(indices);
+    free(submeshes);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+static bool has_extension(const char *filename, const char *extension)
+{
+    size_t n = strlen(filename);
+    size_t m = strlen(extension);
+    if (n < m) {
+        return false;
+    }
+    for (size_t i = 0; i < m; i++) {
+        char c = filename[n - m + i];
+        if (c >= 'A' && c <= 'Z') {
+            c = (char) (c - 'A' + 'a');
+        }
+        if (c != extension[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int arg = 1;
+    num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-j") == 0 && arg + 1 < argc) {
+            num_threads = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "-O") == 0) {
+            optimize = true;
+        } else if (strcmp(argv[arg], "-q") == 0) {
+            quantize = true;
+        } else if (strcmp(argv[arg], "-s") == 0) {
+            strips = true;
+        } else if (strcmp(argv[arg], "-l") == 0 && arg + 1 < argc) {
+            lod_levels = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "-d") == 0 && arg + 1 < argc) {
+            optimize = true;
+            overdraw_threshold = strtof(argv[++arg], NULL);
+        } else {
+            num_threads = 0;
+            break;
+        }
+    }
+    if (argc - arg != 2 || num_threads < 1 || lod_levels < 0) {
+        fprintf(stderr, "Usage: %s [-j threads] [-O] [-d threshold] [-s] [-q] "
+                        "[-l levels] input.obj|input.ply output.glam\n",
+                argv[0]);
+        return 1;
+    }
+    const char *input = argv[arg];
+    const char *output = argv[arg + 1];
+
+    int fd = open(input, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "Error: Unable to read file %s\n", input);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+    size_t size = (size_t) st.st_size;
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Error: Unable to map file %s\n", input);
+        return 1;
+    }
+    madvise((void *) data, size, MADV_SEQUENTIAL);
+
+    // The calling thread works, too
+    if (num_threads > 1) {
+        pool = gla_create_job_pool(num_threads - 1);
+    }
+
+    double start = now_ms();
+    imported_mesh mesh = {0};
+    bool ok;
+    if (has_extension(input, ".ply")) {
+        ok = import_ply(data, size, &mesh);
+    } else if (has_extension(input, ".obj")) {
+        ok = import_obj(data, size, &mesh);
+    } else {
+        fprintf(stderr, "Error: Unknown file type of %s\n", input);
+        ok = false;
+    }
+    munmap((void *) data, size);
+
+    if (ok) {
+        ok = mesh.num_triangles > 0 && write_mesh(output, &mesh);
+        printf("Imported %s in %.1f ms using %d threads\n", input,
+            now_ms() - start, num_threads);
+    }
+
+    free(mesh.positions);
+    free(mesh.normals);
+    free(mesh.texcoords);
+    free(mesh.indices);
+    free(mesh.materials);
+    gla_delete_job_pool(pool);
+    return ok ? 0 : 1;
+}
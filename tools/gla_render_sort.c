@@ -0,0 +1,186 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-present Lars Schütz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ******************************************************************************/
+/*
+ * Measure the time of gla's render queue sort.
+ *
+ * Usage: gla_render_sort [-n count] [-r repetitions]
+ *
+ * count packets are pushed with keys of two kinds: typical keys with 4
+ * layers, 32 programs, 512 materials and random 24-bit depths, and keys with
+ * all 64 bits random. The time of gla_sort_render_queue is reported for the
+ * first sort (cold) and as the best of the repetitions, next to qsort of the
+ * same keys. The sorted order is checked against qsort.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glad/glad.h>
+
+#define GLA_IMPLEMENTATION
+#include "../gla/gla.h"
+
+typedef struct sort_result {
+    double cold_ms;
+    double best_ms;
+    double qsort_ms;
+    int sorted;
+} sort_result;
+
+static GLuint64 random_state = 88172645463325252ull;
+
+// -----------------------------------------------------------------------------
+static double now_ms(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+// -----------------------------------------------------------------------------
+static GLuint64 random_u64(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+// -----------------------------------------------------------------------------
+static GLuint64 make_key(int typical)
+{
+    if (!typical) {
+        return random_u64();
+    }
+    GLuint64 r = random_u64();
+    return GLA_RENDER_KEY(r & 3, (r >> 2) & 31, (r >> 7) & 511, r >> 40);
+}
+
+// -----------------------------------------------------------------------------
+static int compare_keys(const void *a, const void *b)
+{
+    GLuint64 x = *(const GLuint64 *) a;
+    GLuint64 y = *(const GLuint64 *) b;
+    return x < y ? -1 : x > y;
+}
+
+// -----------------------------------------------------------------------------
+static void check_key(void *user, GLuint64 key, const void *packet)
+{
+    GLuint64 **expected = user;
+    if (key != **expected || *(const GLuint64 *) packet != key) {
+        *expected = NULL;
+        return;
+    }
+    (*expected)++;
+}
+
+// -----------------------------------------------------------------------------
+static void skip_key(void *user, GLuint64 key, const void *packet)
+{
+    (void) user;
+    (void) key;
+    (void) packet;
+}
+
+// -----------------------------------------------------------------------------
+static sort_result measure_sort(gla_render_queue *queue, GLuint64 *keys,
+                                int count, int repetitions, int typical)
+{
+    sort_result result = {0.0, INFINITY, INFINITY, 1};
+    for (int r = 0; r < repetitions; r++) {
+        for (int i = 0; i < count; i++) {
+            keys[i] = make_key(typical);
+            GLuint64 *packet = gla_push_render_packet(queue, keys[i]);
+            *packet = keys[i];
+        }
+
+        double t0 = now_ms();
+        gla_sort_render_queue(queue);
+        double t1 = now_ms();
+        qsort(keys, count, sizeof(GLuint64), compare_keys);
+        double t2 = now_ms();
+        if (r == 0) {
+            result.cold_ms = t1 - t0;
+        }
+        result.best_ms = fmin(result.best_ms, t1 - t0);
+        result.qsort_ms = fmin(result.qsort_ms, t2 - t1);
+
+        GLuint64 *expected = keys;
+        gla_submit_render_queue(queue, 0, NULL,
+                                result.sorted ? check_key : skip_key,
+                                &expected);
+        result.sorted = result.sorted && expected;
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+static void print_result(const char *name, const sort_result *result)
+{
+    printf("  %-14s cold %7.3f ms  best %7.3f ms  qsort %7.3f ms  %s\n",
+        name, result->cold_ms, result->best_ms, result->qsort_ms,
+        result->sorted ? "sorted" : "NOT SORTED");
+}
+
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int count = 100000;
+    int repetitions = 20;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            repetitions = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [-n count] [-r repetitions]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (count < 1 || repetitions < 1) {
+        fprintf(stderr, "Error: Count and repetitions must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    gla_render_queue *queue =
+        gla_create_render_queue(count, sizeof(GLuint64));
+    GLuint64 *keys = malloc(count * sizeof(GLuint64));
+    if (!(queue && keys)) {
+        fprintf(stderr, "Error: Unable to allocate memory for the keys\n");
+        return EXIT_FAILURE;
+    }
+
+    sort_result typical = measure_sort(queue, keys, count, repetitions, 1);
+    sort_result random = measure_sort(queue, keys, count, repetitions, 0);
+    printf("%d packets, best of %d:\n", count, repetitions);
+    print_result("typical keys", &typical);
+    print_result("random keys", &random);
+    gla_delete_render_queue(queue);
+    free(keys);
+    return typical.sorted && random.sorted ? EXIT_SUCCESS : EXIT_FAILURE;
+}